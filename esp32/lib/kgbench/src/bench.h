@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include "mpu6050.h"
+#include "quaternion.h"
+
+/*
+  KneeGuard – pomocnicze narzędzia benchmarków (tylko env:native_bench)
+
+  Pomiar czasu na hoście (steady_clock), "ujście" zapobiegające wycięciu
+  obliczeń przez optymalizator oraz deterministyczne dane wejściowe.
+*/
+
+static volatile float bench_sink_f = 0;
+
+static inline void benchSink(float v) { bench_sink_f = bench_sink_f + v; }
+
+// Najlepszy (najmniejszy) czas z `reps` przebiegów, w ns na operację.
+template <typename F>
+static double benchNsPerOp(size_t ops, F fn, int reps = 5) {
+  double best = 1e300;
+  for (int r = 0; r < reps; r++) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn();
+    const auto t1 = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (double)ops;
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+static inline void benchReport(const char* name, double ns_per_op, const char* unit = "sample") {
+  printf("[BENCH] %-28s %10.1f ns/%s\n", name, ns_per_op, unit);
+}
+
+// Para próbek (udo, podudzie) w postaci surowych rejestrów MPU6050
+// + prawdziwy kąt kolana (do liczenia błędu fuzji).
+struct BenchRawPair {
+  MpuRaw thigh;
+  MpuRaw shank;
+  float knee_deg = 0;
+};
+
+static inline int16_t benchClamp16(float v) {
+  if (v > 32767.0f) return 32767;
+  if (v < -32768.0f) return -32768;
+  return (int16_t)lrintf(v);
+}
+
+// Syntetyczny ruch: udo kołysze się ±10°, kolano zgina się 0..90° (0.5 Hz),
+// z deterministycznym szumem. Zgięcie to obrót wokół osi X segmentu; oba
+// czujniki mogą być zamontowane z odchyłką tilt_deg wokół osi Y segmentu
+// (oś zgięcia nie pokrywa się wtedy z osią X czujnika).
+static inline std::vector<BenchRawPair> benchMakeKneeMotion(size_t n, float fs_hz, float tilt_deg = 0.0f) {
+  std::vector<BenchRawPair> out(n);
+  uint32_t lcg = 12345;
+  const float dt = 1.0f / fs_hz;
+  const float w = 2.0f * 3.14159265f * 0.5f;
+  const Quat mount = quatFromAxisAngleDeg(0.0f, 1.0f, 0.0f, tilt_deg);
+  for (size_t i = 0; i < n; i++) {
+    const float t = i * dt;
+    const float thigh_deg = 10.0f * sinf(w * t);
+    const float knee_deg  = 45.0f * (1.0f - cosf(w * t));
+    const float shank_deg = thigh_deg + knee_deg;
+    const float thigh_rate = 10.0f * w * cosf(w * t);
+    const float shank_rate = thigh_rate + 45.0f * w * sinf(w * t);
+    out[i].knee_deg = knee_deg;
+
+    const float angles[2] = {thigh_deg, shank_deg};
+    const float rates[2]  = {thigh_rate, shank_rate};
+    MpuRaw* dst[2] = {&out[i].thigh, &out[i].shank};
+    for (int k = 0; k < 2; k++) {
+      lcg = lcg * 1664525u + 1013904223u;
+      const float noise = ((int32_t)(lcg >> 16) - 32768) / 32768.0f * 0.01f;
+
+      // grawitacja w układzie czujnika: q* (0,0,1) q, q = Rx(kąt) * montaż
+      const Quat q = quatMul(quatFromAxisAngleDeg(1.0f, 0.0f, 0.0f, angles[k]), mount);
+      float ax = 0.0f, ay = 0.0f, az = 1.0f;
+      quatRotate(quatConj(q), ax, ay, az);
+
+      // prędkość kątowa segmentu (oś X) w układzie czujnika
+      float gx = rates[k], gy = 0.0f, gz = 0.0f;
+      quatRotate(quatConj(mount), gx, gy, gz);
+
+      dst[k]->ax = benchClamp16((ax + noise) * ACC_LSB_PER_G);
+      dst[k]->ay = benchClamp16((ay + noise) * ACC_LSB_PER_G);
+      dst[k]->az = benchClamp16((az - noise) * ACC_LSB_PER_G);
+      dst[k]->gx = benchClamp16((gx + 20.0f * noise) * GYRO_LSB_PER_DPS);
+      dst[k]->gy = benchClamp16((gy + 20.0f * noise) * GYRO_LSB_PER_DPS);
+      dst[k]->gz = benchClamp16((gz - 20.0f * noise) * GYRO_LSB_PER_DPS);
+    }
+  }
+  return out;
+}
+
+// Zapis próbki do postaci bloku 14 B (big-endian), jak odczyt z 0x3B.
+static inline void benchEncodeBurst(const MpuRaw& r, uint8_t* buf) {
+  const int16_t v[7] = {r.ax, r.ay, r.az, r.temp, r.gx, r.gy, r.gz};
+  for (int i = 0; i < 7; i++) {
+    buf[2 * i]     = (uint8_t)((uint16_t)v[i] >> 8);
+    buf[2 * i + 1] = (uint8_t)((uint16_t)v[i] & 0xFF);
+  }
+}
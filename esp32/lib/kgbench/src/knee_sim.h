@@ -0,0 +1,323 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "mpu6050.h"
+#include "quaternion.h"
+
+/*
+  KneeGuard – generator syntetycznej kinematyki kolana (host: testy i benchmarki)
+
+  Model płaski (płaszczyzna strzałkowa Y-Z, Z w górę): udo i podudzie to
+  odcinki obracające się wokół osi X świata; kąt segmentu 0 = pionowo.
+  Zgięcie kolana k: podudzie = udo - k. Czujniki leżą na segmentach w
+  odległości SIM_*_SENSOR_M od stawu, więc akcelerometr widzi grawitację
+  oraz przyspieszenie liniowe (styczne, dośrodkowe, ruch biodra) – liczone
+  różnicami centralnymi położenia w double.
+
+  Ruchy (SimMotion), każdy zaczyna i kończy się w staniu z zerową prędkością:
+  - SIM_SQUAT: przysiady 0..90° (stopa nieruchoma, biodro opada i cofa się),
+  - SIM_GAIT: chód na bieżni (profil zgięcia z fazą podporu i przenoszenia,
+    zgięcie biodra, pionowe kołysanie biodra, uderzenie pięty – tłumiona
+    oscylacja przyspieszenia na podudziu),
+  - SIM_HYPEREXT: przeprost kolana (-SIM_HYPEREXT_DEG) w staniu,
+  - SIM_STILL: bezruch (kalibracja, śledzenie biasu).
+  simMakeScenario składa ciąg ruchów; simRun syntetyzuje rejestry MPU6050
+  obu IMU: odchyłka montażu (roll/pitch/yaw czujnika względem segmentu),
+  szum biały (Gauss), bias żyroskopu z dryfem liniowym, błądzeniem losowym
+  i zależnością od temperatury (nagrzewanie), zakresy i kwantyzacja int16.
+
+  Prawda (SimSample): kąty segmentów i zgięcie kolana ze znakiem – potok
+  podaje kąt kolana jako wartość bezwzględną, więc porównanie z |knee_deg|.
+  Deterministyczny (seed): ten sam SimConfig daje te same próbki.
+*/
+
+static const double SIM_G              = 9.80665;
+static const double SIM_THIGH_M        = 0.45;  // biodro -> kolano
+static const double SIM_SHANK_M        = 0.43;  // kolano -> kostka
+static const double SIM_THIGH_SENSOR_M = 0.20;  // czujnik od biodra
+static const double SIM_SHANK_SENSOR_M = 0.15;  // czujnik od kolana
+static const double SIM_HYPEREXT_DEG   = 8.0;
+
+enum SimMotion : uint8_t { SIM_STILL, SIM_SQUAT, SIM_GAIT, SIM_HYPEREXT };
+
+struct SimSegment {
+  SimMotion motion;
+  float     duration_s;
+  float     period_s; // okres powtórzenia (przysiad, krok, przeprost)
+};
+
+// Parametry czujnika jednego IMU
+struct SimImuError {
+  float mount_roll_deg = 0, mount_pitch_deg = 0, mount_yaw_deg = 0;
+  float bias_dps[3]       = {0, 0, 0}; // bias żyroskopu w 25 °C
+  float drift_dps_min[3]  = {0, 0, 0}; // dryf liniowy [dps/min]
+  float temp_k_dps_c[3]   = {0, 0, 0}; // zależność od temperatury [dps/°C]
+};
+
+struct SimConfig {
+  float    fs_hz          = 500.0f;
+  MpuConfig cfg;                       // zakresy (skalowanie rejestrów)
+  float    acc_noise_g    = 0.004f;    // odch. std. na próbkę (MPU6050 ~400 ug/sqrt(Hz))
+  float    gyro_noise_dps = 0.05f;     // odch. std. na próbkę (~0.005 dps/sqrt(Hz))
+  float    gyro_rw_dps    = 0.0f;      // błądzenie losowe biasu [dps/sqrt(s)]
+  float    temp_start_c   = 25.0f;
+  float    temp_rise_c    = 0.0f;      // nagrzewanie: T = start + rise * (1 - exp(-t / tau))
+  float    temp_tau_s     = 600.0f;
+  float    impact_g       = 2.0f;      // uderzenie pięty (chód), amplituda na podudziu
+  SimImuError imu[2];                  // 0 = udo, 1 = podudzie
+  uint32_t seed           = 1;
+};
+
+// Wartości fizyczne przed kwantyzacją (z szumem i biasem): [g], [deg/s] –
+// wejście emulatora rejestrów (lib/kgsim/src/mpu6050_emu.h)
+struct SimPhys {
+  float acc_g[3]    = {0, 0, 0};
+  float gyro_dps[3] = {0, 0, 0};
+};
+
+// Prawda i rejestry obu IMU w jednej chwili
+struct SimSample {
+  uint64_t t_us = 0;
+  MpuRaw   thigh, shank;
+  SimPhys  phys[2];                      // 0 = udo, 1 = podudzie
+  float    thigh_deg = 0, shank_deg = 0; // kąty segmentów (oś X świata)
+  float    knee_deg  = 0;                // zgięcie ze znakiem (przeprost < 0)
+  float    temp_c    = 25.0f;
+  SimMotion motion   = SIM_STILL;
+};
+
+// Stan kinematyki w chwili t: kąty segmentów [rad] i położenie biodra [m];
+// uderzenie pięty jako osobne przyspieszenie pionowe podudzia [m/s^2].
+struct SimPose {
+  double thigh = 0, shank = 0;
+  double hip_y = 0, hip_z = SIM_THIGH_M + SIM_SHANK_M;
+  double impact = 0;
+  SimMotion motion = SIM_STILL;
+};
+
+static inline double simDeg2Rad(double d) { return d * 3.14159265358979323846 / 180.0; }
+
+// Gładkie wejście/wyjście 0..1..0 (pochodna 0 na końcach)
+static inline double simBump(double x) {
+  if (x <= 0.0 || x >= 1.0) return 0.0;
+  return 0.5 - 0.5 * cos(2.0 * 3.14159265358979323846 * x);
+}
+
+static inline double simEnvelope(double t, double len, double ramp) {
+  if (t <= 0.0 || t >= len) return 0.0;
+  const double r = ramp < len / 2 ? ramp : len / 2;
+  double e = 1.0;
+  if (t < r) e = 0.5 - 0.5 * cos(3.14159265358979323846 * t / r);
+  else if (t > len - r) e = 0.5 - 0.5 * cos(3.14159265358979323846 * (len - t) / r);
+  return e;
+}
+
+// Biodro z łańcucha od nieruchomej kostki (przysiad, stanie)
+static inline void simHipFromAnkle(SimPose& p) {
+  p.hip_y = -(SIM_SHANK_M * sin(p.shank) + SIM_THIGH_M * sin(p.thigh));
+  p.hip_z = SIM_SHANK_M * cos(p.shank) + SIM_THIGH_M * cos(p.thigh);
+}
+
+static inline SimPose simPoseIn(const SimSegment& seg, double t) {
+  SimPose p;
+  p.motion = seg.motion;
+  const double period = seg.period_s > 0 ? seg.period_s : 1.0;
+  const double ph = fmod(t, period) / period;
+  switch (seg.motion) {
+    case SIM_SQUAT: {
+      // całe powtórzenia; zgięcie 0..90°, udo pochyla się do tyłu, podudzie do przodu
+      const double reps = floor(seg.duration_s / period);
+      const double k = t < reps * period ? simDeg2Rad(90.0) * simBump(ph) : 0.0;
+      p.thigh = 0.5 * k;
+      p.shank = p.thigh - k;
+      simHipFromAnkle(p);
+      break;
+    }
+    case SIM_GAIT: {
+      // profil chodu: podpór (~15° przy obciążeniu) i przenoszenie (~60°)
+      const double env = simEnvelope(t, seg.duration_s, period);
+      const double k = simDeg2Rad(5.0 + 12.0 * simBump(ph / 0.35) + 55.0 * simBump((ph - 0.55) / 0.45)) * env;
+      p.thigh = simDeg2Rad(20.0) * cos(2.0 * 3.14159265358979323846 * ph) * env;
+      p.shank = p.thigh - k;
+      p.hip_y = 0.0; // bieżnia: stała prędkość nie daje przyspieszenia
+      p.hip_z = (SIM_THIGH_M + SIM_SHANK_M) * (1.0 - 0.03 * env) +
+                0.025 * env * cos(4.0 * 3.14159265358979323846 * ph);
+      const double since_strike = fmod(t, period);
+      p.impact = env * SIM_G * exp(-since_strike / 0.02) * sin(2.0 * 3.14159265358979323846 * 30.0 * since_strike);
+      break;
+    }
+    case SIM_HYPEREXT: {
+      // krótki przeprost w połowie okresu, poza nim stanie
+      const double k = -simDeg2Rad(SIM_HYPEREXT_DEG) * simBump((ph - 0.3) / 0.4);
+      p.thigh = -0.3 * k;
+      p.shank = p.thigh - k;
+      simHipFromAnkle(p);
+      break;
+    }
+    default:
+      break;
+  }
+  return p;
+}
+
+// Położenie czujnika uda (0) / podudzia (1) w świecie
+static inline void simSensorPos(const SimPose& p, int imu, double& y, double& z) {
+  // u(a) = Rx(a) * (0, 0, 1) – kierunek "w górę" wzdłuż segmentu
+  const double ty = -sin(p.thigh), tz = cos(p.thigh);
+  if (imu == 0) {
+    y = p.hip_y - SIM_THIGH_SENSOR_M * ty;
+    z = p.hip_z - SIM_THIGH_SENSOR_M * tz;
+    return;
+  }
+  const double sy = -sin(p.shank), sz = cos(p.shank);
+  y = p.hip_y - SIM_THIGH_M * ty - SIM_SHANK_SENSOR_M * sy;
+  z = p.hip_z - SIM_THIGH_M * tz - SIM_SHANK_SENSOR_M * sz;
+}
+
+// Deterministyczny generator (xorshift32) + rozkład normalny (Box-Muller)
+struct SimRng {
+  uint32_t s = 1;
+  bool     has_spare = false;
+  double   spare = 0;
+};
+
+static inline double simUniform(SimRng& r) {
+  r.s ^= r.s << 13;
+  r.s ^= r.s >> 17;
+  r.s ^= r.s << 5;
+  return ((double)r.s + 0.5) / 4294967296.0;
+}
+
+static inline double simGauss(SimRng& r) {
+  if (r.has_spare) {
+    r.has_spare = false;
+    return r.spare;
+  }
+  const double u1 = simUniform(r), u2 = simUniform(r);
+  const double m = sqrt(-2.0 * log(u1));
+  r.spare = m * sin(2.0 * 3.14159265358979323846 * u2);
+  r.has_spare = true;
+  return m * cos(2.0 * 3.14159265358979323846 * u2);
+}
+
+static inline int16_t simClamp16(double v) {
+  if (v > 32767.0) return 32767;
+  if (v < -32768.0) return -32768;
+  return (int16_t)lrint(v);
+}
+
+// Scenariusz: ciąg segmentów ruchu; czas całkowity = suma duration_s.
+static inline double simDuration(const std::vector<SimSegment>& sc) {
+  double d = 0;
+  for (size_t i = 0; i < sc.size(); i++) d += sc[i].duration_s;
+  return d;
+}
+
+static inline SimPose simPoseAt(const std::vector<SimSegment>& sc, double t) {
+  double t0 = 0;
+  for (size_t i = 0; i < sc.size(); i++) {
+    if (t < t0 + sc[i].duration_s) return simPoseIn(sc[i], t - t0);
+    t0 += sc[i].duration_s;
+  }
+  return SimPose();
+}
+
+// Typowe scenariusze: still_s bezruchu na początku (kalibracja żyroskopu i "calib"),
+// ruch, 1 s bezruchu na końcu.
+static inline std::vector<SimSegment> simMakeScenario(SimMotion m, float duration_s, float still_s = 3.0f) {
+  std::vector<SimSegment> sc;
+  sc.push_back(SimSegment{SIM_STILL, still_s, 1.0f});
+  switch (m) {
+    case SIM_SQUAT:    sc.push_back(SimSegment{SIM_SQUAT, duration_s, 3.0f}); break;
+    case SIM_GAIT:     sc.push_back(SimSegment{SIM_GAIT, duration_s, 1.1f}); break;
+    case SIM_HYPEREXT: sc.push_back(SimSegment{SIM_HYPEREXT, duration_s, 2.0f}); break;
+    default:           sc.push_back(SimSegment{SIM_STILL, duration_s, 1.0f}); break;
+  }
+  sc.push_back(SimSegment{SIM_STILL, 1.0f, 1.0f});
+  return sc;
+}
+
+static inline const char* simMotionName(SimMotion m) {
+  switch (m) {
+    case SIM_SQUAT:    return "squat";
+    case SIM_GAIT:     return "gait";
+    case SIM_HYPEREXT: return "hyperext";
+    default:           return "still";
+  }
+}
+
+// Synteza rejestrów obu IMU dla scenariusza z częstotliwością cfg.fs_hz.
+static inline std::vector<SimSample> simRun(const std::vector<SimSegment>& sc, const SimConfig& cfg) {
+  const double dt = 1.0 / cfg.fs_hz;
+  const double h = 0.5e-3; // krok różnic centralnych
+  const size_t n = (size_t)(simDuration(sc) * cfg.fs_hz);
+  const MpuScaleFactors sf = mpuScaleFactors(cfg.cfg);
+  std::vector<SimSample> out(n);
+
+  SimRng rng;
+  rng.s = cfg.seed ? cfg.seed : 1;
+  Quat mount[2];
+  double rw[2][3] = {{0, 0, 0}, {0, 0, 0}};
+  for (int k = 0; k < 2; k++) {
+    const SimImuError& e = cfg.imu[k];
+    mount[k] = quatMul(quatFromAxisAngleDeg(0, 0, 1, e.mount_yaw_deg),
+                       quatFromRollPitchDeg(e.mount_roll_deg, e.mount_pitch_deg));
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    const double t = (double)i * dt;
+    const SimPose p = simPoseAt(sc, t);
+    const SimPose pm = simPoseAt(sc, t - h), pp = simPoseAt(sc, t + h);
+    SimSample& s = out[i];
+    s.t_us = (uint64_t)llround(t * 1e6);
+    s.motion = p.motion;
+    s.thigh_deg = (float)(p.thigh * 180.0 / 3.14159265358979323846);
+    s.shank_deg = (float)(p.shank * 180.0 / 3.14159265358979323846);
+    s.knee_deg = s.thigh_deg - s.shank_deg;
+    const double temp = cfg.temp_start_c + cfg.temp_rise_c * (1.0 - exp(-t / cfg.temp_tau_s));
+    s.temp_c = (float)temp;
+
+    const double ang[2]  = {p.thigh, p.shank};
+    const double rate[2] = {(pp.thigh - pm.thigh) / (2 * h), (pp.shank - pm.shank) / (2 * h)};
+    MpuRaw* dst[2] = {&s.thigh, &s.shank};
+    for (int k = 0; k < 2; k++) {
+      // przyspieszenie liniowe czujnika (świat) + grawitacja -> siła właściwa [g]
+      double y, z, ym, zm, yp, zp;
+      simSensorPos(p, k, y, z);
+      simSensorPos(pm, k, ym, zm);
+      simSensorPos(pp, k, yp, zp);
+      const double ay = (yp - 2 * y + ym) / (h * h);
+      const double az = (zp - 2 * z + zm) / (h * h) + (k == 1 ? cfg.impact_g * p.impact : 0.35 * cfg.impact_g * p.impact);
+      float fx = 0.0f, fy = (float)(ay / SIM_G), fz = (float)(1.0 + az / SIM_G);
+
+      // układ czujnika: segment (Rx) * montaż
+      const Quat q = quatMul(quatFromAxisAngleDeg(1, 0, 0, (float)(ang[k] * 180.0 / 3.14159265358979323846)), mount[k]);
+      quatRotate(quatConj(q), fx, fy, fz);
+      float gx = (float)(rate[k] * 180.0 / 3.14159265358979323846), gy = 0.0f, gz = 0.0f;
+      quatRotate(quatConj(mount[k]), gx, gy, gz);
+
+      const SimImuError& e = cfg.imu[k];
+      const double g[3] = {gx, gy, gz};
+      const double f[3] = {fx, fy, fz};
+      int16_t* acc_out[3]  = {&dst[k]->ax, &dst[k]->ay, &dst[k]->az};
+      int16_t* gyro_out[3] = {&dst[k]->gx, &dst[k]->gy, &dst[k]->gz};
+      for (int a = 0; a < 3; a++) {
+        rw[k][a] += cfg.gyro_rw_dps * sqrt(dt) * simGauss(rng);
+        const double bias = e.bias_dps[a] + e.drift_dps_min[a] * t / 60.0 +
+                            e.temp_k_dps_c[a] * (temp - 25.0) + rw[k][a];
+        const double acc  = f[a] + cfg.acc_noise_g * simGauss(rng);
+        const double gyro = g[a] + bias + cfg.gyro_noise_dps * simGauss(rng);
+        s.phys[k].acc_g[a]    = (float)acc;
+        s.phys[k].gyro_dps[a] = (float)gyro;
+        *acc_out[a]  = simClamp16(acc / sf.g_per_lsb);
+        *gyro_out[a] = simClamp16(gyro / sf.dps_per_lsb);
+      }
+      dst[k]->temp = simClamp16((temp - 36.53) * 340.0);
+    }
+  }
+  return out;
+}
@@ -0,0 +1,141 @@
+#include "i2c_emu.h"
+
+static const uint8_t I2C_EMU_STUCK_MAX_BITS = 9;
+
+bool i2cEmuAttach(I2cEmuBus& bus, const I2cEmuDevice& dev) {
+  if (bus.n_dev >= I2C_EMU_MAX_DEVICES) return false;
+  bus.dev[bus.n_dev++] = dev;
+  return true;
+}
+
+bool i2cEmuAddFault(I2cEmuBus& bus, const I2cEmuFault& fault) {
+  if (bus.n_faults >= I2C_EMU_MAX_FAULTS) return false;
+  bus.faults[bus.n_faults++] = fault;
+  return true;
+}
+
+static uint32_t i2cEmuRand(I2cEmuBus& bus) {
+  uint32_t& s = bus.rng;
+  if (s == 0) s = 1;
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+static float i2cEmuUniform(I2cEmuBus& bus) {
+  return (float)(i2cEmuRand(bus) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Czas transakcji: START + bajt adresu + n bajtów (po 9 bitów z ACK) + STOP.
+static uint32_t i2cEmuDuration(I2cEmuBus& bus, size_t bytes) {
+  const uint32_t clock = bus.clock_hz ? bus.clock_hz : 100000;
+  const uint64_t bits = 2 + 9 * (uint64_t)(1 + bytes);
+  uint32_t us = (uint32_t)((bits * 1000000ULL + clock - 1) / clock) + bus.latency_us;
+  if (bus.latency_jitter_us) us += i2cEmuRand(bus) % (bus.latency_jitter_us + 1);
+  return us;
+}
+
+static bool faultMatches(const I2cEmuFault& f, uint8_t addr, uint64_t now_us) {
+  return (f.addr == 0 || f.addr == addr) && now_us >= f.t0_us && now_us < f.t1_us;
+}
+
+// Usterki w chwili transakcji; true = adres nie zostaje potwierdzony.
+static bool i2cEmuFaultNack(I2cEmuBus& bus, const I2cEmuDevice& dev, uint64_t now_us) {
+  bool nack = false;
+  for (size_t i = 0; i < bus.n_faults; i++) {
+    I2cEmuFault& f = bus.faults[i];
+    if (f.addr != 0 && f.addr != dev.addr) continue;
+    switch (f.type) {
+      case I2C_FAULT_NACK:
+        if (faultMatches(f, dev.addr, now_us) && i2cEmuUniform(bus) < f.prob) nack = true;
+        break;
+      case I2C_FAULT_DETACH:
+        if (faultMatches(f, dev.addr, now_us)) {
+          nack = true;
+        } else if (now_us >= f.t1_us && !f.fired) {
+          f.fired = true; // ponowne podłączenie: czujnik startuje od zera
+          if (dev.power_on) dev.power_on(dev.ctx, f.t1_us);
+        }
+        break;
+      case I2C_FAULT_STUCK:
+        break;
+    }
+  }
+  return nack;
+}
+
+// STUCK: pierwsza transakcja po t0 urywa się w połowie bajtu.
+static bool i2cEmuFaultStuck(I2cEmuBus& bus, uint8_t addr, uint64_t now_us) {
+  for (size_t i = 0; i < bus.n_faults; i++) {
+    I2cEmuFault& f = bus.faults[i];
+    if (f.type != I2C_FAULT_STUCK || f.fired || !faultMatches(f, addr, now_us)) continue;
+    f.fired = true;
+    bus.stuck_bits = (uint8_t)(1 + i2cEmuRand(bus) % I2C_EMU_STUCK_MAX_BITS);
+    bus.stuck_events++;
+    return true;
+  }
+  return false;
+}
+
+static I2cEmuDevice* i2cEmuFind(I2cEmuBus& bus, uint8_t addr) {
+  for (size_t i = 0; i < bus.n_dev; i++) {
+    if (bus.dev[i].addr == addr) return &bus.dev[i];
+  }
+  return nullptr;
+}
+
+// Wspólny początek transakcji: zablokowana magistrala, adres, usterki.
+// I2C_EMU_OK = dev ustawione, można przesyłać dane.
+static uint8_t i2cEmuBegin(I2cEmuBus& bus, uint8_t addr, uint64_t now_us, uint32_t& dur_us, I2cEmuDevice*& dev) {
+  bus.transactions++;
+  dev = nullptr;
+  if (bus.stuck_bits > 0 || i2cEmuFaultStuck(bus, addr, now_us)) {
+    dur_us = bus.timeout_us;
+    bus.busy_us += dur_us;
+    bus.timeouts++;
+    return I2C_EMU_TIMEOUT;
+  }
+  dev = i2cEmuFind(bus, addr);
+  if (dev && !i2cEmuFaultNack(bus, *dev, now_us)) return I2C_EMU_OK;
+  dev = nullptr;
+  dur_us = 0;
+  return I2C_EMU_NACK_ADDR;
+}
+
+// Koniec transakcji: ok = dane przesłane, inaczej NACK adresu (brak
+// urządzenia, usterka albo czujnik w trakcie resetu).
+static uint8_t i2cEmuEnd(I2cEmuBus& bus, bool ok, size_t n, uint32_t& dur_us) {
+  dur_us = i2cEmuDuration(bus, ok ? n : 0);
+  bus.busy_us += dur_us;
+  if (!ok) {
+    bus.nacks++;
+    return I2C_EMU_NACK_ADDR;
+  }
+  bus.bytes += (uint32_t)n;
+  return I2C_EMU_OK;
+}
+
+uint8_t i2cEmuWrite(I2cEmuBus& bus, uint8_t addr, const uint8_t* data, size_t n, uint64_t now_us,
+                    uint32_t& dur_us) {
+  I2cEmuDevice* dev;
+  const uint8_t r = i2cEmuBegin(bus, addr, now_us, dur_us, dev);
+  if (r == I2C_EMU_TIMEOUT) return r;
+  return i2cEmuEnd(bus, dev && dev->write && dev->write(dev->ctx, data, n, now_us), n, dur_us);
+}
+
+uint8_t i2cEmuRead(I2cEmuBus& bus, uint8_t addr, uint8_t* out, size_t n, uint64_t now_us, uint32_t& dur_us) {
+  I2cEmuDevice* dev;
+  const uint8_t r = i2cEmuBegin(bus, addr, now_us, dur_us, dev);
+  if (r == I2C_EMU_TIMEOUT) return r;
+  return i2cEmuEnd(bus, dev && dev->read && dev->read(dev->ctx, out, n, now_us), n, dur_us);
+}
+
+bool i2cEmuSdaLow(const I2cEmuBus& bus) {
+  return bus.stuck_bits > 0;
+}
+
+void i2cEmuSclPulse(I2cEmuBus& bus) {
+  if (bus.stuck_bits == 0) return;
+  if (--bus.stuck_bits == 0) bus.unstuck++;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – emulator magistrali I2C (host: testy i fwsim)
+
+  Transakcje na poziomie bajtów z czasem trwania liczonym z zegara magistrali
+  (9 bitów na bajt z ACK + START/STOP) plus stałe opóźnienie i losowy rozrzut
+  (rozciąganie zegara, przełączanie zadań w sterowniku). Funkcje nie czekają –
+  zwracają czas trwania, a wywołujący (fwsim: Wire) odczekuje go sam.
+  Kody wyników jak Wire.endTransmission na ESP32: 0 OK, 2 NACK adresu,
+  5 timeout.
+
+  Urządzenia (I2cEmuDevice) to wskaźniki funkcji z kontekstem, jak LogStorage.
+  Usterki (I2cEmuFault) w przedziałach czasu [t0_us, t1_us):
+  - I2C_FAULT_NACK: adres potwierdzany z prawdopodobieństwem 1 - prob,
+  - I2C_FAULT_DETACH: urządzenie odłączone (NACK); po t1_us wraca w stanie
+    po zasileniu (power_on) – firmware musi je skonfigurować od nowa,
+  - I2C_FAULT_STUCK: pierwsza transakcja po t0_us zostaje przerwana w połowie
+    bajtu, urządzenie trzyma SDA w stanie niskim; do czasu impulsów SCL
+    (i2cEmuSclPulse – odblokowanie magistrali) każda transakcja kończy się
+    timeoutem. Zamiast stanu linii modelowana jest liczba brakujących bitów.
+  addr = 0 w usterce: dowolne urządzenie.
+*/
+
+static const uint8_t I2C_EMU_OK        = 0;
+static const uint8_t I2C_EMU_NACK_ADDR = 2;
+static const uint8_t I2C_EMU_TIMEOUT   = 5;
+
+static const size_t I2C_EMU_MAX_DEVICES = 8;
+static const size_t I2C_EMU_MAX_FAULTS  = 16;
+
+struct I2cEmuDevice {
+  void*   ctx  = nullptr;
+  uint8_t addr = 0;
+  // false = brak odpowiedzi (NACK adresu); now_us – początek transakcji
+  bool (*write)(void* ctx, const uint8_t* data, size_t n, uint64_t now_us) = nullptr;
+  bool (*read)(void* ctx, uint8_t* out, size_t n, uint64_t now_us)         = nullptr;
+  void (*power_on)(void* ctx, uint64_t now_us)                             = nullptr;
+};
+
+enum I2cEmuFaultType : uint8_t { I2C_FAULT_NACK, I2C_FAULT_DETACH, I2C_FAULT_STUCK };
+
+struct I2cEmuFault {
+  I2cEmuFaultType type  = I2C_FAULT_NACK;
+  uint8_t         addr  = 0;
+  uint64_t        t0_us = 0, t1_us = 0;
+  float           prob  = 1.0f; // I2C_FAULT_NACK
+  bool            fired = false; // STUCK: wyzwolona; DETACH: urządzenie już po power_on
+};
+
+struct I2cEmuBus {
+  I2cEmuDevice dev[I2C_EMU_MAX_DEVICES];
+  size_t       n_dev = 0;
+  I2cEmuFault  faults[I2C_EMU_MAX_FAULTS];
+  size_t       n_faults = 0;
+
+  uint32_t clock_hz          = 100000;
+  uint32_t timeout_us        = 50000;
+  uint32_t latency_us        = 0; // stały narzut na transakcję
+  uint32_t latency_jitter_us = 0; // + losowo 0..jitter
+  uint32_t rng               = 1;
+  uint8_t  stuck_bits        = 0; // > 0: SDA trzymane nisko, tyle impulsów SCL do zwolnienia
+
+  // statystyki
+  uint32_t transactions = 0;
+  uint32_t bytes        = 0;
+  uint32_t nacks        = 0;
+  uint32_t timeouts     = 0;
+  uint32_t stuck_events = 0;
+  uint32_t unstuck      = 0; // zwolnienia SDA impulsami SCL
+  uint64_t busy_us      = 0; // suma czasów transakcji
+};
+
+bool i2cEmuAttach(I2cEmuBus& bus, const I2cEmuDevice& dev);
+bool i2cEmuAddFault(I2cEmuBus& bus, const I2cEmuFault& fault);
+
+// Zapis n bajtów (bez bajtu adresu); stop = false: repeated start (bez wpływu na model).
+uint8_t i2cEmuWrite(I2cEmuBus& bus, uint8_t addr, const uint8_t* data, size_t n, uint64_t now_us,
+                    uint32_t& dur_us);
+
+// Odczyt n bajtów; przy błędzie out jest niezmienione.
+uint8_t i2cEmuRead(I2cEmuBus& bus, uint8_t addr, uint8_t* out, size_t n, uint64_t now_us, uint32_t& dur_us);
+
+// Linie przy odblokowaniu magistrali (bit-bang SDA/SCL).
+bool i2cEmuSdaLow(const I2cEmuBus& bus);
+void i2cEmuSclPulse(I2cEmuBus& bus);
@@ -0,0 +1,221 @@
+#include "mpu6050_emu.h"
+
+#include <math.h>
+#include <string.h>
+
+// Rejestry i bity spoza mapy firmware (mpu6050.h)
+static const uint8_t PWR_DEVICE_RESET = 0x80;
+static const uint8_t PWR_SLEEP        = 0x40;
+static const uint8_t FIFO_EN_TEMP     = 0x80;
+static const uint8_t FIFO_EN_XG       = 0x40;
+static const uint8_t FIFO_EN_YG       = 0x20;
+static const uint8_t FIFO_EN_ZG       = 0x10;
+static const uint8_t FIFO_EN_ACCEL    = 0x08;
+static const uint8_t INT_FIFO_OFLOW   = 0x10;
+
+// Dogonienie czasu po długiej przerwie: starsze próbki i tak wypadłyby z FIFO
+static const uint32_t MAX_CATCHUP_SAMPLES = 2 * MPU_FIFO_SIZE;
+
+void mpuEmuInit(MpuEmu& m, MpuEmuSource source, void* ctx) {
+  m.source = source;
+  m.source_ctx = ctx;
+  mpuEmuPowerOn(m);
+}
+
+void mpuEmuPowerOn(MpuEmu& m) {
+  memset(m.regs, 0, sizeof(m.regs));
+  m.regs[MPU_REG_PWR_MGMT_1] = PWR_SLEEP;
+  m.regs[MPU_REG_WHO_AM_I]   = MPU_EMU_WHO_AM_I;
+  m.fifo_head = m.fifo_count = 0;
+  m.fifo_last = 0;
+  m.ptr = 0;
+  m.sampling = false;
+  m.next_sample_us = 0;
+  m.reset_until_us = 0;
+}
+
+float mpuEmuSampleRateHz(const MpuEmu& m) {
+  const uint8_t dlpf = m.regs[MPU_REG_CONFIG] & 0x07;
+  const float gyro_hz = (dlpf == 0 || dlpf == 7) ? 8000.0f : 1000.0f;
+  return gyro_hz / (1.0f + m.regs[MPU_REG_SMPLRT_DIV]);
+}
+
+static uint32_t samplePeriodUs(const MpuEmu& m) {
+  return (uint32_t)(1e6f / mpuEmuSampleRateHz(m) + 0.5f);
+}
+
+static int16_t toLsb(float v, float lsb_per_unit) {
+  const float x = roundf(v * lsb_per_unit);
+  if (x > 32767.0f) return 32767;
+  if (x < -32768.0f) return -32768;
+  return (int16_t)x;
+}
+
+static void putBe16(uint8_t* p, int16_t v) {
+  p[0] = (uint8_t)((uint16_t)v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void fifoPush(MpuEmu& m, const uint8_t* data, size_t n, bool& lost) {
+  for (size_t i = 0; i < n; i++) {
+    if (m.fifo_count == MPU_FIFO_SIZE) { // nadpisanie najstarszego bajtu
+      m.fifo_head = (uint16_t)((m.fifo_head + 1) % MPU_FIFO_SIZE);
+      m.fifo_count--;
+      lost = true;
+    }
+    m.fifo[(m.fifo_head + m.fifo_count) % MPU_FIFO_SIZE] = data[i];
+    m.fifo_count++;
+  }
+}
+
+// Jedna próbka w chwili t_us: rejestry danych + FIFO.
+static void sampleAt(MpuEmu& m, uint64_t t_us) {
+  MpuEmuReading r;
+  if (m.source) m.source(m.source_ctx, t_us, r);
+  const MpuAccelRange ar = (MpuAccelRange)((m.regs[MPU_REG_ACCEL_CONFIG] >> 3) & 0x03);
+  const MpuGyroRange  gr = (MpuGyroRange)((m.regs[MPU_REG_GYRO_CONFIG] >> 3) & 0x03);
+  const float acc_lsb = mpuAccelLsbPerG(ar), gyro_lsb = mpuGyroLsbPerDps(gr);
+
+  uint8_t* d = m.regs + MPU_REG_ACCEL_XOUT_H; // 14 B: acc, temp, gyro
+  for (int a = 0; a < 3; a++) {
+    putBe16(d + 2 * a, toLsb(r.acc_g[a], acc_lsb));
+    putBe16(d + 8 + 2 * a, toLsb(r.gyro_dps[a], gyro_lsb));
+  }
+  putBe16(d + 6, toLsb(r.temp_c - 36.53f, 340.0f));
+  m.regs[MPU_REG_INT_STATUS] |= MPU_INT_DATA_RDY;
+  m.samples++;
+
+  if (!(m.regs[MPU_REG_USER_CTRL] & MPU_USER_CTRL_FIFO_EN)) return;
+  const uint8_t en = m.regs[MPU_REG_FIFO_EN];
+  bool lost = false;
+  if (en & FIFO_EN_ACCEL) fifoPush(m, d, 6, lost);
+  if (en & FIFO_EN_TEMP)  fifoPush(m, d + 6, 2, lost);
+  if (en & FIFO_EN_XG)    fifoPush(m, d + 8, 2, lost);
+  if (en & FIFO_EN_YG)    fifoPush(m, d + 10, 2, lost);
+  if (en & FIFO_EN_ZG)    fifoPush(m, d + 12, 2, lost);
+  if (lost) {
+    m.regs[MPU_REG_INT_STATUS] |= INT_FIFO_OFLOW;
+    m.fifo_overflows++;
+  }
+}
+
+void mpuEmuAdvance(MpuEmu& m, uint64_t now_us) {
+  if (!m.sampling) return;
+  const uint32_t period = samplePeriodUs(m);
+  if (now_us > m.next_sample_us + (uint64_t)MAX_CATCHUP_SAMPLES * period) {
+    m.next_sample_us = now_us - (uint64_t)MAX_CATCHUP_SAMPLES * period;
+  }
+  while (m.next_sample_us <= now_us) {
+    sampleAt(m, m.next_sample_us);
+    m.next_sample_us += period;
+  }
+}
+
+uint64_t mpuEmuNextDataReady(const MpuEmu& m, uint64_t after_us) {
+  if (!m.sampling || !(m.regs[MPU_REG_INT_ENABLE] & MPU_INT_DATA_RDY)) return 0;
+  const uint64_t period = samplePeriodUs(m);
+  uint64_t t = m.next_sample_us; // siatka próbek: next_sample_us + k * okres
+  if (t > after_us) t -= (t - after_us - 1) / period * period;
+  else              t += ((after_us - t) / period + 1) * period;
+  return t;
+}
+
+static void writeReg(MpuEmu& m, uint8_t reg, uint8_t val, uint64_t now_us) {
+  switch (reg) {
+    case MPU_REG_PWR_MGMT_1:
+      if (val & PWR_DEVICE_RESET) {
+        mpuEmuPowerOn(m);
+        m.reset_until_us = now_us + MPU_EMU_RESET_US;
+        m.resets++;
+        return;
+      }
+      m.regs[reg] = val;
+      if (!(val & PWR_SLEEP) && !m.sampling) m.next_sample_us = now_us + samplePeriodUs(m);
+      m.sampling = !(val & PWR_SLEEP);
+      return;
+    case MPU_REG_USER_CTRL:
+      if (val & MPU_USER_CTRL_FIFO_RESET) m.fifo_head = m.fifo_count = 0;
+      m.regs[reg] = val & (uint8_t)~MPU_USER_CTRL_FIFO_RESET; // bit kasuje się sam
+      return;
+    case MPU_REG_WHO_AM_I:
+    case MPU_REG_INT_STATUS:
+    case MPU_REG_FIFO_COUNT_H:
+    case MPU_REG_FIFO_COUNT_H + 1:
+    case MPU_REG_FIFO_R_W:
+      return; // tylko do odczytu (zapis do FIFO_R_W pomijany)
+    default:
+      if (reg >= MPU_REG_ACCEL_XOUT_H && reg < MPU_REG_ACCEL_XOUT_H + MPU_BURST_LEN) return;
+      m.regs[reg] = val;
+  }
+}
+
+static uint8_t readReg(MpuEmu& m, uint8_t reg) {
+  switch (reg) {
+    case MPU_REG_FIFO_COUNT_H:
+      return (uint8_t)(m.fifo_count >> 8);
+    case MPU_REG_FIFO_COUNT_H + 1:
+      return (uint8_t)m.fifo_count;
+    case MPU_REG_FIFO_R_W:
+      if (m.fifo_count > 0) {
+        m.fifo_last = m.fifo[m.fifo_head];
+        m.fifo_head = (uint16_t)((m.fifo_head + 1) % MPU_FIFO_SIZE);
+        m.fifo_count--;
+      }
+      return m.fifo_last;
+    case MPU_REG_INT_STATUS: {
+      const uint8_t v = m.regs[reg];
+      m.regs[reg] = 0;
+      return v;
+    }
+    default:
+      return m.regs[reg];
+  }
+}
+
+static inline uint8_t nextPtr(uint8_t ptr) {
+  return ptr == MPU_REG_FIFO_R_W ? ptr : (uint8_t)((ptr + 1) & 0x7F);
+}
+
+bool mpuEmuWrite(MpuEmu& m, const uint8_t* data, size_t n, uint64_t now_us) {
+  if (now_us < m.reset_until_us) return false;
+  mpuEmuAdvance(m, now_us);
+  if (n == 0) return true;
+  m.ptr = data[0] & 0x7F;
+  for (size_t i = 1; i < n; i++) {
+    writeReg(m, m.ptr, data[i], now_us);
+    m.ptr = nextPtr(m.ptr);
+  }
+  return true;
+}
+
+bool mpuEmuRead(MpuEmu& m, uint8_t* out, size_t n, uint64_t now_us) {
+  if (now_us < m.reset_until_us) return false;
+  mpuEmuAdvance(m, now_us);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = readReg(m, m.ptr);
+    m.ptr = nextPtr(m.ptr);
+  }
+  return true;
+}
+
+static bool devWrite(void* ctx, const uint8_t* data, size_t n, uint64_t now_us) {
+  return mpuEmuWrite(*(MpuEmu*)ctx, data, n, now_us);
+}
+
+static bool devRead(void* ctx, uint8_t* out, size_t n, uint64_t now_us) {
+  return mpuEmuRead(*(MpuEmu*)ctx, out, n, now_us);
+}
+
+static void devPowerOn(void* ctx, uint64_t) {
+  mpuEmuPowerOn(*(MpuEmu*)ctx);
+}
+
+I2cEmuDevice mpuEmuDevice(MpuEmu& m, uint8_t addr) {
+  I2cEmuDevice d;
+  d.ctx = &m;
+  d.addr = addr;
+  d.write = devWrite;
+  d.read = devRead;
+  d.power_on = devPowerOn;
+  return d;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i2c_emu.h"
+#include "mpu6050.h"
+
+/*
+  KneeGuard – emulator MPU6050 na poziomie rejestrów (host: testy i fwsim)
+
+  Mapa rejestrów jak w czujniku: po włączeniu zasilania PWR_MGMT_1 = 0x40
+  (uśpiony), WHO_AM_I = 0x68 niezależnie od AD0. Zapis: pierwszy bajt to
+  wskaźnik rejestru, kolejne bajty z autoinkrementacją; odczyt od wskaźnika,
+  też z autoinkrementacją – poza FIFO_R_W, które zdejmuje kolejne bajty FIFO.
+  - DEVICE_RESET (PWR_MGMT_1 bit 7): rejestry i FIFO do stanu po zasileniu,
+    przez MPU_EMU_RESET_US czujnik nie potwierdza adresu (NACK),
+  - SLEEP (bit 6): brak nowych próbek, rejestry danych zachowują wartość,
+  - CONFIG/SMPLRT_DIV: Fs = (DLPF 0 lub 7 ? 8 kHz : 1 kHz) / (1 + SMPLRT_DIV);
+    samego filtru DLPF emulator nie odtwarza (źródło podaje sygnał gotowy),
+  - ACCEL_CONFIG/GYRO_CONFIG: zakresy (FS_SEL) przy przeliczaniu na LSB,
+  - rejestry danych 0x3B..0x48 aktualizowane co okres próbkowania,
+  - FIFO 1024 B (FIFO_EN + USER_CTRL): akcelerometr, temperatura, żyroskop
+    w kolejności z datasheetu; przepełnienie nadpisuje najstarsze bajty
+    i ustawia FIFO_OFLOW w INT_STATUS (odczyt INT_STATUS kasuje bity),
+  - INT_ENABLE.DATA_RDY_EN: impuls na pinie INT w chwili każdej próbki
+    (mpuEmuNextDataReady – fwsim wywołuje z nim ISR firmware).
+  Próbki powstają leniwie: każda transakcja najpierw dogania czas (mpuEmuAdvance)
+  i pyta źródło o wartości fizyczne w chwilach kolejnych próbek.
+*/
+
+static const uint32_t MPU_EMU_RESET_US = 30000; // DEVICE_RESET: czujnik niedostępny
+static const uint8_t  MPU_EMU_WHO_AM_I = 0x68;
+
+// Wartości fizyczne w chwili próbki: [g], [deg/s], [°C]
+struct MpuEmuReading {
+  float acc_g[3]    = {0.0f, 0.0f, 1.0f};
+  float gyro_dps[3] = {0.0f, 0.0f, 0.0f};
+  float temp_c      = 25.0f;
+};
+
+typedef void (*MpuEmuSource)(void* ctx, uint64_t t_us, MpuEmuReading& out);
+
+struct MpuEmu {
+  uint8_t  regs[128];
+  uint8_t  fifo[MPU_FIFO_SIZE];
+  uint16_t fifo_head  = 0; // indeks najstarszego bajtu
+  uint16_t fifo_count = 0;
+  uint8_t  fifo_last  = 0; // odczyt z pustego FIFO zwraca ostatni bajt
+  uint8_t  ptr        = 0; // wskaźnik rejestru
+  bool     sampling   = false;
+  uint64_t next_sample_us = 0;
+  uint64_t reset_until_us = 0;
+
+  MpuEmuSource source     = nullptr;
+  void*        source_ctx = nullptr;
+
+  // statystyki
+  uint32_t samples        = 0;
+  uint32_t fifo_overflows = 0; // próbki, przy których FIFO straciło bajty
+  uint32_t resets         = 0;
+};
+
+// Źródło wartości fizycznych + stan po włączeniu zasilania.
+void mpuEmuInit(MpuEmu& m, MpuEmuSource source, void* ctx);
+
+// Rejestry i FIFO jak po włączeniu zasilania (też po ponownym podłączeniu
+// czujnika – I2cEmuDevice::power_on); źródło i statystyki zostają.
+void mpuEmuPowerOn(MpuEmu& m);
+
+// Próbki do chwili now_us (wywoływane przez zapis/odczyt).
+void mpuEmuAdvance(MpuEmu& m, uint64_t now_us);
+
+// Fs wynikające z bieżących rejestrów [Hz].
+float mpuEmuSampleRateHz(const MpuEmu& m);
+
+// Chwila następnego impulsu data-ready po after_us (siatka próbek);
+// 0 = czujnik nie próbkuje albo przerwanie jest wyłączone.
+uint64_t mpuEmuNextDataReady(const MpuEmu& m, uint64_t after_us);
+
+// Transakcje magistrali; false = NACK (czujnik w trakcie resetu).
+bool mpuEmuWrite(MpuEmu& m, const uint8_t* data, size_t n, uint64_t now_us);
+bool mpuEmuRead(MpuEmu& m, uint8_t* out, size_t n, uint64_t now_us);
+
+// Czujnik pod adresem addr (0x68 / 0x69) do podłączenia w I2cEmuBus.
+I2cEmuDevice mpuEmuDevice(MpuEmu& m, uint8_t addr);
@@ -0,0 +1,92 @@
+#include "tca9548a_emu.h"
+
+bool tca9548aEmuAttach(Tca9548aEmu& m, uint8_t ch, const I2cEmuDevice& dev) {
+  if (m.n_dev >= TCA_EMU_MAX_DEVICES || ch >= 8) return false;
+  m.dev[m.n_dev] = dev;
+  m.ch[m.n_dev] = ch;
+  m.n_dev++;
+  return true;
+}
+
+static bool tcaWrite(void* ctx, const uint8_t* data, size_t n, uint64_t) {
+  Tca9548aEmu& m = *(Tca9548aEmu*)ctx;
+  if (n > 0) {
+    m.ctrl = data[n - 1];
+    m.selects++;
+  }
+  return true;
+}
+
+static bool tcaRead(void* ctx, uint8_t* out, size_t n, uint64_t) {
+  const Tca9548aEmu& m = *(const Tca9548aEmu*)ctx;
+  for (size_t i = 0; i < n; i++) out[i] = m.ctrl;
+  return true;
+}
+
+// Wyłączenie zasilania dotyczy całej gałęzi: multiplekser i urządzenia za nim.
+static void tcaPowerOn(void* ctx, uint64_t now_us) {
+  Tca9548aEmu& m = *(Tca9548aEmu*)ctx;
+  m.ctrl = 0;
+  for (size_t i = 0; i < m.n_dev; i++) {
+    if (m.dev[i].power_on) m.dev[i].power_on(m.dev[i].ctx, now_us);
+  }
+}
+
+static bool proxyWrite(void* ctx, const uint8_t* data, size_t n, uint64_t now_us) {
+  const Tca9548aEmuProxy& p = *(const Tca9548aEmuProxy*)ctx;
+  const Tca9548aEmu& m = *p.mux;
+  bool ack = false;
+  for (size_t i = 0; i < m.n_dev; i++) {
+    if (m.dev[i].addr != p.addr || !(m.ctrl & (1u << m.ch[i]))) continue;
+    ack |= m.dev[i].write(m.dev[i].ctx, data, n, now_us);
+  }
+  return ack;
+}
+
+static bool proxyRead(void* ctx, uint8_t* out, size_t n, uint64_t now_us) {
+  const Tca9548aEmuProxy& p = *(const Tca9548aEmuProxy*)ctx;
+  const Tca9548aEmu& m = *p.mux;
+  for (size_t i = 0; i < m.n_dev; i++) {
+    if (m.dev[i].addr != p.addr || !(m.ctrl & (1u << m.ch[i]))) continue;
+    return m.dev[i].read(m.dev[i].ctx, out, n, now_us);
+  }
+  return false;
+}
+
+// Odłączenie adresu (usterka DETACH) – ponowne zasilenie urządzeń tego adresu.
+static void proxyPowerOn(void* ctx, uint64_t now_us) {
+  const Tca9548aEmuProxy& p = *(const Tca9548aEmuProxy*)ctx;
+  const Tca9548aEmu& m = *p.mux;
+  for (size_t i = 0; i < m.n_dev; i++) {
+    if (m.dev[i].addr == p.addr && m.dev[i].power_on) m.dev[i].power_on(m.dev[i].ctx, now_us);
+  }
+}
+
+bool tca9548aEmuConnect(Tca9548aEmu& m, I2cEmuBus& bus, uint8_t addr) {
+  I2cEmuDevice d;
+  d.ctx = &m;
+  d.addr = addr;
+  d.write = tcaWrite;
+  d.read = tcaRead;
+  d.power_on = tcaPowerOn;
+  if (!i2cEmuAttach(bus, d)) return false;
+
+  for (size_t i = 0; i < m.n_dev; i++) {
+    bool known = false;
+    for (size_t k = 0; k < m.n_proxy; k++) known |= m.proxy[k].addr == m.dev[i].addr;
+    if (known) continue;
+    if (m.n_proxy >= TCA_EMU_MAX_PROXIES) return false;
+    Tca9548aEmuProxy& p = m.proxy[m.n_proxy++];
+    p.mux = &m;
+    p.addr = m.dev[i].addr;
+
+    I2cEmuDevice pd;
+    pd.ctx = &p;
+    pd.addr = p.addr;
+    pd.write = proxyWrite;
+    pd.read = proxyRead;
+    pd.power_on = proxyPowerOn;
+    if (!i2cEmuAttach(bus, pd)) return false;
+  }
+  return true;
+}
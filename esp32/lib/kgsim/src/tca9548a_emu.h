@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i2c_emu.h"
+
+/*
+  KneeGuard – emulator multipleksera TCA9548A (host: testy i fwsim)
+
+  Rejestr sterujący (jeden bajt, zapis i odczyt pod adresem multipleksera):
+  bit k = kanał k połączony z magistralą; po włączeniu zasilania 0 (wszystkie
+  odłączone). Urządzenia za kanałami są widoczne na magistrali przez
+  pośredników (tca9548aEmuProxy) – po jednym na adres: transakcja trafia do
+  urządzeń tego adresu na włączonych kanałach, bez żadnego – NACK. Kilka
+  włączonych kanałów z tym samym adresem: zapis do wszystkich, odczyt
+  z pierwszego (w sprzęcie – kolizja na linii).
+*/
+
+static const size_t TCA_EMU_MAX_DEVICES = 16;
+static const size_t TCA_EMU_MAX_PROXIES = 4;
+
+struct Tca9548aEmu;
+
+struct Tca9548aEmuProxy {
+  Tca9548aEmu* mux  = nullptr;
+  uint8_t      addr = 0;
+};
+
+struct Tca9548aEmu {
+  uint8_t      ctrl = 0;
+  I2cEmuDevice dev[TCA_EMU_MAX_DEVICES];
+  uint8_t      ch[TCA_EMU_MAX_DEVICES];
+  size_t       n_dev = 0;
+  Tca9548aEmuProxy proxy[TCA_EMU_MAX_PROXIES];
+  size_t           n_proxy = 0;
+
+  // statystyki
+  uint32_t selects = 0; // zapisy rejestru sterującego
+};
+
+// Urządzenie za kanałem ch (0..7).
+bool tca9548aEmuAttach(Tca9548aEmu& m, uint8_t ch, const I2cEmuDevice& dev);
+
+// Podłączenie do magistrali: multiplekser pod adresem addr + pośrednik na
+// każdy adres urządzeń za kanałami (wywołać po tca9548aEmuAttach).
+bool tca9548aEmuConnect(Tca9548aEmu& m, I2cEmuBus& bus, uint8_t addr);
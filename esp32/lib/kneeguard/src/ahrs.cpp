@@ -0,0 +1,90 @@
+#include "ahrs.h"
+
+void madgwickUpdateImu(Quat& q, float gx, float gy, float gz,
+                       float ax, float ay, float az, float beta, float dt) {
+  const float q0 = q.w, q1 = q.x, q2 = q.y, q3 = q.z;
+
+  // pochodna kwaternionu z żyroskopu
+  float qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  float qDot1 = 0.5f * ( q0 * gx + q2 * gz - q3 * gy);
+  float qDot2 = 0.5f * ( q0 * gy - q1 * gz + q3 * gx);
+  float qDot3 = 0.5f * ( q0 * gz + q1 * gy - q2 * gx);
+
+  // korekcja z akcelerometru (pomijana przy zerowym wektorze)
+  const float an2 = ax * ax + ay * ay + az * az;
+  if (an2 > 0.0f) {
+    const float ra = kgInvSqrt(an2);
+    ax *= ra;
+    ay *= ra;
+    az *= ra;
+
+    const float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+    const float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+    const float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+    const float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+    float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+    const float sn2 = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (sn2 > 0.0f) {
+      const float rs = beta * kgInvSqrt(sn2);
+      qDot0 -= rs * s0;
+      qDot1 -= rs * s1;
+      qDot2 -= rs * s2;
+      qDot3 -= rs * s3;
+    }
+  }
+
+  q.w = q0 + qDot0 * dt;
+  q.x = q1 + qDot1 * dt;
+  q.y = q2 + qDot2 * dt;
+  q.z = q3 + qDot3 * dt;
+  quatNormalize(q);
+}
+
+void mahonyUpdateImu(Quat& q, MahonyState& st, float gx, float gy, float gz,
+                     float ax, float ay, float az, float kp, float ki, float dt) {
+  const float an2 = ax * ax + ay * ay + az * az;
+  if (an2 > 0.0f) {
+    const float ra = kgInvSqrt(an2);
+    ax *= ra;
+    ay *= ra;
+    az *= ra;
+
+    // kierunek grawitacji przewidziany z orientacji (połowa wartości)
+    const float hvx = q.x * q.z - q.w * q.y;
+    const float hvy = q.w * q.x + q.y * q.z;
+    const float hvz = q.w * q.w - 0.5f + q.z * q.z;
+
+    // błąd = pomiar x przewidywanie
+    const float hex = ay * hvz - az * hvy;
+    const float hey = az * hvx - ax * hvz;
+    const float hez = ax * hvy - ay * hvx;
+
+    if (ki > 0.0f) {
+      st.ix += 2.0f * ki * hex * dt;
+      st.iy += 2.0f * ki * hey * dt;
+      st.iz += 2.0f * ki * hez * dt;
+      gx += st.ix;
+      gy += st.iy;
+      gz += st.iz;
+    }
+
+    gx += 2.0f * kp * hex;
+    gy += 2.0f * kp * hey;
+    gz += 2.0f * kp * hez;
+  }
+
+  gx *= 0.5f * dt;
+  gy *= 0.5f * dt;
+  gz *= 0.5f * dt;
+  const float qa = q.w, qb = q.x, qc = q.y;
+  q.w += -qb * gx - qc * gy - q.z * gz;
+  q.x +=  qa * gx + qc * gz - q.z * gy;
+  q.y +=  qa * gy - qb * gz + q.z * gx;
+  q.z +=  qa * gz + qb * gy - qc * gx;
+  quatNormalize(q);
+}
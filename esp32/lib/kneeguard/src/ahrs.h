@@ -0,0 +1,26 @@
+#pragma once
+
+#include "quaternion.h"
+
+/*
+  KneeGuard – fuzja 6-DoF na kwaternionach (alternatywa dla Kalman1D)
+
+  - Madgwick: krok gradientowy w kierunku grawitacji, wzmocnienie beta,
+  - Mahony: sprzężenie PI błędu grawitacji (Kp, Ki) do prędkości kątowej.
+  Obie metody: żyroskop [rad/s], akcelerometr w dowolnych jednostkach
+  (normalizowany), bez funkcji trygonometrycznych w kroku aktualizacji.
+*/
+
+static const float MADGWICK_BETA = 0.1f;
+static const float MAHONY_KP     = 1.0f;
+static const float MAHONY_KI     = 0.0f;
+
+struct MahonyState {
+  float ix = 0, iy = 0, iz = 0; // całka błędu (człon I)
+};
+
+void madgwickUpdateImu(Quat& q, float gx, float gy, float gz,
+                       float ax, float ay, float az, float beta, float dt);
+
+void mahonyUpdateImu(Quat& q, MahonyState& st, float gx, float gy, float gz,
+                     float ax, float ay, float az, float kp, float ki, float dt);
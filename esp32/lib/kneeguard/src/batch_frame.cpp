@@ -0,0 +1,133 @@
+#include "batch_frame.h"
+
+#include <string.h>
+
+#include "le_bytes.h"
+
+void batcherInit(TelemetryBatcher& b, uint8_t k, uint32_t max_latency_us, bool delta) {
+  if (k < 1) k = 1;
+  if (k > BATCH_K_MAX) k = BATCH_K_MAX;
+  b.k = k;
+  b.max_latency_us = max_latency_us;
+  b.delta = delta;
+  b.count = 0;
+  b.used = 0;
+  deltaCodecInit(b.codec, BATCH_DELTA_KEYFRAME);
+}
+
+static size_t flushDelta(TelemetryBatcher& b, uint8_t* out) {
+  uint8_t* p = b.buf;
+  p[0] = BATCH_SYNC0;
+  p[1] = BATCH_DELTA_SYNC1;
+  putLe16(p + 2, b.seq++);
+  putLe16(p + 4, b.used);
+  p[6] = b.count;
+  p[7] = BATCH_VERSION;
+  const size_t len = BATCH_DELTA_HEADER_LEN + b.used + 2;
+  putLe16(p + len - 2, crc16Ccitt(p + 2, len - 4));
+  memcpy(out, p, len);
+  b.count = 0;
+  b.used = 0;
+  return len;
+}
+
+size_t batcherFlush(TelemetryBatcher& b, uint8_t* out) {
+  if (b.count == 0) return 0;
+  if (b.delta) return flushDelta(b, out);
+  uint8_t* p = b.buf;
+  p[0] = BATCH_SYNC0;
+  p[1] = BATCH_SYNC1;
+  putLe16(p + 2, b.seq++);
+  p[12] = b.count;
+  p[13] = BATCH_VERSION;
+  const size_t len = batchFrameLen(b.count);
+  putLe16(p + len - 2, crc16Ccitt(p + 2, len - 4));
+  memcpy(out, p, len);
+  b.count = 0;
+  return len;
+}
+
+size_t batcherPush(TelemetryBatcher& b, const KneeSample& s, uint32_t now_us, uint8_t* out) {
+  if (b.delta) {
+    if (b.count == 0) b.first_push_us = now_us;
+    b.used = (uint16_t)(b.used + deltaEncode(b.codec, s, b.buf + BATCH_DELTA_HEADER_LEN + b.used));
+    return ++b.count >= b.k ? flushDelta(b, out) : 0;
+  }
+
+  // przyrost czasu poza uint16 (przerwa w strumieniu) -> bieżąca paczka wychodzi od razu
+  size_t n = 0;
+  if (b.count > 0 && s.t_us - b.last_t_us > 0xFFFFu) n = batcherFlush(b, out);
+
+  if (b.count == 0) {
+    putLe64(b.buf + 4, s.t_us);
+    b.first_push_us = now_us;
+  }
+  uint8_t* rec = b.buf + BATCH_HEADER_LEN + (size_t)b.count * BIN_RECORD_LEN;
+  binEncodeRecord(rec, (uint16_t)(b.count == 0 ? 0 : s.t_us - b.last_t_us), s);
+  b.last_t_us = s.t_us;
+  b.count++;
+
+  // k >= 2, gdy powyżej zamknięto paczkę – nowa ma 1 próbkę, więc nie jest pełna
+  if (n == 0 && b.count >= b.k) n = batcherFlush(b, out);
+  return n;
+}
+
+size_t batcherPoll(TelemetryBatcher& b, uint32_t now_us, uint8_t* out) {
+  if (b.count == 0 || now_us - b.first_push_us < b.max_latency_us) return 0;
+  b.latency_flushes++;
+  return batcherFlush(b, out);
+}
+
+size_t decodeBatchFrame(const uint8_t* in, size_t len, uint16_t& seq, KneeSample* out, size_t max) {
+  if (len < batchFrameLen(1) || in[0] != BATCH_SYNC0 || in[1] != BATCH_SYNC1) return 0;
+  const uint8_t count = in[12];
+  if (count == 0 || count > BATCH_K_MAX || in[13] != BATCH_VERSION) return 0;
+  const size_t flen = batchFrameLen(count);
+  if (len < flen) return 0;
+  if (crc16Ccitt(in + 2, flen - 4) != getLe16(in + flen - 2)) return 0;
+
+  seq = getLe16(in + 2);
+  uint64_t t = getLe64(in + 4);
+  const size_t n = count < max ? count : max;
+  for (size_t i = 0; i < n; i++) {
+    t += binDecodeRecord(in + BATCH_HEADER_LEN + i * BIN_RECORD_LEN, out[i]);
+    out[i].t_us = t;
+  }
+  return n;
+}
+
+size_t decodeDeltaFrame(DeltaFrameDecoder& d, const uint8_t* in, size_t len, uint16_t& seq,
+                        KneeSample* out, size_t max) {
+  if (len < BATCH_DELTA_HEADER_LEN + 2 || in[0] != BATCH_SYNC0 || in[1] != BATCH_DELTA_SYNC1) return 0;
+  const uint16_t plen = getLe16(in + 4);
+  const uint8_t count = in[6];
+  if (count == 0 || count > BATCH_K_MAX || in[7] != BATCH_VERSION) return 0;
+  const size_t flen = BATCH_DELTA_HEADER_LEN + plen + 2;
+  if (plen > BATCH_DELTA_FRAME_MAX || len < flen) return 0;
+  if (crc16Ccitt(in + 2, flen - 4) != getLe16(in + flen - 2)) return 0;
+
+  seq = getLe16(in + 2);
+  if (d.has_seq && seq != d.next_seq) {
+    d.lost_frames += (uint16_t)(seq - d.next_seq);
+    deltaCodecResync(d.codec);
+  }
+  d.has_seq = true;
+  d.next_seq = (uint16_t)(seq + 1);
+
+  const uint8_t* p = in + BATCH_DELTA_HEADER_LEN;
+  const uint8_t* end = p + plen;
+  size_t n = 0;
+  // wszystkie rekordy przechodzą przez dekoder (stan dla kolejnej paczki), do out najwyżej max
+  for (uint8_t i = 0; i < count; i++) {
+    KneeSample s;
+    bool have = false;
+    const size_t m = deltaDecode(d.codec, p, (size_t)(end - p), s, have);
+    if (m == 0) { // niespójna paczka mimo CRC – dalsze przyrosty byłyby błędne
+      deltaCodecResync(d.codec);
+      break;
+    }
+    p += m;
+    if (have && n < max) out[n++] = s;
+  }
+  return n;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "binary_frame.h"
+#include "delta_codec.h"
+#include "fusion.h"
+
+/*
+  KneeGuard – paczka K próbek w jednym zapisie BT (format "batch")
+
+  Każdy BT.write() ma stały narzut stosu SPP/RFCOMM i budzi radio, więc przy
+  200..500 Hz pojedyncze ramki ograniczają przepływność. Paczka niesie bazę
+  czasu i przyrosty, więc koszt próbki to 17 B zamiast 29 B ramki.
+
+  Układ paczki (little-endian, BATCH_HEADER_LEN + count * 17 + 2 B):
+    [0..1]   sync 0xAA 0x5A (ramka pojedyncza: 0xAA 0x55)
+    [2..3]   seq    uint16 – numer kolejny paczki
+    [4..11]  t0_us  uint64 – czas pierwszej próbki
+    [12]     count  – liczba próbek (1..BATCH_K_MAX)
+    [13]     wersja formatu (BATCH_VERSION)
+    [14..]   count x rekord BIN_RECORD_LEN (dt_us od poprzedniej próbki, kąty, flagi)
+    [koniec-2..] CRC-16/CCITT-FALSE z bajtów [2..koniec-2)
+
+  Paczka skompresowana (format "delta", delta_codec.h), BATCH_DELTA_HEADER_LEN + len + 2 B:
+    [0..1]   sync 0xAA 0x5D
+    [2..3]   seq    uint16
+    [4..5]   len    uint16 – długość rekordów
+    [6]      count  – liczba próbek (1..BATCH_K_MAX)
+    [7]      wersja formatu (BATCH_VERSION)
+    [8..]    count x rekord delta_codec (zmienna długość)
+    [koniec-2..] CRC-16/CCITT-FALSE z bajtów [2..koniec-2)
+  Stan kodera przechodzi między paczkami (czas i kąty są w rekordach), a klatka
+  kluczowa co BATCH_DELTA_KEYFRAME próbek pozwala odbiorcy wznowić po utracie
+  paczki (luka w seq -> rekordy przyrostowe pomijane do klatki).
+
+  TelemetryBatcher zamyka paczkę, gdy:
+  - ma K próbek,
+  - najstarsza próbka czeka max_latency_us (batcherPoll – sufit opóźnienia),
+  - przyrost czasu nie mieści się w uint16 (próbka otwiera nową paczkę; tylko
+    paczki nieskompresowane).
+*/
+
+static const uint8_t BATCH_SYNC0   = 0xAA;
+static const uint8_t BATCH_SYNC1   = 0x5A;
+static const uint8_t BATCH_DELTA_SYNC1 = 0x5D;
+static const uint8_t BATCH_VERSION = 2; // 1: t0_us uint32
+static const uint8_t BATCH_K_MAX   = 32;
+
+static const size_t BATCH_HEADER_LEN = 14;
+static const size_t BATCH_FRAME_MAX  = BATCH_HEADER_LEN + BATCH_K_MAX * BIN_RECORD_LEN + 2;
+
+static const size_t   BATCH_DELTA_HEADER_LEN = 8;
+static const size_t   BATCH_DELTA_FRAME_MAX  = BATCH_DELTA_HEADER_LEN + BATCH_K_MAX * DELTA_SAMPLE_MAX + 2;
+static const uint16_t BATCH_DELTA_KEYFRAME   = 50; // próbek między klatkami kluczowymi
+
+// Bufor wyjściowy wystarczający dla obu rodzajów paczek.
+static const size_t BATCH_OUT_MAX = BATCH_DELTA_FRAME_MAX > BATCH_FRAME_MAX ? BATCH_DELTA_FRAME_MAX : BATCH_FRAME_MAX;
+
+static inline size_t batchFrameLen(uint8_t count) {
+  return BATCH_HEADER_LEN + (size_t)count * BIN_RECORD_LEN + 2;
+}
+
+struct TelemetryBatcher {
+  uint8_t  k              = 1;
+  uint32_t max_latency_us = 0;
+  bool     delta          = false; // paczki skompresowane (0xAA 0x5D)
+
+  uint8_t  count         = 0;
+  uint16_t seq           = 0;
+  uint16_t used          = 0; // tryb delta: bajty rekordów w paczce
+  uint64_t last_t_us     = 0; // t_us ostatniej próbki w paczce
+  uint32_t first_push_us = 0; // zegar nadawcy przy pierwszej próbce (sufit opóźnienia)
+  DeltaCodec codec;
+  uint8_t  buf[BATCH_OUT_MAX];
+
+  uint32_t latency_flushes = 0; // paczki zamknięte przez sufit opóźnienia
+};
+
+// K próbek na paczkę (1..BATCH_K_MAX), sufit opóźnienia i kompresja; bieżąca
+// paczka jest odrzucana, a kolejna próbka w trybie delta jest klatką kluczową.
+void batcherInit(TelemetryBatcher& b, uint8_t k, uint32_t max_latency_us, bool delta = false);
+
+// Dodanie próbki (now_us – zegar nadawcy). Zwraca długość zamkniętej paczki
+// zapisanej do out (co najmniej BATCH_OUT_MAX B) albo 0.
+size_t batcherPush(TelemetryBatcher& b, const KneeSample& s, uint32_t now_us, uint8_t* out);
+
+// Sufit opóźnienia: zamyka niepełną paczkę, gdy najstarsza próbka czeka >= max_latency_us.
+size_t batcherPoll(TelemetryBatcher& b, uint32_t now_us, uint8_t* out);
+
+// Zamknięcie niepełnej paczki bez względu na czas (0, gdy pusta).
+size_t batcherFlush(TelemetryBatcher& b, uint8_t* out);
+
+// Dekodowanie kompletnej paczki (sync, długość, wersja, CRC); zwraca liczbę
+// próbek zapisanych do out (najwyżej max) albo 0, gdy paczka jest błędna.
+size_t decodeBatchFrame(const uint8_t* in, size_t len, uint16_t& seq, KneeSample* out, size_t max);
+
+// Odbiorca paczek skompresowanych: stan dekodera przechodzi między paczkami.
+struct DeltaFrameDecoder {
+  DeltaCodec codec;
+  uint16_t   next_seq    = 0;
+  bool       has_seq     = false;
+  uint32_t   lost_frames = 0; // paczki brakujące wg seq (każda luka wymusza resync)
+};
+
+static inline void deltaFrameDecoderInit(DeltaFrameDecoder& d) { d = DeltaFrameDecoder(); }
+
+// Dekodowanie paczki 0xAA 0x5D (sync, długość, wersja, CRC); zwraca liczbę
+// odtworzonych próbek (najwyżej max). Próbki przed pierwszą klatką kluczową
+// po luce w seq są pomijane (d.codec.skipped).
+size_t decodeDeltaFrame(DeltaFrameDecoder& d, const uint8_t* in, size_t len, uint16_t& seq,
+                        KneeSample* out, size_t max);
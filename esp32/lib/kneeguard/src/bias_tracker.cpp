@@ -0,0 +1,78 @@
+#include "bias_tracker.h"
+
+#include <math.h>
+
+static inline void clearWindow(BiasTracker& t) {
+  t.n = 0;
+  t.t_s = 0;
+  for (int i = 0; i < 3; i++) t.sg[i] = t.sg2[i] = 0;
+  t.sa = t.sa2 = 0;
+}
+
+void biasTrackerReset(BiasTracker& t, float std_dps) {
+  clearWindow(t);
+  t.var = std_dps * std_dps;
+  t.since_update_s = 0;
+}
+
+bool biasTrackerPush(BiasTracker& t, float rgx, float rgy, float rgz,
+                     float ax, float ay, float az, float dt, float corr[3]) {
+  const float r[3] = {rgx, rgy, rgz};
+  for (int i = 0; i < 3; i++) {
+    t.sg[i]  += r[i];
+    t.sg2[i] += r[i] * r[i];
+  }
+  const float a2 = ax * ax + ay * ay + az * az - 1.0f; // względem 1 g: bez utraty precyzji float
+  t.sa  += a2;
+  t.sa2 += a2 * a2;
+  t.n++;
+  t.t_s += dt;
+  t.since_update_s += dt;
+  if (t.t_s < BIAS_WIN_S || t.n < 2) return false;
+
+  // koniec okna: estymata starzeje się o jego długość (dryf termiczny)
+  const float inv_n = 1.0f / (float)t.n;
+  const float win_s = t.t_s;
+  t.var += BIAS_DRIFT_Q * win_s;
+  if (t.var > BIAS_VAR_MAX) t.var = BIAS_VAR_MAX;
+  t.windows++;
+
+  float mean[3], meas_var = BIAS_MEAS_VAR_MIN;
+  bool still = true;
+  for (int i = 0; i < 3; i++) {
+    mean[i] = t.sg[i] * inv_n;
+    const float v = t.sg2[i] * inv_n - mean[i] * mean[i];
+    if (v > BIAS_STILL_GYRO_STD_DPS * BIAS_STILL_GYRO_STD_DPS) still = false;
+    if (v * inv_n > meas_var) meas_var = v * inv_n; // wariancja średniej okna
+  }
+  const float a2_mean = t.sa * inv_n;
+  const float a2_var  = t.sa2 * inv_n - a2_mean * a2_mean;
+  if (fabsf(a2_mean) > BIAS_STILL_ACC2_TOL || a2_var > BIAS_STILL_ACC2_STD * BIAS_STILL_ACC2_STD) {
+    still = false;
+  }
+  clearWindow(t);
+  t.still = still;
+  if (!still) return false;
+  t.still_windows++;
+
+  // bramka: 3 sigma niepewności, ale nie mniej niż BIAS_GATE_DPS
+  float gate2 = 9.0f * (t.var + meas_var);
+  if (gate2 < BIAS_GATE_DPS * BIAS_GATE_DPS) gate2 = BIAS_GATE_DPS * BIAS_GATE_DPS;
+  for (int i = 0; i < 3; i++) {
+    if (mean[i] * mean[i] > gate2) {
+      t.rejected++;
+      return false;
+    }
+  }
+
+  const float K = t.var / (t.var + meas_var);
+  for (int i = 0; i < 3; i++) corr[i] = K * mean[i];
+  t.var *= 1.0f - K;
+  t.updates++;
+  t.since_update_s = 0;
+  return true;
+}
+
+float biasTrackerStdDps(const BiasTracker& t) {
+  return sqrtf(t.var);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+  KneeGuard – śledzenie biasu żyroskopu w przerwach między powtórzeniami
+
+  Bias z kalibracji startowej dryfuje z temperaturą; yaw (integracja gz) i w
+  mniejszym stopniu roll/pitch tracą przez to dokładność w długiej sesji.
+  BiasTracker zbiera okna BIAS_WIN_S próbek jednego IMU (sumy i kwadraty
+  reszty żyroskopu po korekcji bias oraz |a|^2 – bez buforów i sqrt, O(1) na
+  próbkę) i na końcu okna wykrywa bezruch:
+  - wariancja każdej osi żyroskopu < BIAS_STILL_GYRO_STD_DPS^2,
+  - |a|^2 blisko 1 g^2 i stabilne (noga nie przyspiesza).
+  Średnia reszty z nieruchomego okna jest pomiarem błędu biasu dla skalarnego
+  filtra Kalmana: wariancja estymaty rośnie z czasem (BIAS_DRIFT_Q, dryf
+  termiczny) i maleje z każdym nieruchomym oknem. Reszta większa niż bramka
+  (powolny, jednostajny obrót) jest odrzucana.
+
+  Pewność estymaty: biasTrackerStdDps (odchylenie standardowe biasu w dps).
+*/
+
+static const float BIAS_WIN_S              = 0.25f;  // okno detekcji bezruchu
+static const float BIAS_STILL_GYRO_STD_DPS = 0.5f;
+static const float BIAS_STILL_ACC2_TOL     = 0.1f;   // | |a|^2 - 1 | (~±5% normy)
+static const float BIAS_STILL_ACC2_STD     = 0.05f;  // odch. std. |a|^2 (~0.025 g)
+static const float BIAS_GATE_DPS           = 2.0f;   // minimalna bramka reszty okna
+static const float BIAS_DRIFT_Q            = 4e-4f;  // (dps)^2/s: ~0.5 dps std po 10 min
+static const float BIAS_MEAS_VAR_MIN       = 0.0025f; // (dps)^2: resztkowy ruch w oknie
+static const float BIAS_VAR_INIT           = 1.0f;   // (dps)^2 bez kalibracji
+static const float BIAS_VAR_MAX            = 25.0f;
+
+struct BiasTracker {
+  bool enabled = true;
+
+  // bieżące okno (reszta żyroskopu = surowy - bias)
+  uint16_t n   = 0;
+  float    t_s = 0;
+  float    sg[3]  = {0, 0, 0};
+  float    sg2[3] = {0, 0, 0};
+  float    sa = 0, sa2 = 0; // suma (|a|^2 - 1) i jej kwadratów
+
+  // estymata: wariancja błędu biasu (wspólna dla osi) [dps^2]
+  float var = BIAS_VAR_INIT;
+
+  // statystyki
+  bool     still          = false; // ostatnie okno nieruchome
+  uint32_t windows        = 0;
+  uint32_t still_windows  = 0;
+  uint32_t rejected       = 0;     // nieruchome, ale reszta poza bramką
+  uint32_t updates        = 0;
+  float    since_update_s = 0;
+};
+
+// Nowa estymata z zewnątrz (kalibracja): okno od zera, wariancja std_dps^2.
+void biasTrackerReset(BiasTracker& t, float std_dps);
+
+// Reszta żyroskopu [dps] i akcelerometr [g] jednej próbki. true na końcu
+// nieruchomego okna – wtedy corr[3] to poprawka do dodania do biasu.
+bool biasTrackerPush(BiasTracker& t, float rgx, float rgy, float rgz,
+                     float ax, float ay, float az, float dt, float corr[3]);
+
+float biasTrackerStdDps(const BiasTracker& t);
+
+static inline float biasTrackerStillPct(const BiasTracker& t) {
+  return t.windows ? 100.0f * (float)t.still_windows / (float)t.windows : 0.0f;
+}
@@ -0,0 +1,136 @@
+#include "binary_frame.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "le_bytes.h"
+
+static const size_t BIN_ANGLES_OFFSET = 12;
+static const size_t BIN_FLAGS_OFFSET  = 26;
+static const size_t BIN_CRC_OFFSET    = BIN_FRAME_LEN - 2;
+
+// Tablica półbajtowa (16 x uint16) – 2 odczyty na bajt zamiast 8 przesunięć.
+static const uint16_t CRC16_NIBBLE[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t n, uint16_t crc) {
+  for (size_t i = 0; i < n; i++) {
+    crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+  }
+  return crc;
+}
+
+int16_t binEncodeAngle(float deg) {
+  // NaN/inf z rozbiegniętej fuzji nie może trafić do lrintf (wynik nieokreślony)
+  if (deg == ANGLE_INVALID || !isfinite(deg)) return BIN_ANGLE_INVALID;
+  const float v = deg * 100.0f;
+  if (v >= 32767.0f) return 32767;
+  if (v <= -32767.0f) return -32767; // -32768 zarezerwowane dla BIN_ANGLE_INVALID
+  const long r = lrintf(v);
+  return (int16_t)(r > 32767 ? 32767 : r < -32767 ? -32767 : r);
+}
+
+float binDecodeAngle(int16_t v) {
+  if (v == BIN_ANGLE_INVALID) return ANGLE_INVALID;
+  return v / 100.0f;
+}
+
+uint8_t binSampleFlags(const KneeSample& s) {
+  uint8_t flags = 0;
+  if (s.inv1) flags |= BIN_FLAG_INV1;
+  if (s.inv2) flags |= BIN_FLAG_INV2;
+  if (s.q1 == QUALITY_GYRO_ONLY) flags |= BIN_FLAG_GAP1;
+  if (s.q2 == QUALITY_GYRO_ONLY) flags |= BIN_FLAG_GAP2;
+  return flags;
+}
+
+void binApplyFlags(uint8_t flags, KneeSample& out) {
+  out.inv1 = (flags & BIN_FLAG_INV1) != 0;
+  out.inv2 = (flags & BIN_FLAG_INV2) != 0;
+  // brak danych IMU jest zakodowany w kątach (BIN_ANGLE_INVALID)
+  out.q1 = out.roll1 == ANGLE_INVALID ? QUALITY_INVALID
+         : (flags & BIN_FLAG_GAP1) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  out.q2 = out.roll2 == ANGLE_INVALID ? QUALITY_INVALID
+         : (flags & BIN_FLAG_GAP2) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+}
+
+void binEncodeRecord(uint8_t* p, uint16_t dt_us, const KneeSample& s) {
+  putLe16(p, dt_us);
+  const float angles[7] = {s.roll1, s.pitch1, s.yaw1, s.roll2, s.pitch2, s.yaw2, s.knee_angle};
+  for (int i = 0; i < 7; i++) putLe16(p + 2 + 2 * i, (uint16_t)binEncodeAngle(angles[i]));
+  p[16] = binSampleFlags(s);
+}
+
+uint16_t binDecodeRecord(const uint8_t* p, KneeSample& out) {
+  float* angles[7] = {&out.roll1, &out.pitch1, &out.yaw1, &out.roll2, &out.pitch2, &out.yaw2, &out.knee_angle};
+  for (int i = 0; i < 7; i++) *angles[i] = binDecodeAngle((int16_t)getLe16(p + 2 + 2 * i));
+  binApplyFlags(p[16], out);
+  return getLe16(p);
+}
+
+size_t encodeBinaryFrame(uint8_t* out, uint16_t seq, const KneeSample& s) {
+  out[0] = BIN_SYNC0;
+  out[1] = BIN_SYNC1;
+  putLe16(out + 2, seq);
+  putLe64(out + 4, s.t_us);
+
+  const float angles[7] = {s.roll1, s.pitch1, s.yaw1, s.roll2, s.pitch2, s.yaw2, s.knee_angle};
+  for (int i = 0; i < 7; i++) putLe16(out + BIN_ANGLES_OFFSET + 2 * i, (uint16_t)binEncodeAngle(angles[i]));
+
+  out[BIN_FLAGS_OFFSET] = (uint8_t)((BIN_VERSION << 4) | binSampleFlags(s));
+
+  putLe16(out + BIN_CRC_OFFSET, crc16Ccitt(out + 2, BIN_CRC_OFFSET - 2));
+  return BIN_FRAME_LEN;
+}
+
+bool decodeBinaryFrame(const uint8_t* in, uint16_t& seq, KneeSample& out) {
+  if (in[0] != BIN_SYNC0 || in[1] != BIN_SYNC1) return false;
+  if (crc16Ccitt(in + 2, BIN_CRC_OFFSET - 2) != getLe16(in + BIN_CRC_OFFSET)) return false;
+
+  const uint8_t flags = in[BIN_FLAGS_OFFSET];
+  if ((flags >> 4) != BIN_VERSION) return false;
+
+  seq = getLe16(in + 2);
+  out.t_us = getLe64(in + 4);
+
+  float* angles[7] = {&out.roll1, &out.pitch1, &out.yaw1, &out.roll2, &out.pitch2, &out.yaw2, &out.knee_angle};
+  for (int i = 0; i < 7; i++) *angles[i] = binDecodeAngle((int16_t)getLe16(in + BIN_ANGLES_OFFSET + 2 * i));
+
+  binApplyFlags(flags, out);
+  return true;
+}
+
+// Po błędnej ramce: przesunięcie bufora do następnego kandydata na sync.
+static void binParserResync(BinFrameParser& p) {
+  size_t i = 1;
+  while (i < p.len) {
+    if (p.buf[i] == BIN_SYNC0 && (i + 1 >= p.len || p.buf[i + 1] == BIN_SYNC1)) break;
+    i++;
+  }
+  memmove(p.buf, p.buf + i, p.len - i);
+  p.len -= i;
+}
+
+bool binFrameParserFeed(BinFrameParser& p, uint8_t byte, uint16_t& seq, KneeSample& out) {
+  if (p.len == 0 && byte != BIN_SYNC0) return false;
+  if (p.len == 1 && byte != BIN_SYNC1) {
+    p.len = (byte == BIN_SYNC0) ? 1 : 0;
+    return false;
+  }
+
+  p.buf[p.len++] = byte;
+  if (p.len < BIN_FRAME_LEN) return false;
+
+  if (decodeBinaryFrame(p.buf, seq, out)) {
+    p.len = 0;
+    p.frames_ok++;
+    return true;
+  }
+
+  p.crc_errors++;
+  binParserResync(p);
+  return false;
+}
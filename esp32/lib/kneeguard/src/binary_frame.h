@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+
+/*
+  KneeGuard – binarna ramka telemetrii (alternatywa dla CSV przez BT)
+
+  Układ ramki (little-endian, 29 B):
+    [0..1]   sync 0xAA 0x55
+    [2..3]   seq    uint16 – numer kolejny ramki (odbiorca rozwija do 64 bit, stream_decoder.h)
+    [4..11]  t_us   uint64 – monotoniczny znacznik czasu
+    [12..25] 7 x int16 kątów w 0.01° (roll1, pitch1, yaw1, roll2, pitch2, yaw2, knee)
+             BIN_ANGLE_INVALID (INT16_MIN) = odczyt IMU nieudany (-999 w CSV)
+    [26]     flags: bit0 inv1, bit1 inv2, bit2/bit3 IMU1/IMU2 wypełnione żyroskopem
+             (QUALITY_GYRO_ONLY), bity 4..7 = wersja formatu
+    [27..28] CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) z bajtów [2..26]
+
+  Wersja 1 (25 B, t_us uint32) nie jest już wysyłana; dekoder ją odrzuca.
+
+  Ramka jest samodzielna (pełny czas 64-bit, własne CRC), więc zgubienie jednej nie
+  psuje czasu następnych – za cenę rozmiaru: ~2.3x mniej niż linia CSV (~67 B), a nie
+  ~4x. Drogą do ~4x i więcej są paczki "batch" (~18.6 B/próbkę, batch_frame.h) i
+  "delta" (~10 B/próbkę, delta_codec.h), które płacą za czas raz na paczkę.
+*/
+
+static const uint8_t BIN_SYNC0 = 0xAA;
+static const uint8_t BIN_SYNC1 = 0x55;
+
+static const uint8_t BIN_VERSION = 2;
+static const size_t  BIN_FRAME_LEN = 29;
+
+static const uint8_t BIN_FLAG_INV1 = 0x01;
+static const uint8_t BIN_FLAG_INV2 = 0x02;
+static const uint8_t BIN_FLAG_GAP1 = 0x04;
+static const uint8_t BIN_FLAG_GAP2 = 0x08;
+
+static const int16_t BIN_ANGLE_INVALID = -32768;
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t n, uint16_t crc = 0xFFFF);
+
+// Kąt [deg] -> int16 w 0.01° (z nasyceniem); ANGLE_INVALID, NaN i inf -> BIN_ANGLE_INVALID.
+int16_t binEncodeAngle(float deg);
+float binDecodeAngle(int16_t v);
+
+// Bity 0..3 flag (inv, gyro-only) z próbki i z powrotem; jakość QUALITY_INVALID
+// wynika z kątów, więc binApplyFlags wywołuje się po ich zdekodowaniu.
+uint8_t binSampleFlags(const KneeSample& s);
+void binApplyFlags(uint8_t flags, KneeSample& out);
+
+// Rekord próbki o stałej długości (dziennik sesji, paczki BT):
+//   [0..1] dt_us uint16 – przyrost czasu od poprzedniej próbki (pierwsza: 0)
+//   [2..15] 7 x int16 kątów w 0.01° (kolejność jak w ramce), [16] flagi (bity 0..3)
+static const size_t BIN_RECORD_LEN = 17;
+
+void binEncodeRecord(uint8_t* p, uint16_t dt_us, const KneeSample& s);
+// Zwraca dt_us; t_us próbki ustawia wywołujący (baza + suma przyrostów).
+uint16_t binDecodeRecord(const uint8_t* p, KneeSample& out);
+
+// Zapis ramki do out (co najmniej BIN_FRAME_LEN bajtów); zwraca BIN_FRAME_LEN.
+size_t encodeBinaryFrame(uint8_t* out, uint16_t seq, const KneeSample& s);
+
+// Dekodowanie kompletnej ramki (sync + CRC + wersja); false, gdy ramka jest błędna.
+bool decodeBinaryFrame(const uint8_t* in, uint16_t& seq, KneeSample& out);
+
+// Strumieniowy parser (odbiornik): szuka sync, składa ramkę, sprawdza CRC.
+struct BinFrameParser {
+  uint8_t  buf[BIN_FRAME_LEN];
+  size_t   len = 0;
+  uint32_t frames_ok  = 0;
+  uint32_t crc_errors = 0;
+};
+
+// Podaje jeden bajt; true, gdy właśnie zdekodowano poprawną ramkę.
+bool binFrameParserFeed(BinFrameParser& p, uint8_t byte, uint16_t& seq, KneeSample& out);
@@ -0,0 +1,38 @@
+#include "bus_recovery.h"
+
+bool linkOnFailure(BusLink& l, uint32_t now_us) {
+  if (l.fails == 0) {
+    l.down_since_us = now_us;
+    l.backoff_us = BUS_BACKOFF_MIN_US;
+    l.attempts = 0;
+  }
+  if (l.fails < 0xFFFF) l.fails++;
+  if (l.fails < BUS_FAILS_BEFORE_RECOVERY) return false;
+
+  // pierwsza próba od razu po progu, kolejne po backoff (różnica odporna na zawinięcie)
+  if (l.attempts > 0 && (int32_t)(now_us - l.next_attempt_us) < 0) return false;
+
+  l.attempts++;
+  l.recover_attempts++;
+  l.next_attempt_us = now_us + l.backoff_us;
+  l.backoff_us = (l.backoff_us >= BUS_BACKOFF_MAX_US / 2) ? BUS_BACKOFF_MAX_US : l.backoff_us * 2;
+  return true;
+}
+
+bool linkOnSuccess(BusLink& l, uint32_t now_us) {
+  if (l.fails == 0) return false;
+  l.last_recover_us = now_us - l.down_since_us;
+  if (l.last_recover_us > l.max_recover_us) l.max_recover_us = l.last_recover_us;
+  l.outages++;
+  l.fails = 0;
+  l.attempts = 0;
+  l.backoff_us = BUS_BACKOFF_MIN_US;
+  return true;
+}
+
+void linkResetStats(BusLink& l) {
+  l.outages = 0;
+  l.recover_attempts = 0;
+  l.last_recover_us = 0;
+  l.max_recover_us = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+  KneeGuard – odzyskiwanie łącza I2C z czujnikiem (logika bez Arduino)
+
+  Każde IMU ma własny BusLink. Akwizycja zgłasza wynik każdego odczytu:
+  - linkOnFailure: po BUS_FAILS_BEFORE_RECOVERY kolejnych błędach zwraca true
+    = teraz wykonaj odzyskiwanie (impulsy SCL + STOP, Wire od nowa, reset czujnika);
+    kolejne próby co backoff_us, podwajany od BUS_BACKOFF_MIN_US do
+    BUS_BACKOFF_MAX_US (magistrala nie jest resetowana w kółko),
+  - linkOnSuccess: kończy awarię i zapisuje czas do odzyskania
+    (od pierwszego błędu do pierwszego poprawnego odczytu).
+  Czasy w us z micros() – arytmetyka odporna na przepełnienie uint32.
+*/
+
+static const uint16_t BUS_FAILS_BEFORE_RECOVERY = 3;
+static const uint32_t BUS_BACKOFF_MIN_US = 20000;   // pierwsza ponowna próba po 20 ms
+static const uint32_t BUS_BACKOFF_MAX_US = 1000000; // potem najwyżej co 1 s
+
+struct BusLink {
+  uint16_t fails            = 0; // kolejne nieudane odczyty (0 = łącze sprawne)
+  uint32_t down_since_us    = 0; // czas pierwszego błędu bieżącej awarii
+  uint32_t next_attempt_us  = 0; // najwcześniejsza kolejna próba odzyskania
+  uint32_t backoff_us       = BUS_BACKOFF_MIN_US;
+  uint16_t attempts         = 0; // próby odzyskania w bieżącej awarii
+
+  // statystyki (komenda "stats")
+  uint32_t outages          = 0; // awarie zakończone sukcesem
+  uint32_t recover_attempts = 0; // wszystkie próby odzyskania
+  uint32_t last_recover_us  = 0; // czas do odzyskania ostatniej awarii
+  uint32_t max_recover_us   = 0;
+};
+
+static inline bool linkDown(const BusLink& l) { return l.fails > 0; }
+
+// Nieudany odczyt; true, gdy należy teraz wykonać odzyskiwanie magistrali.
+bool linkOnFailure(BusLink& l, uint32_t now_us);
+
+// Poprawny odczyt; true, gdy zakończył awarię (last_recover_us jest aktualny).
+bool linkOnSuccess(BusLink& l, uint32_t now_us);
+
+// Zerowanie statystyk (stan bieżącej awarii pozostaje).
+void linkResetStats(BusLink& l);
@@ -0,0 +1,145 @@
+#include "calib_store.h"
+
+#include <math.h>
+
+#include "binary_frame.h"
+#include "le_bytes.h"
+
+static inline void welford(uint32_t n, float x, float& mean, float& m2) {
+  const float d = x - mean;
+  mean += d / (float)n;
+  m2 += d * (x - mean);
+}
+
+void gyroCalibPush(GyroCalib& c, const MpuSample& s) {
+  c.n++;
+  welford(c.n, s.gx, c.g_mean[0], c.g_m2[0]);
+  welford(c.n, s.gy, c.g_mean[1], c.g_m2[1]);
+  welford(c.n, s.gz, c.g_mean[2], c.g_m2[2]);
+  welford(c.n, sqrtf(s.ax * s.ax + s.ay * s.ay + s.az * s.az), c.a_mean, c.a_m2);
+}
+
+float gyroCalibGyroStd(const GyroCalib& c, int axis) {
+  return c.n < 2 ? 0.0f : sqrtf(c.g_m2[axis] / (float)(c.n - 1));
+}
+
+float gyroCalibAccStd(const GyroCalib& c) {
+  return c.n < 2 ? 0.0f : sqrtf(c.a_m2 / (float)(c.n - 1));
+}
+
+bool gyroCalibStill(const GyroCalib& c) {
+  if (c.n < CAL_CHECK_SAMPLES / 2) return false;
+  for (int axis = 0; axis < 3; axis++) {
+    if (gyroCalibGyroStd(c, axis) > CAL_STILL_GYRO_STD_DPS) return false;
+  }
+  return gyroCalibAccStd(c) <= CAL_STILL_ACC_STD_G && fabsf(c.a_mean - 1.0f) < 0.2f;
+}
+
+static inline bool finiteWithin(float v, float lim) {
+  return v == v && fabsf(v) <= lim; // NaN != NaN
+}
+
+bool imuCalibPlausible(const ImuCalib& c) {
+  return finiteWithin(c.bgx, CAL_BIAS_MAX_DPS) && finiteWithin(c.bgy, CAL_BIAS_MAX_DPS) &&
+         finiteWithin(c.bgz, CAL_BIAS_MAX_DPS) && finiteWithin(c.off_roll, 180.0f) &&
+         finiteWithin(c.off_pitch, 90.0f);
+}
+
+size_t calibRecordEncode(const CalibRecord& r, uint8_t* out) {
+  out[0] = 'K';
+  out[1] = 'C';
+  out[2] = CAL_RECORD_VERSION;
+  out[3] = r.flags;
+  uint8_t* p = out + 4;
+  for (int i = 0; i < 2; i++) {
+    const float v[5] = {r.imu[i].bgx, r.imu[i].bgy, r.imu[i].bgz, r.imu[i].off_roll, r.imu[i].off_pitch};
+    for (int j = 0; j < 5; j++, p += 4) putLeF32(p, v[j]);
+  }
+  putLe16(p, crc16Ccitt(out, (size_t)(p - out)));
+  return CAL_RECORD_LEN;
+}
+
+bool calibRecordDecode(const uint8_t* in, size_t len, CalibRecord& r) {
+  if (len != CAL_RECORD_LEN || in[0] != 'K' || in[1] != 'C' || in[2] != CAL_RECORD_VERSION) return false;
+  if (crc16Ccitt(in, CAL_RECORD_LEN - 2) != getLe16(in + CAL_RECORD_LEN - 2)) return false;
+
+  CalibRecord out;
+  out.flags = in[3];
+  const uint8_t* p = in + 4;
+  for (int i = 0; i < 2; i++) {
+    float* v[5] = {&out.imu[i].bgx, &out.imu[i].bgy, &out.imu[i].bgz, &out.imu[i].off_roll, &out.imu[i].off_pitch};
+    for (int j = 0; j < 5; j++, p += 4) *v[j] = getLeF32(p);
+    if (!imuCalibPlausible(out.imu[i])) return false;
+  }
+  r = out;
+  return true;
+}
+
+bool gyroCalibMatches(const GyroCalib& c, const ImuCalib& stored) {
+  return fabsf(c.g_mean[0] - stored.bgx) <= CAL_BIAS_TOL_DPS &&
+         fabsf(c.g_mean[1] - stored.bgy) <= CAL_BIAS_TOL_DPS &&
+         fabsf(c.g_mean[2] - stored.bgz) <= CAL_BIAS_TOL_DPS;
+}
+
+void imuCalibFromState(const ImuState& imu, ImuCalib& out) {
+  out.bgx = imu.bgx;
+  out.bgy = imu.bgy;
+  out.bgz = imu.bgz;
+  out.off_roll  = imu.off_roll;
+  out.off_pitch = imu.off_pitch;
+}
+
+// Zapisany bias: zgodny z oknem sprawdzającym w CAL_BIAS_TOL_DPS (albo niesprawdzony).
+void imuCalibApplyBias(ImuState& imu, const ImuCalib& c) {
+  imu.bgx = c.bgx;
+  imu.bgy = c.bgy;
+  imu.bgz = c.bgz;
+  biasTrackerReset(imu.bias, 0.5f * CAL_BIAS_TOL_DPS);
+}
+
+// Średnia okna (bias w bieżącej temperaturze): niepewność = błąd standardowy
+// średniej najgorszej osi.
+void imuCalibApplyBias(ImuState& imu, const GyroCalib& c) {
+  imu.bgx = c.g_mean[0] - imu.tc[0];
+  imu.bgy = c.g_mean[1] - imu.tc[1];
+  imu.bgz = c.g_mean[2] - imu.tc[2];
+  float sd = 0;
+  for (int axis = 0; axis < 3; axis++) sd = fmaxf(sd, gyroCalibGyroStd(c, axis));
+  const float se = c.n ? sd / sqrtf((float)c.n) : CAL_BIAS_MAX_DPS;
+  biasTrackerReset(imu.bias, fmaxf(se, 0.05f));
+}
+
+ImuCalib imuCalibAtTemperature(const ImuCalib& c, const ImuState& imu) {
+  ImuCalib out = c;
+  out.bgx += imu.tc[0];
+  out.bgy += imu.tc[1];
+  out.bgz += imu.tc[2];
+  return out;
+}
+
+void imuCalibApplyMount(ImuState& imu, const ImuCalib& c) {
+  imu.off_roll  = c.off_roll;
+  imu.off_pitch = c.off_pitch;
+  imu.off_yaw   = 0.0f;
+  imu.q_off = quatFromRollPitchDeg(c.off_roll, c.off_pitch);
+}
+
+const char* calibBootActionName(CalibBootAction a) {
+  switch (a) {
+    case CAL_BOOT_STORED: return "stored";
+    case CAL_BOOT_FRESH:  return "fresh";
+    case CAL_BOOT_MOVING: return "moving";
+    default:              return "pending";
+  }
+}
+
+CalibBootAction calibBootDecide(const GyroCalib& c, const ImuCalib* stored, bool final) {
+  const bool still = gyroCalibStill(c);
+  if (!final) {
+    if (stored && (!still || gyroCalibMatches(c, *stored))) return CAL_BOOT_STORED;
+    return CAL_BOOT_CONTINUE;
+  }
+  if (still) return CAL_BOOT_FRESH;
+  if (stored) return CAL_BOOT_STORED;
+  return c.n > 0 ? CAL_BOOT_MOVING : CAL_BOOT_CONTINUE;
+}
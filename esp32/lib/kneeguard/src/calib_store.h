@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+#include "mpu6050.h"
+
+/*
+  KneeGuard – kalibracja żyroskopu i zapis kalibracji (logika bez Arduino)
+
+  GyroCalib zbiera surowe próbki jednego IMU (przed korektą bias): średnia i
+  wariancja żyroskopu per oś oraz normy akcelerometru (Welford, O(1) na próbkę).
+  Średnia to nowy bias, wariancja mówi, czy urządzenie leżało nieruchomo.
+
+  Start (main.cpp): oba IMU czytane naprzemiennie w jednym przebiegu.
+  - okno sprawdzające CAL_CHECK_SAMPLES: zapisany bias jest używany, gdy
+    urządzenie stoi i średnia zgadza się z nim (CAL_BIAS_TOL_DPS), albo gdy
+    urządzenie się rusza (świeży bias byłby gorszy niż zapisany),
+  - inaczej przebieg trwa do CAL_SAMPLES i daje nowy bias (zapisywany tylko,
+    jeśli urządzenie stało).
+  Ten sam akumulator obsługuje "calib gyro" w trakcie pracy.
+
+  CalibRecord (NVS): bias obu IMU i offsety montażowe roll/pitch z "calib".
+  Bias jak w ImuState: w TEMP_REF_C, gdy IMU ma model temperaturowy (temp_comp.h).
+  Yaw nie ma odniesienia bez magnetometru (po starcie zaczyna od 0), więc jego
+  offset nie jest zapisywany; q_off wynika z roll/pitch. Rekord ma magic,
+  wersję i CRC; wartości spoza fizycznego zakresu dają rekord nieważny.
+*/
+
+static const uint16_t CAL_CHECK_SAMPLES = 100;  // okno sprawdzające (0.2 s przy 500 Hz)
+static const uint16_t CAL_SAMPLES       = 500;  // pełna kalibracja (1 s przy 500 Hz)
+static const float    CAL_STILL_GYRO_STD_DPS = 0.5f;  // szum MPU6050 ~0.05..0.1 dps rms
+static const float    CAL_STILL_ACC_STD_G    = 0.03f;
+static const float    CAL_BIAS_TOL_DPS       = 1.0f;  // dryf ZRO ~0.1..0.2 dps/°C
+static const float    CAL_BIAS_MAX_DPS       = 30.0f; // datasheet: ZRO ±20 dps
+
+struct GyroCalib {
+  uint32_t n = 0;
+  float g_mean[3] = {0, 0, 0};
+  float g_m2[3]   = {0, 0, 0};
+  float a_mean = 0, a_m2 = 0; // norma akcelerometru [g]
+};
+
+static inline void gyroCalibReset(GyroCalib& c) { c = GyroCalib(); }
+
+void gyroCalibPush(GyroCalib& c, const MpuSample& s);
+
+// Odchylenie standardowe osi żyroskopu (0..2) [dps]; 0 przy n < 2.
+float gyroCalibGyroStd(const GyroCalib& c, int axis);
+float gyroCalibAccStd(const GyroCalib& c);
+
+// Nieruchomo: co najmniej CAL_CHECK_SAMPLES / 2 próbek, szum żyroskopu
+// i normy akcelerometru poniżej progów, norma ~1 g.
+bool gyroCalibStill(const GyroCalib& c);
+
+struct ImuCalib {
+  float bgx = 0, bgy = 0, bgz = 0;  // bias żyroskopu [dps]
+  float off_roll = 0, off_pitch = 0; // offsety montażowe [deg]
+};
+
+static const uint8_t CAL_HAS_BIAS  = 0x01;
+static const uint8_t CAL_HAS_MOUNT = 0x02;
+
+struct CalibRecord {
+  uint8_t  flags = 0; // CAL_HAS_BIAS | CAL_HAS_MOUNT
+  ImuCalib imu[2];
+};
+
+// magic 'K' 'C' | wersja | flagi | 2 x (bias xyz, roll, pitch) f32 LE | CRC16
+static const uint8_t CAL_RECORD_VERSION = 1;
+static const size_t  CAL_RECORD_LEN     = 4 + 2 * 5 * 4 + 2;
+
+size_t calibRecordEncode(const CalibRecord& r, uint8_t* out);
+
+// false: zła długość, magic, wersja, CRC albo wartości poza zakresem.
+bool calibRecordDecode(const uint8_t* in, size_t len, CalibRecord& r);
+
+bool imuCalibPlausible(const ImuCalib& c);
+
+// Średnia okna zgodna z zapisanym biasem (każda oś w CAL_BIAS_TOL_DPS).
+bool gyroCalibMatches(const GyroCalib& c, const ImuCalib& stored);
+
+void imuCalibFromState(const ImuState& imu, ImuCalib& out);
+// Nowy bias + niepewność startowa dla śledzenia w bezruchu (BiasTracker).
+void imuCalibApplyBias(ImuState& imu, const ImuCalib& c);
+void imuCalibApplyBias(ImuState& imu, const GyroCalib& c);
+
+// Zapisany bias przeliczony na bieżącą temperaturę IMU (porównanie z oknem).
+ImuCalib imuCalibAtTemperature(const ImuCalib& c, const ImuState& imu);
+
+// Offsety roll/pitch (yaw = 0) i q_off z nich – jak po "calib" w tej orientacji.
+void imuCalibApplyMount(ImuState& imu, const ImuCalib& c);
+
+enum CalibBootAction : uint8_t {
+  CAL_BOOT_CONTINUE = 0, // zbieraj dalej (do CAL_SAMPLES)
+  CAL_BOOT_STORED,       // użyj zapisanego biasu
+  CAL_BOOT_FRESH,        // nowy bias z nieruchomego urządzenia (do zapisu)
+  CAL_BOOT_MOVING,       // nowy bias mimo ruchu, brak zapisanego (nie zapisywać)
+};
+
+const char* calibBootActionName(CalibBootAction a);
+
+// Decyzja po oknie sprawdzającym (final = false) albo po pełnym przebiegu;
+// stored = nullptr, gdy w NVS nie ma ważnego biasu. CAL_BOOT_CONTINUE po pełnym
+// przebiegu = brak jakiejkolwiek próbki (czujnik nie odpowiada).
+CalibBootAction calibBootDecide(const GyroCalib& c, const ImuCalib* stored, bool final);
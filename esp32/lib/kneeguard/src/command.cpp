@@ -0,0 +1,81 @@
+#include "command.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool cmdLineFeed(CmdLineBuffer& lb, char c) {
+  if (lb.ready) {
+    // poprzednia linia została oddana – zaczynamy od nowa
+    lb.len = 0;
+    lb.overflow = false;
+    lb.ready = false;
+  }
+  if (c == '\n' || c == '\r') {
+    // pusta linia (np. drugi znak z CRLF) nie jest zgłaszana
+    if (lb.len == 0 && !lb.overflow) return false;
+    lb.buf[lb.len] = '\0';
+    lb.ready = true;
+    return true;
+  }
+  if (lb.len >= CMD_LINE_MAX) {
+    lb.overflow = true;
+    return false;
+  }
+  if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+  lb.buf[lb.len++] = c;
+  return false;
+}
+
+static inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+int cmdTokenize(char* line, const char** argv, int max_tokens) {
+  int argc = 0;
+  char* p = line;
+  while (*p && argc < max_tokens) {
+    while (isSpace(*p)) p++;
+    if (!*p) break;
+    argv[argc++] = p;
+    if (argc == max_tokens) break; // reszta linii należy do ostatniego tokenu
+    while (*p && !isSpace(*p)) p++;
+    if (*p) *p++ = '\0';
+  }
+  // obcięcie końcowych spacji ostatniego tokenu
+  if (argc > 0) {
+    char* end = (char*)argv[argc - 1] + strlen(argv[argc - 1]);
+    while (end > argv[argc - 1] && isSpace(end[-1])) *--end = '\0';
+  }
+  return argc;
+}
+
+CmdResult cmdDispatch(const CmdEntry* table, size_t n, CmdLineBuffer& lb, void* ctx,
+                      const CmdEntry** entry, const char** argv0) {
+  if (entry) *entry = nullptr;
+  if (argv0) *argv0 = "";
+  if (!lb.ready) return CMD_EMPTY;
+  if (lb.overflow) return CMD_TOO_LONG;
+
+  const char* argv[CMD_ARGS_MAX];
+  const int argc = cmdTokenize(lb.buf, argv, (int)CMD_ARGS_MAX);
+  if (argc == 0) return CMD_EMPTY;
+  if (argv0) *argv0 = argv[0];
+
+  for (size_t i = 0; i < n; i++) {
+    if (strcmp(table[i].name, argv[0]) != 0) continue;
+    if (entry) *entry = &table[i];
+    const int nargs = argc - 1;
+    if (nargs < table[i].min_args || nargs > table[i].max_args) return CMD_BAD_ARGS;
+    return table[i].fn(argc, argv, ctx) ? CMD_OK : CMD_BAD_ARGS;
+  }
+  return CMD_UNKNOWN;
+}
+
+bool cmdParseInt(const char* s, long& out) {
+  if (!s || !*s) return false;
+  char* end = nullptr;
+  errno = 0;
+  const long v = strtol(s, &end, 10);
+  if (*end != '\0' || errno == ERANGE) return false; // poza long: strtol nasyca do LONG_MAX/MIN
+  out = v;
+  return true;
+}
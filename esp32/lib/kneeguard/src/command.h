@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – parser komend (USB/BT) bez alokacji
+
+  Znaki z transportu trafiają do stałego bufora linii (CmdLineBuffer, jeden na
+  transport). Gotowa linia jest dzielona w miejscu na tokeny (argv wskazuje do
+  bufora) i przekazywana do funkcji z tablicy komend:
+
+    static const CmdEntry COMMANDS[] = {
+      {"calib", 0, 0, cmdCalib, ""},
+      {"rate",  1, 1, cmdRate,  "<4..1000>"},
+    };
+
+  Nowa komenda = jedna funkcja + jeden wpis w tablicy.
+*/
+
+static const size_t CMD_LINE_MAX = 64; // znaków w linii (bez '\0'); dłuższe są odrzucane
+static const size_t CMD_ARGS_MAX = 4;  // tokenów razem z nazwą komendy
+
+struct CmdLineBuffer {
+  char   buf[CMD_LINE_MAX + 1];
+  size_t len      = 0;
+  bool   overflow = false; // linia przekroczyła CMD_LINE_MAX (do końca linii znaki są pomijane)
+  bool   ready    = false; // buf zawiera kompletną linię (do następnego cmdLineFeed)
+};
+
+// false = złe argumenty (dispatcher zgłasza CMD_BAD_ARGS); ctx przekazywany bez zmian.
+typedef bool (*CmdHandler)(int argc, const char* const* argv, void* ctx);
+
+struct CmdEntry {
+  const char* name;
+  uint8_t     min_args; // bez nazwy komendy
+  uint8_t     max_args;
+  CmdHandler  fn;
+  const char* usage;    // składnia argumentów (do komunikatu o błędzie / "help")
+};
+
+enum CmdResult : uint8_t {
+  CMD_OK = 0,
+  CMD_EMPTY,     // pusta linia
+  CMD_TOO_LONG,  // linia dłuższa niż CMD_LINE_MAX
+  CMD_UNKNOWN,   // brak komendy w tablicy
+  CMD_BAD_ARGS,  // zła liczba argumentów albo handler zwrócił false
+};
+
+// Dodanie znaku; true, gdy linia jest kompletna (CR/LF) – wtedy lb.buf zawiera
+// linię małymi literami, a następne wywołanie zaczyna nową linię.
+bool cmdLineFeed(CmdLineBuffer& lb, char c);
+
+// Podział linii w miejscu na tokeny (spacje/taby); zwraca liczbę tokenów <= max_tokens.
+// Nadmiarowe tokeny są doklejane do ostatniego (np. ostatni argument ze spacjami).
+int cmdTokenize(char* line, const char** argv, int max_tokens);
+
+// Tokenizacja gotowej linii (w miejscu) + wyszukanie w tablicy + wywołanie
+// handlera; bez gotowej linii zwraca CMD_EMPTY. *entry (opcjonalnie)
+// wskazuje dopasowany wpis, argv0 – nazwę komendy (również nieznanej).
+CmdResult cmdDispatch(const CmdEntry* table, size_t n, CmdLineBuffer& lb, void* ctx,
+                      const CmdEntry** entry = nullptr, const char** argv0 = nullptr);
+
+// Liczba całkowita dziesiętna (cały token); false dla pustego / z resztą znaków.
+bool cmdParseInt(const char* s, long& out);
@@ -0,0 +1,37 @@
+#include "data_ready.h"
+
+bool drdyStampAt(const DrdyStamps& d, uint32_t idx, uint64_t& t_us) {
+  const uint32_t age = d.count - idx; // 1 = ostatnie przerwanie
+  if (age == 0 || age > DRDY_STAMPS / 2 || age > d.count) return false;
+  t_us = d.t_us[idx & (DRDY_STAMPS - 1)];
+  return true;
+}
+
+void drdyFifoStart(DrdyFifo& f, uint32_t count) {
+  f.base = count;
+  f.consumed = 0;
+}
+
+bool drdyFifoSync(DrdyFifo& f, uint32_t c0, uint32_t c1, uint32_t avail) {
+  if (c0 != c1) return true; // nowa ramka w trakcie odczytu – nie wiadomo, czy policzona
+  if (c1 - f.base - f.consumed == avail) return true;
+  f.base = c1 - f.consumed - avail;
+  f.resyncs++;
+  return false;
+}
+
+bool drdyJitterUpdate(DrdyJitter& j, uint32_t idx, uint64_t t_us, uint32_t& dev_us) {
+  const bool next = idx == j.next && j.last_t != 0;
+  const uint64_t period = t_us - j.last_t;
+  j.next = idx + 1;
+  j.last_t = t_us;
+  if (!next) return false;
+  if (j.period_us <= 0.0f) {
+    j.period_us = (float)period;
+    return false;
+  }
+  const float dev = (float)period - j.period_us;
+  j.period_us += DRDY_PERIOD_ALPHA * dev;
+  dev_us = (uint32_t)(dev < 0.0f ? -dev + 0.5f : dev + 0.5f);
+  return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – znaczniki czasu przerwania data-ready MPU6050 (logika bez Arduino)
+
+  Pin INT czujnika odniesienia (DRDY_SENSOR) daje impuls przy każdej nowej
+  próbce. ISR zapisuje czas impulsu (esp_timer, 64 bit) do pierścienia
+  DrdyStamps i budzi akwizycję – próbka ma czas z chwili pomiaru, a nie
+  z chwili, w której zadanie zdążyło ją odczytać.
+
+  Tryb FIFO: ramka k od startu FIFO to przerwanie base + k (DrdyFifo). Po każdym
+  odczycie FIFO_COUNT liczba ramek jest porównywana z liczbą przerwań; różnica
+  (start FIFO w chwili próbki, zgubione przerwanie) ustawia base od nowa
+  (resyncs). Gdy odczyt objął nowe przerwanie, porównanie jest pomijane.
+
+  DrdyJitter: odchylenie okresu między kolejnymi przerwaniami od średniej
+  kroczącej – rozrzut znaczników czasu (opóźnienie ISR), a nie błąd zegara
+  czujnika (ten przesuwa samą średnią).
+*/
+
+static const size_t DRDY_STAMPS       = 64;     // znaczników w pierścieniu (potęga 2)
+static const float  DRDY_PERIOD_ALPHA = 1.0f / 64.0f;
+
+// Zapis: ISR, odczyt: akwizycja (wpis nadpisywany najwcześniej po DRDY_STAMPS przerwaniach).
+struct DrdyStamps {
+  volatile uint64_t t_us[DRDY_STAMPS];
+  volatile uint32_t count = 0; // przerwania od startu
+};
+
+static inline void drdyStamp(DrdyStamps& d, uint64_t t_us) {
+  const uint32_t c = d.count;
+  d.t_us[c & (DRDY_STAMPS - 1)] = t_us;
+  d.count = c + 1; // po znaczniku: odczyt count zawsze widzi zapisany wpis
+}
+
+// Czas przerwania numer idx; false, gdy jeszcze go nie było albo wpis mógł być
+// już nadpisany (zostawiony margines na przerwania w trakcie odczytu).
+bool drdyStampAt(const DrdyStamps& d, uint32_t idx, uint64_t& t_us);
+
+struct DrdyFifo {
+  uint32_t base     = 0; // numer przerwania ramki 0 (po starcie FIFO)
+  uint32_t consumed = 0; // ramki zdjęte z FIFO od startu
+  uint32_t resyncs  = 0; // korekty base
+};
+
+// Start FIFO czujnika odniesienia; count – licznik przerwań zaraz po starcie.
+void drdyFifoStart(DrdyFifo& f, uint32_t count);
+
+// Po odczycie FIFO_COUNT: c0/c1 – licznik przerwań przed/po odczycie, avail –
+// pełne ramki w FIFO. false = base skorygowane.
+bool drdyFifoSync(DrdyFifo& f, uint32_t c0, uint32_t c1, uint32_t avail);
+
+// Numer przerwania k-tej kolejnej ramki do zdjęcia z FIFO.
+static inline uint32_t drdyFifoIndex(const DrdyFifo& f, size_t k) {
+  return f.base + f.consumed + (uint32_t)k;
+}
+
+static inline void drdyFifoConsume(DrdyFifo& f, size_t n) { f.consumed += (uint32_t)n; }
+
+struct DrdyJitter {
+  uint32_t next      = 0;    // numer następnego przerwania do oceny
+  uint64_t last_t    = 0;
+  float    period_us = 0.0f; // średnia krocząca okresu (0 = jeszcze brak)
+};
+
+// Kolejne przerwanie idx z czasem t_us: dev_us = |okres - średnia|; false, gdy nie
+// ma jeszcze średniej albo idx nie następuje bezpośrednio po poprzednim.
+bool drdyJitterUpdate(DrdyJitter& j, uint32_t idx, uint64_t t_us, uint32_t& dev_us);
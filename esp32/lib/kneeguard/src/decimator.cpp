@@ -0,0 +1,186 @@
+#include "decimator.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kg_math.h"
+
+static const float  DECIM_CUTOFF = 0.35f; // granica pasma * częstotliwość wyjściowa
+static const size_t KNEE_CHANNEL = DECIM_CHANNELS - 1;
+
+static inline float* channelPtr(KneeSample& s, size_t ch) {
+  float* const p[DECIM_CHANNELS] = {&s.roll1, &s.pitch1, &s.yaw1,
+                                    &s.roll2, &s.pitch2, &s.yaw2, &s.knee_angle};
+  return p[ch];
+}
+
+static inline float channelValue(const KneeSample& s, size_t ch) {
+  return *channelPtr(const_cast<KneeSample&>(s), ch);
+}
+
+void decimatorInit(KneeDecimator& d, uint16_t ratio) {
+  if (ratio < 1) ratio = 1;
+  // rozkład ratio = pre * fir (fir <= DECIM_FIR_RATIO_MAX), najmniejsze pre
+  // dające dokładny albo najbliższy iloczyn
+  const uint16_t pre_min = (uint16_t)((ratio + DECIM_FIR_RATIO_MAX - 1) / DECIM_FIR_RATIO_MAX);
+  int best_err = 0x7FFF;
+  for (uint16_t p = pre_min; p <= 2 * pre_min && best_err != 0; p++) {
+    uint16_t f = (uint16_t)((ratio + p / 2) / p);
+    if (f > DECIM_FIR_RATIO_MAX) f = DECIM_FIR_RATIO_MAX;
+    if (f < 1) f = 1;
+    const int err = abs((int)(p * f) - (int)ratio);
+    if (err < best_err) {
+      best_err = err;
+      d.pre = p;
+      d.fir = f;
+    }
+  }
+  d.ratio = (uint16_t)(d.pre * d.fir);
+  d.taps  = (uint16_t)(d.fir == 1 ? 1 : 6 * d.fir + 1);
+
+  // okienkowany sinc, wzmocnienie DC = 1
+  const float fc = DECIM_CUTOFF / d.fir; // [cykle / próbkę wejścia FIR]
+  const float mid = 0.5f * (d.taps - 1);
+  float sum = 0;
+  for (uint16_t i = 0; i < d.taps; i++) {
+    const float n = i - mid;
+    const float sinc = (n == 0.0f) ? 2.0f * fc : sinf(2.0f * KG_PI * fc * n) / (KG_PI * n);
+    const float win = d.taps == 1 ? 1.0f : 0.54f - 0.46f * cosf(2.0f * KG_PI * i / (d.taps - 1));
+    d.h[i] = sinc * win;
+    sum += d.h[i];
+  }
+  for (uint16_t i = 0; i < d.taps; i++) d.h[i] /= sum;
+
+  memset(d.hist, 0, sizeof(d.hist));
+  memset(d.t_hist, 0, sizeof(d.t_hist));
+  memset(d.f_hist, 0, sizeof(d.f_hist));
+  memset(d.pre_sum, 0, sizeof(d.pre_sum));
+  d.pos = 0;
+  d.phase = 0;
+  d.filled = 0;
+  d.pre_n = 0;
+  d.pre_t0 = 0;
+  d.pre_bad = 0;
+  d.pre_gap = 0;
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) {
+    d.last_raw[ch] = 0;
+    d.unwrapped[ch] = 0;
+    d.bad_left[ch] = 0;
+    d.seeded[ch] = false;
+  }
+}
+
+// Przesunięcie rozwiniętego kanału (i jego historii) o wielokrotność 360°,
+// żeby wartości nie rosły bez końca przy dryfie yaw (precyzja float).
+static void recenter(KneeDecimator& d, size_t ch) {
+  const float shift = 360.0f * floorf(d.unwrapped[ch] / 360.0f + 0.5f);
+  d.unwrapped[ch] -= shift;
+  for (uint16_t i = 0; i < 2 * d.taps; i++) d.hist[ch][i] -= shift;
+  d.pre_sum[ch] -= shift * d.pre_n;
+}
+
+// Wejście etapu FIR (po CIC): zapis do historii, wynik co `fir` próbek.
+static bool firPush(KneeDecimator& d, const float* v, uint8_t bad, uint64_t t_us, uint8_t flags,
+                    KneeSample& out) {
+  const uint16_t n = d.taps;
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) {
+    if (bad & (1u << ch)) {
+      d.bad_left[ch] = n;
+      d.seeded[ch] = false;
+      continue;
+    }
+    if (!d.seeded[ch]) {
+      // start / powrót po błędzie: historia wypełniona pierwszą wartością
+      for (uint16_t i = 0; i < 2 * n; i++) d.hist[ch][i] = v[ch];
+      d.seeded[ch] = true;
+    }
+    d.hist[ch][d.pos] = v[ch];
+    d.hist[ch][d.pos + n] = v[ch];
+    if (d.bad_left[ch] > 0) d.bad_left[ch]--;
+  }
+  d.t_hist[d.pos] = t_us;
+  d.f_hist[d.pos] = flags;
+  d.pos = (uint16_t)(d.pos + 1 == n ? 0 : d.pos + 1);
+  if (d.filled < n) d.filled++;
+
+  if (++d.phase < d.fir) return false;
+  d.phase = 0;
+  if (d.filled < n) return false; // okno jeszcze z t_hist = 0
+
+  // okno: hist[pos .. pos + n - 1] (od najstarszej), środek okna = opóźnienie grupowe
+  const uint16_t mid = (uint16_t)((d.pos + n / 2) % n);
+  out.t_us = d.t_hist[mid];
+  out.inv1 = (d.f_hist[mid] & 0x01) != 0;
+  out.inv2 = (d.f_hist[mid] & 0x02) != 0;
+  uint8_t gap = 0;
+  for (uint16_t i = 0; i < n; i++) gap |= d.f_hist[i];
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) {
+    float* dst = channelPtr(out, ch);
+    if (d.bad_left[ch] > 0 || !d.seeded[ch]) {
+      *dst = ANGLE_INVALID;
+      continue;
+    }
+    const float* x = &d.hist[ch][d.pos];
+    float acc = 0;
+    for (uint16_t i = 0; i < n; i++) acc += d.h[i] * x[i];
+    *dst = (ch == KNEE_CHANNEL) ? acc : wrap180(acc);
+  }
+  out.q1 = out.roll1 == ANGLE_INVALID ? QUALITY_INVALID : (gap & 0x04) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  out.q2 = out.roll2 == ANGLE_INVALID ? QUALITY_INVALID : (gap & 0x08) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  return true;
+}
+
+bool decimatorPush(KneeDecimator& d, const KneeSample& in, KneeSample& out) {
+  if (d.ratio == 1) {
+    out = in;
+    return true;
+  }
+
+  // rozwinięcie kątów: kolejne przyrosty w [-180..180] (kąt kolana 0..180 – liniowy)
+  float v[DECIM_CHANNELS];
+  uint8_t bad = 0;
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) {
+    const float raw = channelValue(in, ch);
+    if (raw == ANGLE_INVALID) {
+      bad |= (uint8_t)(1u << ch);
+      d.unwrapped[ch] = 0;
+      d.last_raw[ch] = 0;
+      v[ch] = 0;
+      continue;
+    }
+    if (ch == KNEE_CHANNEL) {
+      v[ch] = raw;
+      continue;
+    }
+    d.unwrapped[ch] += angleDiffDeg(raw, d.last_raw[ch]);
+    d.last_raw[ch] = raw;
+    if (fabsf(d.unwrapped[ch]) > 540.0f) recenter(d, ch);
+    v[ch] = d.unwrapped[ch];
+  }
+  const uint8_t flags = (uint8_t)((in.inv1 ? 0x01 : 0) | (in.inv2 ? 0x02 : 0) |
+                                  (in.q1 == QUALITY_GYRO_ONLY ? 0x04 : 0) |
+                                  (in.q2 == QUALITY_GYRO_ONLY ? 0x08 : 0));
+
+  if (d.pre == 1) return firPush(d, v, bad, in.t_us, flags, out);
+
+  // CIC: średnia z `pre` próbek, czas = środek bloku
+  if (d.pre_n == 0) d.pre_t0 = in.t_us;
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) d.pre_sum[ch] += v[ch];
+  d.pre_bad |= bad;
+  d.pre_gap |= flags & 0x0C;
+  if (++d.pre_n < d.pre) return false;
+
+  float avg[DECIM_CHANNELS];
+  for (size_t ch = 0; ch < DECIM_CHANNELS; ch++) {
+    avg[ch] = d.pre_sum[ch] / d.pre;
+    d.pre_sum[ch] = 0;
+  }
+  const uint8_t block_bad = d.pre_bad;
+  const uint8_t block_flags = (uint8_t)((flags & 0x03) | d.pre_gap);
+  const uint64_t t_mid = d.pre_t0 + (in.t_us - d.pre_t0) / 2;
+  d.pre_n = 0;
+  d.pre_bad = 0;
+  d.pre_gap = 0;
+  return firPush(d, avg, block_bad, t_mid, block_flags, out);
+}
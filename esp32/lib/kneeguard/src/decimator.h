@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+
+/*
+  KneeGuard – decymacja strumienia KneeSample (częstotliwość akwizycji -> telemetrii)
+
+  Zamiast wysyłać co n-tą próbkę (aliasing szybkiego ruchu) każdy kanał kątowy
+  (roll/pitch/yaw obu IMU + kąt kolana) przechodzi przez:
+  1) CIC rzędu 1 (średnia z `pre` próbek) – tylko dla dużych współczynników,
+  2) FIR dolnoprzepustowy (okno Hamminga, 6 * fir + 1 współczynników,
+     granica ~0.35 * częstotliwości wyjściowej), liczony raz na `fir` próbek.
+  Efektywny współczynnik = pre * fir (najbliższy do żądanego).
+
+  Kąty są filtrowane po "rozwinięciu" (bez skoku przy ±180°), wynik jest
+  zawijany z powrotem do [-180..180]. ANGLE_INVALID w oknie filtra daje
+  ANGLE_INVALID na wyjściu, próbka QUALITY_GYRO_ONLY w oknie – taką jakość
+  wyjścia; t_us wyjścia to czas próbki w środku okna
+  (opóźnienie grupowe filtra jest uwzględnione w znaczniku czasu). Pierwsze
+  wyjście dopiero po wypełnieniu okna rzeczywistymi próbkami (taps) – czasy
+  wyjść rosną od pierwszego.
+*/
+
+static const uint16_t DECIM_FIR_RATIO_MAX = 16;
+static const size_t   DECIM_TAPS_MAX      = 6 * DECIM_FIR_RATIO_MAX + 1;
+static const size_t   DECIM_CHANNELS      = 7; // roll1, pitch1, yaw1, roll2, pitch2, yaw2, knee
+
+struct KneeDecimator {
+  uint16_t ratio = 1; // efektywny współczynnik (pre * fir)
+  uint16_t pre   = 1; // CIC (średnia)
+  uint16_t fir   = 1; // decymacja FIR
+  uint16_t taps  = 1;
+  float    h[DECIM_TAPS_MAX];
+
+  // historia FIR: każda próbka zapisana pod pos i pos + taps (okno zawsze ciągłe)
+  float    hist[DECIM_CHANNELS][2 * DECIM_TAPS_MAX];
+  uint64_t t_hist[DECIM_TAPS_MAX];
+  uint8_t  f_hist[DECIM_TAPS_MAX]; // bit0 inv1, bit1 inv2, bit2/bit3 gyro-only IMU1/IMU2
+  uint16_t pos   = 0;
+  uint16_t phase = 0; // próbki FIR od ostatniego wyjścia
+  uint16_t filled = 0; // próbki FIR od startu (do taps)
+
+  // CIC
+  float    pre_sum[DECIM_CHANNELS];
+  uint16_t pre_n    = 0;
+  uint64_t pre_t0   = 0;
+  uint8_t  pre_bad  = 0; // bity kanałów z ANGLE_INVALID w bieżącym bloku
+  uint8_t  pre_gap  = 0; // flagi gyro-only w bieżącym bloku
+
+  // rozwijanie kątów i ważność kanałów
+  float    last_raw[DECIM_CHANNELS];
+  float    unwrapped[DECIM_CHANNELS];
+  uint16_t bad_left[DECIM_CHANNELS]; // > 0: w oknie FIR jest nieważna próbka
+  bool     seeded[DECIM_CHANNELS];
+};
+
+// Projekt filtra dla żądanego współczynnika (1 = przepuszczanie bez zmian).
+void decimatorInit(KneeDecimator& d, uint16_t ratio);
+
+// Jedna próbka wejściowa; true, gdy `out` zawiera nową próbkę wyjściową.
+bool decimatorPush(KneeDecimator& d, const KneeSample& in, KneeSample& out);
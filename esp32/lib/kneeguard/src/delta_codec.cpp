@@ -0,0 +1,124 @@
+#include "delta_codec.h"
+
+#include "binary_frame.h"
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+static inline size_t putVarint(uint8_t* p, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// 0 = zabrakło bajtów albo varint dłuższy niż 10 B.
+static inline size_t getVarint(const uint8_t* p, size_t len, uint64_t& v) {
+  v = 0;
+  for (size_t i = 0; i < len && i < 10; i++) {
+    v |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+    if ((p[i] & 0x80) == 0) return i + 1;
+  }
+  return 0;
+}
+
+// Reszta predykcji liniowej modulo 2^16 (identyczna w koderze i dekoderze).
+static inline int16_t predict(const DeltaCodec& c, int ch) {
+  return (int16_t)(uint16_t)(2u * (uint16_t)c.prev[ch] - (uint16_t)c.prev2[ch]);
+}
+
+static inline void pushHistory(DeltaCodec& c, const int16_t* v) {
+  for (int ch = 0; ch < 7; ch++) {
+    c.prev2[ch] = c.prev[ch];
+    c.prev[ch] = v[ch];
+  }
+}
+
+void deltaCodecInit(DeltaCodec& c, uint16_t keyframe_interval) {
+  c = DeltaCodec();
+  c.keyframe_interval = keyframe_interval;
+}
+
+size_t deltaEncode(DeltaCodec& c, const KneeSample& s, uint8_t* out) {
+  const float angles[7] = {s.roll1, s.pitch1, s.yaw1, s.roll2, s.pitch2, s.yaw2, s.knee_angle};
+  int16_t v[7];
+  for (int ch = 0; ch < 7; ch++) v[ch] = binEncodeAngle(angles[ch]);
+
+  // przerwa dłuższa niż DELTA_DT_MAX_US (albo czas wstecz) -> klatka zamiast przyrostu
+  const bool key = !c.primed || (c.keyframe_interval > 0 && c.since_key >= c.keyframe_interval) ||
+                   s.t_us - c.prev_t > DELTA_DT_MAX_US;
+  size_t n = 0;
+  out[n++] = (uint8_t)((key ? DELTA_FLAG_KEY : 0) | binSampleFlags(s));
+
+  if (key) {
+    n += putVarint(out + n, s.t_us);
+    for (int ch = 0; ch < 7; ch++) {
+      n += putVarint(out + n, zigzag(v[ch]));
+      c.prev[ch] = c.prev2[ch] = v[ch]; // pierwsza predykcja po klatce = poprzednia wartość
+    }
+    c.prev_dt = 0;
+    c.since_key = 0;
+    c.primed = true;
+    c.keyframes++;
+  } else {
+    const int32_t dt = (int32_t)(s.t_us - c.prev_t);
+    n += putVarint(out + n, zigzag(dt - c.prev_dt));
+    for (int ch = 0; ch < 7; ch++) {
+      n += putVarint(out + n, zigzag((int16_t)(uint16_t)((uint16_t)v[ch] - (uint16_t)predict(c, ch))));
+    }
+    pushHistory(c, v);
+    c.prev_dt = dt;
+  }
+  c.prev_t = s.t_us;
+  c.since_key++;
+  return n;
+}
+
+size_t deltaDecode(DeltaCodec& c, const uint8_t* in, size_t len, KneeSample& out, bool& have) {
+  have = false;
+  if (len < 1) return 0;
+  const uint8_t hdr = in[0];
+  const bool key = (hdr & DELTA_FLAG_KEY) != 0;
+  size_t n = 1;
+
+  uint64_t fields[8];
+  for (int i = 0; i < 8; i++) {
+    const size_t m = getVarint(in + n, len - n, fields[i]);
+    if (m == 0) return 0;
+    n += m;
+  }
+
+  int16_t v[7];
+  if (key) {
+    c.prev_t = fields[0];
+    c.prev_dt = 0;
+    for (int ch = 0; ch < 7; ch++) {
+      v[ch] = (int16_t)unzigzag((uint32_t)fields[1 + ch]);
+      c.prev[ch] = c.prev2[ch] = v[ch];
+    }
+    c.primed = true;
+    c.keyframes++;
+  } else {
+    if (!c.primed) {
+      c.skipped++;
+      return n; // rekord poprawny składniowo, ale bez stanu do odtworzenia
+    }
+    const int32_t dt = c.prev_dt + unzigzag((uint32_t)fields[0]);
+    c.prev_t += (uint64_t)(int64_t)dt;
+    c.prev_dt = dt;
+    for (int ch = 0; ch < 7; ch++) {
+      v[ch] = (int16_t)(uint16_t)((uint16_t)predict(c, ch) + (uint16_t)unzigzag((uint32_t)fields[1 + ch]));
+    }
+    pushHistory(c, v);
+  }
+
+  out.t_us = c.prev_t;
+  float* angles[7] = {&out.roll1, &out.pitch1, &out.yaw1, &out.roll2, &out.pitch2, &out.yaw2, &out.knee_angle};
+  for (int ch = 0; ch < 7; ch++) *angles[ch] = binDecodeAngle(v[ch]);
+  binApplyFlags(hdr & 0x0F, out);
+  have = true;
+  return n;
+}
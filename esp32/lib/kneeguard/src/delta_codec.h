@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+
+/*
+  KneeGuard – bezstratna kompresja strumienia KneeSample (predykcja + zigzag/varint)
+
+  Kąty są kodowane w tych samych jednostkach co ramka binarna (int16, 0.01°),
+  więc dekoder odtwarza dokładnie to, co niesie ramka/rekord 17 B.
+
+  Rekord próbki:
+    [0]  nagłówek: bit7 = klatka kluczowa, bity 0..3 = flagi (binSampleFlags)
+    klatka kluczowa: varint(t_us, 64 bit), 7 x zigzag-varint(kąt) – wartości bezwzględne
+    przyrost:        zigzag-varint(dt - dt_poprz),                – dt = t_us - t_poprz
+                     7 x zigzag-varint(kąt - predykcja)
+  Predykcja liniowa: 2 * x[n-1] - x[n-2] (stała prędkość kątowa); arytmetyka
+  modulo 2^16, więc przejście przez ±180° i ANGLE_INVALID też są bezstratne.
+  Typowo 9..11 B na próbkę (rekord stały: 17 B, ramka: 29 B).
+
+  Klatka kluczowa co keyframe_interval próbek (0 = tylko pierwsza) pozwala
+  dekoderowi wznowić strumień po utracie danych: bez stanu (po deltaCodecResync)
+  rekordy przyrostowe są pomijane aż do najbliższej klatki kluczowej.
+*/
+
+static const size_t  DELTA_SAMPLE_MAX  = 1 + 10 + 7 * 3; // najdłuższy rekord (klatka, t_us 64 bit)
+static const size_t  DELTA_SAMPLE_MIN  = 1 + 1 + 7;     // przyrost z zerowymi resztami
+static const uint8_t DELTA_FLAG_KEY    = 0x80;
+static const uint64_t DELTA_DT_MAX_US  = 0x3FFFFFFF;  // dt i dt - dt_poprz mieszczą się w int32
+
+struct DeltaCodec {
+  uint16_t keyframe_interval = 0;
+  uint16_t since_key = 0;
+  bool     primed    = false; // jest stan poprzednich próbek (koder: klatka już wysłana)
+
+  int16_t  prev[7];
+  int16_t  prev2[7];
+  uint64_t prev_t  = 0;
+  int32_t  prev_dt = 0;
+
+  uint32_t keyframes = 0;     // statystyka: wysłane/odebrane klatki kluczowe
+  uint32_t skipped   = 0;     // dekoder: rekordy pominięte w oczekiwaniu na klatkę
+};
+
+void deltaCodecInit(DeltaCodec& c, uint16_t keyframe_interval);
+
+// Kolejna próbka zostanie zakodowana jako klatka kluczowa (nowy blok / nowa paczka).
+static inline void deltaForceKeyframe(DeltaCodec& c) { c.primed = false; }
+
+// Dekoder: utracono dane – rekordy przyrostowe ignorowane do klatki kluczowej.
+static inline void deltaCodecResync(DeltaCodec& c) { c.primed = false; }
+
+// Kodowanie próbki do out (co najmniej DELTA_SAMPLE_MAX B); zwraca liczbę bajtów.
+size_t deltaEncode(DeltaCodec& c, const KneeSample& s, uint8_t* out);
+
+// Dekodowanie jednego rekordu; zwraca liczbę zużytych bajtów (0 = rekord
+// niepełny/uszkodzony). have = false, gdy rekord pominięto (brak klatki kluczowej).
+size_t deltaDecode(DeltaCodec& c, const uint8_t* in, size_t len, KneeSample& out, bool& have);
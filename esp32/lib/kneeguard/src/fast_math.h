@@ -0,0 +1,73 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+  KneeGuard – szybka matematyka dla gorącej ścieżki fuzji
+
+  KG_FAST_MATH (domyślnie 1) wybiera w czasie kompilacji implementację
+  kgAtan2Deg / kgInvSqrt / kgSqrt: 1 = wielomian + Newton, 0 = libm.
+  Obie wersje są zawsze dostępne (…Fast / …Libm), żeby testy mogły je porównać.
+
+  Gwarantowane (i sprawdzane w test/test_fast_math na całej dziedzinie) błędy:
+  - atan2DegFast:  |błąd| <= FAST_ATAN2_MAX_ERR_DEG (wielomian A&S 4.4.49, ~1e-5 rad),
+  - invSqrtFast:   błąd względny <= FAST_INV_SQRT_MAX_REL_ERR (2 kroki Newtona),
+                   dla 1e-30 <= v <= 1e30.
+*/
+
+#ifndef KG_FAST_MATH
+#define KG_FAST_MATH 1
+#endif
+
+static const float FAST_ATAN2_MAX_ERR_DEG    = 1.0e-3f;
+static const float FAST_INV_SQRT_MAX_REL_ERR = 1.0e-5f;
+
+// atan2 w stopniach [-180..180]: redukcja do z = min/max w [0..1], wielomian
+// nieparzysty 9. stopnia, potem odbicia do właściwej ćwiartki (bez funkcji libm).
+static inline float atan2DegFast(float y, float x) {
+  const float ax = fabsf(x), ay = fabsf(y);
+  const float mx = ax > ay ? ax : ay;
+  const float mn = ax > ay ? ay : ax;
+  if (mx == 0.0f) return 0.0f;
+
+  const float z  = mn / mx;
+  const float z2 = z * z;
+  // współczynniki A&S 4.4.49 przeskalowane do stopni (* 180/pi)
+  float a = z * (57.28810f + z2 * (-18.92477f + z2 * (10.32132f + z2 * (-4.877762f + z2 * 1.193763f))));
+
+  if (ay > ax) a = 90.0f - a;
+  if (x < 0.0f) a = 180.0f - a;
+  return y < 0.0f ? -a : a;
+}
+
+static inline float atan2DegLibm(float y, float x) {
+  return atan2f(y, x) * (180.0f / 3.14159265358979f);
+}
+
+// 1/sqrt(v): przybliżenie z reprezentacji bitowej + 2 kroki Newtona.
+static inline float invSqrtFast(float v) {
+  uint32_t i;
+  memcpy(&i, &v, sizeof(i));
+  i = 0x5F375A86u - (i >> 1);
+  float y;
+  memcpy(&y, &i, sizeof(y));
+  const float h = 0.5f * v;
+  y *= 1.5f - h * y * y;
+  y *= 1.5f - h * y * y;
+  return y;
+}
+
+static inline float invSqrtLibm(float v) { return 1.0f / sqrtf(v); }
+
+#if KG_FAST_MATH
+static inline float kgAtan2Deg(float y, float x) { return atan2DegFast(y, x); }
+static inline float kgInvSqrt(float v) { return invSqrtFast(v); }
+#else
+static inline float kgAtan2Deg(float y, float x) { return atan2DegLibm(y, x); }
+static inline float kgInvSqrt(float v) { return invSqrtLibm(v); }
+#endif
+
+// sqrt(v) przez kgInvSqrt (v <= 0 -> 0).
+static inline float kgSqrt(float v) { return v > 0.0f ? v * kgInvSqrt(v) : 0.0f; }
@@ -0,0 +1,199 @@
+#include "fusion.h"
+
+const char* fusionEngineName(FusionEngine e) {
+  switch (e) {
+    case FUSION_KALMAN:   return "kalman";
+    case FUSION_MADGWICK: return "madgwick";
+    case FUSION_MAHONY:   return "mahony";
+  }
+  return "?";
+}
+
+static inline bool usesQuaternion(const ImuState& imu) {
+  return imu.engine != FUSION_KALMAN;
+}
+
+void fuseImuSample(ImuState& imu, const MpuSample& s, float dt) {
+  imu.ax = s.ax;
+  imu.ay = s.ay;
+  imu.az = s.az;
+  imu.gap_s = 0;
+
+  // korekcja bias (z poprawką temperaturową)
+  imu.gx = s.gx - imu.bgx - imu.tc[0];
+  imu.gy = s.gy - imu.bgy - imu.tc[1];
+  imu.gz = s.gz - imu.bgz - imu.tc[2];
+
+  // bezruch między powtórzeniami: poprawka biasu od następnej próbki
+  float corr[3];
+  if (imu.bias.enabled && biasTrackerPush(imu.bias, imu.gx, imu.gy, imu.gz, s.ax, s.ay, s.az, dt, corr)) {
+    imu.bgx += corr[0];
+    imu.bgy += corr[1];
+    imu.bgz += corr[2];
+  }
+
+  if (usesQuaternion(imu)) {
+    // pierwsza próbka: orientacja z akcelerometru zamiast powolnej zbieżności od q = 1
+    if (!imu.q_init) {
+      float r0 = 0, p0 = 0;
+      accelAnglesDeg(imu.ax, imu.ay, imu.az, r0, p0);
+      imu.q = quatFromRollPitchDeg(r0, p0);
+      imu.q_init = true;
+    }
+    const float gx = imu.gx * KG_RAD_PER_DEG;
+    const float gy = imu.gy * KG_RAD_PER_DEG;
+    const float gz = imu.gz * KG_RAD_PER_DEG;
+    if (imu.engine == FUSION_MADGWICK) {
+      madgwickUpdateImu(imu.q, gx, gy, gz, imu.ax, imu.ay, imu.az, MADGWICK_BETA, dt);
+    } else {
+      mahonyUpdateImu(imu.q, imu.mahony, gx, gy, gz, imu.ax, imu.ay, imu.az, MAHONY_KP, MAHONY_KI, dt);
+    }
+    return;
+  }
+
+  float rAcc = 0, pAcc = 0;
+
+  // pomiar roll/pitch z akcelerometru + aktualizacja Kalmana
+  accelAnglesDeg(imu.ax, imu.ay, imu.az, rAcc, pAcc);
+  kalmanUpdate(imu.k_roll,  imu.gx, rAcc, dt);
+  kalmanUpdate(imu.k_pitch, imu.gy, pAcc, dt);
+
+  // yaw integrowany z żyroskopu (będzie dryfować)
+  imu.yaw = wrap180(imu.yaw + imu.gz * dt);
+}
+
+bool propagateGyroOnly(ImuState& imu, float dt) {
+  imu.gap_s += dt;
+  if (imu.gap_s > GAP_FILL_MAX_S) return false;
+
+  // imu.gx/gy/gz: ostatnia prędkość po korekcji bias
+  if (usesQuaternion(imu)) {
+    if (!imu.q_init) return false;
+    // zerowy akcelerometr = sama integracja żyroskopu (bez kroku korekcji)
+    madgwickUpdateImu(imu.q, imu.gx * KG_RAD_PER_DEG, imu.gy * KG_RAD_PER_DEG, imu.gz * KG_RAD_PER_DEG,
+                      0.0f, 0.0f, 0.0f, MADGWICK_BETA, dt);
+    return true;
+  }
+
+  // predykcja Kalmana bez pomiaru: niepewność rośnie, korekta wróci z próbką
+  imu.k_roll.angle_deg  += dt * imu.gx;
+  imu.k_roll.uncert     += dt * dt * KALMAN_Q;
+  imu.k_pitch.angle_deg += dt * imu.gy;
+  imu.k_pitch.uncert    += dt * dt * KALMAN_Q;
+  imu.yaw = wrap180(imu.yaw + imu.gz * dt);
+  return true;
+}
+
+void imuSetTemperature(ImuState& imu, float temp_c) {
+  imu.temp_c = temp_c;
+  imu.has_temp = true;
+  for (int i = 0; i < 3; i++) imu.tc[i] = imu.tk[i] * (temp_c - TEMP_REF_C);
+}
+
+void imuSetTempSlopes(ImuState& imu, const float k[3]) {
+  float* bg[3] = {&imu.bgx, &imu.bgy, &imu.bgz};
+  for (int i = 0; i < 3; i++) {
+    const float now = *bg[i] + imu.tc[i];
+    imu.tk[i] = k[i];
+    imu.tc[i] = k[i] * (imu.temp_c - TEMP_REF_C);
+    *bg[i] = now - imu.tc[i];
+  }
+}
+
+void setFusionEngine(ImuState& imu, FusionEngine e) {
+  if (e == imu.engine) return;
+
+  float roll = 0, pitch = 0, yaw = 0;
+  imuEulerDeg(imu, roll, pitch, yaw);
+
+  imu.engine = e;
+  if (usesQuaternion(imu)) {
+    // q startuje z akcelerometru przy następnej próbce; offsety "calib" przechodzą na q_off
+    imu.q_init = false;
+    imu.mahony = MahonyState();
+    imu.q_off = quatMul(quatFromAxisAngleDeg(0.0f, 0.0f, 1.0f, imu.off_yaw),
+                        quatFromRollPitchDeg(imu.off_roll, imu.off_pitch));
+  } else {
+    imu.k_roll.angle_deg  = roll;
+    imu.k_pitch.angle_deg = pitch;
+    imu.yaw = yaw;
+  }
+}
+
+void imuEulerDeg(const ImuState& imu, float& roll_deg, float& pitch_deg, float& yaw_deg) {
+  if (usesQuaternion(imu)) {
+    quatToEulerDeg(imu.q, roll_deg, pitch_deg, yaw_deg);
+    return;
+  }
+  roll_deg  = imu.k_roll.angle_deg;
+  pitch_deg = imu.k_pitch.angle_deg;
+  yaw_deg   = imu.yaw;
+}
+
+void captureMountOffsets(ImuState& imu) {
+  imuEulerDeg(imu, imu.off_roll, imu.off_pitch, imu.off_yaw);
+  imu.q_off = imu.q;
+}
+
+// Kąt względnego obrotu podudzia względem uda, odniesiony do pozycji z "calib":
+// r = q1* q2 (podudzie w układzie uda), d = r0* r, kąt(d) w [0..180].
+static float kneeAngleFromQuat(const ImuState& imu1, const ImuState& imu2) {
+  const Quat r  = quatMul(quatConj(imu1.q), imu2.q);
+  const Quat r0 = quatMul(quatConj(imu1.q_off), imu2.q_off);
+  return quatAngleDeg(quatMul(quatConj(r0), r));
+}
+
+float jointAngleDeg(const ImuState& a, bool ok_a, const ImuState& b, bool ok_b) {
+  if (!ok_a || !ok_b) return ANGLE_INVALID;
+  if (usesQuaternion(a) && usesQuaternion(b)) return kneeAngleFromQuat(a, b);
+  float ra = 0, rb = 0, p = 0, y = 0;
+  imuEulerDeg(a, ra, p, y);
+  imuEulerDeg(b, rb, p, y);
+  return fabsf(angleDiffDeg(rb - b.off_roll, ra - a.off_roll));
+}
+
+void computeKneeSample(uint64_t t_us,
+                       const ImuState& imu1, bool ok1,
+                       const ImuState& imu2, bool ok2,
+                       KneeSample& out) {
+  out.t_us = t_us;
+
+  float r1 = 0, p1 = 0, y1 = 0, r2 = 0, p2 = 0, y2 = 0;
+  if (ok1) imuEulerDeg(imu1, r1, p1, y1);
+  if (ok2) imuEulerDeg(imu2, r2, p2, y2);
+
+  // Korekta o offsety (po komendzie "calib")
+  out.roll1  = ok1 ? (r1 - imu1.off_roll)  : ANGLE_INVALID;
+  out.pitch1 = ok1 ? (p1 - imu1.off_pitch) : ANGLE_INVALID;
+  out.yaw1   = ok1 ? wrap180(y1 - imu1.off_yaw) : ANGLE_INVALID;
+
+  out.roll2  = ok2 ? (r2 - imu2.off_roll)  : ANGLE_INVALID;
+  out.pitch2 = ok2 ? (p2 - imu2.off_pitch) : ANGLE_INVALID;
+  out.yaw2   = ok2 ? wrap180(y2 - imu2.off_yaw) : ANGLE_INVALID;
+
+  // Prosta diagnostyka orientacji (az < 0 oznacza, że IMU jest odwrócone)
+  out.inv1 = ok1 && (imu1.az < 0.0f);
+  out.inv2 = ok2 && (imu2.az < 0.0f);
+
+  out.q1 = imuQuality(imu1, ok1);
+  out.q2 = imuQuality(imu2, ok2);
+
+  // Kąt zgięcia kolana: względny obrót (kwaterniony) albo dodatnia minimalna
+  // różnica kątowa roll (0..180)
+  out.knee_angle = jointAngleDeg(imu1, ok1, imu2, ok2);
+}
+
+bool fuseImuStep(ImuState& imu, bool ok, const MpuSample& s, float dt) {
+  if (!ok) return propagateGyroOnly(imu, dt);
+  fuseImuSample(imu, s, dt);
+  return true;
+}
+
+void fuseKneeStep(uint64_t t_us, float dt,
+                  ImuState& imu1, bool ok1, const MpuSample& s1,
+                  ImuState& imu2, bool ok2, const MpuSample& s2,
+                  KneeSample& out) {
+  const bool v1 = fuseImuStep(imu1, ok1, s1, dt);
+  const bool v2 = fuseImuStep(imu2, ok2, s2, dt);
+  computeKneeSample(t_us, imu1, v1, imu2, v2, out);
+}
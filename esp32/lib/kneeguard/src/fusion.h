@@ -0,0 +1,183 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ahrs.h"
+#include "bias_tracker.h"
+#include "kg_math.h"
+#include "mpu6050.h"
+#include "quaternion.h"
+
+/*
+  KneeGuard – fuzja danych IMU (przenośna część potoku z main.cpp)
+
+  Silnik fuzji wybierany osobno dla każdego IMU (ImuState::engine):
+  - FUSION_KALMAN: roll/pitch z filtra Kalmana 1D, yaw z integracji gz,
+    kąt kolana = |angleDiff(roll2, roll1)| (tylko płaszczyzna strzałkowa)
+  - FUSION_MADGWICK / FUSION_MAHONY: kwaternion orientacji 6-DoF; gdy oba IMU
+    używają kwaternionów, kąt kolana = kąt względnego obrotu udo -> podudzie
+    (względem pozycji z "calib"), niezależnie od płaszczyzny ruchu
+
+  Krótka przerwa w odczytach (błąd I2C, odzyskiwanie magistrali) jest
+  wypełniana integracją ostatniej prędkości kątowej (propagateGyroOnly) przez
+  najwyżej GAP_FILL_MAX_S; takie próbki mają jakość QUALITY_GYRO_ONLY,
+  dopiero dłuższa przerwa daje ANGLE_INVALID (QUALITY_INVALID).
+*/
+
+enum FusionEngine : uint8_t {
+  FUSION_KALMAN   = 0,
+  FUSION_MADGWICK = 1,
+  FUSION_MAHONY   = 2,
+};
+
+const char* fusionEngineName(FusionEngine e);
+
+// Wartość wysyłana, gdy odczyt IMU się nie powiódł
+static const float ANGLE_INVALID = -999.0f;
+
+// Najdłuższa przerwa w danych IMU wypełniana samym żyroskopem
+static const float GAP_FILL_MAX_S = 0.25f;
+
+// Jakość kątów jednego IMU w próbce wyjściowej
+enum SampleQuality : uint8_t {
+  QUALITY_MEASURED  = 0, // fuzja z bieżącego odczytu czujnika
+  QUALITY_GYRO_ONLY = 1, // przerwa w odczytach wypełniona integracją żyroskopu
+  QUALITY_INVALID   = 2, // brak danych (kąty = ANGLE_INVALID)
+};
+
+// Temperatura odniesienia modelu bias(T) = bg + tk * (T - TEMP_REF_C)
+static const float TEMP_REF_C = 25.0f;
+
+// Q = niepewność modelu (żyroskop: dryf/szum), R = niepewność pomiaru (akcelerometr);
+// strojenie bez zmian w kodzie: -DKG_KALMAN_Q=... / -DKG_KALMAN_R=... (test/bench_knee_sim)
+#ifndef KG_KALMAN_Q
+#define KG_KALMAN_Q 16.0f
+#endif
+#ifndef KG_KALMAN_R
+#define KG_KALMAN_R 1.0f
+#endif
+static const float KALMAN_Q = KG_KALMAN_Q; // (deg/s)^2
+static const float KALMAN_R = KG_KALMAN_R; // (deg)^2
+
+struct Kalman1D {
+  float angle_deg = 0.0f; // estymowana wartość kąta
+  float uncert    = 4.0f; // niepewność estymacji
+};
+
+// Nowe pole stanu -> także imuStateEncode/Decode (raw_trace.cpp), inaczej
+// odtwarzanie śladu przestaje być identyczne z firmware.
+struct ImuState {
+  // surowe próbki (po przeskalowaniu)
+  float ax = 0, ay = 0, az = 0;
+  float gx = 0, gy = 0, gz = 0;
+
+  // bias żyroskopu (kalibracja "keep still", potem śledzony w bezruchu);
+  // z modelem temperaturowym: bias w TEMP_REF_C, tc = tk * (temp_c - TEMP_REF_C)
+  float bgx = 0, bgy = 0, bgz = 0;
+  BiasTracker bias;
+  float temp_c   = TEMP_REF_C; // temperatura czujnika (TEMP_OUT)
+  bool  has_temp = false;
+  float tk[3] = {0, 0, 0};     // nachylenie biasu [dps/°C]
+  float tc[3] = {0, 0, 0};     // bieżąca poprawka temperaturowa [dps]
+
+  FusionEngine engine = FUSION_KALMAN;
+
+  // fuzja (FUSION_KALMAN): roll/pitch z Kalmana, yaw integrowany z gz
+  Kalman1D k_roll, k_pitch;
+  float yaw = 0;
+
+  // fuzja (FUSION_MADGWICK / FUSION_MAHONY): orientacja ciało -> świat
+  Quat q;
+  MahonyState mahony;
+  bool q_init = false; // q zainicjalizowany z akcelerometru
+
+  // offsety po komendzie "calib" (referencja dla montażu na nodze)
+  float off_roll = 0, off_pitch = 0, off_yaw = 0;
+  Quat  q_off;
+
+  // czas bieżącej przerwy w odczytach (0 = ostatnia próbka z czujnika)
+  float gap_s = 0;
+};
+
+// Jedna próbka wyjściowa potoku (kąty po korekcie offsetów + diagnostyka)
+// t_us: monotoniczny czas 64-bit (esp_timer) – bez zawinięcia micros() co ~71.6 min.
+struct KneeSample {
+  uint64_t t_us = 0;
+  float roll1 = 0, pitch1 = 0, yaw1 = 0;
+  float roll2 = 0, pitch2 = 0, yaw2 = 0;
+  float knee_angle = 0;
+  bool inv1 = false, inv2 = false;
+  SampleQuality q1 = QUALITY_MEASURED, q2 = QUALITY_MEASURED;
+};
+
+static inline void kalmanUpdate(Kalman1D& k, float rate_dps, float meas_deg, float dt) {
+  k.angle_deg += dt * rate_dps;
+  k.uncert    += dt * dt * KALMAN_Q;
+
+  const float K = k.uncert / (k.uncert + KALMAN_R);
+  k.angle_deg += K * (meas_deg - k.angle_deg);
+  k.uncert     = (1.0f - K) * k.uncert;
+}
+
+// Aktualizacja stanu IMU nową (przeskalowaną) próbką: korekcja bias + krok
+// wybranego silnika (Kalman + yaw albo kwaternion Madgwick/Mahony). Bias jest
+// poprawiany po każdym nieruchomym oknie BiasTracker (imu.bias.enabled).
+void fuseImuSample(ImuState& imu, const MpuSample& s, float dt);
+
+// Brak próbki (błąd odczytu): orientacja przesuwana ostatnią prędkością kątową
+// (bez korekcji z akcelerometru). false, gdy przerwa przekroczyła GAP_FILL_MAX_S
+// albo nie ma jeszcze orientacji do propagacji – wtedy kąty są nieważne.
+bool propagateGyroOnly(ImuState& imu, float dt);
+
+// Nowa temperatura czujnika (wolnozmienna: odczyt co ~1 s w trybie FIFO) –
+// przeliczenie poprawki tc, żeby fuzja płaciła tylko 3 odejmowania na próbkę.
+void imuSetTemperature(ImuState& imu, float temp_c);
+
+// Nowe nachylenia modelu: bg przeliczane tak, żeby bias w bieżącej
+// temperaturze się nie zmienił (bez skoku kątów).
+void imuSetTempSlopes(ImuState& imu, const float k[3]);
+
+// Bias bezwzględny w bieżącej temperaturze (bg + tc) [dps].
+static inline float imuBiasNow(const ImuState& imu, int axis) {
+  const float bg[3] = {imu.bgx, imu.bgy, imu.bgz};
+  return bg[axis] + imu.tc[axis];
+}
+
+// Zmiana silnika fuzji: Kalman startuje od bieżących kątów, kwaternion od
+// akcelerometru (przy najbliższej próbce).
+void setFusionEngine(ImuState& imu, FusionEngine e);
+
+// Kąty roll/pitch/yaw [deg] bez offsetów, niezależnie od silnika.
+void imuEulerDeg(const ImuState& imu, float& roll_deg, float& pitch_deg, float& yaw_deg);
+
+// Zapamiętanie bieżącej orientacji jako punktu odniesienia (komenda "calib").
+void captureMountOffsets(ImuState& imu);
+
+// Jakość kątów IMU po kroku fuzji (ok = wynik fuseImuStep).
+static inline SampleQuality imuQuality(const ImuState& imu, bool ok) {
+  return !ok ? QUALITY_INVALID : (imu.gap_s > 0.0f ? QUALITY_GYRO_ONLY : QUALITY_MEASURED);
+}
+
+// Kąt stawu między segmentem bliższym (a) i dalszym (b), 0..180 – jak knee_angle
+// (kwaterniony: względny obrót od "calib", Kalman: różnica roll); nieważny
+// odczyt którejkolwiek strony -> ANGLE_INVALID.
+float jointAngleDeg(const ImuState& a, bool ok_a, const ImuState& b, bool ok_b);
+
+// Złożenie próbki wyjściowej z obu IMU; nieudany odczyt -> ANGLE_INVALID.
+// Jakość q1/q2: QUALITY_GYRO_ONLY, gdy IMU jest w trakcie przerwy (gap_s > 0).
+void computeKneeSample(uint64_t t_us,
+                       const ImuState& imu1, bool ok1,
+                       const ImuState& imu2, bool ok2,
+                       KneeSample& out);
+
+// Krok jednego IMU: fuzja próbki albo (ok = false) propagacja żyroskopem;
+// false = kąty nieważne.
+bool fuseImuStep(ImuState& imu, bool ok, const MpuSample& s, float dt);
+
+// Jeden krok potoku dla pary próbek – wspólny dla firmware i odtwarzania śladu
+// (raw_trace.h): fuzja albo (ok = false) propagacja żyroskopem każdego IMU,
+// potem próbka wyjściowa.
+void fuseKneeStep(uint64_t t_us, float dt,
+                  ImuState& imu1, bool ok1, const MpuSample& s1,
+                  ImuState& imu2, bool ok2, const MpuSample& s2,
+                  KneeSample& out);
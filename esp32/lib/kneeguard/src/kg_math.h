@@ -0,0 +1,49 @@
+#pragma once
+
+#include <math.h>
+
+#include "fast_math.h"
+
+/*
+  KneeGuard – matematyka kątów (przenośna, bez zależności od Arduino)
+
+  Funkcje używane w gorącej ścieżce fuzji: przeliczenia stopnie/radiany,
+  zawijanie kąta do [-180..180], różnica kątowa i kąty z akcelerometru.
+  atan2/sqrt idą przez fast_math.h (KG_FAST_MATH).
+*/
+
+static const float KG_PI          = 3.14159265358979f;
+static const float KG_DEG_PER_RAD = 180.0f / KG_PI;
+static const float KG_RAD_PER_DEG = KG_PI / 180.0f;
+
+// Zawijanie kąta o więcej niż jeden obrót poza [-180..180]: odjęcie 360 * floorf
+// (czas niezależny od |deg|); dla |deg| >= 1e6 fmodf – iloczyn 360 * k traciłby
+// bity. NaN / ±inf -> NaN.
+static inline float wrap180Far(float deg) {
+  if (!isfinite(deg)) return NAN;
+  float r = fabsf(deg) < 1.0e6f ? deg - 360.0f * floorf((deg + 180.0f) * (1.0f / 360.0f))
+                                : fmodf(deg, 360.0f);
+  if (r > 180.0f) r -= 360.0f; // zaokrąglenie ilorazu przy granicy przedziału / reszta fmodf
+  else if (r < -180.0f) r += 360.0f;
+  return r;
+}
+
+// Zawijanie do [-180..180]: w fuzji kąt wychodzi poza przedział najwyżej o jeden obrót –
+// jeden krok pętli; dalsze wartości (i NaN) przez wrap180Far zamiast pętli bez końca.
+static inline float wrap180(float deg) {
+  if (deg >= -180.0f && deg <= 180.0f) return deg;
+  if (deg > 180.0f && deg <= 540.0f) return deg - 360.0f;
+  if (deg < -180.0f && deg >= -540.0f) return deg + 360.0f;
+  return wrap180Far(deg);
+}
+
+// Minimalna różnica kątowa (wynik w [-180..180]), odporna na przejście przez ±180°.
+static inline float angleDiffDeg(float a1_deg, float a2_deg) {
+  return wrap180(a1_deg - a2_deg);
+}
+
+// Kąty z akcelerometru (roll/pitch) – atan2 daje poprawny znak i ćwiartkę.
+static inline void accelAnglesDeg(float ax, float ay, float az, float& roll_deg, float& pitch_deg) {
+  roll_deg  = kgAtan2Deg(ay, az);                      // [-180..180]
+  pitch_deg = kgAtan2Deg(-ax, kgSqrt(ay * ay + az * az)); // [-90..90]
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// KneeGuard – zapis/odczyt liczb little-endian w buforach ramek i bloków.
+
+static inline void putLe16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void putLe32(uint8_t* p, uint32_t v) {
+  putLe16(p, (uint16_t)(v & 0xFFFF));
+  putLe16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void putLe64(uint8_t* p, uint64_t v) {
+  putLe32(p, (uint32_t)v);
+  putLe32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint16_t getLe16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getLe32(const uint8_t* p) {
+  return (uint32_t)getLe16(p) | ((uint32_t)getLe16(p + 2) << 16);
+}
+
+static inline uint64_t getLe64(const uint8_t* p) {
+  return (uint64_t)getLe32(p) | ((uint64_t)getLe32(p + 4) << 32);
+}
+
+static inline void putLeF32(uint8_t* p, float v) {
+  uint32_t u;
+  memcpy(&u, &v, sizeof(u));
+  putLe32(p, u);
+}
+
+static inline float getLeF32(const uint8_t* p) {
+  const uint32_t u = getLe32(p);
+  float v;
+  memcpy(&v, &u, sizeof(v));
+  return v;
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – MPU6050: mapa rejestrów i dekodowanie surowych danych
+
+  Tylko logika niezależna od magistrali (bez Wire) – dzięki temu dekodowanie
+  można testować i mierzyć na hoście.
+*/
+
+// Adresy rejestrów
+static const uint8_t MPU_REG_SMPLRT_DIV   = 0x19; // Fs = Fgyro / (1 + SMPLRT_DIV)
+static const uint8_t MPU_REG_CONFIG       = 0x1A; // DLPF
+static const uint8_t MPU_REG_GYRO_CONFIG  = 0x1B;
+static const uint8_t MPU_REG_ACCEL_CONFIG = 0x1C;
+static const uint8_t MPU_REG_FIFO_EN      = 0x23;
+static const uint8_t MPU_REG_INT_PIN_CFG  = 0x37;
+static const uint8_t MPU_REG_INT_ENABLE   = 0x38;
+static const uint8_t MPU_REG_INT_STATUS   = 0x3A;
+static const uint8_t MPU_REG_ACCEL_XOUT_H = 0x3B; // początek bloku 14 B (acc, temp, gyro)
+static const uint8_t MPU_REG_TEMP_OUT_H   = 0x41;
+static const uint8_t MPU_REG_USER_CTRL    = 0x6A;
+static const uint8_t MPU_REG_PWR_MGMT_1   = 0x6B;
+static const uint8_t MPU_REG_FIFO_COUNT_H = 0x72;
+static const uint8_t MPU_REG_FIFO_R_W     = 0x74;
+static const uint8_t MPU_REG_WHO_AM_I     = 0x75;
+
+static const size_t MPU_BURST_LEN = 14;
+
+// FIFO: akcelerometr + żyroskop (bez temperatury) -> 12 B na próbkę
+static const uint8_t  MPU_FIFO_EN_ACCEL_GYRO   = 0x78; // XG | YG | ZG | ACCEL
+static const uint8_t  MPU_USER_CTRL_FIFO_EN    = 0x40;
+static const uint8_t  MPU_USER_CTRL_FIFO_RESET = 0x04;
+static const uint16_t MPU_FIFO_SIZE            = 1024;
+static const size_t   MPU_FIFO_FRAME_LEN       = 12;
+
+// INT: impuls 50 us, aktywny wysoki, push-pull, przy każdej nowej próbce (data-ready)
+static const uint8_t  MPU_INT_PIN_CFG_PULSE    = 0x10; // INT_RD_CLEAR, bez LATCH_INT_EN
+static const uint8_t  MPU_INT_DATA_RDY         = 0x01; // INT_ENABLE / INT_STATUS
+
+// Skale MPU6050 (konfiguracja domyślna: ±8 g, ±500 dps)
+static const float ACC_LSB_PER_G    = 4096.0f;
+static const float GYRO_LSB_PER_DPS = 65.5f;
+
+// Zakresy pomiarowe: pole FS_SEL (bity 4:3) w ACCEL_CONFIG / GYRO_CONFIG
+enum MpuAccelRange : uint8_t {
+  MPU_ACCEL_2G  = 0,
+  MPU_ACCEL_4G  = 1,
+  MPU_ACCEL_8G  = 2,
+  MPU_ACCEL_16G = 3,
+};
+
+enum MpuGyroRange : uint8_t {
+  MPU_GYRO_250DPS  = 0,
+  MPU_GYRO_500DPS  = 1,
+  MPU_GYRO_1000DPS = 2,
+  MPU_GYRO_2000DPS = 3,
+};
+
+static const uint8_t MPU_DLPF_MAX    = 6;       // 7 = zarezerwowane
+static const float   MPU_RATE_MAX_HZ = 1000.0f; // limit akwizycji (FIFO_DRAIN_MAX / takt)
+
+// Konfiguracja czujnika zmieniana w locie (komendy "rate", "dlpf", "accel", "gyro")
+struct MpuConfig {
+  uint8_t       dlpf_cfg    = 0x05; // DLPF ~10 Hz -> żyroskop 1 kHz
+  uint8_t       smplrt_div  = 1;    // 1 kHz / (1 + 1) = 500 Hz
+  MpuAccelRange accel_range = MPU_ACCEL_8G;
+  MpuGyroRange  gyro_range  = MPU_GYRO_500DPS;
+};
+
+// Mnożniki LSB -> [g] / [deg/s] dla bieżących zakresów
+struct MpuScaleFactors {
+  float g_per_lsb   = 1.0f / ACC_LSB_PER_G;
+  float dps_per_lsb = 1.0f / GYRO_LSB_PER_DPS;
+};
+
+static inline uint8_t mpuRangeReg(uint8_t fs_sel) { return (uint8_t)((fs_sel & 0x03) << 3); }
+
+static inline float mpuAccelLsbPerG(MpuAccelRange r) {
+  return 16384.0f / (float)(1 << (r & 0x03));
+}
+
+static inline float mpuGyroLsbPerDps(MpuGyroRange r) {
+  static const float LSB[4] = {131.0f, 65.5f, 32.8f, 16.4f};
+  return LSB[r & 0x03];
+}
+
+static inline int mpuAccelRangeG(MpuAccelRange r) { return 2 << (r & 0x03); }
+static inline int mpuGyroRangeDps(MpuGyroRange r) { return 250 << (r & 0x03); }
+
+// Zakres z wartości w g / dps (2/4/8/16, 250/500/1000/2000); false dla innych.
+static inline bool mpuAccelRangeFromG(int g, MpuAccelRange& out) {
+  for (uint8_t i = 0; i < 4; i++) {
+    if (mpuAccelRangeG((MpuAccelRange)i) == g) { out = (MpuAccelRange)i; return true; }
+  }
+  return false;
+}
+
+static inline bool mpuGyroRangeFromDps(int dps, MpuGyroRange& out) {
+  for (uint8_t i = 0; i < 4; i++) {
+    if (mpuGyroRangeDps((MpuGyroRange)i) == dps) { out = (MpuGyroRange)i; return true; }
+  }
+  return false;
+}
+
+static inline MpuScaleFactors mpuScaleFactors(const MpuConfig& cfg) {
+  MpuScaleFactors f;
+  f.g_per_lsb   = 1.0f / mpuAccelLsbPerG(cfg.accel_range);
+  f.dps_per_lsb = 1.0f / mpuGyroLsbPerDps(cfg.gyro_range);
+  return f;
+}
+
+// Surowe rejestry jednej próbki (kolejność jak w bloku 0x3B..0x48)
+struct MpuRaw {
+  int16_t ax = 0, ay = 0, az = 0;
+  int16_t temp = 0;
+  int16_t gx = 0, gy = 0, gz = 0;
+};
+
+// Surowe rejestry obu IMU z jednego taktu akwizycji
+struct MpuRawPair {
+  uint32_t t_us = 0;
+  MpuRaw imu1, imu2;
+};
+
+// Próbka po przeskalowaniu: [g] oraz [deg/s]
+struct MpuSample {
+  float ax = 0, ay = 0, az = 0;
+  float gx = 0, gy = 0, gz = 0;
+};
+
+static inline int16_t mpuBe16(const uint8_t* p) {
+  return (int16_t)((p[0] << 8) | p[1]);
+}
+
+// Dekodowanie bloku 14 B odczytanego od ACCEL_XOUT_H (big-endian).
+static inline void mpuDecodeBurst(const uint8_t* raw, MpuRaw& out) {
+  out.ax   = mpuBe16(raw + 0);
+  out.ay   = mpuBe16(raw + 2);
+  out.az   = mpuBe16(raw + 4);
+  out.temp = mpuBe16(raw + 6);
+  out.gx   = mpuBe16(raw + 8);
+  out.gy   = mpuBe16(raw + 10);
+  out.gz   = mpuBe16(raw + 12);
+}
+
+// Temperatura struktury czujnika [°C] z TEMP_OUT (datasheet: raw / 340 + 36.53).
+static inline float mpuTempC(int16_t raw) {
+  return (float)raw * (1.0f / 340.0f) + 36.53f;
+}
+
+// Dekodowanie jednej ramki FIFO (12 B: acc XYZ, gyro XYZ; bez temperatury).
+static inline void mpuDecodeFifoFrame(const uint8_t* raw, MpuRaw& out) {
+  out.ax   = mpuBe16(raw + 0);
+  out.ay   = mpuBe16(raw + 2);
+  out.az   = mpuBe16(raw + 4);
+  out.temp = 0;
+  out.gx   = mpuBe16(raw + 6);
+  out.gy   = mpuBe16(raw + 8);
+  out.gz   = mpuBe16(raw + 10);
+}
+
+// Częstotliwość próbkowania [Hz] wynikająca z DLPF_CFG i SMPLRT_DIV
+// (żyroskop pracuje z 8 kHz przy DLPF 0/7, w pozostałych przypadkach z 1 kHz).
+static inline float mpuSampleRateHz(uint8_t dlpf_cfg, uint8_t smplrt_div) {
+  const uint8_t cfg = dlpf_cfg & 0x07;
+  const float gyro_rate_hz = (cfg == 0 || cfg == 7) ? 8000.0f : 1000.0f;
+  return gyro_rate_hz / (1.0f + smplrt_div);
+}
+
+static inline float mpuSampleRateHz(const MpuConfig& cfg) {
+  return mpuSampleRateHz(cfg.dlpf_cfg, cfg.smplrt_div);
+}
+
+// SMPLRT_DIV dający częstotliwość najbliższą rate_hz przy danym DLPF
+// (wynik ograniczony do 0..255 oraz MPU_RATE_MAX_HZ).
+static inline uint8_t mpuDividerForRate(uint8_t dlpf_cfg, float rate_hz) {
+  const float base_hz = mpuSampleRateHz(dlpf_cfg, 0);
+  if (rate_hz > MPU_RATE_MAX_HZ) rate_hz = MPU_RATE_MAX_HZ;
+  if (rate_hz <= 0.0f) return 255;
+  float div = base_hz / rate_hz - 1.0f;
+  if (div < 0.0f) div = 0.0f;
+  if (div > 255.0f) div = 255.0f;
+  // rate = base / (1 + div) nie jest liniowe w div: z floor/ceil wybór po błędzie częstotliwości
+  // (floor daje rate >= rate_hz, ceil rate <= rate_hz)
+  uint8_t d = (uint8_t)div;
+  if (d < 255) {
+    const float err_floor = mpuSampleRateHz(dlpf_cfg, d) - rate_hz;
+    const float err_ceil  = rate_hz - mpuSampleRateHz(dlpf_cfg, (uint8_t)(d + 1));
+    if (err_ceil < err_floor) d++;
+  }
+  while (d < 255 && mpuSampleRateHz(dlpf_cfg, d) > MPU_RATE_MAX_HZ) d++;
+  return d;
+}
+
+static inline bool mpuConfigValid(const MpuConfig& cfg) {
+  return cfg.dlpf_cfg <= MPU_DLPF_MAX && cfg.accel_range <= MPU_ACCEL_16G &&
+         cfg.gyro_range <= MPU_GYRO_2000DPS && mpuSampleRateHz(cfg) <= MPU_RATE_MAX_HZ;
+}
+
+// Liczba pełnych ramek w FIFO; -1 przy przepełnieniu (ramki są wtedy
+// rozjechane i wymagany jest reset FIFO). Niepełna ramka zostaje na później.
+static inline int mpuFifoFrames(uint16_t fifo_count) {
+  if (fifo_count >= MPU_FIFO_SIZE) return -1;
+  return (int)(fifo_count / MPU_FIFO_FRAME_LEN);
+}
+
+static inline void mpuScale(const MpuRaw& raw, MpuSample& out) {
+  out.ax = raw.ax / ACC_LSB_PER_G;
+  out.ay = raw.ay / ACC_LSB_PER_G;
+  out.az = raw.az / ACC_LSB_PER_G;
+
+  out.gx = raw.gx / GYRO_LSB_PER_DPS;
+  out.gy = raw.gy / GYRO_LSB_PER_DPS;
+  out.gz = raw.gz / GYRO_LSB_PER_DPS;
+}
+
+// Skalowanie dla dowolnych zakresów (mnożenie zamiast dzielenia).
+static inline void mpuScale(const MpuRaw& raw, const MpuScaleFactors& f, MpuSample& out) {
+  out.ax = raw.ax * f.g_per_lsb;
+  out.ay = raw.ay * f.g_per_lsb;
+  out.az = raw.az * f.g_per_lsb;
+
+  out.gx = raw.gx * f.dps_per_lsb;
+  out.gy = raw.gy * f.dps_per_lsb;
+  out.gz = raw.gz * f.dps_per_lsb;
+}
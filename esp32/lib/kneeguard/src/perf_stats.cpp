@@ -0,0 +1,38 @@
+#include "perf_stats.h"
+
+#include <stdio.h>
+
+uint32_t latencyPercentileUs(const LatencyHist& h, float p) {
+  if (h.count == 0) return 0;
+  const uint64_t rank = (uint64_t)(p * h.count + 0.5f);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += h.buckets[i];
+    if (seen >= rank && seen > 0) {
+      // górna granica kubełka, ale nie więcej niż zaobserwowane maksimum
+      const uint32_t upper = (i + 1 < LATENCY_BUCKETS) ? ((2u << i) - 1) : h.max_us;
+      return upper < h.max_us ? upper : h.max_us;
+    }
+  }
+  return h.max_us;
+}
+
+size_t formatLatencyHist(char* out, size_t cap, const char* name, const LatencyHist& h) {
+  const uint32_t avg = h.count ? (uint32_t)(h.sum_us / h.count) : 0;
+  int n = snprintf(out, cap, "%s n=%lu min=%lu avg=%lu max=%lu p50<=%lu p99<=%lu |",
+                   name, (unsigned long)h.count,
+                   (unsigned long)(h.count ? h.min_us : 0), (unsigned long)avg,
+                   (unsigned long)h.max_us,
+                   (unsigned long)latencyPercentileUs(h, 0.50f),
+                   (unsigned long)latencyPercentileUs(h, 0.99f));
+  if (n < 0 || (size_t)n >= cap) return 0;
+  size_t len = (size_t)n;
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    if (h.buckets[i] == 0) continue;
+    const unsigned long lo = i == 0 ? 0 : (1ul << i);
+    n = snprintf(out + len, cap - len, " %lu:%lu", lo, (unsigned long)h.buckets[i]);
+    if (n < 0 || (size_t)n >= cap - len) return 0;
+    len += (size_t)n;
+  }
+  return len;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – liczniki wydajności: histogramy opóźnień w skali log2
+
+  Kubełek i obejmuje czasy [2^i, 2^(i+1)) us (kubełek 0: 0..1 us, ostatni:
+  wszystko >= 2^(LATENCY_BUCKETS-1) us). Zapis to kilka instrukcji bez dzielenia,
+  więc histogramy mogą być włączone na stałe w gorącej ścieżce.
+  Każdy histogram ma jednego "pisarza" (zadanie); odczyt z innego zadania może
+  zobaczyć niespójne o jedną próbkę liczniki, co dla statystyk jest akceptowalne.
+*/
+
+static const size_t LATENCY_BUCKETS = 20; // do ~0.5 s w ostatnim pełnym kubełku
+
+struct LatencyHist {
+  uint32_t count  = 0;
+  uint32_t min_us = UINT32_MAX;
+  uint32_t max_us = 0;
+  uint64_t sum_us = 0;
+  uint32_t buckets[LATENCY_BUCKETS] = {};
+};
+
+static inline uint8_t latencyBucket(uint32_t us) {
+  if (us < 2) return 0;
+  const uint8_t b = (uint8_t)(31 - __builtin_clz(us));
+  return b < LATENCY_BUCKETS ? b : (uint8_t)(LATENCY_BUCKETS - 1);
+}
+
+static inline void latencyRecord(LatencyHist& h, uint32_t us) {
+  h.count++;
+  h.sum_us += us;
+  if (us < h.min_us) h.min_us = us;
+  if (us > h.max_us) h.max_us = us;
+  h.buckets[latencyBucket(us)]++;
+}
+
+static inline void latencyReset(LatencyHist& h) { h = LatencyHist(); }
+
+// Górna granica kubełka, w którym leży percentyl p (0..1); 0 gdy brak próbek.
+uint32_t latencyPercentileUs(const LatencyHist& h, float p);
+
+// Jedna linia: "<name> n=.. min=.. avg=.. max=.. p50<=.. p99<=.. | <us>:<count> ..."
+// (tylko niepuste kubełki, etykieta = dolna granica w us). Zwraca długość albo 0,
+// gdy bufor jest za mały.
+size_t formatLatencyHist(char* out, size_t cap, const char* name, const LatencyHist& h);
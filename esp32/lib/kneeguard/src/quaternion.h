@@ -0,0 +1,92 @@
+#pragma once
+
+#include <math.h>
+
+#include "kg_math.h"
+
+/*
+  KneeGuard – kwaterniony orientacji (w, x, y, z)
+
+  Konwencja: q opisuje obrót ciało -> świat, kąty Eulera ZYX (yaw, pitch, roll)
+  zgodne z accelAnglesDeg(): roll = atan2(ay, az), pitch = atan2(-ax, ...).
+*/
+
+struct Quat {
+  float w = 1, x = 0, y = 0, z = 0;
+};
+
+static inline Quat quatMake(float w, float x, float y, float z) {
+  Quat q;
+  q.w = w;
+  q.x = x;
+  q.y = y;
+  q.z = z;
+  return q;
+}
+
+static inline Quat quatConj(const Quat& q) {
+  return quatMake(q.w, -q.x, -q.y, -q.z);
+}
+
+static inline Quat quatMul(const Quat& a, const Quat& b) {
+  return quatMake(a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+                  a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                  a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                  a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w);
+}
+
+static inline void quatNormalize(Quat& q) {
+  const float n2 = q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z;
+  if (n2 <= 0.0f) {
+    q = Quat();
+    return;
+  }
+  const float inv = kgInvSqrt(n2);
+  q.w *= inv;
+  q.x *= inv;
+  q.y *= inv;
+  q.z *= inv;
+}
+
+// Obrót o kąt [deg] wokół osi jednostkowej (ax, ay, az).
+static inline Quat quatFromAxisAngleDeg(float ax, float ay, float az, float deg) {
+  const float h = 0.5f * deg * KG_RAD_PER_DEG;
+  const float s = sinf(h);
+  return quatMake(cosf(h), ax * s, ay * s, az * s);
+}
+
+// Orientacja z kątów roll/pitch (yaw = 0), np. inicjalizacja z akcelerometru.
+static inline Quat quatFromRollPitchDeg(float roll_deg, float pitch_deg) {
+  const float hr = 0.5f * roll_deg * KG_RAD_PER_DEG;
+  const float hp = 0.5f * pitch_deg * KG_RAD_PER_DEG;
+  const float cr = cosf(hr), sr = sinf(hr);
+  const float cp = cosf(hp), sp = sinf(hp);
+  return quatMake(cr * cp, sr * cp, cr * sp, -sr * sp);
+}
+
+static inline void quatToEulerDeg(const Quat& q, float& roll_deg, float& pitch_deg, float& yaw_deg) {
+  roll_deg = kgAtan2Deg(2.0f * (q.w * q.x + q.y * q.z),
+                        1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+  float sp = 2.0f * (q.w * q.y - q.z * q.x);
+  if (sp > 1.0f) sp = 1.0f;
+  if (sp < -1.0f) sp = -1.0f;
+  pitch_deg = kgAtan2Deg(sp, kgSqrt(1.0f - sp * sp)); // asin(sp)
+  yaw_deg = kgAtan2Deg(2.0f * (q.w * q.z + q.x * q.y),
+                       1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+}
+
+// Kąt obrotu [deg, 0..180] kwaternionu jednostkowego (niezależny od osi).
+static inline float quatAngleDeg(const Quat& q) {
+  // 2 atan2(|v|, |w|) zamiast 2 acos(|w|): dokładne przy małych kątach
+  // i niewrażliwe na niedokładną normę q
+  const float v = kgSqrt(q.x * q.x + q.y * q.y + q.z * q.z);
+  return 2.0f * kgAtan2Deg(v, fabsf(q.w));
+}
+
+// Obrót wektora v przez q (v' = q v q*), np. grawitacja świat -> ciało przez quatConj(q).
+static inline void quatRotate(const Quat& q, float& vx, float& vy, float& vz) {
+  const Quat p = quatMul(quatMul(q, quatMake(0.0f, vx, vy, vz)), quatConj(q));
+  vx = p.x;
+  vy = p.y;
+  vz = p.z;
+}
@@ -0,0 +1,233 @@
+#include "raw_trace.h"
+
+#include <string.h>
+
+#include "binary_frame.h"
+#include "le_bytes.h"
+
+static const size_t IMU_STATE_FLOATS = 47;
+
+static const uint8_t STATE_BIAS_ENABLED = 0x01;
+static const uint8_t STATE_BIAS_STILL   = 0x02;
+static const uint8_t STATE_HAS_TEMP     = 0x04;
+static const uint8_t STATE_Q_INIT       = 0x08;
+
+// Wszystkie pola float ImuState w kolejności zapisu (wspólne dla encode/decode).
+static void imuStateFloats(ImuState& imu, float* v[IMU_STATE_FLOATS]) {
+  BiasTracker& b = imu.bias;
+  float* const list[IMU_STATE_FLOATS] = {
+    &imu.ax, &imu.ay, &imu.az, &imu.gx, &imu.gy, &imu.gz,
+    &imu.bgx, &imu.bgy, &imu.bgz,
+    &b.t_s, &b.sg[0], &b.sg[1], &b.sg[2], &b.sg2[0], &b.sg2[1], &b.sg2[2],
+    &b.sa, &b.sa2, &b.var, &b.since_update_s,
+    &imu.temp_c, &imu.tk[0], &imu.tk[1], &imu.tk[2], &imu.tc[0], &imu.tc[1], &imu.tc[2],
+    &imu.k_roll.angle_deg, &imu.k_roll.uncert, &imu.k_pitch.angle_deg, &imu.k_pitch.uncert, &imu.yaw,
+    &imu.q.w, &imu.q.x, &imu.q.y, &imu.q.z,
+    &imu.mahony.ix, &imu.mahony.iy, &imu.mahony.iz,
+    &imu.off_roll, &imu.off_pitch, &imu.off_yaw,
+    &imu.q_off.w, &imu.q_off.x, &imu.q_off.y, &imu.q_off.z,
+    &imu.gap_s,
+  };
+  memcpy(v, list, sizeof(list));
+}
+
+void imuStateEncode(const ImuState& imu, uint8_t* out) {
+  ImuState copy = imu;
+  float* v[IMU_STATE_FLOATS];
+  imuStateFloats(copy, v);
+  uint8_t* p = out;
+  for (size_t i = 0; i < IMU_STATE_FLOATS; i++, p += 4) putLeF32(p, *v[i]);
+  const BiasTracker& b = imu.bias;
+  putLe32(p, b.windows);
+  putLe32(p + 4, b.still_windows);
+  putLe32(p + 8, b.rejected);
+  putLe32(p + 12, b.updates);
+  putLe16(p + 16, b.n);
+  p[18] = (uint8_t)imu.engine;
+  p[19] = (uint8_t)((b.enabled ? STATE_BIAS_ENABLED : 0) | (b.still ? STATE_BIAS_STILL : 0) |
+                    (imu.has_temp ? STATE_HAS_TEMP : 0) | (imu.q_init ? STATE_Q_INIT : 0));
+}
+
+void imuStateDecode(const uint8_t* in, ImuState& imu) {
+  float* v[IMU_STATE_FLOATS];
+  imuStateFloats(imu, v);
+  const uint8_t* p = in;
+  for (size_t i = 0; i < IMU_STATE_FLOATS; i++, p += 4) *v[i] = getLeF32(p);
+  BiasTracker& b = imu.bias;
+  b.windows       = getLe32(p);
+  b.still_windows = getLe32(p + 4);
+  b.rejected      = getLe32(p + 8);
+  b.updates       = getLe32(p + 12);
+  b.n             = getLe16(p + 16);
+  imu.engine      = (FusionEngine)p[18];
+  b.enabled    = (p[19] & STATE_BIAS_ENABLED) != 0;
+  b.still      = (p[19] & STATE_BIAS_STILL) != 0;
+  imu.has_temp = (p[19] & STATE_HAS_TEMP) != 0;
+  imu.q_init   = (p[19] & STATE_Q_INIT) != 0;
+}
+
+// Nagłówek + CRC wokół payloadu zapisanego już pod out + TRACE_HEADER_LEN.
+static size_t traceFinish(uint8_t* out, TraceRecType type, size_t len) {
+  out[0] = TRACE_SYNC0;
+  out[1] = TRACE_SYNC1;
+  out[2] = (uint8_t)type;
+  putLe16(out + 3, (uint16_t)len);
+  putLe16(out + TRACE_HEADER_LEN + len, crc16Ccitt(out + 2, TRACE_HEADER_LEN - 2 + len));
+  return TRACE_OVERHEAD + len;
+}
+
+size_t traceEncodeConfig(uint8_t* out, const MpuConfig& cfg, bool fifo) {
+  uint8_t* p = out + TRACE_HEADER_LEN;
+  memset(p, 0, TRACE_CONFIG_LEN);
+  p[0] = TRACE_VERSION;
+  p[1] = cfg.dlpf_cfg;
+  p[2] = cfg.smplrt_div;
+  p[3] = (uint8_t)cfg.accel_range;
+  p[4] = (uint8_t)cfg.gyro_range;
+  p[5] = fifo ? 1 : 0;
+  return traceFinish(out, TRACE_REC_CONFIG, TRACE_CONFIG_LEN);
+}
+
+size_t traceEncodeState(uint8_t* out, const ImuState& imu1, const ImuState& imu2) {
+  imuStateEncode(imu1, out + TRACE_HEADER_LEN);
+  imuStateEncode(imu2, out + TRACE_HEADER_LEN + TRACE_IMU_STATE_LEN);
+  return traceFinish(out, TRACE_REC_STATE, TRACE_STATE_LEN);
+}
+
+static uint8_t* putRaw(uint8_t* p, const MpuRaw& r) {
+  const int16_t v[7] = {r.ax, r.ay, r.az, r.temp, r.gx, r.gy, r.gz};
+  for (int i = 0; i < 7; i++, p += 2) putLe16(p, (uint16_t)v[i]);
+  return p;
+}
+
+static const uint8_t* getRaw(const uint8_t* p, MpuRaw& r) {
+  int16_t* v[7] = {&r.ax, &r.ay, &r.az, &r.temp, &r.gx, &r.gy, &r.gz};
+  for (int i = 0; i < 7; i++, p += 2) *v[i] = (int16_t)getLe16(p);
+  return p;
+}
+
+size_t traceEncodeSample(uint8_t* out, const TraceSample& s) {
+  uint8_t* p = out + TRACE_HEADER_LEN;
+  putLe32(p, s.seq);
+  putLe64(p + 4, s.t_us);
+  putLeF32(p + 12, s.dt);
+  p[16] = (uint8_t)((s.ok1 ? TRACE_OK1 : 0) | (s.ok2 ? TRACE_OK2 : 0));
+  putRaw(putRaw(p + 17, s.raw1), s.raw2);
+  return traceFinish(out, TRACE_REC_SAMPLE, TRACE_SAMPLE_LEN);
+}
+
+bool traceDecodeConfig(const uint8_t* payload, size_t len, MpuConfig& cfg, bool& fifo) {
+  if (len != TRACE_CONFIG_LEN || payload[0] != TRACE_VERSION) return false;
+  MpuConfig c;
+  c.dlpf_cfg    = payload[1];
+  c.smplrt_div  = payload[2];
+  c.accel_range = (MpuAccelRange)payload[3];
+  c.gyro_range  = (MpuGyroRange)payload[4];
+  if (!mpuConfigValid(c)) return false;
+  cfg = c;
+  fifo = payload[5] != 0;
+  return true;
+}
+
+bool traceDecodeSample(const uint8_t* payload, size_t len, TraceSample& s) {
+  if (len != TRACE_SAMPLE_LEN) return false;
+  s.seq  = getLe32(payload);
+  s.t_us = getLe64(payload + 4);
+  s.dt   = getLeF32(payload + 12);
+  s.ok1  = (payload[16] & TRACE_OK1) != 0;
+  s.ok2  = (payload[16] & TRACE_OK2) != 0;
+  getRaw(getRaw(payload + 17, s.raw1), s.raw2);
+  return true;
+}
+
+// Po błędnym rekordzie: przesunięcie bufora do następnego kandydata na sync.
+static void traceParserResync(TraceParser& p) {
+  size_t i = 1;
+  while (i < p.len) {
+    if (p.buf[i] == TRACE_SYNC0 && (i + 1 >= p.len || p.buf[i + 1] == TRACE_SYNC1)) break;
+    i++;
+  }
+  memmove(p.buf, p.buf + i, p.len - i);
+  p.len -= i;
+}
+
+// Bufor zawiera kompletny rekord albo da się stwierdzić, że go nie zawiera.
+// 1 = rekord poprawny, 0 = za mało bajtów, -1 = błąd (resync).
+static int traceParserCheck(TraceParser& p) {
+  if (p.len < TRACE_HEADER_LEN) return 0;
+  const size_t plen = getLe16(p.buf + 3);
+  if (plen > TRACE_STATE_LEN) return -1;
+  if (p.len < TRACE_OVERHEAD + plen) return 0;
+  const uint16_t crc = getLe16(p.buf + TRACE_HEADER_LEN + plen);
+  return crc16Ccitt(p.buf + 2, TRACE_HEADER_LEN - 2 + plen) == crc ? 1 : -1;
+}
+
+bool traceParserFeed(TraceParser& p, uint8_t byte, uint8_t& type, const uint8_t*& payload, size_t& len) {
+  if (p.len == 0 && byte != TRACE_SYNC0) return false;
+  if (p.len == 1 && byte != TRACE_SYNC1) {
+    p.len = (byte == TRACE_SYNC0) ? 1 : 0;
+    return false;
+  }
+  if (p.len >= TRACE_RECORD_MAX) p.len = 0; // nie powinno się zdarzyć (długość sprawdzana)
+  p.buf[p.len++] = byte;
+
+  for (;;) {
+    const int r = traceParserCheck(p);
+    if (r == 0) return false;
+    if (r > 0) {
+      type = p.buf[2];
+      payload = p.buf + TRACE_HEADER_LEN;
+      len = getLe16(p.buf + 3);
+      p.len = 0;
+      p.records++;
+      return true;
+    }
+    p.crc_errors++;
+    traceParserResync(p);
+  }
+}
+
+bool traceReplayRecord(TraceReplay& r, uint8_t type, const uint8_t* payload, size_t len, KneeSample& out) {
+  switch (type) {
+    case TRACE_REC_CONFIG:
+      if (!traceDecodeConfig(payload, len, r.cfg, r.fifo)) break;
+      r.scale = mpuScaleFactors(r.cfg);
+      r.configs++;
+      return false;
+
+    case TRACE_REC_STATE:
+      if (len != TRACE_STATE_LEN) break;
+      imuStateDecode(payload, r.imu1);
+      imuStateDecode(payload + TRACE_IMU_STATE_LEN, r.imu2);
+      r.have_state = true;
+      r.state_fresh = true;
+      r.states++;
+      return false;
+
+    case TRACE_REC_SAMPLE: {
+      TraceSample s;
+      if (!traceDecodeSample(payload, len, s)) break;
+      if (r.samples + r.waiting > 0 && s.seq != r.next_seq) {
+        r.lost += (uint32_t)(s.seq - r.next_seq);
+        // stan po zgubionych próbkach nieznany – chyba że właśnie przyszedł STATE
+        if (!r.state_fresh) r.have_state = false;
+      }
+      r.next_seq = s.seq + 1;
+      r.state_fresh = false;
+      if (!r.have_state) {
+        r.waiting++;
+        return false;
+      }
+      MpuSample s1, s2;
+      if (s.ok1) mpuScale(s.raw1, r.scale, s1);
+      if (s.ok2) mpuScale(s.raw2, r.scale, s2);
+      fuseKneeStep(s.t_us, s.dt, r.imu1, s.ok1, s1, r.imu2, s.ok2, s2, out);
+      if (r.samples == 0) r.first_t_us = s.t_us;
+      r.last_t_us = s.t_us;
+      r.samples++;
+      return true;
+    }
+  }
+  r.bad_records++;
+  return false;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+#include "mpu6050.h"
+
+/*
+  KneeGuard – ślad surowy (rejestry obu IMU) i jego odtwarzanie poza urządzeniem
+
+  Firmware (komenda "trace on") zapisuje na USB strumień rekordów:
+    [0..1]  sync 0xAA 0x54 ('T')
+    [2]     typ rekordu (TraceRecType)
+    [3..4]  długość payloadu uint16 LE
+    [5..]   payload
+    [..+2]  CRC-16/CCITT-FALSE z bajtów [2..koniec payloadu]
+
+  Rekordy:
+  - CONFIG: wersja, MpuConfig (rejestry DLPF/SMPLRT_DIV/zakresy), tryb FIFO –
+    na początku i po każdej zmianie konfiguracji czujników,
+  - STATE: pełny ImuState obu IMU (bias, BiasTracker, model temperatury,
+    Kalman/kwaternion, offsety "calib", przerwa) – na początku i po każdej
+    zmianie stanu spoza fuzji (calib, calib gyro, fusion, bias, temperatura)
+    oraz po zgubionym rekordzie,
+  - SAMPLE: numer, t_us (uint64, ten sam co w KneeSample), dt użyte w fuzji
+    (float – bez ponownego liczenia), flagi ok1/ok2 i 2 x 7 x int16 rejestrów
+    (acc, temp, gyro) – dokładnie to, co przeczytał readIMU / FIFO.
+
+  Odtwarzanie (traceReplayRecord, narzędzie tools/kgreplay.cpp) skaluje
+  rejestry tą samą funkcją mpuScale i woła ten sam krok fuseKneeStep, co
+  firmware, więc na tej samej platformie wynik jest bit w bit identyczny
+  z potokiem na żywo. Między ESP32 a hostem identyczność nie jest
+  gwarantowana (kompilator może łączyć mnożenie i dodawanie w FMA).
+
+  Numer próbki rośnie o 1; luka oznacza zgubione rekordy (za wolne USB) –
+  odtwarzanie czeka wtedy na następny STATE, który firmware wysyła zaraz po
+  stracie.
+*/
+
+static const uint8_t TRACE_SYNC0 = 0xAA;
+static const uint8_t TRACE_SYNC1 = 0x54;
+static const uint8_t TRACE_VERSION = 1;
+
+enum TraceRecType : uint8_t {
+  TRACE_REC_CONFIG = 'C',
+  TRACE_REC_STATE  = 'S',
+  TRACE_REC_SAMPLE = 'R',
+};
+
+static const size_t TRACE_HEADER_LEN     = 5; // sync, typ, długość
+static const size_t TRACE_OVERHEAD       = TRACE_HEADER_LEN + 2;
+static const size_t TRACE_CONFIG_LEN     = 8;
+static const size_t TRACE_IMU_STATE_LEN  = 47 * 4 + 4 * 4 + 2 + 2;
+static const size_t TRACE_STATE_LEN      = 2 * TRACE_IMU_STATE_LEN;
+static const size_t TRACE_SAMPLE_LEN     = 4 + 8 + 4 + 1 + 2 * 7 * 2;
+static const size_t TRACE_RECORD_MAX     = TRACE_OVERHEAD + TRACE_STATE_LEN;
+
+static const uint8_t TRACE_OK1 = 0x01;
+static const uint8_t TRACE_OK2 = 0x02;
+
+// Jeden takt potoku: surowe rejestry obu IMU i parametry kroku fuzji
+struct TraceSample {
+  uint32_t seq  = 0;
+  uint64_t t_us = 0;
+  float    dt   = 0;
+  bool     ok1 = false, ok2 = false;
+  MpuRaw   raw1, raw2;
+};
+
+// Zapis kompletnego rekordu do out (co najmniej TRACE_RECORD_MAX / długość
+// rekordu); zwraca liczbę bajtów.
+size_t traceEncodeConfig(uint8_t* out, const MpuConfig& cfg, bool fifo);
+size_t traceEncodeState(uint8_t* out, const ImuState& imu1, const ImuState& imu2);
+size_t traceEncodeSample(uint8_t* out, const TraceSample& s);
+
+// Serializacja stanu jednego IMU (TRACE_IMU_STATE_LEN bajtów, jawnie pole po
+// polu – niezależna od układu struktury na danej platformie).
+void imuStateEncode(const ImuState& imu, uint8_t* out);
+void imuStateDecode(const uint8_t* in, ImuState& imu);
+
+bool traceDecodeConfig(const uint8_t* payload, size_t len, MpuConfig& cfg, bool& fifo);
+bool traceDecodeSample(const uint8_t* payload, size_t len, TraceSample& s);
+
+// Strumieniowy parser (jak BinFrameParser): szuka sync, składa rekord, sprawdza CRC.
+struct TraceParser {
+  uint8_t  buf[TRACE_RECORD_MAX];
+  size_t   len = 0;
+  uint32_t records    = 0;
+  uint32_t crc_errors = 0;
+};
+
+// Podaje jeden bajt; true, gdy rekord jest kompletny – typ i payload w
+// p.buf[2] / p.buf + TRACE_HEADER_LEN (ważne do następnego wywołania).
+bool traceParserFeed(TraceParser& p, uint8_t byte, uint8_t& type, const uint8_t*& payload, size_t& len);
+
+// Stan odtwarzania: konfiguracja i stan fuzji z ostatnich rekordów
+struct TraceReplay {
+  MpuConfig       cfg;
+  MpuScaleFactors scale;
+  bool            fifo        = false;
+  bool            have_state  = false;
+  bool            state_fresh = false; // STATE po ostatniej próbce
+  ImuState        imu1, imu2;
+  uint32_t        next_seq    = 0;
+
+  uint64_t samples      = 0; // próbki wyjściowe
+  uint64_t lost         = 0; // luki w numeracji
+  uint64_t waiting      = 0; // próbki pominięte w oczekiwaniu na STATE
+  uint64_t states       = 0;
+  uint64_t configs      = 0;
+  uint64_t bad_records  = 0; // nieznany typ / zła długość / wersja
+  uint64_t first_t_us   = 0, last_t_us = 0;
+};
+
+// Kolejny rekord (po CRC); true, gdy powstała próbka wyjściowa out.
+bool traceReplayRecord(TraceReplay& r, uint8_t type, const uint8_t* payload, size_t len, KneeSample& out);
@@ -0,0 +1,44 @@
+#include "sensor_array.h"
+
+static bool sensorConflicts(const SensorDesc& a, const SensorDesc& b) {
+  if (a.port != b.port || a.addr != b.addr) return false;
+  return a.mux_ch == MUX_NONE || b.mux_ch == MUX_NONE || a.mux_ch == b.mux_ch;
+}
+
+int sensorArrayCheck(const SensorDesc* s, size_t n) {
+  if (n > SENSORS_MAX) return (int)SENSORS_MAX;
+  for (size_t i = 0; i < n; i++) {
+    if (s[i].port >= SENSOR_PORTS) return (int)i;
+    if (s[i].mux_ch < MUX_NONE || s[i].mux_ch >= (int8_t)MUX_CHANNELS) return (int)i;
+    if (s[i].addr == MUX_ADDR || s[i].addr < 0x08 || s[i].addr > 0x77) return (int)i;
+    for (size_t j = 0; j < i; j++) {
+      if (sensorConflicts(s[i], s[j])) return (int)i;
+    }
+  }
+  return -1;
+}
+
+int jointArrayCheck(const JointDesc* j, size_t n_joints, size_t n_sensors) {
+  for (size_t i = 0; i < n_joints; i++) {
+    if (j[i].proximal >= n_sensors || j[i].distal >= n_sensors || j[i].proximal == j[i].distal) return (int)i;
+  }
+  return -1;
+}
+
+size_t sensorPortOrder(const SensorDesc* s, size_t n, uint8_t port, uint8_t* order) {
+  size_t k = 0;
+  for (int ch = MUX_NONE; ch < (int)MUX_CHANNELS; ch++) {
+    for (size_t i = 0; i < n; i++) {
+      if (s[i].port == port && s[i].mux_ch == ch) order[k++] = (uint8_t)i;
+    }
+  }
+  return k;
+}
+
+size_t sensorPortMaxLoad(const SensorDesc* s, size_t n) {
+  size_t load[SENSOR_PORTS] = {0, 0};
+  for (size_t i = 0; i < n; i++) {
+    if (s[i].port < SENSOR_PORTS) load[s[i].port]++;
+  }
+  return load[0] > load[1] ? load[0] : load[1];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – tablica czujników i stawów (logika bez Arduino)
+
+  Każdy czujnik to port I2C ESP32 (0 = Wire, 1 = Wire1), adres (0x68 / 0x69)
+  i opcjonalnie kanał multipleksera TCA9548A (MUX_ADDR) na tym porcie.
+  Staw to para czujników: segment bliższy (np. udo) i dalszy (podudzie);
+  kąt stawu liczy jointAngleDeg (fusion.h). Tablice są stałe (rozmiar znany
+  przy kompilacji, src/sensor_layout.h) – tu tylko sprawdzenie spójności
+  i kolejność odczytu.
+
+  Oba porty pracują równolegle, więc czas odczytu jednej próbki rośnie z liczbą
+  czujników na porcie, nie z liczbą wszystkich. Na porcie czujniki są czytane
+  pogrupowane po kanale multipleksera (najpierw te bez multipleksera) –
+  jeden zapis wyboru kanału na grupę zamiast na czujnik (MuxPort pamięta
+  wybrany kanał).
+
+  Czujnik bezpośrednio na porcie jest widoczny przy każdym kanale, a czujniki
+  za różnymi kanałami nigdy razem – adres może się powtórzyć tylko za różnymi
+  kanałami (sensorArrayCheck).
+*/
+
+static const uint8_t SENSOR_PORTS  = 2;    // kontrolery I2C ESP32
+static const int8_t  MUX_NONE      = -1;   // czujnik bezpośrednio na magistrali
+static const int8_t  MUX_UNKNOWN   = -2;   // MuxPort: kanał nieznany (start, błąd)
+static const uint8_t MUX_ADDR      = 0x70; // TCA9548A, A0..A2 = GND
+static const uint8_t MUX_CHANNELS  = 8;
+static const size_t  SENSORS_MAX   = 16;
+
+struct SensorDesc {
+  const char* name;   // etykieta w raportach (ASCII, bez spacji)
+  uint8_t     port;   // 0 = Wire, 1 = Wire1
+  uint8_t     addr;
+  int8_t      mux_ch; // kanał TCA9548A albo MUX_NONE
+};
+
+struct JointDesc {
+  const char* name;
+  uint8_t     proximal; // indeks czujnika segmentu bliższego
+  uint8_t     distal;   // indeks czujnika segmentu dalszego
+};
+
+// Wybrany kanał multipleksera jednego portu.
+struct MuxPort {
+  int8_t   ch      = MUX_UNKNOWN;
+  uint32_t selects = 0; // zapisy wyboru kanału (statystyka)
+};
+
+// Przed transakcją z czujnikiem za kanałem ch trzeba wybrać kanał (zapis 1 << ch).
+static inline bool muxNeedsSelect(const MuxPort& m, int8_t ch) {
+  return ch != MUX_NONE && ch != m.ch;
+}
+
+// -1 = tablica poprawna, inaczej indeks pierwszego czujnika z błędem: port, kanał,
+// adres multipleksera albo konflikt adresu z wcześniejszym czujnikiem.
+int sensorArrayCheck(const SensorDesc* s, size_t n);
+
+// -1 = poprawna, inaczej indeks pierwszego stawu z indeksem spoza tablicy
+// albo tym samym czujnikiem po obu stronach.
+int jointArrayCheck(const JointDesc* j, size_t n_joints, size_t n_sensors);
+
+// Indeksy czujników portu w kolejności odczytu (bez multipleksera, potem
+// rosnąco po kanale; kolejność z tablicy w grupie); zwraca ich liczbę.
+size_t sensorPortOrder(const SensorDesc* s, size_t n, uint8_t port, uint8_t* order);
+
+// Najwięcej czujników na jednym porcie (czas odczytu próbki ~ ta liczba).
+size_t sensorPortMaxLoad(const SensorDesc* s, size_t n);
@@ -0,0 +1,238 @@
+#include "session_log.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "le_bytes.h"
+
+// ---- pamięć na pliku stdio ----
+
+static bool fileRead(void* ctx, uint32_t slot, uint8_t* buf, size_t n) {
+  FILE* f = (FILE*)ctx;
+  if (fseek(f, (long)slot * (long)LOG_BLOCK_SIZE, SEEK_SET) != 0) return false;
+  return fread(buf, 1, n, f) == n;
+}
+
+static bool fileWrite(void* ctx, uint32_t slot, const uint8_t* buf) {
+  FILE* f = (FILE*)ctx;
+  if (fseek(f, (long)slot * (long)LOG_BLOCK_SIZE, SEEK_SET) != 0) return false;
+  return fwrite(buf, 1, LOG_BLOCK_SIZE, f) == LOG_BLOCK_SIZE;
+}
+
+static bool fileSync(void* ctx) {
+  FILE* f = (FILE*)ctx;
+  if (fflush(f) != 0) return false;
+  return fsync(fileno(f)) == 0;
+}
+
+LogStorage logFileStorage(FILE* f, uint32_t slots) {
+  LogStorage st;
+  st.ctx   = f;
+  st.slots = f ? slots : 0;
+  st.read  = fileRead;
+  st.write = fileWrite;
+  st.sync  = fileSync;
+  return st;
+}
+
+// ---- format bloku ----
+
+// Sam nagłówek (bez CRC) – wystarcza do skanu przy starcie.
+static bool headerValid(const uint8_t* blk, LogBlockInfo& info) {
+  if (blk[0] != LOG_MAGIC0 || blk[1] != LOG_MAGIC1) return false;
+  if (blk[2] != LOG_VERSION) return false;
+  const uint8_t count = blk[18];
+  if (blk[3] == LOG_KIND_KNEE) {
+    if (count == 0 || count > LOG_SAMPLES_PER_BLOCK) return false;
+  } else if (blk[3] == LOG_KIND_KNEE_DELTA) {
+    if (count == 0 || count > LOG_DELTA_SAMPLES_MAX) return false;
+  } else {
+    return false;
+  }
+  info.kind    = blk[3];
+  info.seq     = getLe32(blk + 4);
+  info.t0_us   = getLe64(blk + 8);
+  info.session = getLe16(blk + 16);
+  info.count   = count;
+  return true;
+}
+
+bool logBlockValid(const uint8_t* blk, LogBlockInfo* info) {
+  LogBlockInfo tmp;
+  if (!headerValid(blk, tmp)) return false;
+  if (crc16Ccitt(blk, LOG_CRC_OFFSET) != getLe16(blk + LOG_CRC_OFFSET)) return false;
+  if (info) *info = tmp;
+  return true;
+}
+
+size_t logDecodeBlock(const uint8_t* blk, KneeSample* out, size_t max) {
+  LogBlockInfo info;
+  if (!logBlockValid(blk, &info)) return 0;
+  const size_t n = info.count < max ? info.count : max;
+  const uint8_t* p = blk + LOG_HEADER_LEN;
+
+  if (info.kind == LOG_KIND_KNEE_DELTA) {
+    DeltaCodec dec;
+    deltaCodecInit(dec, 0);
+    const uint8_t* end = blk + LOG_CRC_OFFSET;
+    for (size_t i = 0; i < n; i++) {
+      bool have = false;
+      const size_t m = deltaDecode(dec, p, (size_t)(end - p), out[i], have);
+      if (m == 0 || !have) return i; // blok z CRC, więc tylko przy błędzie kodera
+      p += m;
+    }
+    return n;
+  }
+
+  uint64_t t = info.t0_us;
+  for (size_t i = 0; i < n; i++, p += LOG_SAMPLE_LEN) {
+    t += binDecodeRecord(p, out[i]);
+    out[i].t_us = t;
+  }
+  return n;
+}
+
+// ---- zapis cykliczny ----
+
+bool logOpen(SessionLog& lg, const LogStorage& st) {
+  lg.st = st;
+  lg.oldest_seq = lg.next_seq = 0;
+  lg.session = 0;
+  lg.count = 0;
+  lg.used = 0;
+  lg.unsynced = 0;
+  lg.samples = 0;
+  lg.write_errors = 0;
+  if (st.slots == 0 || !st.read || !st.write) return false;
+
+  // Zapisane seq leżą w (max - slots, max]: wystarczy min i max z nagłówków
+  bool any = false;
+  uint32_t lo = 0, hi = 0;
+  for (uint32_t slot = 0; slot < st.slots; slot++) {
+    LogBlockInfo info;
+    if (!st.read(st.ctx, slot, lg.blk, LOG_HEADER_LEN) || !headerValid(lg.blk, info)) continue;
+    if (info.seq % st.slots != slot) continue; // blok z pliku o innej pojemności
+    if (!any || (int32_t)(info.seq - hi) > 0) hi = info.seq;
+    if (!any || (int32_t)(info.seq - lo) < 0) lo = info.seq;
+    any = true;
+  }
+  if (!any) return true;
+
+  // Przerwany zapis psuje najnowszy blok – brzegi zakresu sprawdzane w całości
+  lg.oldest_seq = lo;
+  lg.next_seq = hi + 1;
+  LogBlockInfo info;
+  while (lg.next_seq != lg.oldest_seq) {
+    if (st.read(st.ctx, (lg.next_seq - 1) % st.slots, lg.blk, LOG_BLOCK_SIZE) &&
+        logBlockValid(lg.blk, &info) && info.seq == lg.next_seq - 1) {
+      lg.session = (uint16_t)(info.session + 1);
+      break;
+    }
+    lg.next_seq--;
+  }
+  while (lg.oldest_seq != lg.next_seq && !logReadBlock(lg, lg.oldest_seq, lg.blk)) lg.oldest_seq++;
+  lg.count = 0;
+  return true;
+}
+
+static bool writeBlock(SessionLog& lg) {
+  if (lg.count == 0) return true;
+  uint8_t* b = lg.blk;
+  b[0] = LOG_MAGIC0;
+  b[1] = LOG_MAGIC1;
+  b[2] = LOG_VERSION;
+  b[3] = lg.kind;
+  putLe32(b + 4, lg.next_seq);
+  putLe16(b + 16, lg.session);
+  b[18] = lg.count;
+  b[19] = 0;
+  const size_t used = LOG_HEADER_LEN + lg.used;
+  memset(b + used, 0, LOG_CRC_OFFSET - used);
+  putLe16(b + LOG_CRC_OFFSET, crc16Ccitt(b, LOG_CRC_OFFSET));
+  lg.count = 0;
+  lg.used = 0;
+
+  // slot najstarszego bloku jest nadpisywany
+  if (lg.next_seq - lg.oldest_seq >= lg.st.slots) lg.oldest_seq = lg.next_seq - lg.st.slots + 1;
+  if (!lg.st.write(lg.st.ctx, lg.next_seq % lg.st.slots, b)) {
+    lg.write_errors++;
+    return false;
+  }
+  lg.next_seq++;
+  if (++lg.unsynced >= LOG_SYNC_EVERY_BLOCKS) {
+    lg.unsynced = 0;
+    if (lg.st.sync && !lg.st.sync(lg.st.ctx)) lg.write_errors++;
+  }
+  return true;
+}
+
+// Blok skompresowany: zamykany, gdy kolejny rekord się nie mieści; pierwszy
+// rekord bloku zawsze jest klatką kluczową (blok dekoduje się samodzielnie).
+static bool appendDelta(SessionLog& lg, const KneeSample& s) {
+  static const size_t capacity = LOG_CRC_OFFSET - LOG_HEADER_LEN;
+  uint8_t rec[DELTA_SAMPLE_MAX];
+  bool ok = true;
+  if (lg.count == 0) deltaForceKeyframe(lg.codec);
+  size_t n = deltaEncode(lg.codec, s, rec);
+  if (lg.used + n > capacity) {
+    ok = writeBlock(lg);
+    deltaForceKeyframe(lg.codec);
+    n = deltaEncode(lg.codec, s, rec);
+  }
+  if (lg.count == 0) putLe64(lg.blk + 8, s.t_us);
+  memcpy(lg.blk + LOG_HEADER_LEN + lg.used, rec, n);
+  lg.used = (uint16_t)(lg.used + n);
+  lg.count++;
+  return ok;
+}
+
+bool logAppend(SessionLog& lg, const KneeSample& s) {
+  if (lg.st.slots == 0) return false;
+  lg.samples++;
+  if (lg.kind == LOG_KIND_KNEE_DELTA) return appendDelta(lg, s);
+
+  // przyrost czasu musi zmieścić się w uint16 – inaczej nowy blok z własnym t0
+  bool ok = true;
+  if (lg.count > 0 && s.t_us - lg.last_t_us > 0xFFFFu) ok = writeBlock(lg);
+  if (lg.count == 0) putLe64(lg.blk + 8, s.t_us);
+
+  uint8_t* p = lg.blk + LOG_HEADER_LEN + (size_t)lg.count * LOG_SAMPLE_LEN;
+  binEncodeRecord(p, (uint16_t)(lg.count == 0 ? 0 : s.t_us - lg.last_t_us), s);
+  lg.last_t_us = s.t_us;
+  lg.used = (uint16_t)(lg.used + LOG_SAMPLE_LEN);
+
+  if (++lg.count == LOG_SAMPLES_PER_BLOCK) ok = writeBlock(lg) && ok;
+  return ok;
+}
+
+bool logSetKind(SessionLog& lg, uint8_t kind) {
+  if (kind != LOG_KIND_KNEE && kind != LOG_KIND_KNEE_DELTA) return false;
+  if (kind == lg.kind) return true;
+  const bool ok = lg.st.slots == 0 || writeBlock(lg);
+  lg.kind = kind;
+  return ok;
+}
+
+bool logFlush(SessionLog& lg) {
+  if (lg.st.slots == 0) return false;
+  const bool ok = writeBlock(lg);
+  lg.unsynced = 0;
+  if (lg.st.sync && !lg.st.sync(lg.st.ctx)) {
+    lg.write_errors++;
+    return false;
+  }
+  return ok;
+}
+
+void logNewSession(SessionLog& lg) {
+  logFlush(lg);
+  lg.session++;
+}
+
+bool logReadBlock(SessionLog& lg, uint32_t seq, uint8_t* buf) {
+  if (lg.st.slots == 0) return false;
+  if ((int32_t)(seq - lg.oldest_seq) < 0 || (int32_t)(seq - lg.next_seq) >= 0) return false;
+  LogBlockInfo info;
+  if (!lg.st.read(lg.st.ctx, seq % lg.st.slots, buf, LOG_BLOCK_SIZE)) return false;
+  return logBlockValid(buf, &info) && info.seq == seq;
+}
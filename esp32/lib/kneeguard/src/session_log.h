@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "binary_frame.h"
+#include "delta_codec.h"
+#include "fusion.h"
+
+/*
+  KneeGuard – dziennik sesji w pamięci flash (bufor cykliczny bloków)
+
+  Próbki KneeSample z pełną częstotliwością akwizycji są pakowane w bloki
+  o stałym rozmiarze LOG_BLOCK_SIZE. Blok o numerze seq trafia do slotu
+  seq % slots – najstarsze bloki są nadpisywane. Każdy blok jest
+  samoopisujący (magic, seq, CRC), więc:
+  - po restarcie logOpen odtwarza zakres [oldest_seq, next_seq) skanując nagłówki,
+  - przerwany zapis (zanik zasilania) psuje tylko jeden blok,
+  - pobieranie ("log get") to wysłanie bloków bez zmian; odbiorca sam
+    znajduje granice (magic + CRC) i wznawia od ostatniego potwierdzonego seq.
+
+  Układ bloku (little-endian, 512 B):
+    [0..1]    magic 'K' 'L'
+    [2]       wersja formatu (LOG_VERSION)
+    [3]       rodzaj próbek (LOG_KIND_KNEE / LOG_KIND_KNEE_DELTA)
+    [4..7]    seq      uint32 – numer bloku (rośnie przez całe życie pliku)
+    [8..15]   t0_us    uint64 – czas pierwszej próbki (monotoniczny)
+    [16..17]  session  uint16 – numer sesji (nowa po starcie / "log on")
+    [18]      count    – liczba próbek w bloku
+    [19]      zarezerwowane (0)
+    [20..]    count x rekord 17 B (BIN_RECORD_LEN, binary_frame.h): dt_us uint16
+              od poprzedniej próbki (pierwsza 0), 7 x int16 kątów w 0.01°, flagi
+              – albo (LOG_KIND_KNEE_DELTA) count rekordów delta_codec.h; pierwszy
+              jest klatką kluczową, więc każdy blok dekoduje się samodzielnie
+    [510..511] CRC-16/CCITT-FALSE z bajtów [0..509]
+
+  Pamięć masowa jest za interfejsem LogStorage (odczyt/zapis całego slotu),
+  więc ta sama logika działa na LittleFS (ESP32) i na pliku na hoście.
+*/
+
+static const size_t  LOG_BLOCK_SIZE        = 512;
+static const size_t  LOG_HEADER_LEN        = 20;
+static const size_t  LOG_SAMPLE_LEN        = BIN_RECORD_LEN;
+static const size_t  LOG_CRC_OFFSET        = LOG_BLOCK_SIZE - 2;
+static const uint8_t LOG_SAMPLES_PER_BLOCK = (uint8_t)((LOG_CRC_OFFSET - LOG_HEADER_LEN) / LOG_SAMPLE_LEN);
+
+static const uint8_t LOG_MAGIC0   = 'K';
+static const uint8_t LOG_MAGIC1   = 'L';
+static const uint8_t LOG_VERSION  = 2; // 1: t0_us uint32 (bloki pomijane przy skanie)
+static const uint8_t LOG_KIND_KNEE = 1; // KneeSample po fuzji
+static const uint8_t LOG_KIND_KNEE_DELTA = 2; // j.w., kompresja delta_codec (~1.7x więcej próbek)
+
+static const uint8_t LOG_DELTA_SAMPLES_MAX = (uint8_t)((LOG_CRC_OFFSET - LOG_HEADER_LEN) / DELTA_SAMPLE_MIN);
+
+// Slot pamięci masowej (LOG_BLOCK_SIZE bajtów); ctx – np. FILE*.
+// read czyta pierwsze n bajtów slotu (skan przy starcie czyta tylko nagłówki).
+struct LogStorage {
+  void*    ctx   = nullptr;
+  uint32_t slots = 0;
+  bool (*read)(void* ctx, uint32_t slot, uint8_t* buf, size_t n) = nullptr;
+  bool (*write)(void* ctx, uint32_t slot, const uint8_t* buf)    = nullptr;
+  bool (*sync)(void* ctx)                                        = nullptr; // trwały zapis
+};
+
+// LogStorage na pliku stdio (LittleFS przez VFS na ESP32, zwykły plik na hoście).
+// Plik rośnie przy zapisie; slot za końcem pliku jest po prostu pusty.
+LogStorage logFileStorage(FILE* f, uint32_t slots);
+
+// Bloki zapisywane między kolejnymi sync (metadane LittleFS są drogie).
+static const uint8_t LOG_SYNC_EVERY_BLOCKS = 8;
+
+struct SessionLog {
+  LogStorage st;
+  uint32_t oldest_seq = 0; // zakres zapisanych bloków: [oldest_seq, next_seq)
+  uint32_t next_seq   = 0;
+  uint16_t session    = 0;
+  uint8_t  kind       = LOG_KIND_KNEE; // format nowych bloków (logSetKind)
+
+  // bieżący (niezapisany) blok
+  uint8_t  blk[LOG_BLOCK_SIZE];
+  uint8_t  count     = 0;
+  uint16_t used      = 0; // bajty rekordów za nagłówkiem
+  DeltaCodec codec;       // stan kompresji bieżącego bloku
+  uint64_t last_t_us = 0;
+  uint8_t  unsynced  = 0;
+
+  uint32_t samples      = 0; // próbki przyjęte od logOpen
+  uint32_t write_errors = 0;
+};
+
+struct LogBlockInfo {
+  uint32_t seq     = 0;
+  uint64_t t0_us   = 0;
+  uint16_t session = 0;
+  uint8_t  count   = 0;
+  uint8_t  kind    = 0;
+};
+
+// Skan nagłówków slotów i odtworzenie zakresu (bloki brzegowe sprawdzane z CRC);
+// nowa sesja = ostatnia + 1. false, gdy brak pamięci.
+bool logOpen(SessionLog& lg, const LogStorage& st);
+
+// Dopisanie próbki; pełny blok jest zapisywany od razu. false przy błędzie zapisu.
+bool logAppend(SessionLog& lg, const KneeSample& s);
+
+// Format kolejnych bloków (LOG_KIND_KNEE / LOG_KIND_KNEE_DELTA); bieżący blok
+// jest najpierw zamykany w starym formacie. false przy nieznanym rodzaju.
+bool logSetKind(SessionLog& lg, uint8_t kind);
+
+// Zapis niepełnego bieżącego bloku + sync (przed pobieraniem / "log off").
+bool logFlush(SessionLog& lg);
+
+// Zamknięcie bieżącego bloku i rozpoczęcie nowej sesji.
+void logNewSession(SessionLog& lg);
+
+static inline uint32_t logBlockCount(const SessionLog& lg) { return lg.next_seq - lg.oldest_seq; }
+
+// Odczyt bloku seq z pamięci (zakres, magic, CRC, zgodność seq); false, gdy brak/uszkodzony.
+bool logReadBlock(SessionLog& lg, uint32_t seq, uint8_t* buf);
+
+// Sprawdzenie bloku (magic, wersja, rodzaj, CRC); info wypełniane, gdy poprawny.
+bool logBlockValid(const uint8_t* blk, LogBlockInfo* info = nullptr);
+
+// Dekodowanie próbek z poprawnego bloku; zwraca ich liczbę (najwyżej max).
+size_t logDecodeBlock(const uint8_t* blk, KneeSample* out, size_t max);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  KneeGuard – bufor pierścieniowy SPSC (jeden producent, jeden konsument)
+
+  - pojemność N ustalana w czasie kompilacji (potęga dwójki), bez alokacji,
+  - bez blokad: producent zapisuje tylko head_, konsument tylko tail_,
+  - kolejność pamięci: dane elementu są publikowane store(release) na head_
+    i czytane po load(acquire) – poprawne między rdzeniami ESP32 i na hoście,
+  - przy pełnym buforze push() zwraca false i zwiększa licznik dropped(),
+  - pushN()/popN(): blok elementów publikowany jednym store – konsument
+    widzi cały blok albo nic (rekordy zmiennej długości w SpscRing<uint8_t>).
+
+  Typowe rekordy: KneeSample (próbka po fuzji), MpuRawPair (surowe rejestry),
+  bajty śladu surowego (raw_trace.h).
+  Obiekt jest wyrównany do linii cache – tworzyć jako zmienną globalną/statyczną.
+*/
+
+static const size_t KG_CACHE_LINE = 64;
+
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing: N musi być potęgą dwójki");
+
+public:
+  // Producent
+  bool push(const T& v) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    buf_[head & MASK] = v;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producent: n elementów albo nic (pełny bufor -> dropped() + 1)
+  bool pushN(const T* v, size_t n) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    if (n > N || head - tail_.load(std::memory_order_acquire) > N - n) {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    for (size_t i = 0; i < n; i++) buf_[(head + (uint32_t)i) & MASK] = v[i];
+    head_.store(head + (uint32_t)n, std::memory_order_release);
+    return true;
+  }
+
+  // Konsument
+  bool pop(T& out) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[tail & MASK];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Konsument: dokładnie n elementów albo nic (mniej w buforze)
+  bool popN(T* out, size_t n) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) - tail < n) return false;
+    for (size_t i = 0; i < n; i++) out[i] = buf_[(tail + (uint32_t)i) & MASK];
+    tail_.store(tail + (uint32_t)n, std::memory_order_release);
+    return true;
+  }
+
+  // Liczba elementów (przybliżona, gdy druga strona pracuje równolegle)
+  size_t size() const {
+    return (size_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+  }
+
+  bool empty() const { return size() == 0; }
+  static size_t capacity() { return N; }
+
+  // Liczba odrzuconych push() (pełny bufor); zapisywana tylko przez producenta
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  static const uint32_t MASK = (uint32_t)(N - 1);
+
+  alignas(KG_CACHE_LINE) std::atomic<uint32_t> head_{0};    // zapis: producent
+  std::atomic<uint32_t> dropped_{0};                        // zapis: producent
+  alignas(KG_CACHE_LINE) std::atomic<uint32_t> tail_{0};    // zapis: konsument
+  alignas(KG_CACHE_LINE) T buf_[N];
+};
@@ -0,0 +1,325 @@
+#include "stream_decoder.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "le_bytes.h"
+
+// ---- numer kolejny ----
+
+SeqEvent seqTrackerPush(SeqTracker& t, uint32_t raw, uint8_t bits, uint64_t& missing) {
+  missing = 0;
+  const uint64_t mask = (bits >= 32) ? 0xFFFFFFFFull : ((1ull << bits) - 1);
+  if (!t.started) {
+    t.started = true;
+    t.next = (uint64_t)raw + 1;
+    t.window = 1;
+    t.received++;
+    return SEQ_IN_ORDER;
+  }
+
+  const uint64_t ahead = ((uint64_t)raw - t.next) & mask;
+  if (ahead <= mask / 2) {
+    // w kolejności albo po luce: okno przesuwa się o ahead + 1
+    const uint64_t shift = ahead + 1;
+    t.window = (shift >= 64) ? 1 : ((t.window << shift) | 1);
+    t.next += shift;
+    t.received++;
+    t.lost += ahead;
+    missing = ahead;
+    return ahead ? SEQ_GAP : SEQ_IN_ORDER;
+  }
+
+  const uint64_t behind = mask + 1 - ahead; // raw == next - behind
+  if (behind <= 64) {
+    const uint64_t bit = 1ull << (behind - 1);
+    if (t.window & bit) {
+      t.duplicates++;
+      return SEQ_DUPLICATE;
+    }
+    t.window |= bit;
+    if (t.lost > 0) t.lost--;
+    t.late++;
+    t.received++;
+    return SEQ_LATE;
+  }
+
+  // duży skok wstecz: restart nadawcy (reset, zmiana formatu po drodze)
+  t.restarts++;
+  t.next = (uint64_t)raw + 1;
+  t.window = 1;
+  t.received++;
+  return SEQ_RESTART;
+}
+
+const char* streamFrameKindName(StreamFrameKind k) {
+  switch (k) {
+    case STREAM_CSV:     return "csv";
+    case STREAM_LABELED: return "labeled";
+    case STREAM_BIN:     return "bin";
+    case STREAM_BATCH:   return "batch";
+    case STREAM_DELTA:   return "delta";
+    case STREAM_LOG:     return "log";
+    default:             return "none";
+  }
+}
+
+// ---- luki i próbki ----
+
+void streamDecoderInit(StreamDecoder& d) {
+  void (*on_sample)(void*, const KneeSample&, StreamFrameKind, uint64_t) = d.on_sample;
+  void (*on_gap)(void*, const StreamGap&) = d.on_gap;
+  void* ctx = d.ctx;
+  d.len = 0;
+  d.kind = STREAM_NONE;
+  d.seq = SeqTracker();
+  deltaFrameDecoderInit(d.delta);
+  d.has_t = false;
+  d.last_t_us = 0;
+  d.period_us = 0;
+  d.gap_pending = false;
+  d.stats = StreamStats();
+  d.on_sample = on_sample;
+  d.on_gap = on_gap;
+  d.ctx = ctx;
+}
+
+static void openGap(StreamDecoder& d, StreamFrameKind kind, uint64_t first_seq, uint64_t frames) {
+  if (d.gap_pending) {
+    d.pending.frames += frames;
+    return;
+  }
+  d.gap_pending = true;
+  d.pending.kind = kind;
+  d.pending.first_seq = first_seq;
+  d.pending.frames = frames;
+  d.pending.t_before_us = d.last_t_us;
+  d.pending.t_after_us = 0;
+  d.pending.samples_est = 0;
+}
+
+// Luka zamykana pierwszą próbką po niej: brakujące próbki z przerwy w czasie
+// i ostatniego okresu (co najmniej jedna na utraconą ramkę).
+static void closeGap(StreamDecoder& d, uint64_t t_after) {
+  StreamGap& g = d.pending;
+  g.t_after_us = t_after;
+  uint64_t est = g.frames;
+  if (d.has_t && d.period_us > 0 && t_after > g.t_before_us) {
+    const uint64_t span = (t_after - g.t_before_us + d.period_us / 2) / d.period_us;
+    if (span > 1 && span - 1 > est) est = span - 1;
+  }
+  g.samples_est = est;
+  d.gap_pending = false;
+  d.stats.gaps++;
+  d.stats.samples_lost += est;
+  if (d.on_gap) d.on_gap(d.ctx, g);
+}
+
+static void emitSample(StreamDecoder& d, const KneeSample& s, StreamFrameKind kind, uint64_t seq) {
+  if (d.gap_pending) {
+    closeGap(d, s.t_us);
+  } else if (d.has_t && s.t_us > d.last_t_us) {
+    d.period_us = s.t_us - d.last_t_us;
+  }
+  d.has_t = true;
+  d.last_t_us = s.t_us;
+  d.stats.samples++;
+  if (d.on_sample) d.on_sample(d.ctx, s, kind, seq);
+}
+
+// Ramka po dekodowaniu: numer kolejny, luki, próbki. bits = 0 – ramka bez numeru.
+static void onFrame(StreamDecoder& d, StreamFrameKind kind, uint32_t raw_seq, uint8_t bits,
+                    const KneeSample* s, size_t n, uint64_t skipped) {
+  if (kind != d.kind) {
+    d.kind = kind;
+    d.seq = SeqTracker(); // nowy format = nowy licznik nadawcy
+  }
+  // czas wstecz o więcej niż 1 s: restart urządzenia (esp_timer od zera)
+  if (n > 0 && d.has_t && s[0].t_us + 1000000 < d.last_t_us) {
+    d.seq = SeqTracker();
+    d.has_t = false;
+    d.period_us = 0;
+    d.gap_pending = false;
+  }
+
+  uint64_t missing = 0;
+  SeqEvent ev = SEQ_IN_ORDER;
+  if (bits > 0) ev = seqTrackerPush(d.seq, raw_seq, bits, missing);
+  if (ev == SEQ_DUPLICATE) return;
+  const uint64_t seq = d.seq.next - 1;
+
+  if (ev == SEQ_LATE) {
+    // próbki już policzone jako utracone – oddawane poza kolejnością
+    d.stats.samples_lost -= (n < d.stats.samples_lost) ? n : d.stats.samples_lost;
+    for (size_t i = 0; i < n; i++) {
+      d.stats.samples++;
+      if (d.on_sample) d.on_sample(d.ctx, s[i], kind, seq);
+    }
+    return;
+  }
+  if (ev == SEQ_GAP) openGap(d, kind, seq - missing, missing);
+  if (skipped > 0) openGap(d, kind, seq, 0);
+  for (size_t i = 0; i < n; i++) emitSample(d, s[i], kind, seq);
+}
+
+// ---- rozpoznawanie ramek ----
+
+static void decodeTextLine(StreamDecoder& d, const char* line) {
+  KneeSample s;
+  unsigned long long t = 0;
+  unsigned long seq = 0;
+  int inv1 = 0, inv2 = 0, q1 = 0, q2 = 0;
+  int n = 0;
+  StreamFrameKind kind = STREAM_NONE;
+  if (line[0] >= '0' && line[0] <= '9') {
+    kind = STREAM_CSV;
+    n = sscanf(line, "%llu,%f,%f,%f,%f,%f,%f,%f,%d,%d,%d,%d,%lu", &t, &s.roll1, &s.pitch1, &s.yaw1,
+               &s.roll2, &s.pitch2, &s.yaw2, &s.knee_angle, &inv1, &inv2, &q1, &q2, &seq);
+  } else if (strncmp(line, "time:", 5) == 0) {
+    kind = STREAM_LABELED;
+    n = sscanf(line,
+               "time:%llu roll1:%f pitch1:%f yaw1:%f roll2:%f pitch2:%f yaw2:%f"
+               " knee_angle:%f inv1:%d inv2:%d q1:%d q2:%d seq:%lu",
+               &t, &s.roll1, &s.pitch1, &s.yaw1, &s.roll2, &s.pitch2, &s.yaw2, &s.knee_angle,
+               &inv1, &inv2, &q1, &q2, &seq);
+  }
+  if (n < 8) { // komunikat albo linia niepełna
+    if (line[0] != '\0') d.stats.text_lines++;
+    return;
+  }
+  s.t_us = t;
+  s.inv1 = inv1 != 0;
+  s.inv2 = inv2 != 0;
+  s.q1 = (SampleQuality)q1;
+  s.q2 = (SampleQuality)q2;
+  onFrame(d, kind, (uint32_t)seq, n >= 13 ? 32 : 0, &s, 1, 0);
+}
+
+// Próba dekodowania od początku bufora; zwraca liczbę zużytych bajtów (0 = za mało danych).
+static size_t tryParse(StreamDecoder& d) {
+  const uint8_t* b = d.buf;
+  const size_t len = d.len;
+
+  if (b[0] == BIN_SYNC0) {
+    if (len < 2) return 0;
+    if (b[1] == BIN_SYNC1) {
+      if (len < BIN_FRAME_LEN) return 0;
+      uint16_t seq = 0;
+      KneeSample s;
+      if (!decodeBinaryFrame(b, seq, s)) {
+        d.stats.crc_errors++;
+        return 1;
+      }
+      onFrame(d, STREAM_BIN, seq, 16, &s, 1, 0);
+      return BIN_FRAME_LEN;
+    }
+    if (b[1] == BATCH_SYNC1) {
+      if (len < BATCH_HEADER_LEN) return 0;
+      const uint8_t count = b[12];
+      if (count == 0 || count > BATCH_K_MAX || b[13] != BATCH_VERSION) {
+        d.stats.crc_errors++;
+        return 1;
+      }
+      const size_t flen = batchFrameLen(count);
+      if (len < flen) return 0;
+      uint16_t seq = 0;
+      KneeSample s[BATCH_K_MAX];
+      const size_t n = decodeBatchFrame(b, flen, seq, s, BATCH_K_MAX);
+      if (n == 0) {
+        d.stats.crc_errors++;
+        return 1;
+      }
+      onFrame(d, STREAM_BATCH, seq, 16, s, n, 0);
+      return flen;
+    }
+    if (b[1] == BATCH_DELTA_SYNC1) {
+      if (len < BATCH_DELTA_HEADER_LEN) return 0;
+      const size_t flen = BATCH_DELTA_HEADER_LEN + getLe16(b + 4) + 2;
+      if (flen > BATCH_DELTA_FRAME_MAX || b[6] == 0 || b[6] > BATCH_K_MAX || b[7] != BATCH_VERSION) {
+        d.stats.crc_errors++;
+        return 1;
+      }
+      if (len < flen) return 0;
+      // CRC przed dekodowaniem – dekoder delta zmienia stan
+      if (crc16Ccitt(b + 2, flen - 4) != getLe16(b + flen - 2)) {
+        d.stats.crc_errors++;
+        return 1;
+      }
+      uint16_t seq = 0;
+      KneeSample s[BATCH_K_MAX];
+      const uint32_t skipped0 = d.delta.codec.skipped;
+      const size_t n = decodeDeltaFrame(d.delta, b, flen, seq, s, BATCH_K_MAX);
+      onFrame(d, STREAM_DELTA, seq, 16, s, n, d.delta.codec.skipped - skipped0);
+      return flen;
+    }
+    d.stats.bytes_skipped++;
+    return 1;
+  }
+
+  if (b[0] == LOG_MAGIC0 && len >= 2 && b[1] == LOG_MAGIC1) {
+    if (len < LOG_BLOCK_SIZE) return 0;
+    LogBlockInfo info;
+    if (logBlockValid(b, &info)) {
+      KneeSample s[LOG_DELTA_SAMPLES_MAX];
+      const size_t n = logDecodeBlock(b, s, LOG_DELTA_SAMPLES_MAX);
+      onFrame(d, STREAM_LOG, info.seq, 32, s, n, 0);
+      return LOG_BLOCK_SIZE;
+    }
+    d.stats.crc_errors++;
+    return 1;
+  }
+  if (b[0] == LOG_MAGIC0 && len < 2) return 0;
+
+  // tekst do '\n' (albo do bajtu ramki binarnej, gdy linia została urwana)
+  for (size_t i = 0; i < len; i++) {
+    if (b[i] == '\n' || (b[i] == BIN_SYNC0 && i > 0)) {
+      char line[STREAM_TEXT_MAX];
+      size_t n = i < STREAM_TEXT_MAX - 1 ? i : STREAM_TEXT_MAX - 1;
+      memcpy(line, b, n);
+      while (n > 0 && line[n - 1] == '\r') n--;
+      line[n] = '\0';
+      if (b[i] == '\n') {
+        decodeTextLine(d, line);
+        return i + 1;
+      }
+      d.stats.bytes_skipped += i;
+      return i;
+    }
+  }
+  if (len >= STREAM_TEXT_MAX) {
+    d.stats.bytes_skipped += len;
+    return len;
+  }
+  return 0;
+}
+
+static void parseBuffer(StreamDecoder& d) {
+  while (d.len > 0) {
+    const size_t used = tryParse(d);
+    if (used == 0) break;
+    memmove(d.buf, d.buf + used, d.len - used);
+    d.len -= used;
+  }
+}
+
+void streamDecoderFeed(StreamDecoder& d, const uint8_t* data, size_t n) {
+  while (n > 0) {
+    const size_t room = STREAM_BUF_LEN - d.len;
+    const size_t chunk = n < room ? n : room;
+    memcpy(d.buf + d.len, data, chunk);
+    d.len += chunk;
+    data += chunk;
+    n -= chunk;
+    parseBuffer(d);
+  }
+}
+
+void streamDecoderFinish(StreamDecoder& d) {
+  if (d.len == 0) return;
+  if (d.len < STREAM_BUF_LEN) {
+    d.buf[d.len++] = '\n'; // ostatnia linia bez końca wiersza
+    parseBuffer(d);
+  }
+  d.stats.bytes_skipped += d.len;
+  d.len = 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "batch_frame.h"
+#include "binary_frame.h"
+#include "fusion.h"
+#include "session_log.h"
+
+/*
+  KneeGuard – referencyjny dekoder strumienia telemetrii (host)
+
+  Przyjmuje surowe bajty z USB/BT (zapis z terminala, pliku, gniazda RFCOMM) i
+  rozpoznaje wszystkie formaty wyjściowe firmware:
+  - linie CSV (BT) i etykietowane (USB) z polem seq,
+  - ramki 0xAA 0x55, paczki 0xAA 0x5A i skompresowane paczki 0xAA 0x5D,
+  - bloki dziennika 'K' 'L' (pobieranie "log get").
+  Linie komunikatów ("[TAG] ...") są pomijane – firmware wysyła tylko ASCII,
+  więc bajt 0xAA zawsze zaczyna ramkę binarną.
+
+  Każda ramka ma numer kolejny (linie: uint32, ramki/paczki: uint16, bloki: uint32).
+  SeqTracker rozwija go do 64 bit i liczy ramki utracone, zduplikowane i spóźnione
+  (zmiana kolejności); zmiana formatu albo duży skok wstecz to restart strumienia.
+  Luka jest odtwarzana jako zdarzenie StreamGap: czasy próbek po obu stronach
+  (t_us 64-bit) i szacowana liczba brakujących próbek (z przerwy w czasie i
+  ostatniego okresu próbkowania) – także dla paczek i próbek pominiętych przez
+  dekoder delta do najbliższej klatki kluczowej.
+*/
+
+struct SeqTracker {
+  bool     started    = false;
+  uint64_t next       = 0; // oczekiwany numer (rozwinięty)
+  uint64_t window     = 0; // bit i: odebrano next - 1 - i (duplikaty/spóźnione)
+  uint64_t received   = 0;
+  uint64_t lost       = 0; // luki pomniejszone o ramki, które dotarły później
+  uint64_t duplicates = 0;
+  uint64_t late       = 0; // dotarły po późniejszych (zmiana kolejności)
+  uint64_t restarts   = 0;
+};
+
+enum SeqEvent : uint8_t { SEQ_IN_ORDER, SEQ_GAP, SEQ_LATE, SEQ_DUPLICATE, SEQ_RESTART };
+
+// Numer ramki o szerokości bits (16 albo 32). missing = liczba ramek brakujących
+// przed tą (SEQ_GAP).
+SeqEvent seqTrackerPush(SeqTracker& t, uint32_t raw, uint8_t bits, uint64_t& missing);
+
+static inline float seqLossPct(const SeqTracker& t) {
+  const uint64_t total = t.received + t.lost;
+  return total ? 100.0f * (float)t.lost / (float)total : 0.0f;
+}
+
+enum StreamFrameKind : uint8_t {
+  STREAM_NONE = 0, STREAM_CSV, STREAM_LABELED, STREAM_BIN, STREAM_BATCH, STREAM_DELTA, STREAM_LOG,
+};
+
+const char* streamFrameKindName(StreamFrameKind k);
+
+struct StreamGap {
+  StreamFrameKind kind;
+  uint64_t first_seq;       // pierwszy brakujący numer (rozwinięty)
+  uint64_t frames;          // brakujące ramki (0: tylko próbki pominięte przez dekoder delta)
+  uint64_t t_before_us;     // ostatnia próbka przed luką
+  uint64_t t_after_us;      // pierwsza próbka po luce
+  uint64_t samples_est;     // szacowana liczba brakujących próbek
+};
+
+struct StreamStats {
+  uint64_t samples       = 0;
+  uint64_t samples_lost  = 0; // suma StreamGap.samples_est
+  uint64_t gaps          = 0;
+  uint64_t crc_errors    = 0; // ramki/paczki/bloki z błędnym CRC lub długością
+  uint64_t text_lines    = 0; // komunikaty pominięte
+  uint64_t bytes_skipped = 0; // bajty poza rozpoznanymi ramkami
+};
+
+static const size_t STREAM_TEXT_MAX = 256;
+static const size_t STREAM_BUF_LEN  = BATCH_OUT_MAX > LOG_BLOCK_SIZE ? BATCH_OUT_MAX : LOG_BLOCK_SIZE;
+
+struct StreamDecoder {
+  uint8_t buf[STREAM_BUF_LEN];
+  size_t  len = 0;
+
+  StreamFrameKind   kind = STREAM_NONE; // format ostatniej ramki (zmiana = restart seq)
+  SeqTracker        seq;
+  DeltaFrameDecoder delta;
+
+  // odtwarzanie luk
+  bool     has_t        = false;
+  uint64_t last_t_us    = 0;
+  uint64_t period_us    = 0; // ostatni okres między kolejnymi próbkami bez luki
+  bool     gap_pending  = false;
+  StreamGap pending;
+
+  StreamStats stats;
+
+  void (*on_sample)(void* ctx, const KneeSample& s, StreamFrameKind kind, uint64_t seq) = nullptr;
+  void (*on_gap)(void* ctx, const StreamGap& g) = nullptr;
+  void* ctx = nullptr;
+};
+
+void streamDecoderInit(StreamDecoder& d);
+
+// Kolejne bajty strumienia (dowolne porcje); próbki i luki przez wywołania zwrotne.
+void streamDecoderFeed(StreamDecoder& d, const uint8_t* data, size_t n);
+
+// Koniec danych: niepełna linia tekstu (bez '\n') jest jeszcze dekodowana.
+void streamDecoderFinish(StreamDecoder& d);
+
+static inline float streamSampleLossPct(const StreamDecoder& d) {
+  const uint64_t total = d.stats.samples + d.stats.samples_lost;
+  return total ? 100.0f * (float)d.stats.samples_lost / (float)total : 0.0f;
+}
@@ -0,0 +1,33 @@
+#include "telemetry.h"
+
+#include <stdio.h>
+
+size_t formatTelemetryCsv(char* out, size_t cap, const KneeSample& s, uint32_t seq) {
+  const int n = snprintf(out, cap,
+                         "%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%d,%d,%lu\n",
+                         (unsigned long long)s.t_us,
+                         s.roll1, s.pitch1, s.yaw1,
+                         s.roll2, s.pitch2, s.yaw2,
+                         s.knee_angle,
+                         s.inv1 ? 1 : 0,
+                         s.inv2 ? 1 : 0,
+                         (int)s.q1, (int)s.q2, (unsigned long)seq);
+  if (n < 0 || (size_t)n >= cap) return 0;
+  return (size_t)n;
+}
+
+size_t formatTelemetryLabeled(char* out, size_t cap, const KneeSample& s, uint32_t seq) {
+  const int n = snprintf(out, cap,
+                         "time:%llu roll1:%.2f pitch1:%.2f yaw1:%.2f"
+                         " roll2:%.2f pitch2:%.2f yaw2:%.2f"
+                         " knee_angle:%.2f inv1:%d inv2:%d q1:%d q2:%d seq:%lu\r\n",
+                         (unsigned long long)s.t_us,
+                         s.roll1, s.pitch1, s.yaw1,
+                         s.roll2, s.pitch2, s.yaw2,
+                         s.knee_angle,
+                         s.inv1 ? 1 : 0,
+                         s.inv2 ? 1 : 0,
+                         (int)s.q1, (int)s.q2, (unsigned long)seq);
+  if (n < 0 || (size_t)n >= cap) return 0;
+  return (size_t)n;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+
+/*
+  KneeGuard – formatowanie telemetrii
+
+  BT: szybki CSV bez etykiet (łatwy parsing w aplikacji):
+    time,roll1,pitch1,yaw1,roll2,pitch2,yaw2,knee_angle,inv1,inv2,q1,q2,seq\n
+
+  USB: format etykietowany (pod Serial Plotter / łatwe logowanie):
+    time:.. roll1:.. pitch1:.. yaw1:.. roll2:.. pitch2:.. yaw2:.. knee_angle:.. inv1:.. inv2:.. q1:.. q2:.. seq:..\r\n
+
+  time = monotoniczny czas 64-bit w us, seq = numer kolejny linii w danym strumieniu
+  (rośnie także dla linii odrzuconych – luka w seq to utracona linia).
+  q1/q2 = SampleQuality: 0 pomiar, 1 przerwa I2C wypełniona żyroskopem, 2 brak danych
+*/
+
+static const size_t TELEMETRY_CSV_MAX     = 128;
+static const size_t TELEMETRY_LABELED_MAX = 192;
+
+// Zwraca liczbę zapisanych bajtów (bez '\0') albo 0, gdy bufor jest za mały.
+size_t formatTelemetryCsv(char* out, size_t cap, const KneeSample& s, uint32_t seq);
+
+// Cała linia USB w jednym buforze (jeden zapis do Serial); zwraca jak wyżej.
+size_t formatTelemetryLabeled(char* out, size_t cap, const KneeSample& s, uint32_t seq);
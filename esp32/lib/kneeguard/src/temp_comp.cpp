@@ -0,0 +1,106 @@
+#include "temp_comp.h"
+
+#include <math.h>
+
+#include "binary_frame.h"
+#include "le_bytes.h"
+
+void tempFitAddPoint(TempBiasFit& f, float temp_c, const float bias[3]) {
+  if (f.n >= TEMP_FIT_N_MAX) {
+    f.n *= 0.5f;
+    f.st *= 0.5f;
+    f.st2 *= 0.5f;
+    for (int i = 0; i < 3; i++) {
+      f.sb[i] *= 0.5f;
+      f.stb[i] *= 0.5f;
+    }
+  }
+  const float t = temp_c - TEMP_REF_C;
+  f.n += 1.0f;
+  f.st += t;
+  f.st2 += t * t;
+  for (int i = 0; i < 3; i++) {
+    f.sb[i] += bias[i];
+    f.stb[i] += t * bias[i];
+  }
+  f.last_t = temp_c;
+  f.since_point_s = 0;
+  f.points++;
+}
+
+bool tempFitObserve(TempBiasFit& f, const ImuState& imu, float dt) {
+  f.since_point_s += dt;
+  if (imu.bias.updates == f.seen_updates) return false;
+  f.seen_updates = imu.bias.updates;
+  if (!imu.has_temp || biasTrackerStdDps(imu.bias) > TEMP_POINT_STD_MAX) return false;
+  if (fabsf(imu.temp_c - f.last_t) < TEMP_POINT_MIN_DT_C && f.since_point_s < TEMP_POINT_MIN_S) return false;
+
+  const float b[3] = {imuBiasNow(imu, 0), imuBiasNow(imu, 1), imuBiasNow(imu, 2)};
+  tempFitAddPoint(f, imu.temp_c, b);
+  return true;
+}
+
+float tempFitStdC(const TempBiasFit& f) {
+  if (f.n < 2.0f) return 0.0f;
+  const float mean = f.st / f.n;
+  const float var = f.st2 / f.n - mean * mean;
+  return var > 0.0f ? sqrtf(var) : 0.0f;
+}
+
+bool tempFitSlopes(const TempBiasFit& f, float k[3]) {
+  for (int i = 0; i < 3; i++) k[i] = 0.0f;
+  const float sd = tempFitStdC(f);
+  if (f.n < TEMP_FIT_MIN_POINTS || sd < TEMP_FIT_MIN_STD_C) return false;
+
+  // k = cov(T, b) / var(T)
+  const float inv_n = 1.0f / f.n;
+  const float mean_t = f.st * inv_n;
+  float out[3];
+  for (int i = 0; i < 3; i++) {
+    out[i] = (f.stb[i] * inv_n - mean_t * f.sb[i] * inv_n) / (sd * sd);
+    if (!(fabsf(out[i]) <= TEMP_SLOPE_MAX)) return false; // także NaN
+  }
+  for (int i = 0; i < 3; i++) k[i] = out[i];
+  return true;
+}
+
+size_t tempModelEncode(const TempBiasFit fits[2], uint8_t* out) {
+  out[0] = 'K';
+  out[1] = 'T';
+  out[2] = TEMP_MODEL_VERSION;
+  out[3] = 0;
+  uint8_t* p = out + 4;
+  for (int i = 0; i < 2; i++) {
+    const TempBiasFit& f = fits[i];
+    const float v[9] = {f.n, f.st, f.st2, f.sb[0], f.sb[1], f.sb[2], f.stb[0], f.stb[1], f.stb[2]};
+    for (int j = 0; j < 9; j++, p += 4) putLeF32(p, v[j]);
+  }
+  putLe16(p, crc16Ccitt(out, (size_t)(p - out)));
+  return TEMP_MODEL_LEN;
+}
+
+bool tempModelDecode(const uint8_t* in, size_t len, TempBiasFit fits[2]) {
+  if (len != TEMP_MODEL_LEN || in[0] != 'K' || in[1] != 'T' || in[2] != TEMP_MODEL_VERSION) return false;
+  if (crc16Ccitt(in, TEMP_MODEL_LEN - 2) != getLe16(in + TEMP_MODEL_LEN - 2)) return false;
+
+  float v[2][9];
+  const uint8_t* p = in + 4;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 9; j++, p += 4) {
+      v[i][j] = getLeF32(p);
+      if (!(fabsf(v[i][j]) < 1e9f)) return false; // NaN / inf
+    }
+    if (v[i][0] < 0.0f) return false;
+  }
+  for (int i = 0; i < 2; i++) {
+    TempBiasFit& f = fits[i];
+    f.n = v[i][0];
+    f.st = v[i][1];
+    f.st2 = v[i][2];
+    for (int a = 0; a < 3; a++) {
+      f.sb[a] = v[i][3 + a];
+      f.stb[a] = v[i][6 + a];
+    }
+  }
+  return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "fusion.h"
+
+/*
+  KneeGuard – model biasu żyroskopu od temperatury (logika bez Arduino)
+
+  Czujniki na ciele nagrzewają się w trakcie sesji o kilka °C, a bias
+  żyroskopu MPU6050 idzie za temperaturą (~0.1..0.2 dps/°C). Model per IMU
+  i oś: bias(T) = bg + tk * (T - TEMP_REF_C), stosowany w fuseImuSample przez
+  gotową poprawkę tc (imuSetTemperature) – 3 odejmowania na próbkę.
+
+  Dane do dopasowania zbiera urządzenie: każde okno bezruchu przyjęte przez
+  BiasTracker z niepewnością < TEMP_POINT_STD_MAX daje punkt (T, bias w tej
+  temperaturze), najwyżej co TEMP_POINT_MIN_DT_C albo TEMP_POINT_MIN_S
+  (długa przerwa w jednej temperaturze nie dominuje regresji). Regresja
+  liniowa z sum (T względem TEMP_REF_C) jest liczona przy każdym punkcie.
+
+  Sumy są zapisywane w NVS (tempModelEncode), więc model zbiera dane z wielu
+  sesji; powyżej TEMP_FIT_N_MAX punktów sumy są połowione (starsze dane
+  tracą wagę). Nachylenie jest przyjmowane dopiero przy rozrzucie temperatur
+  >= TEMP_FIT_MIN_STD_C i |tk| <= TEMP_SLOPE_MAX.
+*/
+
+static const float    TEMP_POINT_MIN_DT_C = 0.25f;
+static const float    TEMP_POINT_MIN_S    = 30.0f;
+static const float    TEMP_POINT_STD_MAX  = 0.1f;   // dps: pewność BiasTracker przy punkcie
+static const uint16_t TEMP_FIT_MIN_POINTS = 8;
+static const float    TEMP_FIT_MIN_STD_C  = 1.0f;
+static const float    TEMP_SLOPE_MAX      = 0.5f;   // dps/°C (datasheet: ZRO ±20 dps w -40..85 °C)
+static const float    TEMP_FIT_N_MAX      = 500.0f;
+
+struct TempBiasFit {
+  // sumy regresji (float: połowione przy TEMP_FIT_N_MAX)
+  float n   = 0;
+  float st  = 0, st2 = 0;            // T - TEMP_REF_C
+  float sb[3]  = {0, 0, 0};
+  float stb[3] = {0, 0, 0};
+
+  // obserwacja w bieżącej sesji (nie zapisywana)
+  uint32_t seen_updates  = 0;     // BiasTracker::updates przy ostatnim sprawdzeniu
+  float    last_t        = -1000; // temperatura ostatniego punktu
+  float    since_point_s = 0;
+  uint32_t points        = 0;     // punkty dodane w tej sesji
+};
+
+void tempFitAddPoint(TempBiasFit& f, float temp_c, const float bias[3]);
+
+// Wywoływane co takt akwizycji (dt = czas taktu): nowe okno BiasTracker ->
+// ewentualnie nowy punkt. true = dodano punkt (warto przeliczyć nachylenia).
+bool tempFitObserve(TempBiasFit& f, const ImuState& imu, float dt);
+
+// Nachylenia [dps/°C]; false (k = 0) przy za małej liczbie punktów, rozrzucie
+// temperatur albo nachyleniu poza zakresem.
+bool tempFitSlopes(const TempBiasFit& f, float k[3]);
+
+// Odchylenie standardowe temperatur punktów [°C].
+float tempFitStdC(const TempBiasFit& f);
+
+// magic 'K' 'T' | wersja | 0 | 2 x (n, st, st2, sb xyz, stb xyz) f32 LE | CRC16
+static const uint8_t TEMP_MODEL_VERSION = 1;
+static const size_t  TEMP_MODEL_LEN     = 4 + 2 * 9 * 4 + 2;
+
+size_t tempModelEncode(const TempBiasFit fits[2], uint8_t* out);
+
+// false: zła długość, magic, wersja, CRC albo sumy nieskończone / n < 0.
+// Stan obserwacji w fits nie jest zmieniany.
+bool tempModelDecode(const uint8_t* in, size_t len, TempBiasFit fits[2]);
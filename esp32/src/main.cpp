@@ -1,355 +1,2038 @@
 #include <BluetoothSerial.h>
+#include <LittleFS.h>
+#include <Preferences.h>
 #include <Wire.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <math.h>
 
+#include "batch_frame.h"
+#include "binary_frame.h"
+#include "bus_recovery.h"
+#include "calib_store.h"
+#include "command.h"
+#include "data_ready.h"
+#include "decimator.h"
+#include "fusion.h"
+#include "le_bytes.h"
+#include "mpu6050.h"
+#include "perf_stats.h"
+#include "raw_trace.h"
+#include "sensor_array.h"
+#include "sensor_layout.h"
+#include "session_log.h"
+#include "spsc_ring.h"
+#include "telemetry.h"
+#include "temp_comp.h"
+
 /*
   KneeGuard – firmware ESP32 (Arduino)
 
   Cel: pomiar kąta zgięcia kolana z wykorzystaniem dwóch modułów MPU6050
        (IMU1: udo, IMU2: podudzie) oraz wysyłanie danych przez USB Serial i Bluetooth.
+       Więcej czujników i stawów (biodro, kolano, kostka obu nóg): tablice
+       SENSORS / JOINTS w sensor_layout.h – czujniki na obu kontrolerach I2C
+       (Wire, Wire1) i za multiplekserami TCA9548A, porty czytane równolegle.
 
   Najważniejsze założenia:
   - odczyt: akcelerometr + żyroskop (MPU6050)
   - roll/pitch: filtr Kalmana 1D (osobno dla każdej osi)
   - yaw: integracja żyroskopu (bez magnetometru -> dryf)
   - kąt kolana: stabilna, dodatnia różnica kątowa roll (0..180°)
+
+  Matematyka i fuzja (bez zależności od Arduino) są w lib/kneeguard –
+  ten plik zawiera tylko obsługę sprzętu (I2C, Serial, BT) i potok zadań.
+
+  Potok (PIPELINE_DUAL_CORE):
+  - zadanie akwizycji (rdzeń 1, przerwanie data-ready czujnika odniesienia):
+    I2C + fuzja -> bufor SPSC; czujniki na Wire1 czyta w tym czasie zadanie
+    portu 1 (busRunAll)
+  - zadanie transportu (rdzeń 0): komendy, Serial, BT <- bufor SPSC
+  Zablokowany zapis BT/USB nie opóźnia więc kolejnej próbki IMU.
+
+  Błędy I2C (BusLink, lib/kneeguard/src/bus_recovery.h): po kilku kolejnych
+  błędach magistrala jest odblokowywana (impulsy SCL + STOP), Wire startuje od
+  nowa, a czujnik jest resetowany i konfigurowany od nowa (bias i offsety
+  zostają w ImuState).
+  Do tego czasu kąty są propagowane żyroskopem (jakość q1/q2 w telemetrii),
+  a ANGLE_INVALID pojawia się dopiero po GAP_FILL_MAX_S. Odzyskiwany jest tylko
+  port z niesprawnym czujnikiem.
+
+  Dziennik sesji (lib/kneeguard/src/session_log.h): transport kopiuje każdą
+  próbkę akwizycji do zadania dziennika, które zapisuje bloki 512 B do pliku
+  na LittleFS (bufor cykliczny) – dane nie giną, gdy telefon jest poza zasięgiem.
+  "log get" wysyła bloki hurtem przez USB albo BT. Bloki i "format delta" na BT
+  używają bezstratnej kompresji z lib/kneeguard/src/delta_codec.h.
+
+  Kalibracja (lib/kneeguard/src/calib_store.h): bias żyroskopu obu IMU w jednym
+  naprzemiennym przebiegu przy starcie; bias i offsety "calib" są w NVS i przy
+  kolejnym starcie wystarcza krótkie okno sprawdzające (urządzenie nieruchome).
+  W trakcie pracy bias jest poprawiany w przerwach bez ruchu (bias_tracker.h),
+  a model bias(T) z tych przerw (temp_comp.h) przewiduje dryf przy nagrzewaniu.
+
+  Próbki mają 64-bitowy znacznik czasu (esp_timer), a każdy format wyjściowy
+  numer kolejny ramki – referencyjny dekoder hosta: tools/kgdecode.cpp.
+  "trace on" wysyła surowe rejestry i stan fuzji (raw_trace.h) do odtworzenia
+  na hoście tym samym kodem fuzji: tools/kgreplay.cpp.
 */
 
 // ============================================================================
 // 1) Konfiguracja sprzętu i parametrów
 // ============================================================================
 
-static const uint8_t I2C_SDA = 21;
-static const uint8_t I2C_SCL = 22;
-
-static const uint8_t MPU1_ADDR = 0x68; // IMU1 (udo)      – AD0 = GND/NC
-static const uint8_t MPU2_ADDR = 0x69; // IMU2 (podudzie) – AD0 = 3.3V
+// Czujniki, porty I2C (piny) i stawy: sensor_layout.h (-DKG_SENSOR_LAYOUT=...).
+static const uint32_t I2C_CLOCK_HZ   = 400000; // po konfiguracji (inicjalizacja: 100 kHz)
+static const uint16_t I2C_TIMEOUT_MS = 5;      // zawieszona magistrala nie blokuje taktu na 50 ms
+static const int      I2C_RETRIES    = 1;      // ponowienie odczytu po NACK adresu/rejestru
 
-static const uint32_t SEND_FREQ_HZ   = 50;                    // docelowa częstotliwość telemetrii
+static const uint32_t SEND_FREQ_HZ   = 50;                    // domyślna częstotliwość telemetrii
 static const uint32_t SEND_PERIOD_US = 1000000UL / SEND_FREQ_HZ;
+static const uint32_t SEND_FREQ_MAX_HZ = 1000;                 // limit komendy "send" (= max Fs czujnika)
+
+// Telemetria jako decymowany strumień akwizycji (FIR antyaliasingowy, współczynnik
+// = częstotliwość próbkowania / send); false: ostatnia próbka co send_period_us.
+static const bool TELEMETRY_DECIMATE = true;
+
+// USB Serial: prędkość (np. -DKG_USB_BAUD=921600 w build_flags + monitor_speed)
+// i bufor nadawczy UART – linia telemetrii jest zapisywana jednym write() bez blokowania.
+#ifndef KG_USB_BAUD
+#define KG_USB_BAUD 115200
+#endif
+static const uint32_t USB_BAUD      = KG_USB_BAUD;
+static const size_t   USB_TX_BUFFER = 1024;
+
+// Akwizycja: FIFO MPU6050 (próbki w stałym takcie czujnika, odczyt paczkami)
+// albo odczyt rejestrów 0x3B..0x48 w każdej iteracji loop().
+// Konfiguracja czujnika: domyślnie MpuConfig (DLPF 0x05, 500 Hz, ±8 g, ±500 dps),
+// w locie komendami "rate", "dlpf", "accel", "gyro" (patrz tablica COMMANDS).
+static const bool    ACQ_USE_FIFO   = true;
+static const size_t  FIFO_BATCH_MAX = 10;   // ramek na transakcję (10 * 12 B < bufor Wire 128 B)
+static const size_t  FIFO_DRAIN_MAX = 40;   // ramek na IMU w jednej iteracji loop()
+
+// Data-ready: INT czujnika odniesienia (DRDY_SENSOR -> DRDY_PIN, sensor_layout.h) budzi
+// akwizycję i daje znaczniki czasu próbek (data_ready.h); FIFO: pobudka co ~ACQ_PERIOD_US
+// próbek, rejestry: co próbkę. Bez przerwań (INT niepodłączony) akwizycja budzi się
+// po ACQ_DRDY_TIMEOUT_PERIODS oczekiwanych pobudkach (najmniej ACQ_DRDY_TIMEOUT_MIN_MS),
+// a czas próbek liczony jest jak z timera.
+// false: takt z esp_timer co ACQ_PERIOD_US.
+static const bool     ACQ_USE_DRDY             = true;
+static const uint32_t ACQ_DRDY_TIMEOUT_MIN_MS  = 5;
+static const uint32_t ACQ_DRDY_TIMEOUT_PERIODS = 3;
+
+// Potok: akwizycja i transport jako osobne zadania na dwóch rdzeniach
+// (false: oba kroki kolejno w loop(), jak w wersji jednowątkowej).
+static const bool     PIPELINE_DUAL_CORE = true;
+static const uint32_t ACQ_PERIOD_US      = 4000; // takt zadania akwizycji (FIFO: ~2 ramki/IMU)
+static const BaseType_t ACQ_CORE         = 1;
+static const BaseType_t TRANSPORT_CORE   = 0;
+static const size_t   SAMPLE_RING_LEN    = 128;  // próbek KneeSample między zadaniami (potęga 2)
+static const UBaseType_t BUS1_PRIORITY   = configMAX_PRIORITIES - 2; // zadanie portu 1 (jak akwizycja)
+
+// Fuzja: FUSION_KALMAN (roll/pitch, kolano w płaszczyźnie strzałkowej) albo
+// FUSION_MADGWICK / FUSION_MAHONY (kwaternion, kolano jako kąt względnego obrotu).
+// Zmiana w locie komendą "fusion kalman|madgwick|mahony".
+static const FusionEngine FUSION_ENGINE = FUSION_KALMAN;
 
 static const char* BT_DEVICE_NAME = "KneeGuard"; // nazwa widoczna przy parowaniu
 
-// Skale MPU6050 (konfiguracja: ±8 g, ±500 dps)
-static const float ACC_LSB_PER_G    = 4096.0f;
-static const float GYRO_LSB_PER_DPS = 65.5f;
+// BT "format batch": K próbek w jednym zapisie SPP (200..500 Hz przy ~50 zapisach/s);
+// niepełna paczka wychodzi po BATCH_MAX_LATENCY_MS. Zmiana w locie: "batch <K> [ms]".
+// "format delta": te same paczki z bezstratną kompresją (~9..10 B/próbkę zamiast 17 B).
+static const uint8_t  BATCH_K              = 10;
+static const uint32_t BATCH_MAX_LATENCY_MS = 20;
+
+// Dziennik sesji na LittleFS: każda próbka akwizycji (niezależnie od BT), bloki
+// 512 B w buforze cyklicznym; pobieranie "log get", wznowienie od "log ack".
+// Przy 500 Hz ~17 bloków/s: 2048 bloków (1 MB) to ~2 min, przy 100 Hz ~10 min;
+// z kompresją (LOG_COMPRESS, delta_codec.h) ~1.7x dłużej.
+static const bool       LOG_ENABLED     = true;  // zapis od startu (komendy "log on|off")
+static const char*      LOG_FILE_PATH   = "/littlefs/session.kgl";
+static const uint32_t   LOG_FILE_BLOCKS = 2048;  // partycja danych esp32dev: ~1.4 MB
+static const bool       LOG_COMPRESS    = true;  // bloki LOG_KIND_KNEE_DELTA
+static const size_t     LOG_RING_LEN    = 256;   // próbek transport -> zadanie dziennika (potęga 2)
+static const uint32_t   LOG_DL_BATCH    = 8;     // bloków pobierania na iterację zadania dziennika
+static const BaseType_t LOG_CORE        = 0;
+
+// Kalibracja w NVS (Preferences): bias żyroskopu + offsety "calib", rekord CalibRecord
+// na każde dwa czujniki (klucze "calib", "calib1", ...).
+// "calib gyro" – ponowna kalibracja biasu w trakcie pracy, "calib clear" – usunięcie zapisu.
+static const char*    CALIB_NVS_NAMESPACE  = "kneeguard";
+static const char*    CALIB_NVS_KEY        = "calib";
+static const size_t   CAL_RECORDS          = (SENSOR_COUNT + 1) / 2;
+static const uint32_t GYRO_CAL_TIMEOUT_US  = 3000000; // "calib gyro": limit zbierania CAL_SAMPLES
+
+// Kompensacja temperaturowa biasu: TEMP_OUT co TEMP_READ_PERIOD_US (FIFO: osobny odczyt
+// 2 B, tryb rejestrowy: z bloku 14 B), model bias(T) w NVS najwyżej co TEMP_SAVE_PERIOD_S.
+static const uint32_t TEMP_READ_PERIOD_US = 1000000;
+static const uint32_t TEMP_SAVE_PERIOD_S  = 600;
+static const char*    TEMP_NVS_KEY        = "tempfit"; // jak calib: "tempfit", "tempfit1", ...
+
+// Ślad surowy ("trace on"): rejestry obu IMU stawu głównego (JOINTS[0]) + stan fuzji na USB (raw_trace.h),
+// odtwarzanie na hoście: tools/kgreplay.cpp. ~48 B na próbkę (24 KB/s przy 500 Hz)
+// wymaga KG_USB_BAUD >= TRACE_MIN_BAUD; przy wolniejszym USB rekordy giną
+// (licznik lost), a po stracie akwizycja wysyła pełny stan od nowa.
+static const size_t   TRACE_RING_BYTES = 16384; // akwizycja -> transport (potęga 2)
+static const uint32_t TRACE_MIN_BAUD   = 460800;
 
 // ============================================================================
-// 2) Struktury danych
-// ============================================================================
-
-struct Kalman1D {
-  float angle_deg = 0.0f; // estymowana wartość kąta
-  float uncert    = 4.0f; // niepewność estymacji
-};
-
-struct ImuState {
-  // surowe próbki (po przeskalowaniu)
-  float ax = 0, ay = 0, az = 0;
-  float gx = 0, gy = 0, gz = 0;
-
-  // bias żyroskopu (wyznaczony w kalibracji "keep still")
-  float bgx = 0, bgy = 0, bgz = 0;
-
-  // fuzja: roll/pitch z Kalmana, yaw integrowany z gz
-  Kalman1D k_roll, k_pitch;
-  float yaw = 0;
-
-  // offsety po komendzie "calib" (referencja dla montażu na nodze)
-  float off_roll = 0, off_pitch = 0, off_yaw = 0;
-};
-
-// ============================================================================
-// 3) Zmienne globalne
+// 2) Zmienne globalne
 // ============================================================================
 
 BluetoothSerial BT; // Bluetooth Classic SPP
 
-ImuState imu1, imu2;
+// Stan fuzji czujników z SENSORS (właściciel: akwizycja); staw główny JOINTS[0]
+// daje pary kątów 1/2 w KneeSample (telemetria, dziennik, ślad surowy).
+ImuState imus[SENSOR_COUNT];
+static const JointDesc& MAIN_JOINT = JOINTS[0];
 
 uint32_t last_us       = 0;
 uint32_t last_send_us  = 0;
-uint32_t err_count1    = 0;
-uint32_t err_count2    = 0;
+uint32_t err_count[SENSOR_COUNT] = {};
 uint32_t last_err_print = 0;
 
-String usbBuf;
-String btBuf;
+// Kąty wszystkich stawów z ostatniej próbki (akwizycja -> transport, bez decymacji)
+volatile float joint_angle[JOINT_COUNT];
+
+// Porty I2C: kolejność odczytu (grupy kanałów multipleksera), wybrany kanał,
+// zadanie portu 1 czytające Wire1 równolegle z portem 0 w akwizycji.
+TwoWire* const WIRES[SENSOR_PORTS] = {&Wire, &Wire1};
+uint8_t        port_order[SENSOR_PORTS][SENSORS_MAX];
+size_t         port_len[SENSOR_PORTS] = {0, 0};
+MuxPort        mux[SENSOR_PORTS];
+TaskHandle_t      bus1_task = nullptr;
+SemaphoreHandle_t bus1_done = nullptr;
+
+KneeSample last_knee; // ostatnia próbka wyjściowa (wysyłana w takcie telemetrii)
+
+// Przekazanie próbek akwizycja -> transport (bez blokad, jeden producent/konsument)
+SpscRing<KneeSample, SAMPLE_RING_LEN> sample_ring;
+TaskHandle_t  acq_task       = nullptr;
+TaskHandle_t  transport_task = nullptr;
+esp_timer_handle_t acq_timer = nullptr;
+
+// Przerwanie data-ready (zapis: ISR, odczyt: akwizycja)
+DrdyStamps        drdy;
+volatile uint32_t drdy_wake_div = 1;  // przerwań na pobudkę akwizycji
+volatile uint32_t drdy_timeout_ms = ACQ_DRDY_TIMEOUT_MIN_MS; // pobudka bez przerwania
+DrdyFifo          drdy_fifo;          // ramki FIFO czujnika odniesienia <-> przerwania
+DrdyJitter        drdy_jitter;
+uint32_t          drdy_seen     = 0;  // drdy.count przy poprzednim takcie akwizycji
+uint32_t          drdy_timeouts = 0;  // pobudki bez przerwania (drdy_timeout_ms)
+
+volatile uint32_t samples_pushed = 0; // próbki wstawione do bufora
+
+uint32_t usb_frames_sent    = 0; // linie telemetrii zapisane do Serial
+uint32_t usb_frames_dropped = 0; // linie odrzucone w całości (brak miejsca w buforze TX)
+volatile bool     imu_ok[SENSOR_COUNT] = {}; // wynik ostatniej akwizycji (przed nią: inicjalizacji)
+volatile bool     calib_pending = false; // "calib" z transportu, wykonywane w akwizycji
+volatile bool     gyro_cal_pending = false; // "calib gyro" z transportu
+volatile int      engine_pending = -1;   // "fusion ..." z transportu (-1 = brak zmiany)
+volatile int      bias_track_pending = -1; // "bias on|off" z transportu (-1 = brak zmiany)
+
+MpuConfig       mpu_cfg;              // aktywna konfiguracja czujników (właściciel: akwizycja)
+MpuScaleFactors mpu_scale;            // skale LSB -> g / dps zgodne z mpu_cfg
+MpuConfig       mpu_cfg_req;          // konfiguracja zlecona komendą (właściciel: transport)
+volatile bool   cfg_pending = false;  // mpu_cfg_req czeka na zapis do czujników
+volatile bool   cfg_report  = false;  // zapis wykonany -> raport "[CONFIG]" z transportu
+volatile bool   cfg_ok      = true;   // wynik ostatniego zapisu konfiguracji
+uint32_t        send_period_us = SEND_PERIOD_US; // takt telemetrii (komenda "send")
+KneeDecimator   decim;                // akwizycja -> telemetria (właściciel: transport)
+
+// Format BT (komenda "format"): CSV, ramka binarna 29 B (v2), paczka K próbek
+// albo paczka skompresowana
+enum BtFormat : uint8_t { BT_FMT_CSV = 0, BT_FMT_BIN = 1, BT_FMT_BATCH = 2, BT_FMT_DELTA = 3 };
+static const int BT_FORMAT_COUNT = 4;
+static const char* const BT_FORMAT_NAMES[BT_FORMAT_COUNT] = {"csv", "bin", "batch", "delta"};
+BtFormat bt_format = BT_FMT_CSV;
+uint32_t bt_seq    = 0;     // numer kolejny linii CSV / ramki binarnej (młodsze 16 bit)
+uint32_t usb_seq   = 0;     // numer kolejny linii USB
+TelemetryBatcher bt_batch;  // paczki BT (właściciel: transport)
+
+CmdLineBuffer usb_cmd; // bufory linii komend (stałe, bez alokacji na stercie)
+CmdLineBuffer bt_cmd;
+
+// Liczniki wydajności (komenda "stats"): histogramy log2 w us + liczniki zdarzeń.
+// Akwizycja: okres taktu, odczyt wszystkich portów w takcie (równolegle: ~najdłuższy port),
+// transakcje I2C na IMU, fuzja jednej próbki (wszystkie IMU + stawy).
+LatencyHist perf_loop, perf_bus, perf_fusion;
+// Data-ready: przerwanie -> start akwizycji, odchylenie okresu przerwań od średniej.
+LatencyHist perf_wake, perf_ts_jitter;
+LatencyHist perf_i2c[SENSOR_COUNT];
+// Transport: czas zapisu linii/ramki do USB i BT.
+LatencyHist perf_usb_write, perf_bt_write;
+uint32_t bt_frames_sent    = 0;
+uint32_t bt_frames_dropped = 0;        // zapis BT krótszy niż ramka (przepełniony bufor SPP)
+uint32_t dt_clamp_count    = 0;        // ile razy computeDtSeconds przycięło dt
+uint32_t ring_dropped_base = 0;        // sample_ring.dropped() w chwili "stats reset"
+volatile bool stats_reset_pending = false; // akwizycja zeruje swoje liczniki w najbliższym takcie
+
+// Łącza I2C z czujnikami (właściciel: akwizycja): seria błędów -> odzyskanie magistrali.
+BusLink     links[SENSOR_COUNT];
+LatencyHist perf_recover;       // czas odzyskania w akwizycji (impulsy SCL + Wire + reset + kroki wybudzenia + FIFO)
+uint32_t    bus_recoveries = 0; // wykonane odzyskania magistrali
+
+// Reset odzyskiwanego czujnika bez blokowania akwizycji: kolejne kroki w taktach po
+// upływie wake_at_us (reset -> 100 ms -> wybudzenie -> 10 ms -> konfiguracja -> 10 ms
+// -> FIFO); czujnik w trakcie nie jest czytany, pozostałe pracują dalej.
+enum SensorWake : uint8_t { WAKE_IDLE = 0, WAKE_RESET, WAKE_PLL, WAKE_CONFIG };
+SensorWake wake_stage[SENSOR_COUNT] = {};
+uint32_t   wake_at_us[SENSOR_COUNT] = {};
+uint32_t   wake_cost_us[SENSOR_COUNT] = {}; // czas kroków w akwizycji (perf_recover)
+
+// FIFO wystartowane osobno (fifo_fresh): przy najbliższym FIFO_COUNT fifo_lag = ile ramek
+// starszych od jego pierwszej mają pozostałe czujniki; tyle ramek dostaje propagację żyroskopem.
+bool     fifo_fresh[SENSOR_COUNT] = {};
+uint16_t fifo_lag[SENSOR_COUNT]   = {};
+
+// Dziennik sesji (właściciel slog/plik: zadanie dziennika; komendy ustawiają flagi)
+SessionLog   slog;
+FILE*        slog_file = nullptr;
+SpscRing<KneeSample, LOG_RING_LEN> log_ring; // transport -> zadanie dziennika
+TaskHandle_t log_task = nullptr;
+volatile bool     log_active          = false; // próbki trafiają do dziennika
+volatile bool     log_session_pending = false; // "log on": nowa sesja
+volatile bool     log_flush_pending   = false; // "log off": zapis niepełnego bloku
+Stream* volatile  log_dl_req   = nullptr;      // "log get": strumień docelowy
+volatile uint32_t log_dl_from  = 0;            // pierwszy żądany seq
+volatile uint32_t log_acked    = 0;            // "log ack <seq>": ostatni potwierdzony blok
+volatile bool     log_has_ack  = false;
+Stream* volatile  log_dl_io    = nullptr;      // pobieranie w toku (telemetria tego strumienia wstrzymana)
+uint32_t          log_dl_next = 0, log_dl_end = 0, log_dl_sent = 0, log_dl_bad = 0;
+
+// Kalibracja: stan w imus (akwizycja), zapis NVS wykonuje transport po fladze.
+Preferences     prefs;
+bool            prefs_ok      = false;
+uint8_t         calib_flags   = 0;     // CAL_HAS_BIAS / CAL_HAS_MOUNT (właściciel: transport)
+volatile bool   calib_save_pending = false; // "calib" wykonane -> zapis offsetów
+CalibBootAction boot_cal[SENSOR_COUNT] = {};  // CAL_BOOT_CONTINUE
+uint32_t        boot_cal_us   = 0;     // czas przebiegu kalibracji żyroskopu przy starcie
+// Znacznik pierwszej próbki z obu IMU stawu głównego (QUALITY_MEASURED). 64 bit nie jest
+// zapisywany atomowo: transport czyta first_valid_us dopiero po first_valid_set.
+volatile uint64_t first_valid_us = 0;
+volatile bool     first_valid_set = false;
+bool            first_valid_reported = false;
+GyroCalib       gyro_cal[SENSOR_COUNT]; // "calib gyro" (właściciel: akwizycja)
+bool            gyro_cal_active = false;
+uint64_t        gyro_cal_t0     = 0;
+volatile uint32_t gyro_cal_done = 0;   // raport dla transportu: GYRO_CAL_REPORT | bit IMU z nowym biasem
+static const uint32_t GYRO_CAL_REPORT = 0x80000000u;
+
+// Model bias(T) (właściciel: akwizycja); zapis: akwizycja koduje rekordy, transport pisze NVS.
+TempBiasFit     temp_fit[2 * CAL_RECORDS]; // rekord NVS na parę czujników (jak CalibRecord)
+uint32_t        temp_read_us      = 0;
+float           poll_temp[SENSOR_COUNT] = {}; // tryb rejestrowy: temperatura z ostatniego bloku
+uint32_t        temp_unsaved      = 0;     // punkty od ostatniego zapisu
+uint32_t        temp_saved_ms     = 0;
+uint8_t         temp_save_buf[CAL_RECORDS][TEMP_MODEL_LEN];
+volatile bool   temp_save_pending = false; // temp_save_buf gotowy do zapisu
+volatile bool   temp_save_req     = false; // "temp save"
+volatile bool   temp_clear_req    = false; // "temp clear"
+
+// Ślad surowy: rekordy z akwizycji, transport zapisuje je na USB całymi rekordami.
+SpscRing<uint8_t, TRACE_RING_BYTES> trace_ring;
+volatile int    trace_pending      = -1;    // "trace on|off" z transportu (-1 = brak zmiany)
+volatile bool   trace_active       = false; // akwizycja zapisuje rekordy (USB bez telemetrii)
+bool            trace_state_dirty  = false; // stan IMU zmieniony poza fuzją -> STATE przed próbką
+bool            trace_config_dirty = false; // nowa konfiguracja czujników -> CONFIG
+uint32_t        trace_seq          = 0;
+uint32_t        trace_records_sent = 0;     // (właściciel: transport)
 
 // ============================================================================
-// 4) Matematyka (kąty, filtr Kalmana)
+// 3) I2C + MPU6050 (obsługa niskopoziomowa)
 // ============================================================================
 
-// Q = niepewność modelu (żyroskop: dryf/szum), R = niepewność pomiaru (akcelerometr)
-static const float KALMAN_Q = 16.0f; // (deg/s)^2
-static const float KALMAN_R =  1.0f; // (deg)^2
+// Wybór kanału multipleksera przed transakcją z czujnikiem i (bez zapisu, gdy
+// kanał jest już wybrany). Czujniki portu są czytane grupami kanałów (port_order).
+static bool sensorSelect(size_t i) {
+  const SensorDesc& d = SENSORS[i];
+  MuxPort& m = mux[d.port];
+  if (!muxNeedsSelect(m, d.mux_ch)) return true;
+  TwoWire& w = *WIRES[d.port];
+  w.beginTransmission(MUX_ADDR);
+  w.write((uint8_t)(1u << d.mux_ch));
+  const bool ok = w.endTransmission() == 0;
+  m.ch = ok ? d.mux_ch : MUX_UNKNOWN;
+  m.selects++;
+  return ok;
+}
 
-static inline void kalmanUpdate(Kalman1D& k, float rate_dps, float meas_deg, float dt) {
-  k.angle_deg += dt * rate_dps;
-  k.uncert    += dt * dt * KALMAN_Q;
+// Po błędzie stan multipleksera jest nieznany (np. reset zasilania) – wybór od nowa.
+static inline bool sensorResult(size_t i, bool ok) {
+  if (!ok) mux[SENSORS[i].port].ch = MUX_UNKNOWN;
+  return ok;
+}
 
-  const float K = k.uncert / (k.uncert + KALMAN_R);
-  k.angle_deg += K * (meas_deg - k.angle_deg);
-  k.uncert     = (1.0f - K) * k.uncert;
+static bool writeReg(size_t i, uint8_t reg, uint8_t val) {
+  if (!sensorSelect(i)) return false;
+  TwoWire& w = *WIRES[SENSORS[i].port];
+  w.beginTransmission(SENSORS[i].addr);
+  w.write(reg);
+  w.write(val);
+  return sensorResult(i, w.endTransmission() == 0);
 }
 
-static inline float wrap180(float deg) {
-  while (deg > 180) deg -= 360;
-  while (deg < -180) deg += 360;
-  return deg;
+// Faza adresu/rejestru jest ponawiana (I2C_RETRIES) – po NACK nic nie zostało
+// odczytane; nieudany odczyt danych już nie (FIFO mogło stracić bajty).
+static bool readBurstNoStats(size_t i, uint8_t startReg, uint8_t* buf, size_t n) {
+  if (!sensorSelect(i)) return false;
+  TwoWire& w = *WIRES[SENSORS[i].port];
+  const uint8_t addr = SENSORS[i].addr;
+  for (int attempt = 0;; attempt++) {
+    w.beginTransmission(addr);
+    w.write(startReg);
+    if (w.endTransmission(false) == 0) break; // repeated start
+    if (attempt >= I2C_RETRIES) return sensorResult(i, false);
+  }
+  if (w.requestFrom((int)addr, (int)n, (int)true) != n) return sensorResult(i, false);
+  for (size_t k = 0; k < n; k++) buf[k] = w.read();
+  return true;
 }
 
-// Minimalna różnica kątowa (wynik w [-180..180]), odporna na przejście przez ±180°.
-static inline float angleDiffDeg(float a1_deg, float a2_deg) {
-  const float rad = (a1_deg - a2_deg) * PI / 180.0f;
-  return atan2f(sinf(rad), cosf(rad)) * 180.0f / (float)PI;
+// Odczyt bloku rejestrów; czas transakcji trafia do histogramu danego IMU.
+static bool readBurst(size_t i, uint8_t startReg, uint8_t* buf, size_t n) {
+  const uint32_t t0 = micros();
+  const bool ok = readBurstNoStats(i, startReg, buf, n);
+  latencyRecord(perf_i2c[i], micros() - t0);
+  return ok;
 }
 
-// Kąty z akcelerometru (roll/pitch) – atan2 daje poprawny znak i ćwiartkę.
-static inline void accelAnglesDeg(float ax, float ay, float az, float& roll_deg, float& pitch_deg) {
-  roll_deg  = atan2f(ay, az) * 180.0f / (float)PI;                       // [-180..180]
-  pitch_deg = atan2f(-ax, sqrtf(ay * ay + az * az)) * 180.0f / (float)PI; // [-90..90]
+static int readWhoAmI(size_t i) {
+  uint8_t b = 0;
+  return readBurstNoStats(i, MPU_REG_WHO_AM_I, &b, 1) ? b : -1;
 }
 
-// ============================================================================
-// 5) I2C + MPU6050 (obsługa niskopoziomowa)
-// ============================================================================
+// Odblokowanie magistrali portu: czujnik przerwany w połowie bajtu trzyma SDA
+// w stanie niskim – do 9 impulsów SCL kończy jego transfer, potem warunek STOP
+// i Wire od nowa.
+static void i2cBusRecover(uint8_t port) {
+  TwoWire& w = *WIRES[port];
+  const uint8_t sda = I2C_SDA_PINS[port], scl = I2C_SCL_PINS[port];
+  w.end();
+  pinMode(sda, INPUT_PULLUP);
+  pinMode(scl, OUTPUT_OPEN_DRAIN);
+  digitalWrite(scl, HIGH);
+  delayMicroseconds(5);
+  for (int i = 0; i < 9 && digitalRead(sda) == LOW; i++) {
+    digitalWrite(scl, LOW);
+    delayMicroseconds(5);
+    digitalWrite(scl, HIGH);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA niski -> wysoki przy wysokim SCL
+  digitalWrite(scl, LOW);
+  pinMode(sda, OUTPUT_OPEN_DRAIN);
+  digitalWrite(sda, LOW);
+  delayMicroseconds(5);
+  digitalWrite(scl, HIGH);
+  delayMicroseconds(5);
+  digitalWrite(sda, HIGH);
+  delayMicroseconds(5);
+
+  w.begin(sda, scl);
+  w.setClock(I2C_CLOCK_HZ);
+  w.setTimeOut(I2C_TIMEOUT_MS);
+  mux[port].ch = MUX_UNKNOWN;
+}
+
+// Zapis DLPF, częstotliwości i zakresów (bez resetu czujnika).
+static bool mpuApplyConfig(size_t i, const MpuConfig& cfg) {
+  if (!writeReg(i, MPU_REG_CONFIG, cfg.dlpf_cfg)) return false;                    // DLPF
+  if (!writeReg(i, MPU_REG_SMPLRT_DIV, cfg.smplrt_div)) return false;              // Fs
+  if (!writeReg(i, MPU_REG_ACCEL_CONFIG, mpuRangeReg(cfg.accel_range))) return false; // ±g
+  if (!writeReg(i, MPU_REG_GYRO_CONFIG, mpuRangeReg(cfg.gyro_range))) return false;   // ±dps
+  return true;
+}
+
+static const uint32_t MPU_RESET_WAIT_US = 100000; // reset -> wybudzenie
+static const uint32_t MPU_WAKE_STEP_US  = 10000;  // wybudzenie (PLL) -> konfiguracja -> pomiary
+
+// Reset czujnika; wybudzenie (mpuWake) najwcześniej po MPU_RESET_WAIT_US.
+static bool mpuReset(size_t i) {
+  return writeReg(i, MPU_REG_PWR_MGMT_1, 0x80);
+}
 
-static bool writeReg(uint8_t addr, uint8_t reg, uint8_t val) {
-  Wire.beginTransmission(addr);
-  Wire.write(reg);
-  Wire.write(val);
-  return Wire.endTransmission() == 0;
+// Wybudzenie z zegarem PLL żyroskopu; konfiguracja po MPU_WAKE_STEP_US.
+static bool mpuWakeStart(size_t i) {
+  return writeReg(i, MPU_REG_PWR_MGMT_1, 0x01);
 }
 
-static bool readBurst(uint8_t addr, uint8_t startReg, uint8_t* buf, size_t n) {
-  Wire.beginTransmission(addr);
-  Wire.write(startReg);
-  if (Wire.endTransmission(false) != 0) return false; // repeated start
-  if (Wire.requestFrom((int)addr, (int)n, (int)true) != (int)n) return false;
-  for (size_t i = 0; i < n; i++) buf[i] = Wire.read();
+static bool mpuWakeConfig(size_t i) {
+  if (!mpuApplyConfig(i, mpu_cfg)) return false;
+  if (ACQ_USE_DRDY && i == DRDY_SENSOR) { // INT: impuls 50 us na każdą nową próbkę
+    if (!writeReg(i, MPU_REG_INT_PIN_CFG, MPU_INT_PIN_CFG_PULSE)) return false;
+    if (!writeReg(i, MPU_REG_INT_ENABLE, MPU_INT_DATA_RDY)) return false;
+  }
   return true;
 }
 
-static int readWhoAmI(uint8_t addr) {
-  Wire.beginTransmission(addr);
-  Wire.write(0x75); // WHO_AM_I
-  if (Wire.endTransmission(false) == 0 && Wire.requestFrom((int)addr, 1, (int)true) == 1) return Wire.read();
-  return -1;
+static bool mpuWake(size_t i) {
+  if (!mpuWakeStart(i)) return false;
+  delay(MPU_WAKE_STEP_US / 1000);
+  if (!mpuWakeConfig(i)) return false;
+  delay(MPU_WAKE_STEP_US / 1000);
+  return true;
 }
 
-static bool mpuInit(uint8_t addr) {
-  if (!writeReg(addr, 0x6B, 0x80)) return false; delay(100); // reset
-  if (!writeReg(addr, 0x6B, 0x01)) return false; delay(10);  // wake + PLL
-  if (!writeReg(addr, 0x1A, 0x05)) return false;             // DLPF
-  if (!writeReg(addr, 0x1C, 0x10)) return false;             // accel ±8 g
-  if (!writeReg(addr, 0x1B, 0x08)) return false;             // gyro ±500 dps
-  delay(10);
+// Blok 14 B: acc, temperatura (opcjonalnie *temp_c), gyro; surowe rejestry
+// opcjonalnie do *raw_out (ślad surowy).
+static bool readIMU(size_t i, MpuSample& out, float* temp_c = nullptr, MpuRaw* raw_out = nullptr) {
+  uint8_t buf[MPU_BURST_LEN];
+  if (!readBurst(i, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf))) return false;
+
+  MpuRaw raw;
+  mpuDecodeBurst(buf, raw);
+  mpuScale(raw, mpu_scale, out);
+  if (temp_c) *temp_c = mpuTempC(raw.temp);
+  if (raw_out) *raw_out = raw;
   return true;
 }
 
-static bool readIMU(uint8_t addr, float& ax, float& ay, float& az, float& gx, float& gy, float& gz) {
-  uint8_t raw[14];
-  if (!readBurst(addr, 0x3B, raw, sizeof(raw))) return false;
+// Sama temperatura (tryb FIFO – ramki FIFO jej nie zawierają).
+static bool readTempC(size_t i, float& temp_c) {
+  uint8_t b[2];
+  if (!readBurst(i, MPU_REG_TEMP_OUT_H, b, sizeof(b))) return false;
+  temp_c = mpuTempC(mpuBe16(b));
+  return true;
+}
 
-  auto s16 = [&](int i) -> int16_t { return (int16_t)((raw[i] << 8) | raw[i + 1]); };
-  const int16_t AccX = s16(0), AccY = s16(2), AccZ = s16(4);
-  const int16_t GyX  = s16(8), GyY  = s16(10), GyZ = s16(12);
+// Włączenie FIFO (acc + gyro) od zera – stare ramki są odrzucane.
+static bool mpuFifoStart(size_t i) {
+  if (!writeReg(i, MPU_REG_FIFO_EN, 0x00)) return false;
+  if (!writeReg(i, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_RESET)) return false;
+  if (!writeReg(i, MPU_REG_FIFO_EN, MPU_FIFO_EN_ACCEL_GYRO)) return false;
+  if (!writeReg(i, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_EN)) return false;
+  if (i == DRDY_SENSOR) drdyFifoStart(drdy_fifo, drdy.count); // ramka 0 = następne przerwanie
+  fifo_fresh[i] = true;
+  fifo_lag[i] = 0;
+  return true;
+}
 
-  ax = AccX / ACC_LSB_PER_G;
-  ay = AccY / ACC_LSB_PER_G;
-  az = AccZ / ACC_LSB_PER_G;
+static const int FIFO_ERR_I2C      = -1;
+static const int FIFO_ERR_OVERFLOW = -2;
 
-  gx = GyX / GYRO_LSB_PER_DPS;
-  gy = GyY / GYRO_LSB_PER_DPS;
-  gz = GyZ / GYRO_LSB_PER_DPS;
+// Liczba pełnych ramek w FIFO albo FIFO_ERR_I2C / FIFO_ERR_OVERFLOW.
+static int mpuFifoAvailable(size_t i) {
+  uint8_t b[2];
+  if (!readBurst(i, MPU_REG_FIFO_COUNT_H, b, sizeof(b))) return FIFO_ERR_I2C;
+  const int frames = mpuFifoFrames((uint16_t)mpuBe16(b));
+  return frames < 0 ? FIFO_ERR_OVERFLOW : frames;
+}
 
+// Odczyt n ramek z FIFO paczkami po FIFO_BATCH_MAX (jedna transakcja na paczkę);
+// surowe ramki także do raw_out (n elementów, ślad surowy).
+static bool mpuFifoRead(size_t i, MpuSample* out, MpuRaw* raw_out, size_t n) {
+  uint8_t buf[FIFO_BATCH_MAX * MPU_FIFO_FRAME_LEN];
+  size_t done = 0;
+  while (done < n) {
+    const size_t batch = (n - done < FIFO_BATCH_MAX) ? (n - done) : FIFO_BATCH_MAX;
+    if (!readBurst(i, MPU_REG_FIFO_R_W, buf, batch * MPU_FIFO_FRAME_LEN)) return false;
+    for (size_t k = 0; k < batch; k++) {
+      MpuRaw raw;
+      mpuDecodeFifoFrame(buf + k * MPU_FIFO_FRAME_LEN, raw);
+      mpuScale(raw, mpu_scale, out[done + k]);
+      raw_out[done + k] = raw;
+    }
+    done += batch;
+  }
   return true;
 }
 
 // ============================================================================
-// 6) Kalibracje
+// 4) Kalibracje
 // ============================================================================
 
-static void calibrateGyro(ImuState& imu, uint8_t addr, int N = 1200) {
-  imu.bgx = imu.bgy = imu.bgz = 0;
-  for (int i = 0; i < N; i++) {
-    float ax, ay, az, gx, gy, gz;
-    if (readIMU(addr, ax, ay, az, gx, gy, gz)) {
-      imu.bgx += gx;
-      imu.bgy += gy;
-      imu.bgz += gz;
+// Klucz NVS rekordu r (para czujników 2r, 2r + 1): "calib", "calib1", ...
+static const char* nvsKey(char* buf, size_t cap, const char* base, size_t r) {
+  if (r == 0) return base;
+  snprintf(buf, cap, "%s%u", base, (unsigned)r);
+  return buf;
+}
+
+// Odczyt rekordów kalibracji z NVS; false = brak albo któryś rekord nieważny.
+static bool loadCalib(CalibRecord* rec) {
+  for (size_t r = 0; r < CAL_RECORDS; r++) {
+    char kb[16];
+    const char* key = nvsKey(kb, sizeof(kb), CALIB_NVS_KEY, r);
+    uint8_t buf[CAL_RECORD_LEN];
+    if (!prefs_ok || prefs.getBytesLength(key) != sizeof(buf)) return false;
+    if (prefs.getBytes(key, buf, sizeof(buf)) != sizeof(buf) || !calibRecordDecode(buf, sizeof(buf), rec[r])) {
+      return false;
     }
-    delay(1);
   }
-  imu.bgx /= N;
-  imu.bgy /= N;
-  imu.bgz /= N;
+  return true;
 }
 
-// Kalibracja "montażowa" – ustawia bieżącą pozycję obu czujników jako punkt odniesienia.
+// Zapis bieżącego biasu i offsetów wszystkich IMU (flash: kilka ms, tylko na żądanie).
+static bool saveCalib() {
+  bool ok = prefs_ok;
+  for (size_t r = 0; r < CAL_RECORDS && ok; r++) {
+    CalibRecord rec;
+    rec.flags = calib_flags;
+    for (size_t k = 0; k < 2 && 2 * r + k < SENSOR_COUNT; k++) imuCalibFromState(imus[2 * r + k], rec.imu[k]);
+    uint8_t buf[CAL_RECORD_LEN];
+    calibRecordEncode(rec, buf);
+    char kb[16];
+    ok = prefs.putBytes(nvsKey(kb, sizeof(kb), CALIB_NVS_KEY, r), buf, sizeof(buf)) == sizeof(buf);
+  }
+  return ok;
+}
+
+// Model bias(T) z NVS: sumy regresji wszystkich IMU + nachylenia (jeśli dopasowanie ważne).
+static bool loadTempModel() {
+  for (size_t r = 0; r < CAL_RECORDS; r++) {
+    char kb[16];
+    const char* key = nvsKey(kb, sizeof(kb), TEMP_NVS_KEY, r);
+    uint8_t buf[TEMP_MODEL_LEN];
+    if (!prefs_ok || prefs.getBytesLength(key) != sizeof(buf) ||
+        prefs.getBytes(key, buf, sizeof(buf)) != sizeof(buf) ||
+        !tempModelDecode(buf, sizeof(buf), &temp_fit[2 * r])) {
+      for (size_t i = 0; i < 2 * CAL_RECORDS; i++) temp_fit[i] = TempBiasFit();
+      return false;
+    }
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    float k[3];
+    if (tempFitSlopes(temp_fit[i], k)) imuSetTempSlopes(imus[i], k);
+  }
+  return true;
+}
+
+// Bias żyroskopu wszystkich IMU w jednym przebiegu: odczyty po kolei w takcie
+// czujnika; po CAL_CHECK_SAMPLES zapisany bias (rec) kończy przebieg, jeśli
+// pasuje albo urządzenie się rusza (calibBootDecide), inaczej do CAL_SAMPLES.
+// Przy wielu czujnikach na porcie odczyty mogą nie mieścić się w okresie –
+// przebieg trwa wtedy dłużej (liczba próbek jest stała).
+static void calibrateGyros(const CalibRecord* rec) {
+  const ImuCalib* stored[SENSOR_COUNT];
+  for (size_t i = 0; i < SENSOR_COUNT; i++) stored[i] = rec ? &rec[i / 2].imu[i % 2] : nullptr;
+  GyroCalib c[SENSOR_COUNT];
+  CalibBootAction a[SENSOR_COUNT];
+  for (size_t i = 0; i < SENSOR_COUNT; i++) a[i] = CAL_BOOT_CONTINUE;
+  const uint32_t period_us = (uint32_t)(1e6f / mpuSampleRateHz(mpu_cfg) + 0.5f);
+  const uint32_t t_start = micros();
+  uint32_t t_next = t_start;
+
+  for (uint16_t n = 1; n <= CAL_SAMPLES; n++) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      MpuSample s;
+      float t = 0;
+      if (a[i] == CAL_BOOT_CONTINUE && readIMU(i, s, &t)) {
+        gyroCalibPush(c[i], s);
+        if (!imus[i].has_temp) imuSetTemperature(imus[i], t);
+      }
+    }
+    if (n == CAL_CHECK_SAMPLES || n == CAL_SAMPLES) {
+      // zapisany bias (w TEMP_REF_C) przeliczony na temperaturę startu
+      const bool final = n == CAL_SAMPLES;
+      bool pending = false;
+      for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        if (a[i] != CAL_BOOT_CONTINUE) continue;
+        const ImuCalib at = stored[i] ? imuCalibAtTemperature(*stored[i], imus[i]) : ImuCalib();
+        a[i] = calibBootDecide(c[i], stored[i] ? &at : nullptr, final);
+        pending |= a[i] == CAL_BOOT_CONTINUE;
+      }
+      if (!pending) break;
+    }
+    t_next += period_us;
+    const int32_t wait = (int32_t)(t_next - micros());
+    if (wait > 0) delayMicroseconds((uint32_t)wait);
+  }
+  boot_cal_us = micros() - t_start;
+
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (a[i] == CAL_BOOT_STORED) imuCalibApplyBias(imus[i], *stored[i]);
+    else if (a[i] != CAL_BOOT_CONTINUE) imuCalibApplyBias(imus[i], c[i]);
+    boot_cal[i] = a[i];
+  }
+}
+
+// Start: rekordy z NVS (offsety od razu), bias z kalibracji; nowy bias wszystkich
+// IMU z nieruchomego urządzenia jest zapisywany.
+static void restoreCalibration() {
+  prefs_ok = prefs.begin(CALIB_NVS_NAMESPACE, false);
+  const bool temp_model = loadTempModel();
+  static CalibRecord rec[CAL_RECORDS];
+  bool have = loadCalib(rec);
+  uint8_t flags = CAL_HAS_BIAS | CAL_HAS_MOUNT;
+  for (size_t r = 0; r < CAL_RECORDS; r++) flags &= have ? rec[r].flags : 0;
+  if (flags & CAL_HAS_MOUNT) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) imuCalibApplyMount(imus[i], rec[i / 2].imu[i % 2]);
+    calib_flags |= CAL_HAS_MOUNT;
+  }
+  calibrateGyros((flags & CAL_HAS_BIAS) ? rec : nullptr);
+
+  bool trusted = true, fresh = false;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    trusted &= boot_cal[i] == CAL_BOOT_STORED || boot_cal[i] == CAL_BOOT_FRESH;
+    fresh |= boot_cal[i] == CAL_BOOT_FRESH;
+  }
+  if (trusted) calib_flags |= CAL_HAS_BIAS;
+  const bool saved = trusted && fresh && saveCalib();
+
+  Serial.printf("[CAL] nvs=%s gyro", !prefs_ok ? "FAIL" : (have ? "OK" : "empty"));
+  for (size_t i = 0; i < SENSOR_COUNT; i++) Serial.printf(" imu%u=%s", (unsigned)(i + 1), calibBootActionName(boot_cal[i]));
+  Serial.printf(" in %lums%s mount=%s\n", (unsigned long)(boot_cal_us / 1000), saved ? " (saved)" : "",
+                (calib_flags & CAL_HAS_MOUNT) ? "stored" : "none");
+  Serial.print("[TEMP]");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) Serial.printf(" imu%u=%.1fC", (unsigned)(i + 1), imus[i].temp_c);
+  Serial.printf(" model=%s gz_k=", temp_model ? "stored" : "none");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) Serial.printf(i ? "/%.3f" : "%.3f", imus[i].tk[2]);
+  Serial.println(" dps/C");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (boot_cal[i] == CAL_BOOT_MOVING) {
+      Serial.println("[CAL] motion during calibration - keep still and send 'calib gyro'");
+      break;
+    }
+  }
+}
+
+// Kalibracja "montażowa" – ustawia bieżącą pozycję wszystkich czujników jako punkt odniesienia.
 // PROCEDURA:
 //   1) załóż urządzenie na nogę,
 //   2) wyprostuj kolano (pozycja neutralna),
 //   3) wyślij komendę: calib
 static void processCalib(bool from_bt) {
-  imu1.off_roll  = imu1.k_roll.angle_deg;
-  imu1.off_pitch = imu1.k_pitch.angle_deg;
-  imu1.off_yaw   = imu1.yaw;
-
-  imu2.off_roll  = imu2.k_roll.angle_deg;
-  imu2.off_pitch = imu2.k_pitch.angle_deg;
-  imu2.off_yaw   = imu2.yaw;
+  // offsety zmienia zadanie akwizycji (właściciel imus) w najbliższym takcie,
+  // zapis do NVS – transport po calib_save_pending
+  calib_pending = true;
 
   if (from_bt) {
     Serial.println("[CALIB] OK via BT");
-    if (BT.hasClient()) BT.println("[CALIB] OK (both IMUs = 0/0/0)");
+    if (BT.hasClient()) BT.println("[CALIB] OK (all IMUs = 0/0/0)");
   } else {
     Serial.println("[CALIB] OK via USB");
-    if (BT.hasClient()) BT.println("[CALIB] OK (both IMUs = 0/0/0)");
+    if (BT.hasClient()) BT.println("[CALIB] OK (all IMUs = 0/0/0)");
   }
 }
 
+static inline bool btBatched(BtFormat f) { return f == BT_FMT_BATCH || f == BT_FMT_DELTA; }
+
+// Przełączenie formatu telemetrii BT: "format csv|bin|batch|delta".
+static void processFormat(BtFormat f, bool from_bt) {
+  bt_format = f;
+  bt_seq = 0;
+  bt_batch.seq = 0;
+  // niepełna paczka odrzucana; w trybie delta następna próbka jest klatką kluczową
+  batcherInit(bt_batch, bt_batch.k, bt_batch.max_latency_us, f == BT_FMT_DELTA);
+  Serial.printf("[FORMAT] BT=%s via %s\n", BT_FORMAT_NAMES[f], from_bt ? "BT" : "USB");
+  if (btBatched(f)) {
+    Serial.printf("[FORMAT] %s k=%u max_latency=%lums\n", BT_FORMAT_NAMES[f], bt_batch.k,
+                  (unsigned long)(bt_batch.max_latency_us / 1000));
+  }
+  if (BT.hasClient()) BT.printf("[FORMAT] %s\n", BT_FORMAT_NAMES[f]);
+}
+
+// Zmiana silnika fuzji: "fusion kalman" / "fusion madgwick" / "fusion mahony".
+static void processFusion(FusionEngine e, bool from_bt) {
+  // stan imus należy do zadania akwizycji – przełączenie w najbliższym takcie
+  engine_pending = (int)e;
+  Serial.printf("[FUSION] %s via %s\n", fusionEngineName(e), from_bt ? "BT" : "USB");
+  if (BT.hasClient()) BT.printf("[FUSION] %s\n", fusionEngineName(e));
+}
+
+// Próbek czujnika na pobudkę akwizycji: FIFO – paczka ~ACQ_PERIOD_US, rejestry – każda próbka.
+static uint32_t drdyWakeDiv(const MpuConfig& cfg) {
+  if (!ACQ_USE_FIFO) return 1;
+  const uint32_t n = (uint32_t)(mpuSampleRateHz(cfg) * ACQ_PERIOD_US / 1e6f + 0.5f);
+  return n ? n : 1;
+}
+
+// Podział i timeout pobudek dla nowej częstotliwości próbkowania (przy 4 Hz
+// pobudka z timeoutu co 5 ms byłaby ~50 razy na próbkę).
+static void setDrdyRate(const MpuConfig& cfg) {
+  const uint32_t div = drdyWakeDiv(cfg);
+  const uint32_t ms = (uint32_t)(ACQ_DRDY_TIMEOUT_PERIODS * div * 1000.0f / mpuSampleRateHz(cfg) + 0.999f);
+  drdy_wake_div = div;
+  drdy_timeout_ms = ms > ACQ_DRDY_TIMEOUT_MIN_MS ? ms : ACQ_DRDY_TIMEOUT_MIN_MS;
+}
+
+// Częstotliwość próbek KneeSample z akwizycji (FIFO / data-ready: takt czujnika,
+// inaczej takt zadania).
+static float acqSampleRateHz() {
+  return ACQ_USE_FIFO || ACQ_USE_DRDY ? mpuSampleRateHz(mpu_cfg_req) : 1e6f / ACQ_PERIOD_US;
+}
+
+// "calib gyro": nowy bias z CAL_SAMPLES próbek zbieranych przez akwizycję w trakcie
+// pracy (fuzja działa dalej ze starym); "calib clear": usunięcie rekordu z NVS.
+static void processGyroCalib(Stream& io) {
+  gyro_cal_pending = true;
+  io.printf("[CALIB] gyro: keep still ~%lums\n", (unsigned long)(CAL_SAMPLES * 1000.0f / acqSampleRateHz()));
+}
+
+static void processCalibClear(Stream& io) {
+  bool ok = prefs_ok;
+  for (size_t r = 0; r < CAL_RECORDS; r++) {
+    char kb[16];
+    ok = prefs_ok && prefs.remove(nvsKey(kb, sizeof(kb), CALIB_NVS_KEY, r)) && ok;
+  }
+  calib_flags = 0;
+  io.printf("[CALIB] nvs cleared: %s\n", ok ? "OK" : "FAIL");
+}
+
+// Współczynnik decymacji dla bieżącej częstotliwości próbkowania i "send".
+static void configureDecimator() {
+  const float ratio = acqSampleRateHz() * send_period_us / 1e6f;
+  decimatorInit(decim, (TELEMETRY_DECIMATE && ratio > 1.0f) ? (uint16_t)(ratio + 0.5f) : 1);
+}
+
+// Raport bieżącej (efektywnej) konfiguracji: USB + BT.
+static void printConfig() {
+  const float send_hz = TELEMETRY_DECIMATE ? acqSampleRateHz() / decim.ratio : 1e6f / send_period_us;
+  char line[160];
+  snprintf(line, sizeof(line),
+           "[CONFIG] rate=%.1fHz dlpf=%u div=%u accel=+-%dg gyro=+-%ddps send=%.1fHz decim=%u%s",
+           mpuSampleRateHz(mpu_cfg_req), mpu_cfg_req.dlpf_cfg, mpu_cfg_req.smplrt_div,
+           mpuAccelRangeG(mpu_cfg_req.accel_range), mpuGyroRangeDps(mpu_cfg_req.gyro_range),
+           send_hz, (unsigned)decim.ratio,
+           cfg_pending ? " (pending)" : (cfg_ok ? "" : " (I2C FAIL)"));
+  Serial.println(line);
+  if (BT.hasClient()) BT.println(line);
+}
+
+// Zlecenie zapisu konfiguracji czujników; wykonuje akwizycja, raport po zastosowaniu.
+static void queueConfig(const MpuConfig& cfg) {
+  mpu_cfg_req = cfg;
+  cfg_pending = true;
+}
+
 // ============================================================================
-// 7) Komendy (USB/BT) i pomocnicze funkcje runtime
+// 5) Komendy (USB/BT) i pomocnicze funkcje runtime
 // ============================================================================
 
-static bool readLine(Stream& io, String& out, String& buf, size_t maxLen = 64) {
-  while (io.available()) {
-    const char c = (char)io.read();
-    if (c == '\n' || c == '\r') {
-      if (buf.length() > 0) {
-        out = buf;
-        buf = "";
-        out.trim();
-        out.toLowerCase();
-        return true;
-      }
-      continue;
+// Źródło komendy (kontekst handlerów): odpowiedzi trafiają do tego samego transportu.
+struct CmdSource {
+  Stream* io;
+  bool    from_bt;
+};
+
+static inline CmdSource& cmdSource(void* ctx) { return *(CmdSource*)ctx; }
+
+// "calib" – offsety montażowe, "calib gyro" – bias żyroskopu, "calib clear" – zapis NVS.
+static bool cmdCalib(int argc, const char* const* argv, void* ctx) {
+  if (argc == 1) processCalib(cmdSource(ctx).from_bt);
+  else if (strcmp(argv[1], "gyro") == 0) processGyroCalib(*cmdSource(ctx).io);
+  else if (strcmp(argv[1], "clear") == 0) processCalibClear(*cmdSource(ctx).io);
+  else return false;
+  return true;
+}
+
+static bool cmdFormat(int, const char* const* argv, void* ctx) {
+  for (int f = 0; f < BT_FORMAT_COUNT; f++) {
+    if (strcmp(argv[1], BT_FORMAT_NAMES[f]) == 0) {
+      processFormat((BtFormat)f, cmdSource(ctx).from_bt);
+      return true;
     }
-    if (buf.length() < (int)maxLen) buf += c;
   }
   return false;
 }
 
-static void handleCommands() {
-  String cmd;
+// "batch <K> [ms]" – próbek na paczkę i sufit opóźnienia; przełącza BT na "format batch"
+// (format delta pozostaje).
+static bool cmdBatch(int argc, const char* const* argv, void* ctx) {
+  long k = 0, ms = (long)(bt_batch.max_latency_us / 1000);
+  if (!cmdParseInt(argv[1], k) || k < 1 || k > BATCH_K_MAX) return false;
+  if (argc == 3 && (!cmdParseInt(argv[2], ms) || ms < 1 || ms > 1000)) return false;
+  const BtFormat f = bt_format == BT_FMT_DELTA ? BT_FMT_DELTA : BT_FMT_BATCH;
+  batcherInit(bt_batch, (uint8_t)k, (uint32_t)ms * 1000, f == BT_FMT_DELTA);
+  processFormat(f, cmdSource(ctx).from_bt);
+  return true;
+}
+
+static bool cmdFusion(int, const char* const* argv, void* ctx) {
+  const FusionEngine engines[3] = {FUSION_KALMAN, FUSION_MADGWICK, FUSION_MAHONY};
+  for (int i = 0; i < 3; i++) {
+    if (strcmp(argv[1], fusionEngineName(engines[i])) == 0) {
+      processFusion(engines[i], cmdSource(ctx).from_bt);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool cmdRate(int, const char* const* argv, void*) {
+  long v = 0;
+  if (!cmdParseInt(argv[1], v) || v < 4 || v > (long)MPU_RATE_MAX_HZ) return false;
+  MpuConfig cfg = mpu_cfg_req;
+  cfg.smplrt_div = mpuDividerForRate(cfg.dlpf_cfg, (float)v);
+  queueConfig(cfg);
+  return true;
+}
+
+static bool cmdDlpf(int, const char* const* argv, void*) {
+  long v = 0;
+  if (!cmdParseInt(argv[1], v) || v < 0 || v > MPU_DLPF_MAX) return false;
+  // zmiana DLPF zmienia bazę żyroskopu (1/8 kHz) – dzielnik dobierany tak, by zachować Fs
+  MpuConfig cfg = mpu_cfg_req;
+  const float rate_hz = mpuSampleRateHz(cfg);
+  cfg.dlpf_cfg = (uint8_t)v;
+  cfg.smplrt_div = mpuDividerForRate(cfg.dlpf_cfg, rate_hz);
+  queueConfig(cfg);
+  return true;
+}
+
+static bool cmdAccel(int, const char* const* argv, void*) {
+  long v = 0;
+  MpuConfig cfg = mpu_cfg_req;
+  if (!cmdParseInt(argv[1], v) || !mpuAccelRangeFromG((int)v, cfg.accel_range)) return false;
+  queueConfig(cfg);
+  return true;
+}
+
+static bool cmdGyro(int, const char* const* argv, void*) {
+  long v = 0;
+  MpuConfig cfg = mpu_cfg_req;
+  if (!cmdParseInt(argv[1], v) || !mpuGyroRangeFromDps((int)v, cfg.gyro_range)) return false;
+  queueConfig(cfg);
+  return true;
+}
+
+static bool cmdSend(int, const char* const* argv, void*) {
+  long v = 0;
+  if (!cmdParseInt(argv[1], v) || v < 1 || v > (long)SEND_FREQ_MAX_HZ) return false;
+  send_period_us = 1000000UL / (uint32_t)v;
+  configureDecimator();
+  printConfig();
+  return true;
+}
+
+static bool cmdConfig(int, const char* const*, void*) {
+  printConfig();
+  return true;
+}
 
-  // USB
-  if (readLine(Serial, cmd, usbBuf)) {
-    if (cmd == "calib") processCalib(false);
-    else Serial.printf("[WARN] unknown cmd: %s\n", cmd.c_str());
+// Zrzut liczników wydajności do transportu, z którego przyszła komenda.
+static void printStats(Stream& io) {
+  io.printf("[STATS] uptime=%lus samples=%lu ring_drop=%lu dt_clamp=%lu i2c_err=",
+            (unsigned long)(millis() / 1000), (unsigned long)samples_pushed,
+            (unsigned long)(sample_ring.dropped() - ring_dropped_base), (unsigned long)dt_clamp_count);
+  for (size_t i = 0; i < SENSOR_COUNT; i++) io.printf(i ? "/%lu" : "%lu", (unsigned long)err_count[i]);
+  io.println();
+  io.printf("[STATS] usb sent=%lu drop=%lu | bt sent=%lu drop=%lu\n",
+            (unsigned long)usb_frames_sent, (unsigned long)usb_frames_dropped, (unsigned long)bt_frames_sent,
+            (unsigned long)bt_frames_dropped);
+  io.printf("[STATS] bus_recover=%lu", (unsigned long)bus_recoveries);
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const BusLink& l = links[i];
+    io.printf(" | imu%u outages=%lu attempts=%lu last=%lums max=%lums", (unsigned)(i + 1),
+              (unsigned long)l.outages, (unsigned long)l.recover_attempts, (unsigned long)(l.last_recover_us / 1000),
+              (unsigned long)(l.max_recover_us / 1000));
+  }
+  io.println();
+  io.printf("[STATS] sensors=%u per_port=%u/%u mux_select=%lu/%lu\n", (unsigned)SENSOR_COUNT,
+            (unsigned)port_len[0], (unsigned)port_len[1], (unsigned long)mux[0].selects,
+            (unsigned long)mux[1].selects);
+  if (ACQ_USE_DRDY) {
+    io.printf("[STATS] drdy irq=%lu timeouts=%lu/%lums resync=%lu period=%.1fus\n", (unsigned long)drdy.count,
+              (unsigned long)drdy_timeouts, (unsigned long)drdy_timeout_ms, (unsigned long)drdy_fifo.resyncs,
+              drdy_jitter.period_us);
+  }
+  io.printf("[STATS] boot first_valid=%lums gyro_cal=%lums",
+            (unsigned long)(first_valid_set ? first_valid_us / 1000 : 0), (unsigned long)(boot_cal_us / 1000));
+  for (size_t i = 0; i < SENSOR_COUNT; i++) io.printf(" imu%u=%s", (unsigned)(i + 1), calibBootActionName(boot_cal[i]));
+  io.println();
+  io.print("[STATS] bias_std=");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) io.printf(i ? "/%.3f" : "%.3f", biasTrackerStdDps(imus[i].bias));
+  io.print("dps still=");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) io.printf(i ? "/%.0f%%" : "%.0f%%", biasTrackerStillPct(imus[i].bias));
+  io.println();
+
+  struct { const char* name; const LatencyHist* h; } const hists[] = {
+    {"loop_us", &perf_loop},     {"bus_us", &perf_bus},          {"fusion_us", &perf_fusion},
+    {"usb_write_us", &perf_usb_write}, {"bt_write_us", &perf_bt_write}, {"recover_us", &perf_recover},
+    {"wake_us", &perf_wake},     {"ts_jitter_us", &perf_ts_jitter},
+  };
+  char line[256];
+  for (size_t i = 0; i < sizeof(hists) / sizeof(hists[0]); i++) {
+    const LatencyHist snap = *hists[i].h; // kopia – drugie zadanie może właśnie zapisywać
+    if (formatLatencyHist(line, sizeof(line), hists[i].name, snap) > 0) io.printf("[STATS] %s\n", line);
   }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "i2c%u_us", (unsigned)(i + 1));
+    const LatencyHist snap = perf_i2c[i];
+    if (formatLatencyHist(line, sizeof(line), name, snap) > 0) io.printf("[STATS] %s\n", line);
+  }
+}
 
-  // Bluetooth
-  if (BT.hasClient() && readLine(BT, cmd, btBuf)) {
-    if (cmd == "calib") processCalib(true);
-    else if (BT.hasClient()) {
-      BT.print("[WARN] unknown cmd: ");
-      BT.println(cmd);
+// "stats" – zrzut, "stats reset" – zerowanie (liczniki akwizycji zeruje akwizycja).
+static bool cmdStats(int argc, const char* const* argv, void* ctx) {
+  if (argc == 1) {
+    printStats(*cmdSource(ctx).io);
+    return true;
+  }
+  if (strcmp(argv[1], "reset") != 0) return false;
+  latencyReset(perf_usb_write);
+  latencyReset(perf_bt_write);
+  usb_frames_sent = usb_frames_dropped = 0;
+  bt_frames_sent = bt_frames_dropped = 0;
+  ring_dropped_base = sample_ring.dropped();
+  stats_reset_pending = true;
+  cmdSource(ctx).io->println("[STATS] reset");
+  return true;
+}
+
+// Stan dziennika: zakres bloków, sesja, potwierdzenia, błędy zapisu.
+static void printLogStatus(Stream& io) {
+  io.printf("[LOG] %s %s session=%u blocks=%lu..%lu (%lu/%lu) samples=%lu ring_drop=%lu err=%lu",
+            slog_file ? (log_active ? "on" : "off") : "unavailable",
+            slog.kind == LOG_KIND_KNEE_DELTA ? "delta" : "raw", slog.session,
+            (unsigned long)slog.oldest_seq, (unsigned long)slog.next_seq, (unsigned long)logBlockCount(slog),
+            (unsigned long)slog.st.slots, (unsigned long)slog.samples, (unsigned long)log_ring.dropped(),
+            (unsigned long)slog.write_errors);
+  if (log_has_ack) io.printf(" acked=%lu", (unsigned long)log_acked);
+  io.println();
+}
+
+// "log" – stan, "log on|off", "log get [seq]" – bloki od seq (domyślnie od ostatniego
+// potwierdzonego + 1), "log ack <seq>" – odbiorca zapisał bloki do seq włącznie.
+static bool cmdLog(int argc, const char* const* argv, void* ctx) {
+  Stream& io = *cmdSource(ctx).io;
+  if (argc == 1) {
+    printLogStatus(io);
+    return true;
+  }
+  long v = 0;
+  const bool has_seq = argc == 3 && cmdParseInt(argv[2], v) && v >= 0;
+  if (strcmp(argv[1], "on") == 0 && argc == 2) {
+    if (!log_active) log_session_pending = true;
+    log_active = slog_file != nullptr;
+  } else if (strcmp(argv[1], "off") == 0 && argc == 2) {
+    log_active = false;
+    log_flush_pending = true;
+  } else if (strcmp(argv[1], "get") == 0 && (argc == 2 || has_seq)) {
+    if (log_dl_io || log_dl_req) {
+      io.println("[LOG] download already running");
+      return true;
     }
+    log_dl_from = has_seq ? (uint32_t)v : (log_has_ack ? log_acked + 1 : 0);
+    log_dl_req = &io;
+  } else if (strcmp(argv[1], "ack") == 0 && has_seq) {
+    log_acked = (uint32_t)v;
+    log_has_ack = true;
+    return true; // bez odpowiedzi – potwierdzenia przychodzą w trakcie pobierania
+  } else {
+    return false;
   }
+  if (log_task) xTaskNotifyGive(log_task);
+  if (!log_dl_req) printLogStatus(io);
+  return true;
 }
 
+// Bias żyroskopu śledzony w bezruchu (BiasTracker): estymata, niepewność, udział
+// nieruchomych okien. Odczyt stanu akwizycji bez blokady – tylko do podglądu.
+static void printBias(Stream& io) {
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const ImuState& imu = imus[i];
+    const BiasTracker t = imu.bias;
+    io.printf("[BIAS] imu%u %s bias=%.3f,%.3f,%.3f dps std=%.3f still=%.0f%% updates=%lu rejected=%lu last=%.0fs\n",
+              (unsigned)(i + 1), t.enabled ? "on" : "off", imu.bgx, imu.bgy, imu.bgz, biasTrackerStdDps(t),
+              biasTrackerStillPct(t), (unsigned long)t.updates, (unsigned long)t.rejected, t.since_update_s);
+  }
+}
+
+// Temperatura, nachylenia modelu bias(T) i dane dopasowania wszystkich IMU.
+static void printTemp(Stream& io) {
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const ImuState& imu = imus[i];
+    const TempBiasFit f = temp_fit[i];
+    io.printf("[TEMP] imu%u %.2fC k=%.4f,%.4f,%.4f dps/C tc=%.3f,%.3f,%.3f points=%.0f (+%lu) spread=%.2fC\n",
+              (unsigned)(i + 1), imu.temp_c, imu.tk[0], imu.tk[1], imu.tk[2], imu.tc[0], imu.tc[1], imu.tc[2],
+              f.n, (unsigned long)f.points, tempFitStdC(f));
+  }
+}
+
+// "temp" – stan, "temp save" – zapis modelu teraz, "temp clear" – model od zera (też w NVS).
+static bool cmdTemp(int argc, const char* const* argv, void* ctx) {
+  Stream& io = *cmdSource(ctx).io;
+  if (argc == 1) {
+    printTemp(io);
+  } else if (strcmp(argv[1], "save") == 0) {
+    temp_save_req = true;
+  } else if (strcmp(argv[1], "clear") == 0) {
+    temp_clear_req = true;
+    bool ok = prefs_ok;
+    for (size_t r = 0; r < CAL_RECORDS; r++) {
+      char kb[16];
+      ok = prefs_ok && prefs.remove(nvsKey(kb, sizeof(kb), TEMP_NVS_KEY, r)) && ok;
+    }
+    io.printf("[TEMP] cleared: %s\n", ok ? "OK" : "FAIL");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// "bias" – stan śledzenia biasu, "bias on|off" – włączenie/wyłączenie (wszystkie IMU).
+static bool cmdBias(int argc, const char* const* argv, void* ctx) {
+  if (argc == 2) {
+    if (strcmp(argv[1], "on") == 0)       bias_track_pending = 1;
+    else if (strcmp(argv[1], "off") == 0) bias_track_pending = 0;
+    else return false;
+    cmdSource(ctx).io->printf("[BIAS] tracking %s\n", argv[1]);
+    return true;
+  }
+  printBias(*cmdSource(ctx).io);
+  return true;
+}
+
+// "trace" – stan, "trace on|off" – ślad surowy na USB (telemetria USB wstrzymana).
+static bool cmdTrace(int argc, const char* const* argv, void* ctx) {
+  Stream& io = *cmdSource(ctx).io;
+  if (argc == 2) {
+    if (strcmp(argv[1], "on") == 0)       trace_pending = 1;
+    else if (strcmp(argv[1], "off") == 0) trace_pending = 0;
+    else return false;
+    if (trace_pending && USB_BAUD < TRACE_MIN_BAUD) {
+      io.printf("[WARN] trace needs >= %lu baud (now %lu), records will be lost\n", (unsigned long)TRACE_MIN_BAUD,
+                (unsigned long)USB_BAUD);
+    }
+  }
+  io.printf("[TRACE] %s records=%lu lost=%lu ring=%u/%u B\n",
+            (trace_pending >= 0 ? trace_pending != 0 : trace_active) ? "on" : "off",
+            (unsigned long)trace_records_sent, (unsigned long)trace_ring.dropped(), (unsigned)trace_ring.size(),
+            (unsigned)TRACE_RING_BYTES);
+  return true;
+}
+
+// Czujniki (port, kanał multipleksera, adres, stan) i kąty wszystkich stawów.
+static bool cmdJoints(int, const char* const*, void* ctx) {
+  Stream& io = *cmdSource(ctx).io;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorDesc& d = SENSORS[i];
+    io.printf("[SENSOR] imu%u %s port=%u mux=%d addr=0x%02X %s err=%lu\n", (unsigned)(i + 1), d.name,
+              d.port, d.mux_ch, d.addr, imu_ok[i] ? "OK" : "FAIL", (unsigned long)err_count[i]);
+  }
+  for (size_t j = 0; j < JOINT_COUNT; j++) {
+    io.printf("[JOINT] %s=%.2f (%s->%s)%s\n", JOINTS[j].name, joint_angle[j], SENSORS[JOINTS[j].proximal].name,
+              SENSORS[JOINTS[j].distal].name, j == 0 ? " main" : "");
+  }
+  return true;
+}
+
+static void printHelp(Stream& io);
+
+static bool cmdHelp(int, const char* const*, void* ctx) {
+  printHelp(*cmdSource(ctx).io);
+  return true;
+}
+
+// Tablica komend: nazwa, min/max liczba argumentów, handler, składnia.
+static const CmdEntry COMMANDS[] = {
+  {"calib",  0, 1, cmdCalib,  "[gyro|clear]"},
+  {"format", 1, 1, cmdFormat, "csv|bin|batch|delta"},
+  {"batch",  1, 2, cmdBatch,  "<1..32> [1..1000 ms]"},
+  {"fusion", 1, 1, cmdFusion, "kalman|madgwick|mahony"},
+  {"bias",   0, 1, cmdBias,   "[on|off]"},
+  {"temp",   0, 1, cmdTemp,   "[save|clear]"},
+  {"trace",  0, 1, cmdTrace,  "[on|off]"},
+  {"joints", 0, 0, cmdJoints, ""},
+  {"rate",   1, 1, cmdRate,   "<4..1000 Hz>"},
+  {"dlpf",   1, 1, cmdDlpf,   "<0..6>"},
+  {"accel",  1, 1, cmdAccel,  "2|4|8|16"},
+  {"gyro",   1, 1, cmdGyro,   "250|500|1000|2000"},
+  {"send",   1, 1, cmdSend,   "<1..1000 Hz>"},
+  {"config", 0, 0, cmdConfig, ""},
+  {"stats",  0, 1, cmdStats,  "[reset]"},
+  {"log",    0, 2, cmdLog,    "[on|off|get [seq]|ack <seq>]"},
+  {"help",   0, 0, cmdHelp,   ""},
+};
+static const size_t COMMANDS_LEN = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void printHelp(Stream& io) {
+  for (size_t i = 0; i < COMMANDS_LEN; i++) io.printf("[HELP] %s %s\n", COMMANDS[i].name, COMMANDS[i].usage);
+}
+
+// Odczyt dostępnych znaków z transportu i wykonanie kompletnych linii.
+static void pollCommands(CmdLineBuffer& lb, CmdSource& src) {
+  while (src.io->available()) {
+    if (!cmdLineFeed(lb, (char)src.io->read())) continue;
+
+    const CmdEntry* e = nullptr;
+    const char* name = "";
+    switch (cmdDispatch(COMMANDS, COMMANDS_LEN, lb, &src, &e, &name)) {
+      case CMD_UNKNOWN:  src.io->printf("[WARN] unknown cmd: %s\n", name); break;
+      case CMD_BAD_ARGS: src.io->printf("[WARN] usage: %s %s\n", e->name, e->usage); break;
+      case CMD_TOO_LONG: src.io->printf("[WARN] cmd too long (max %u)\n", (unsigned)CMD_LINE_MAX); break;
+      default: break;
+    }
+  }
+}
+
+static void handleCommands() {
+  static CmdSource usb = {&Serial, false};
+  static CmdSource bt  = {&BT, true};
+
+  pollCommands(usb_cmd, usb);
+  if (BT.hasClient()) pollCommands(bt_cmd, bt);
+}
+
+// Monotoniczny czas od startu (esp_timer, 64 bit); micros() to jego młodsze 32 bity.
+static inline uint64_t micros64() { return (uint64_t)esp_timer_get_time(); }
+
 static float computeDtSeconds(uint32_t now_us) {
   float dt = (now_us - last_us) / 1e6f;
-  if (dt <= 0) dt = 0.004f;
-  if (dt > 0.02f) dt = 0.02f;
+  if (dt <= 0)     { dt = 0.004f; dt_clamp_count++; }
+  if (dt > 0.02f)  { dt = 0.02f;  dt_clamp_count++; }
   last_us = now_us;
   return dt;
 }
 
-static bool updateImu(ImuState& imu, uint8_t addr, float dt, uint32_t& errCount) {
-  float rAcc = 0, pAcc = 0;
+// Wstawienie próbki do bufora; przy pełnym buforze próbka jest odrzucana
+// i liczona w sample_ring.dropped().
+static void publishSample(const KneeSample& k) {
+  if (sample_ring.push(k)) samples_pushed++;
+  if (!first_valid_set && k.q1 == QUALITY_MEASURED && k.q2 == QUALITY_MEASURED) {
+    first_valid_us = k.t_us;
+    first_valid_set = true;
+  }
+}
 
-  if (!readIMU(addr, imu.ax, imu.ay, imu.az, imu.gx, imu.gy, imu.gz)) {
-    errCount++;
-    return false;
+// "calib gyro": surowe próbki (przed korektą bias) trafiają do akumulatorów.
+static inline void gyroCalFeed(size_t i, bool ok, const MpuSample& s) {
+  if (gyro_cal_active && ok) gyroCalibPush(gyro_cal[i], s);
+}
+
+// Start / koniec "calib gyro": po CAL_SAMPLES ze wszystkich IMU (albo GYRO_CAL_TIMEOUT_US)
+// bias dostaje tylko IMU, które leżało nieruchomo; wynik raportuje transport.
+static void gyroCalStep(uint64_t now64) {
+  if (gyro_cal_pending) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) gyroCalibReset(gyro_cal[i]);
+    gyro_cal_active = true;
+    gyro_cal_t0 = now64;
+    gyro_cal_pending = false;
+    return;
+  }
+  if (!gyro_cal_active) return;
+  bool full = true;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) full &= gyro_cal[i].n >= CAL_SAMPLES;
+  if (!full && now64 - gyro_cal_t0 < GYRO_CAL_TIMEOUT_US) return;
+
+  uint32_t done = GYRO_CAL_REPORT;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (gyro_cal[i].n >= CAL_SAMPLES && gyroCalibStill(gyro_cal[i])) {
+      imuCalibApplyBias(imus[i], gyro_cal[i]);
+      done |= 1u << i;
+    }
   }
+  gyro_cal_active = false;
+  trace_state_dirty = true;
+  gyro_cal_done = done;
+}
 
-  // korekcja bias
-  imu.gx -= imu.bgx;
-  imu.gy -= imu.bgy;
-  imu.gz -= imu.bgz;
+// Ślad surowy: rekord próbki przed jej fuzją, poprzedzony CONFIG/STATE, gdy
+// konfiguracja albo stan IMU zmieniły się poza fuzją. Rekord, który się nie
+// zmieścił, jest tracony w całości (numer seq i tak rośnie), a następna próbka
+// idzie dopiero po pełnym stanie – odtwarzanie wznawia się od niego.
+// Ślad obejmuje parę czujników stawu głównego (format dwóch IMU).
+static void traceSample(uint64_t t_us, float dt, bool ok1, const MpuRaw& r1, bool ok2, const MpuRaw& r2) {
+  if (!trace_active) return;
+  static uint8_t rec[TRACE_RECORD_MAX];
+  if (trace_config_dirty && trace_ring.pushN(rec, traceEncodeConfig(rec, mpu_cfg, ACQ_USE_FIFO))) {
+    trace_config_dirty = false;
+  }
+  if (trace_state_dirty &&
+      trace_ring.pushN(rec, traceEncodeState(rec, imus[MAIN_JOINT.proximal], imus[MAIN_JOINT.distal]))) {
+    trace_state_dirty = false;
+  }
+  TraceSample ts;
+  ts.seq  = trace_seq++;
+  ts.t_us = t_us;
+  ts.dt   = dt;
+  ts.ok1  = ok1;
+  ts.ok2  = ok2;
+  if (ok1) ts.raw1 = r1;
+  if (ok2) ts.raw2 = r2;
+  if (trace_config_dirty || trace_state_dirty || !trace_ring.pushN(rec, traceEncodeSample(rec, ts))) {
+    trace_state_dirty = true;
+  }
+}
 
-  // pomiar roll/pitch z akcelerometru + aktualizacja Kalmana
-  accelAnglesDeg(imu.ax, imu.ay, imu.az, rAcc, pAcc);
-  kalmanUpdate(imu.k_roll,  imu.gx, rAcc, dt);
-  kalmanUpdate(imu.k_pitch, imu.gy, pAcc, dt);
+// Wyniki odczytu czujników w bieżącym takcie: zapis – zadanie portu czujnika,
+// odczyt – akwizycja po busRunAll.
+struct SensorRead {
+  bool      ok;
+  int       avail; // BUS_OP_FIFO_COUNT: ramki albo FIFO_ERR_*
+  size_t    lead;  // BUS_OP_FIFO_READ: ramki pozostałych czujników przed pierwszą własną (fifo_lag)
+  MpuSample s[FIFO_DRAIN_MAX];
+  MpuRaw    r[FIFO_DRAIN_MAX];
+};
+static SensorRead reads[SENSOR_COUNT];
+
+enum BusOp : uint8_t { BUS_OP_POLL, BUS_OP_FIFO_COUNT, BUS_OP_FIFO_READ };
+static volatile uint8_t bus_op     = BUS_OP_POLL;
+static size_t           bus_fifo_n = 0; // BUS_OP_FIFO_READ: ramek taktu (na czujnik: bez lead)
+
+// Operacja na czujnikach jednego portu (kolejność port_order: grupy kanałów multipleksera).
+static void busRun(uint8_t port, BusOp op) {
+  for (size_t k = 0; k < port_len[port]; k++) {
+    const size_t i = port_order[port][k];
+    SensorRead& rd = reads[i];
+    if (wake_stage[i] != WAKE_IDLE) { // w trakcie resetu – bez transakcji
+      rd.ok = false;
+      continue;
+    }
+    switch (op) {
+      case BUS_OP_POLL:
+        rd.ok = readIMU(i, rd.s[0], &poll_temp[i], &rd.r[0]);
+        break;
+      case BUS_OP_FIFO_COUNT:
+        rd.avail = mpuFifoAvailable(i);
+        rd.ok = rd.avail >= 0;
+        break;
+      case BUS_OP_FIFO_READ:
+        if (rd.ok) rd.ok = mpuFifoRead(i, rd.s + rd.lead, rd.r + rd.lead, bus_fifo_n - rd.lead);
+        break;
+    }
+  }
+}
 
-  // yaw integrowany z żyroskopu (będzie dryfować)
-  imu.yaw = wrap180(imu.yaw + imu.gz * dt);
-  return true;
+// Operacja na wszystkich portach: port 1 w zadaniu bus1 równolegle z portem 0
+// w akwizycji – czas taktu rośnie z liczbą czujników na porcie, nie wszystkich.
+static uint32_t busRunAll(BusOp op) {
+  const uint32_t t0 = micros();
+  if (bus1_task) {
+    bus_op = op;
+    xTaskNotifyGive(bus1_task);
+    busRun(0, op);
+    xSemaphoreTake(bus1_done, portMAX_DELAY);
+  } else {
+    busRun(0, op);
+    busRun(1, op);
+  }
+  return micros() - t0;
+}
+
+static void bus1Task(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    busRun(1, (BusOp)bus_op);
+    xSemaphoreGive(bus1_done);
+  }
+}
+
+// Fuzja ramki f wszystkich czujników (ok = false: propagacja żyroskopem), kąty
+// stawów; próbka wyjściowa z pary stawu głównego – te same kroki co fuseKneeStep,
+// więc odtwarzanie śladu (kgreplay) pozostaje identyczne.
+static void fuseFrame(uint64_t t_us, float dt, const bool* ok, size_t f, KneeSample& k) {
+  bool v[SENSOR_COUNT];
+  for (size_t i = 0; i < SENSOR_COUNT; i++) v[i] = fuseImuStep(imus[i], ok[i], reads[i].s[f], dt);
+  const size_t p = MAIN_JOINT.proximal, d = MAIN_JOINT.distal;
+  computeKneeSample(t_us, imus[p], v[p], imus[d], v[d], k);
+  joint_angle[0] = k.knee_angle;
+  for (size_t j = 1; j < JOINT_COUNT; j++) {
+    const size_t a = JOINTS[j].proximal, b = JOINTS[j].distal;
+    joint_angle[j] = jointAngleDeg(imus[a], v[a], imus[b], v[b]);
+  }
+}
+
+// Tryb rejestrowy: jedna próbka na IMU w każdej iteracji, dt z zegara
+// (now64: czas przerwania data-ready najnowszej próbki albo chwila taktu).
+static void acquirePolling(uint64_t now64, bool* ok) {
+  const float dt = computeDtSeconds((uint32_t)now64);
+
+  latencyRecord(perf_bus, busRunAll(BUS_OP_POLL));
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    ok[i] = reads[i].ok;
+    if (!ok[i] && wake_stage[i] == WAKE_IDLE) err_count[i]++;
+  }
+  const size_t p = MAIN_JOINT.proximal, d = MAIN_JOINT.distal;
+  traceSample(now64, dt, ok[p], reads[p].r[0], ok[d], reads[d].r[0]);
+
+  const uint32_t t0 = micros();
+  for (size_t i = 0; i < SENSOR_COUNT; i++) gyroCalFeed(i, ok[i], reads[i].s[0]);
+  KneeSample k;
+  fuseFrame(now64, dt, ok, 0, k);
+  latencyRecord(perf_fusion, micros() - t0);
+  publishSample(k);
+}
+
+// Tryb FIFO: wszystkie zebrane ramki (ta sama liczba z każdego IMU) przechodzą
+// przez fuzję z rzeczywistym okresem próbkowania czujnika zamiast dt z zegara.
+// Czujnik z FIFO wystartowanym osobno (po odzyskaniu) dołącza z opóźnieniem
+// fifo_lag ramek – wcześniejsze ramki pozostałych czujników ma propagowane żyroskopem.
+static void acquireFifo(uint64_t now64, bool* ok) {
+  const uint32_t now_us = (uint32_t)now64;
+  const float dt = 1.0f / mpuSampleRateHz(mpu_cfg);
+  const uint32_t period_us = (uint32_t)(dt * 1e6f + 0.5f);
+  const float tick_s = (now_us - last_us) / 1e6f; // czas od poprzedniego taktu (przerwa we wszystkich IMU)
+  last_us = now_us;
+
+  const uint32_t c0 = drdy.count;
+  uint32_t bus_us = busRunAll(BUS_OP_FIFO_COUNT);
+  const uint32_t c1 = drdy.count;
+  bool any = false, overflow = false;
+  size_t n = FIFO_DRAIN_MAX, n_aligned = SIZE_MAX; // ramki liczone od najstarszej (z fifo_lag)
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    ok[i] = reads[i].ok;
+    if (!ok[i] && wake_stage[i] == WAKE_IDLE) err_count[i]++;
+    overflow |= reads[i].avail == FIFO_ERR_OVERFLOW;
+    if (ok[i] && !fifo_fresh[i] && (size_t)reads[i].avail + fifo_lag[i] < n_aligned) {
+      n_aligned = (size_t)reads[i].avail + fifo_lag[i];
+    }
+    any |= ok[i];
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (!ok[i] || !fifo_fresh[i]) continue;
+    const size_t avail = (size_t)reads[i].avail;
+    fifo_lag[i] = (uint16_t)(n_aligned != SIZE_MAX && n_aligned > avail ? n_aligned - avail : 0);
+    fifo_fresh[i] = false;
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (ok[i] && (size_t)reads[i].avail + fifo_lag[i] < n) n = (size_t)reads[i].avail + fifo_lag[i];
+  }
+
+  // Przepełnienie jednego FIFO -> restart wszystkich, żeby ramki były zgodne w czasie;
+  // po restarcie w FIFO nie ma jeszcze ramek do odczytu. Czujnik w trakcie wybudzania
+  // jest pomijany – jego FIFO startuje krok WAKE_CONFIG, po zapisie konfiguracji.
+  if (overflow) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      if (wake_stage[i] == WAKE_IDLE) mpuFifoStart(i);
+    }
+    n = 0;
+  }
+  // Ramki czujnika odniesienia zgodne z licznikiem przerwań -> czas ramki z ISR
+  const size_t r = DRDY_SENSOR;
+  const bool stamped = ACQ_USE_DRDY && !overflow && ok[r] && c1 != 0;
+  if (stamped) drdyFifoSync(drdy_fifo, c0, c1, (uint32_t)reads[r].avail);
+  for (size_t i = 0; i < SENSOR_COUNT; i++) reads[i].lead = fifo_lag[i] < n ? fifo_lag[i] : n;
+  if (any && n > 0) {
+    bus_fifo_n = n;
+    bus_us += busRunAll(BUS_OP_FIFO_READ);
+    any = false;
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      if (ok[i] && !reads[i].ok) {
+        ok[i] = false;
+        err_count[i]++;
+      }
+      any |= ok[i];
+    }
+  }
+  latencyRecord(perf_bus, bus_us);
+
+  const size_t p = MAIN_JOINT.proximal, d = MAIN_JOINT.distal;
+  KneeSample k;
+  if (!any) {
+    // brak ramek ze wszystkich IMU: jedna próbka na takt, propagowana żyroskopem
+    traceSample(now64, tick_s, false, reads[p].r[0], false, reads[d].r[0]);
+    fuseFrame(now64, tick_s, ok, 0, k);
+    publishSample(k);
+    return;
+  }
+
+  // Czas ramki: przerwanie data-ready, bez niego ostatnia ramka ~ now64, wcześniejsze
+  // co okres próbkowania wstecz; IMU bez odczytu jest propagowane żyroskopem
+  // w takcie ramek pozostałych
+  for (size_t f = 0; f < n; f++) {
+    bool ok_f[SENSOR_COUNT];
+    for (size_t i = 0; i < SENSOR_COUNT; i++) ok_f[i] = ok[i] && f >= reads[i].lead;
+    uint64_t t_us = now64 - (uint64_t)(n - 1 - f) * period_us, t_irq;
+    if (stamped && ok_f[r] && drdyStampAt(drdy, drdyFifoIndex(drdy_fifo, f - reads[r].lead), t_irq)) t_us = t_irq;
+    traceSample(t_us, dt, ok_f[p], reads[p].r[f], ok_f[d], reads[d].r[f]);
+    for (size_t i = 0; i < SENSOR_COUNT; i++) gyroCalFeed(i, ok_f[i], reads[i].s[f]);
+    const uint32_t t0 = micros();
+    fuseFrame(t_us, dt, ok_f, f, k);
+    latencyRecord(perf_fusion, micros() - t0);
+    publishSample(k);
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (ok[i]) fifo_lag[i] = (uint16_t)(fifo_lag[i] - reads[i].lead);
+  }
+  if (ok[r]) drdyFifoConsume(drdy_fifo, n - reads[r].lead);
 }
 
-static void printI2cErrorsOncePerSecond(bool ok1, bool ok2) {
+// Temperatura co TEMP_READ_PERIOD_US (poprawka tc), punkty modelu bias(T) z okien
+// bezruchu, nowe nachylenia po każdym punkcie; rekordy do zapisu co TEMP_SAVE_PERIOD_S.
+static void updateTemperature(uint32_t now_us, const bool* ok) {
+  static uint32_t prev_us = now_us;
+  const float tick_s = (now_us - prev_us) / 1e6f;
+  prev_us = now_us;
+
+  if (now_us - temp_read_us >= TEMP_READ_PERIOD_US) {
+    temp_read_us = now_us;
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      float t = poll_temp[i];
+      if (ok[i] && (!ACQ_USE_FIFO || readTempC(i, t))) imuSetTemperature(imus[i], t);
+    }
+    trace_state_dirty = true;
+  }
+
+  if (temp_clear_req) {
+    const float zero[3] = {0, 0, 0};
+    for (size_t i = 0; i < 2 * CAL_RECORDS; i++) temp_fit[i] = TempBiasFit();
+    for (size_t i = 0; i < SENSOR_COUNT; i++) imuSetTempSlopes(imus[i], zero);
+    temp_unsaved = 0;
+    temp_clear_req = false;
+    trace_state_dirty = true;
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (!tempFitObserve(temp_fit[i], imus[i], tick_s)) continue;
+    float k[3];
+    tempFitSlopes(temp_fit[i], k); // k = 0, dopóki dopasowanie nie jest ważne
+    imuSetTempSlopes(imus[i], k);
+    temp_unsaved++;
+    trace_state_dirty = true;
+  }
+
+  const uint32_t now_ms = now_us / 1000;
+  const bool due = temp_unsaved > 0 && now_ms - temp_saved_ms >= TEMP_SAVE_PERIOD_S * 1000;
+  if ((due || temp_save_req) && !temp_save_pending) {
+    for (size_t r = 0; r < CAL_RECORDS; r++) tempModelEncode(&temp_fit[2 * r], temp_save_buf[r]);
+    temp_unsaved = 0;
+    temp_saved_ms = now_ms;
+    temp_save_req = false;
+    temp_save_pending = true;
+  }
+}
+
+// Kolejny krok resetu odzyskiwanych czujników, gdy minął jego czas (wake_stage).
+// Na końcu FIFO startuje tylko u tego czujnika – wyrównanie z pozostałymi: fifo_lag.
+static void stepSensorWake(uint32_t now_us) {
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (wake_stage[i] == WAKE_IDLE || (int32_t)(now_us - wake_at_us[i]) < 0) continue;
+    const uint32_t t0 = micros();
+    switch (wake_stage[i]) {
+      case WAKE_RESET:
+        mpuWakeStart(i);
+        wake_stage[i] = WAKE_PLL;
+        break;
+      case WAKE_PLL:
+        mpuWakeConfig(i);
+        wake_stage[i] = WAKE_CONFIG;
+        break;
+      default:
+        if (ACQ_USE_FIFO) mpuFifoStart(i);
+        wake_stage[i] = WAKE_IDLE;
+        break;
+    }
+    wake_at_us[i] = now_us + MPU_WAKE_STEP_US;
+    wake_cost_us[i] += micros() - t0;
+    if (wake_stage[i] == WAKE_IDLE) latencyRecord(perf_recover, wake_cost_us[i]);
+  }
+}
+
+// Wynik odczytu -> BusLink. Po serii błędów: odblokowanie portu niesprawnego
+// czujnika i reset niesprawnych czujników; wybudzenie i konfiguracja w kolejnych
+// taktach (stepSensorWake), bias i offsety zostają w ImuState. Czujnik w trakcie
+// resetu nie zgłasza błędów do BusLink.
+static void trackBusLinks(uint32_t now_us, const bool* ok) {
+  stepSensorWake(now_us);
+  bool recover[SENSOR_COUNT];
+  bool port_down[SENSOR_PORTS] = {false, false};
+  bool any = false;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (ok[i]) linkOnSuccess(links[i], now_us);
+    recover[i] = !ok[i] && wake_stage[i] == WAKE_IDLE && linkOnFailure(links[i], now_us);
+    port_down[SENSORS[i].port] |= recover[i];
+    any |= recover[i];
+  }
+  if (!any) return;
+
+  const uint32_t t0 = micros();
+  for (uint8_t p = 0; p < SENSOR_PORTS; p++) {
+    if (port_down[p]) i2cBusRecover(p);
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (recover[i]) mpuReset(i);
+  }
+  const uint32_t cost = micros() - t0;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (!recover[i]) continue;
+    wake_stage[i] = WAKE_RESET;
+    wake_at_us[i] = now_us + MPU_RESET_WAIT_US;
+    wake_cost_us[i] = cost;
+  }
+  bus_recoveries++;
+}
+
+static void printI2cErrorsOncePerSecond() {
+  static uint32_t last_overflow = 0, last_usb_dropped = 0;
+  static uint32_t seen_outages[SENSOR_COUNT] = {};
   if (millis() - last_err_print <= 1000) return;
-  if (!ok1 || !ok2) {
-    Serial.printf("[ERROR] IMU1(0x68):%s [%lu err] | IMU2(0x69):%s [%lu err]\n",
-                  ok1 ? "OK" : "FAIL", err_count1,
-                  ok2 ? "OK" : "FAIL", err_count2);
+  bool all_ok = true;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const uint32_t outages = links[i].outages;
+    if (outages > seen_outages[i]) {
+      Serial.printf("[I2C] IMU%u recovered after %lu ms (max %lu ms, outages %lu)\n", (unsigned)(i + 1),
+                    (unsigned long)(links[i].last_recover_us / 1000), (unsigned long)(links[i].max_recover_us / 1000),
+                    (unsigned long)outages);
+    }
+    seen_outages[i] = outages;
+    all_ok &= imu_ok[i];
+  }
+  if (!all_ok) {
+    Serial.print("[ERROR]");
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      Serial.printf("%s IMU%u(0x%02X):%s [%lu err]", i ? " |" : "", (unsigned)(i + 1), SENSORS[i].addr,
+                    imu_ok[i] ? "OK" : "FAIL", (unsigned long)err_count[i]);
+    }
+    Serial.println();
+  }
+  const uint32_t overflow = sample_ring.dropped();
+  if (overflow != last_overflow) {
+    Serial.printf("[PIPE] ring overflow: %lu (pushed %lu)\n", (unsigned long)overflow, (unsigned long)samples_pushed);
+    last_overflow = overflow;
+  }
+  if (usb_frames_dropped != last_usb_dropped) {
+    Serial.printf("[USB] dropped frames: %lu (sent %lu)\n", (unsigned long)usb_frames_dropped,
+                  (unsigned long)usb_frames_sent);
+    last_usb_dropped = usb_frames_dropped;
   }
   last_err_print = millis();
 }
 
-static void sendTelemetry(uint32_t now_us,
-                          float roll1, float pitch1, float yaw1,
-                          float roll2, float pitch2, float yaw2,
-                          float knee_angle,
-                          bool imu1_inverted, bool imu2_inverted) {
-  // USB: format etykietowany (pod Serial Plotter / łatwe logowanie)
-  Serial.print("time:"); Serial.print((unsigned long)now_us);
-  Serial.print(" roll1:"); Serial.print(roll1, 2);
-  Serial.print(" pitch1:"); Serial.print(pitch1, 2);
-  Serial.print(" yaw1:"); Serial.print(yaw1, 2);
-  Serial.print(" roll2:"); Serial.print(roll2, 2);
-  Serial.print(" pitch2:"); Serial.print(pitch2, 2);
-  Serial.print(" yaw2:"); Serial.print(yaw2, 2);
-  Serial.print(" knee_angle:"); Serial.print(knee_angle, 2);
-  Serial.print(" inv1:"); Serial.print(imu1_inverted ? 1 : 0);
-  Serial.print(" inv2:"); Serial.println(imu2_inverted ? 1 : 0);
-
-  // BT: szybki CSV bez etykiet (łatwy parsing w aplikacji)
-  if (BT.hasClient()) {
-    char out[128];
-    const int n = snprintf(out, sizeof(out),
-                           "%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d\n",
-                           (unsigned long)now_us,
-                           roll1, pitch1, yaw1,
-                           roll2, pitch2, yaw2,
-                           knee_angle,
-                           imu1_inverted ? 1 : 0,
-                           imu2_inverted ? 1 : 0);
-    BT.write((const uint8_t*)out, n);
+// Jeden zapis ramki/linii/paczki do BT (czas zapisu, krótki zapis = odrzucona).
+static void btWriteFrame(const uint8_t* out, size_t n) {
+  if (n == 0) return;
+  const uint32_t t0 = micros();
+  const size_t written = BT.write(out, n);
+  latencyRecord(perf_bt_write, micros() - t0);
+  if (written == n) bt_frames_sent++;
+  else              bt_frames_dropped++;
+}
+
+// Kąty stawów poza głównym dopisane na końcu linii USB (" hip_l:12.30"): ostatnie
+// wartości z akwizycji, bez decymacji; n = długość linii z "\r\n" na końcu.
+static size_t appendJointAngles(char* out, size_t cap, size_t n) {
+  if (JOINT_COUNT < 2 || n < 2) return n;
+  const size_t line_n = n;
+  n -= 2;
+  for (size_t j = 1; j < JOINT_COUNT; j++) {
+    const int r = snprintf(out + n, cap - n, " %s:%.2f", JOINTS[j].name, joint_angle[j]);
+    if (r < 0 || (size_t)r + 2 >= cap - n) { // brak miejsca na kąt i "\r\n": linia bez kątów stawów
+      memcpy(out + line_n - 2, "\r\n", 3);
+      return line_n;
+    }
+    n += (size_t)r;
+  }
+  memcpy(out + n, "\r\n", 3);
+  return n + 2;
+}
+
+static void sendTelemetry(const KneeSample& k) {
+  // USB: format etykietowany (pod Serial Plotter / łatwe logowanie), jeden zapis;
+  // gdy w buforze TX brak miejsca, cała linia jest odrzucana (nigdy w połowie)
+  // seq rośnie także dla linii odrzuconej – odbiorca widzi lukę (tools/kgdecode)
+  static char usb_out[TELEMETRY_LABELED_MAX + JOINT_COUNT * 24];
+  if (log_dl_io == &Serial || trace_active) {
+    // pobieranie dziennika / ślad surowy w toku – strumień zajęty (linie nie powstają)
+  } else if (const size_t un = appendJointAngles(usb_out, sizeof(usb_out),
+                                                 formatTelemetryLabeled(usb_out, TELEMETRY_LABELED_MAX, k, usb_seq++))) {
+    if ((size_t)Serial.availableForWrite() >= un) {
+      const uint32_t t0 = micros();
+      Serial.write((const uint8_t*)usb_out, un);
+      latencyRecord(perf_usb_write, micros() - t0);
+      usb_frames_sent++;
+    } else {
+      usb_frames_dropped++;
+    }
+  }
+
+  // BT: szybki CSV bez etykiet (łatwy parsing w aplikacji), ramka binarna (29 B, CRC)
+  // albo paczka K próbek, także skompresowana (zapis dopiero po zamknięciu paczki)
+  if (BT.hasClient() && log_dl_io != &BT) {
+    static uint8_t out[BATCH_OUT_MAX];
+    size_t n = 0;
+    if (btBatched(bt_format))         n = batcherPush(bt_batch, k, micros(), out);
+    else if (bt_format == BT_FMT_BIN) n = encodeBinaryFrame(out, (uint16_t)bt_seq++, k);
+    else                              n = formatTelemetryCsv((char*)out, TELEMETRY_CSV_MAX, k, bt_seq++);
+    btWriteFrame(out, n);
+  }
+}
+
+// Ślad surowy -> USB całymi rekordami: akwizycja publikuje rekord jednym pushN,
+// więc po nagłówku reszta jest już w buforze, a linie "[...]" transportu nigdy nie
+// trafiają w środek rekordu. Bez blokowania – tylko gdy bufor TX pomieści rekord.
+static void flushTrace() {
+  static uint8_t rec[TRACE_RECORD_MAX];
+  while ((size_t)Serial.availableForWrite() >= TRACE_RECORD_MAX && trace_ring.popN(rec, TRACE_HEADER_LEN)) {
+    const size_t n = TRACE_HEADER_LEN + getLe16(rec + 3) + 2;
+    trace_ring.popN(rec + TRACE_HEADER_LEN, n - TRACE_HEADER_LEN);
+    Serial.write(rec, n);
+    trace_records_sent++;
   }
 }
 
+// Sufit opóźnienia paczki BT – wywoływane w każdym kroku transportu.
+static void flushBtBatchOnLatency() {
+  if (!btBatched(bt_format) || !BT.hasClient() || log_dl_io == &BT) return;
+  static uint8_t out[BATCH_OUT_MAX];
+  btWriteFrame(out, batcherPoll(bt_batch, micros(), out));
+}
+
+// ============================================================================
+// 6) Potok: akwizycja i transport
+// ============================================================================
+
+// Zapis konfiguracji zleconej komendą do wszystkich czujników. Skale zmieniają się
+// razem z zakresami (bias żyroskopu jest w deg/s, więc pozostaje ważny);
+// FIFO startuje od nowa, bo zawiera ramki w starej konfiguracji. Czujnik w trakcie
+// wybudzania dostaje mpu_cfg w kroku WAKE_PLL -> WAKE_CONFIG; jeśli ten krok już minął,
+// wraca do niego (bez transakcji teraz), a cfg_ok dotyczy tylko czujników w WAKE_IDLE.
+static void applyPendingConfig() {
+  const MpuConfig cfg = mpu_cfg_req;
+  cfg_pending = false;
+
+  bool ok = true;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    if (wake_stage[i] == WAKE_IDLE) ok = mpuApplyConfig(i, cfg) && ok;
+    else if (wake_stage[i] == WAKE_CONFIG) wake_stage[i] = WAKE_PLL;
+  }
+  mpu_cfg   = cfg;
+  mpu_scale = mpuScaleFactors(cfg);
+  setDrdyRate(cfg);
+  if (ACQ_USE_FIFO) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      if (wake_stage[i] == WAKE_IDLE) mpuFifoStart(i);
+    }
+  }
+  cfg_ok = ok;
+  cfg_report = true;
+  trace_config_dirty = true;
+}
+
+// Jeden krok akwizycji: odczyt I2C + fuzja, próbki trafiają do sample_ring.
+static void acquireOnce() {
+  static uint32_t prev_us = 0;
+  const uint64_t now64 = micros64();     // znacznik próbek: bez zawinięcia co ~71.6 min
+  const uint32_t now_us = (uint32_t)now64; // okresy i przerwy: arytmetyka modulo 2^32
+  if (stats_reset_pending) {
+    latencyReset(perf_loop);
+    latencyReset(perf_bus);
+    latencyReset(perf_fusion);
+    latencyReset(perf_recover);
+    latencyReset(perf_wake);
+    latencyReset(perf_ts_jitter);
+    drdy_timeouts = 0;
+    drdy_fifo.resyncs = 0;
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      latencyReset(perf_i2c[i]);
+      linkResetStats(links[i]);
+      err_count[i] = 0;
+    }
+    mux[0].selects = mux[1].selects = 0;
+    bus_recoveries = 0;
+    dt_clamp_count = 0;
+    samples_pushed = 0;
+    stats_reset_pending = false;
+  } else if (prev_us != 0) {
+    latencyRecord(perf_loop, now_us - prev_us);
+  }
+  prev_us = now_us;
+
+  // Przerwania od poprzedniego taktu: rozrzut okresu, opóźnienie pobudki od ostatniego
+  const uint32_t drdy_count = drdy.count;
+  uint64_t t_irq = 0;
+  const uint32_t c_from = drdy_count - drdy_seen > DRDY_STAMPS / 2 ? drdy_count - DRDY_STAMPS / 2 : drdy_seen;
+  for (uint32_t c = c_from; c != drdy_count; c++) {
+    uint32_t dev_us;
+    if (drdyStampAt(drdy, c, t_irq) && drdyJitterUpdate(drdy_jitter, c, t_irq, dev_us)) {
+      latencyRecord(perf_ts_jitter, dev_us);
+    }
+  }
+  const bool drdy_new = drdy_count != drdy_seen && drdyStampAt(drdy, drdy_count - 1, t_irq);
+  if (drdy_new) latencyRecord(perf_wake, (uint32_t)(now64 - t_irq));
+  drdy_seen = drdy_count;
+
+  if (calib_pending) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) captureMountOffsets(imus[i]);
+    calib_save_pending = true;
+    calib_pending = false;
+    trace_state_dirty = true;
+  }
+  gyroCalStep(now64);
+  if (engine_pending >= 0) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) setFusionEngine(imus[i], (FusionEngine)engine_pending);
+    engine_pending = -1;
+    trace_state_dirty = true;
+  }
+  if (bias_track_pending >= 0) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) imus[i].bias.enabled = bias_track_pending != 0;
+    bias_track_pending = -1;
+    trace_state_dirty = true;
+  }
+  if (trace_pending >= 0) {
+    trace_active = trace_pending != 0;
+    trace_config_dirty = trace_state_dirty = trace_active; // ślad zaczyna się od pełnego stanu
+    trace_seq = 0;
+    trace_pending = -1;
+  }
+  if (cfg_pending) applyPendingConfig();
+
+  bool ok[SENSOR_COUNT];
+  if (ACQ_USE_FIFO) acquireFifo(now64, ok);
+  else              acquirePolling(drdy_new ? t_irq : now64, ok);
+  trackBusLinks(now_us, ok);
+  updateTemperature(now_us, ok);
+  for (size_t i = 0; i < SENSOR_COUNT; i++) imu_ok[i] = ok[i];
+
+  if (transport_task && !sample_ring.empty()) xTaskNotifyGive(transport_task);
+}
+
+// Zapis kalibracji do NVS i raporty "calib gyro" / pierwszej ważnej próbki po starcie.
+static void reportCalibration() {
+  if (gyro_cal_done) {
+    const uint32_t done = gyro_cal_done;
+    gyro_cal_done = 0;
+    char line[24 + 16 * SENSOR_COUNT];
+    size_t n = snprintf(line, sizeof(line), "[CALIB] gyro");
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      n += snprintf(line + n, sizeof(line) - n, " imu%u=%s", (unsigned)(i + 1), (done & (1u << i)) ? "OK" : "MOVING");
+    }
+    Serial.println(line);
+    if (BT.hasClient()) BT.println(line);
+    const uint32_t all = (1u << SENSOR_COUNT) - 1;
+    if ((done & all) == all) { // zapis tylko z biasem wszystkich IMU z nieruchomego urządzenia
+      calib_flags |= CAL_HAS_BIAS;
+      Serial.printf("[CALIB] nvs save: %s\n", saveCalib() ? "OK" : "FAIL");
+    }
+  }
+  if (calib_save_pending) {
+    calib_save_pending = false;
+    calib_flags |= CAL_HAS_MOUNT;
+    Serial.printf("[CALIB] nvs save: %s\n", saveCalib() ? "OK" : "FAIL");
+  }
+  if (temp_save_pending) {
+    // bias w ImuState jest odniesiony do nowych nachyleń – zapis razem z modelem
+    bool ok = prefs_ok;
+    for (size_t r = 0; r < CAL_RECORDS && ok; r++) {
+      char kb[16];
+      ok = prefs.putBytes(nvsKey(kb, sizeof(kb), TEMP_NVS_KEY, r), temp_save_buf[r], TEMP_MODEL_LEN) == TEMP_MODEL_LEN;
+    }
+    temp_save_pending = false;
+    Serial.printf("[TEMP] nvs save: %s\n", ok && saveCalib() ? "OK" : "FAIL");
+  }
+  if (!first_valid_reported && first_valid_set) {
+    first_valid_reported = true;
+    Serial.printf("[BOOT] first valid frame after %lums (gyro cal %lums)\n",
+                  (unsigned long)(first_valid_us / 1000), (unsigned long)(boot_cal_us / 1000));
+  }
+}
+
+// Jeden krok transportu: komendy, opróżnienie bufora przez decymator (każda próbka
+// wyjściowa jest wysyłana) albo ostatnia próbka w takcie send_period_us.
+static void transportOnce() {
+  handleCommands();
+  if (cfg_report) {
+    cfg_report = false;
+    configureDecimator(); // nowa częstotliwość próbkowania -> nowy współczynnik
+    printConfig();
+  }
+  reportCalibration();
+
+  KneeSample k, out;
+  bool logged = false;
+  while (sample_ring.pop(k)) {
+    last_knee = k;
+    if (log_active) logged |= log_ring.push(k);
+    if (TELEMETRY_DECIMATE && decimatorPush(decim, k, out)) sendTelemetry(out);
+  }
+  if (logged && log_task) xTaskNotifyGive(log_task);
+  flushTrace();
+  flushBtBatchOnLatency();
+  printI2cErrorsOncePerSecond();
+
+  // Bez decymacji: telemetria z ograniczeniem częstotliwości
+  const uint32_t now_us = micros();
+  if (!TELEMETRY_DECIMATE && now_us - last_send_us >= send_period_us) {
+    last_send_us = now_us;
+    sendTelemetry(last_knee);
+  }
+}
+
+// Start pobierania: niepełny blok zapisany, zakres [from, next_seq) ustalony teraz
+// (bloki dopisane w trakcie trafią do kolejnego "log get").
+static void logDownloadBegin() {
+  Stream* io = log_dl_req;
+  logFlush(slog);
+  uint32_t from = log_dl_from;
+  if ((int32_t)(from - slog.oldest_seq) < 0) from = slog.oldest_seq;
+  if ((int32_t)(from - slog.next_seq) > 0)   from = slog.next_seq;
+  log_dl_next = from;
+  log_dl_end  = slog.next_seq;
+  log_dl_sent = log_dl_bad = 0;
+  io->printf("[LOG] begin from=%lu to=%lu block=%u\n", (unsigned long)from, (unsigned long)log_dl_end,
+             (unsigned)LOG_BLOCK_SIZE);
+  log_dl_io  = io;
+  log_dl_req = nullptr;
+}
+
+// Paczka bloków (zapis blokujący – zadanie dziennika ma niski priorytet);
+// bloki są wysyłane bez zmian, odbiorca sprawdza magic/seq/CRC.
+static void logDownloadStep() {
+  static uint8_t blk[LOG_BLOCK_SIZE];
+  Stream& io = *log_dl_io;
+  const bool lost = (log_dl_io == &BT) && !BT.hasClient();
+  for (uint32_t i = 0; i < LOG_DL_BATCH && !lost && log_dl_next != log_dl_end; i++, log_dl_next++) {
+    if (!logReadBlock(slog, log_dl_next, blk)) {
+      log_dl_bad++; // nadpisany w trakcie albo uszkodzony
+      continue;
+    }
+    io.write(blk, LOG_BLOCK_SIZE);
+    log_dl_sent++;
+  }
+  if (lost) {
+    Serial.printf("[LOG] BT download aborted at %lu\n", (unsigned long)log_dl_next);
+  } else if (log_dl_next == log_dl_end) {
+    io.printf("[LOG] end next=%lu sent=%lu bad=%lu\n", (unsigned long)log_dl_next, (unsigned long)log_dl_sent,
+              (unsigned long)log_dl_bad);
+  } else {
+    return;
+  }
+  log_dl_io = nullptr;
+}
+
+// Jeden krok zadania dziennika: próbki -> bloki, komendy, paczka pobierania.
+static void logOnce() {
+  KneeSample k;
+  while (log_ring.pop(k)) logAppend(slog, k);
+  if (log_session_pending) {
+    logNewSession(slog);
+    log_session_pending = false;
+  }
+  if (log_flush_pending) {
+    logFlush(slog);
+    log_flush_pending = false;
+  }
+  if (log_dl_req && !log_dl_io) logDownloadBegin();
+  if (log_dl_io) logDownloadStep();
+}
+
+static void logTask(void*) {
+  for (;;) {
+    // podczas pobierania bez czekania – zapis do strumienia i tak blokuje
+    ulTaskNotifyTake(pdTRUE, log_dl_io ? 0 : pdMS_TO_TICKS(50));
+    logOnce();
+  }
+}
+
+// LittleFS + plik dziennika (tworzony przy pierwszym starcie) + zadanie zapisu.
+static bool startSessionLog() {
+  if (!LittleFS.begin(true)) return false; // true: formatowanie przy pierwszym użyciu
+  slog_file = fopen(LOG_FILE_PATH, "r+b");
+  if (!slog_file) slog_file = fopen(LOG_FILE_PATH, "w+b");
+  if (!slog_file) return false;
+  logOpen(slog, logFileStorage(slog_file, LOG_FILE_BLOCKS));
+  logSetKind(slog, LOG_COMPRESS ? LOG_KIND_KNEE_DELTA : LOG_KIND_KNEE);
+  return xTaskCreatePinnedToCore(logTask, "log", 4096, nullptr, 1, &log_task, LOG_CORE) == pdPASS;
+}
+
+static void acqTimerCallback(void*) {
+  xTaskNotifyGive(acq_task);
+}
+
+// INT czujnika odniesienia: znacznik czasu każdej próbki, co drdy_wake_div próbek pobudka akwizycji.
+static void IRAM_ATTR drdyIsr() {
+  drdyStamp(drdy, micros64());
+  if (!acq_task || drdy.count % drdy_wake_div != 0) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(acq_task, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+static void acquisitionTask(void*) {
+  for (;;) {
+    // bez przerwań data-ready (INT niepodłączony, czujnik w resecie) takt z timeoutu
+    const TickType_t wait = ACQ_USE_DRDY ? pdMS_TO_TICKS(drdy_timeout_ms) : portMAX_DELAY;
+    if (ulTaskNotifyTake(pdTRUE, wait) == 0) drdy_timeouts++;
+    acquireOnce();
+  }
+}
+
+static void transportTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2)); // budzi akwizycja albo timeout (komendy)
+    transportOnce();
+  }
+}
+
+static bool startPipeline() {
+  if (xTaskCreatePinnedToCore(acquisitionTask, "acq", 4096, nullptr,
+                              configMAX_PRIORITIES - 2, &acq_task, ACQ_CORE) != pdPASS) return false;
+  if (xTaskCreatePinnedToCore(transportTask, "transport", 6144, nullptr,
+                              2, &transport_task, TRANSPORT_CORE) != pdPASS) return false;
+
+  // port 1 czytany równolegle z portem 0 tylko, gdy oba mają czujniki
+  if (port_len[0] > 0 && port_len[1] > 0) {
+    bus1_done = xSemaphoreCreateBinary();
+    if (!bus1_done || xTaskCreatePinnedToCore(bus1Task, "bus1", 3072, nullptr,
+                                              BUS1_PRIORITY, &bus1_task, ACQ_CORE) != pdPASS) return false;
+  }
+  if (ACQ_USE_DRDY) return true; // takt z przerwania data-ready
+
+  esp_timer_create_args_t args = {};
+  args.callback = acqTimerCallback;
+  args.name = "acq";
+  if (esp_timer_create(&args, &acq_timer) != ESP_OK) return false;
+  return esp_timer_start_periodic(acq_timer, ACQ_PERIOD_US) == ESP_OK;
+}
+
 void setup() {
-  Serial.begin(115200);
+  Serial.setTxBufferSize(USB_TX_BUFFER);
+  Serial.begin(USB_BAUD);
   Serial.setTimeout(5);
   delay(300);
   Serial.printf("\n[BOOT] Chip: %s | USB+BT calib commands\n", ESP.getChipModel());
 
-  Wire.begin(I2C_SDA, I2C_SCL);
-  Wire.setClock(100000);
-  delay(200);
+  const int bad_sensor = sensorArrayCheck(SENSORS, SENSOR_COUNT);
+  const int bad_joint  = jointArrayCheck(JOINTS, JOINT_COUNT, SENSOR_COUNT);
+  if (bad_sensor >= 0) Serial.printf("[ERROR] sensor layout: sensor %d (port/kanal/adres)\n", bad_sensor);
+  if (bad_joint >= 0)  Serial.printf("[ERROR] sensor layout: joint %d (indeks czujnika)\n", bad_joint);
+  for (uint8_t p = 0; p < SENSOR_PORTS; p++) {
+    port_len[p] = sensorPortOrder(SENSORS, SENSOR_COUNT, p, port_order[p]);
+    if (port_len[p] == 0) continue;
+    WIRES[p]->begin(I2C_SDA_PINS[p], I2C_SCL_PINS[p]);
+    WIRES[p]->setClock(100000);
+  }
+  delay(50); // start czujników po zasileniu (datasheet: ~30 ms)
+
+  Serial.print("[WHO]");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    Serial.printf("%s %s=0x%02X", i ? "," : "", SENSORS[i].name, readWhoAmI(i));
+  }
+  Serial.println(" (expect 0x68)");
+  // reset wszystkich naraz – jedno oczekiwanie 100 ms zamiast jednego na czujnik
+  bool ok[SENSOR_COUNT];
+  size_t n_ok = 0;
+  for (size_t i = 0; i < SENSOR_COUNT; i++) ok[i] = mpuReset(i);
+  delay(MPU_RESET_WAIT_US / 1000);
+  Serial.print("[INIT]");
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    ok[i] = ok[i] && mpuWake(i);
+    imu_ok[i] = ok[i]; // do pierwszej akwizycji raport "[ERROR]" pokazuje wynik inicjalizacji
+    n_ok += ok[i];
+    Serial.printf("%s %s: %s", i ? " |" : "", SENSORS[i].name, ok[i] ? "OK" : "FAIL");
+  }
+  Serial.println();
 
-  Serial.printf("[WHO] 0x68=0x%02X, 0x69=0x%02X (expect 0x68)\n", readWhoAmI(MPU1_ADDR), readWhoAmI(MPU2_ADDR));
-  bool ok1 = mpuInit(MPU1_ADDR), ok2 = mpuInit(MPU2_ADDR);
-  Serial.printf("[INIT] 0x68: %s | 0x69: %s\n", ok1 ? "OK" : "FAIL", ok2 ? "OK" : "FAIL");
-  
-  if (!ok1 || !ok2) {
+  if (n_ok < SENSOR_COUNT) {
     Serial.println("[ERROR] Sprawdz polaczenia I2C!");
-    Serial.println("[ERROR] MPU1 (0x68): SDA=21, SCL=22, AD0=GND");
-    Serial.println("[ERROR] MPU2 (0x69): SDA=21, SCL=22, AD0=3.3V");
-    if (!ok1 && !ok2) Serial.println("[ERROR] Oba czujniki nie odpowiadaja - mozliwy problem z I2C");
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      if (ok[i]) continue;
+      const SensorDesc& d = SENSORS[i];
+      Serial.printf("[ERROR] IMU%u %s (0x%02X): SDA=%u, SCL=%u, AD0=%s", (unsigned)(i + 1), d.name, d.addr,
+                    I2C_SDA_PINS[d.port], I2C_SCL_PINS[d.port], d.addr == 0x69 ? "3.3V" : "GND");
+      if (d.mux_ch != MUX_NONE) Serial.printf(", TCA9548A 0x%02X kanal %d", MUX_ADDR, d.mux_ch);
+      Serial.println();
+    }
+    if (n_ok == 0) Serial.println("[ERROR] Zaden czujnik nie odpowiada - mozliwy problem z I2C");
   }
 
-  Serial.println("[CAL] keep still ~1.2s...");
-  calibrateGyro(imu1, MPU1_ADDR);
-  calibrateGyro(imu2, MPU2_ADDR);
+  for (size_t i = 0; i < SENSOR_COUNT; i++) setFusionEngine(imus[i], FUSION_ENGINE);
+
+  // 400 kHz już do kalibracji: odczyty 14 B wszystkich czujników portu mieszczą się w okresie 500 Hz
+  for (uint8_t p = 0; p < SENSOR_PORTS; p++) {
+    if (port_len[p] == 0) continue;
+    WIRES[p]->setClock(I2C_CLOCK_HZ);
+    WIRES[p]->setTimeOut(I2C_TIMEOUT_MS);
+  }
+  Serial.printf("[SENSORS] %u IMU, %u joints, port0=%u port1=%u (max %u/port)\n", (unsigned)SENSOR_COUNT,
+                (unsigned)JOINT_COUNT, (unsigned)port_len[0], (unsigned)port_len[1],
+                (unsigned)sensorPortMaxLoad(SENSORS, SENSOR_COUNT));
 
-  Wire.setClock(400000); // szybciej po konfiguracji
+  Serial.println("[CAL] keep still...");
+  restoreCalibration();
 
   bool btok = BT.begin(BT_DEVICE_NAME);
   BT.setTimeout(5);
@@ -359,42 +2042,68 @@ void setup() {
     if (e == ESP_SPP_CLOSE_EVT)     Serial.println("[BT] client DISCONNECTED");
   });
 
+  // Przerwanie data-ready: test, czy INT czujnika odniesienia dochodzi do DRDY_PIN
+  if (ACQ_USE_DRDY) {
+    setDrdyRate(mpu_cfg);
+    pinMode(DRDY_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(DRDY_PIN), drdyIsr, RISING);
+    const uint32_t c0 = drdy.count;
+    delay(20);
+    const uint32_t irq = drdy.count - c0;
+    Serial.printf("[DRDY] GPIO%u <- %s INT: %lu irq/20ms, wake every %lu: %s\n", DRDY_PIN,
+                  SENSORS[DRDY_SENSOR].name, (unsigned long)irq, (unsigned long)drdy_wake_div,
+                  irq ? "OK" : "FAIL (timeout wake)");
+  }
+
+  // FIFO startuje tuż przed akwizycją (BT.begin trwa dłużej niż pojemność FIFO)
+  if (ACQ_USE_FIFO) {
+    Serial.print("[FIFO]");
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+      Serial.printf("%s %s: %s", i ? " |" : "", SENSORS[i].name, mpuFifoStart(i) ? "OK" : "FAIL");
+    }
+    Serial.println();
+  }
+  mpu_cfg_req = mpu_cfg;
+  configureDecimator();
+  batcherInit(bt_batch, BATCH_K, BATCH_MAX_LATENCY_MS * 1000);
+  printConfig();
+
+  const bool logok = startSessionLog();
+  log_active = LOG_ENABLED && logok;
+  printLogStatus(Serial);
+
   last_us = micros();
-  Serial.println("[INFO] labels: time, roll1, pitch1, yaw1, roll2, pitch2, yaw2, knee_angle, inv1, inv2");
-  Serial.println("[INFO] KALIBRACJA: wyprostuj kolano, postaw noge pionowo, wyslij 'calib'");
+  Serial.print("[INFO] labels: time, roll1, pitch1, yaw1, roll2, pitch2, yaw2, knee_angle, inv1, inv2, q1, q2");
+  for (size_t j = 1; j < JOINT_COUNT; j++) Serial.printf(", %s", JOINTS[j].name);
+  Serial.println();
+  Serial.println("[INFO] KALIBRACJA: wyprostuj kolano, postaw noge pionowo, wyslij 'calib' (zapis w NVS)");
   Serial.println("[INFO] Kalibracja kompensuje przekoszenie czujnikow wzgledem nogi");
-  Serial.println("[INFO] IMU1=udo (thigh), IMU2=podudzie (shank), knee_angle=|angleDiff(roll2, roll1)|");
+  // definicja knee_angle zależy od silnika: Kalman – różnica roll, Madgwick/Mahony – kwaternion
+  const bool quat_knee = FUSION_ENGINE == FUSION_MADGWICK || FUSION_ENGINE == FUSION_MAHONY;
+  Serial.printf("[INFO] IMU1=%s, IMU2=%s (%s)%s\n", SENSORS[MAIN_JOINT.proximal].name,
+                SENSORS[MAIN_JOINT.distal].name, MAIN_JOINT.name,
+                quat_knee ? "" : ", knee_angle=|angleDiff(roll2, roll1)|");
+  Serial.printf("[INFO] fusion: %s%s\n", fusionEngineName(FUSION_ENGINE),
+                quat_knee ? " (kwaternion: knee_angle=kat obrotu udo->podudzie)" : "");
+
+  if (PIPELINE_DUAL_CORE) {
+    const bool pok = startPipeline();
+    if (ACQ_USE_DRDY) {
+      Serial.printf("[PIPE] acq@core%d drdy GPIO%u | transport@core%d: %s\n",
+                    (int)ACQ_CORE, DRDY_PIN, (int)TRANSPORT_CORE, pok ? "OK" : "FAIL");
+    } else {
+      Serial.printf("[PIPE] acq@core%d %lu us | transport@core%d: %s\n",
+                    (int)ACQ_CORE, (unsigned long)ACQ_PERIOD_US, (int)TRANSPORT_CORE, pok ? "OK" : "FAIL");
+    }
+  }
 }
 
 void loop() {
-  handleCommands();
-
-  const uint32_t now_us = micros();
-  const float dt = computeDtSeconds(now_us);
-
-  const bool ok1 = updateImu(imu1, MPU1_ADDR, dt, err_count1);
-  const bool ok2 = updateImu(imu2, MPU2_ADDR, dt, err_count2);
-  printI2cErrorsOncePerSecond(ok1, ok2);
-
-  // Korekta o offsety (po komendzie "calib")
-  const float roll1  = ok1 ? (imu1.k_roll.angle_deg  - imu1.off_roll)  : -999.0f;
-  const float pitch1 = ok1 ? (imu1.k_pitch.angle_deg - imu1.off_pitch) : -999.0f;
-  const float yaw1   = ok1 ? wrap180(imu1.yaw - imu1.off_yaw) : -999.0f;
-
-  const float roll2  = ok2 ? (imu2.k_roll.angle_deg  - imu2.off_roll)  : -999.0f;
-  const float pitch2 = ok2 ? (imu2.k_pitch.angle_deg - imu2.off_pitch) : -999.0f;
-  const float yaw2   = ok2 ? wrap180(imu2.yaw - imu2.off_yaw) : -999.0f;
-
-  // Prosta diagnostyka orientacji (az < 0 oznacza, że IMU jest odwrócone)
-  const bool imu1_inverted = ok1 && (imu1.az < 0.0f);
-  const bool imu2_inverted = ok2 && (imu2.az < 0.0f);
-
-  // Kąt zgięcia kolana: dodatnia minimalna różnica kątowa roll (0..180)
-  const float knee_angle = (ok1 && ok2) ? fabsf(angleDiffDeg(roll2, roll1)) : -999.0f;
-
-  // Telemetria z ograniczeniem częstotliwości
-  if (now_us - last_send_us >= SEND_PERIOD_US) {
-    last_send_us = now_us;
-    sendTelemetry(now_us, roll1, pitch1, yaw1, roll2, pitch2, yaw2, knee_angle, imu1_inverted, imu2_inverted);
+  if (PIPELINE_DUAL_CORE) {
+    vTaskDelete(nullptr); // pracę wykonują zadania acq/transport
+    return;
   }
+
+  acquireOnce();
+  transportOnce();
 }
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "sensor_array.h"
+
+/*
+  KneeGuard – rozmieszczenie czujników i definicje stawów (wybór przy kompilacji)
+
+  -DKG_SENSOR_LAYOUT=KG_LAYOUT_KNEE (domyślnie): dwa MPU6050 na Wire (SDA 21,
+  SCL 22), udo 0x68 (AD0 = GND) i podudzie 0x69 (AD0 = 3.3V), staw: kolano.
+
+  -DKG_SENSOR_LAYOUT=KG_LAYOUT_LEGS: biodro, kolano i kostka obu nóg – 7 czujników.
+  Lewa noga + miednica na Wire, prawa noga na Wire1 (SDA 33, SCL 32), każda za
+  TCA9548A 0x70 (po dwa czujniki na kanał, AD0 0/1). Odczyt próbki: 4 czujniki
+  na porcie 0 równolegle z 3 na porcie 1.
+
+  Pierwszy staw jest stawem głównym: jego para czujników daje kąty i knee_angle
+  w telemetrii, dzienniku i śladzie surowym (formaty dwóch IMU bez zmian);
+  kąty pozostałych stawów – linia USB i komenda "joints".
+
+  DRDY_SENSOR: czujnik, którego pin INT (data-ready) jest podłączony do DRDY_PIN –
+  jego przerwania budzą akwizycję i dają znaczniki czasu próbek wszystkich czujników.
+*/
+
+#define KG_LAYOUT_KNEE 0
+#define KG_LAYOUT_LEGS 1
+
+#ifndef KG_SENSOR_LAYOUT
+#define KG_SENSOR_LAYOUT KG_LAYOUT_KNEE
+#endif
+
+// Piny portów I2C (indeks = SensorDesc::port)
+static const uint8_t I2C_SDA_PINS[SENSOR_PORTS] = {21, 33};
+static const uint8_t I2C_SCL_PINS[SENSOR_PORTS] = {22, 32};
+
+// INT czujnika odniesienia (udo / lewe udo) -> GPIO
+static const size_t  DRDY_SENSOR = 0;
+static const uint8_t DRDY_PIN    = 19;
+
+#if KG_SENSOR_LAYOUT == KG_LAYOUT_KNEE
+
+static const SensorDesc SENSORS[] = {
+  {"thigh", 0, 0x68, MUX_NONE}, // IMU1 (udo)
+  {"shank", 0, 0x69, MUX_NONE}, // IMU2 (podudzie)
+};
+
+static const JointDesc JOINTS[] = {
+  {"knee", 0, 1},
+};
+
+#elif KG_SENSOR_LAYOUT == KG_LAYOUT_LEGS
+
+static const SensorDesc SENSORS[] = {
+  {"thigh_l", 0, 0x68, 0},
+  {"shank_l", 0, 0x69, 0},
+  {"foot_l",  0, 0x68, 1},
+  {"pelvis",  0, 0x69, 1},
+  {"thigh_r", 1, 0x68, 0},
+  {"shank_r", 1, 0x69, 0},
+  {"foot_r",  1, 0x68, 1},
+};
+
+static const JointDesc JOINTS[] = {
+  {"knee_l",  0, 1},
+  {"knee_r",  4, 5},
+  {"hip_l",   3, 0},
+  {"hip_r",   3, 4},
+  {"ankle_l", 1, 2},
+  {"ankle_r", 5, 6},
+};
+
+#else
+#error "KG_SENSOR_LAYOUT: KG_LAYOUT_KNEE albo KG_LAYOUT_LEGS"
+#endif
+
+static const size_t SENSOR_COUNT = sizeof(SENSORS) / sizeof(SENSORS[0]);
+static const size_t JOINT_COUNT  = sizeof(JOINTS) / sizeof(JOINTS[0]);
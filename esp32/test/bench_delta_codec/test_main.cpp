@@ -0,0 +1,106 @@
+#include <unity.h>
+
+#include "bench.h"
+#include "binary_frame.h"
+#include "delta_codec.h"
+#include "fusion.h"
+
+/*
+  Benchmark kompresji delta_codec na nagranym (syntetycznym) ruchu kolana:
+  stopień kompresji wobec rekordu 17 B / ramki 25 B oraz ns/próbkę kodera i dekodera.
+  Uruchomienie: pio test -e native_bench
+*/
+
+static const size_t N = 100000;
+static const float FS_HZ = 500.0f;
+
+static std::vector<KneeSample> knee;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Ruch z bench.h przez pełną fuzję (Kalman) – szum i dynamika jak w strumieniu z urządzenia.
+static void makeKneeStream(void) {
+  const std::vector<BenchRawPair> motion = benchMakeKneeMotion(N, FS_HZ, 5.0f);
+  knee.resize(N);
+  ImuState a, b;
+  const float dt = 1.0f / FS_HZ;
+  for (size_t i = 0; i < N; i++) {
+    MpuSample sa, sb;
+    mpuScale(motion[i].thigh, sa);
+    mpuScale(motion[i].shank, sb);
+    fuseImuSample(a, sa, dt);
+    fuseImuSample(b, sb, dt);
+    computeKneeSample((uint32_t)(i * 2000u), a, true, b, true, knee[i]);
+  }
+}
+
+static size_t encodedBytes(uint16_t keyframe, size_t step) {
+  DeltaCodec c;
+  deltaCodecInit(c, keyframe);
+  uint8_t out[DELTA_SAMPLE_MAX];
+  size_t bytes = 0;
+  for (size_t i = 0; i < N; i += step) bytes += deltaEncode(c, knee[i], out);
+  return bytes;
+}
+
+static void bench_ratio(void) {
+  const struct { uint16_t key; size_t step; const char* name; } cfg[] = {
+    {0, 1, "500 Hz, keyframe only first"},
+    {50, 1, "500 Hz, keyframe/50"},
+    {10, 1, "500 Hz, keyframe/10"},
+    {50, 10, "50 Hz, keyframe/50"},
+  };
+  for (const auto& c : cfg) {
+    const size_t n = (N + c.step - 1) / c.step;
+    const double per = (double)encodedBytes(c.key, c.step) / n;
+    printf("[BENCH] %-28s %6.2f B/sample  x%.2f vs record %zu B  x%.2f vs frame %zu B\n", c.name, per,
+           BIN_RECORD_LEN / per, BIN_RECORD_LEN, BIN_FRAME_LEN / per, BIN_FRAME_LEN);
+    TEST_ASSERT_TRUE(per < BIN_RECORD_LEN);
+  }
+}
+
+static void bench_encode(void) {
+  static std::vector<uint8_t> out(N * DELTA_SAMPLE_MAX);
+  size_t bytes = 0;
+  const double ns = benchNsPerOp(N, [&]() {
+    DeltaCodec c;
+    deltaCodecInit(c, 50);
+    bytes = 0;
+    for (size_t i = 0; i < N; i++) bytes += deltaEncode(c, knee[i], &out[bytes]);
+  });
+  benchReport("deltaEncode", ns);
+
+  uint8_t rec[BIN_RECORD_LEN];
+  const double ns_rec = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) {
+      binEncodeRecord(rec, 2000, knee[i]);
+      benchSink(rec[3]);
+    }
+  });
+  benchReport("binEncodeRecord (ref.)", ns_rec);
+
+  KneeSample s;
+  size_t decoded = 0;
+  const double ns_dec = benchNsPerOp(N, [&]() {
+    DeltaCodec c;
+    deltaCodecInit(c, 0);
+    decoded = 0;
+    for (size_t p = 0; p < bytes;) {
+      bool have = false;
+      p += deltaDecode(c, &out[p], bytes - p, s, have);
+      decoded += have;
+    }
+    benchSink(s.knee_angle);
+  });
+  benchReport("deltaDecode", ns_dec);
+  TEST_ASSERT_EQUAL_size_t(N, decoded);
+}
+
+int main(int, char**) {
+  makeKneeStream();
+  UNITY_BEGIN();
+  RUN_TEST(bench_ratio);
+  RUN_TEST(bench_encode);
+  return UNITY_END();
+}
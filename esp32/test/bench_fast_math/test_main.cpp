@@ -0,0 +1,115 @@
+#include <unity.h>
+
+#include "bench.h"
+#include "fast_math.h"
+#include "kg_math.h"
+
+/*
+  Benchmark fast_math.h: wersje szybkie vs libm dla funkcji z gorącej ścieżki.
+  Koszt całej fuzji (zależny od KG_FAST_MATH): bench_pipeline / bench_fusion_engines.
+  Uruchomienie: pio test -e native_bench
+*/
+
+static const size_t N = 1000000;
+
+static std::vector<float> xs, ys;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Poprzednia wersja wrap180 (pętle) – punkt odniesienia.
+static inline float wrap180Loop(float deg) {
+  while (deg > 180) deg -= 360;
+  while (deg < -180) deg += 360;
+  return deg;
+}
+
+static void bench_atan2(void) {
+  const double fast = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += atan2DegFast(ys[i], xs[i]);
+    benchSink(acc);
+  });
+  const double libm = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += atan2DegLibm(ys[i], xs[i]);
+    benchSink(acc);
+  });
+  benchReport("atan2DegFast", fast, "call");
+  benchReport("atan2f (libm)", libm, "call");
+  TEST_ASSERT_GREATER_THAN(0.0, fast);
+}
+
+static void bench_inv_sqrt(void) {
+  const double fast = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += invSqrtFast(1.0f + xs[i] * xs[i]);
+    benchSink(acc);
+  });
+  const double libm = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += invSqrtLibm(1.0f + xs[i] * xs[i]);
+    benchSink(acc);
+  });
+  benchReport("invSqrtFast", fast, "call");
+  benchReport("1/sqrtf (libm)", libm, "call");
+  TEST_ASSERT_GREATER_THAN(0.0, fast);
+}
+
+static void bench_wrap180(void) {
+  const double fast = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += wrap180(ys[i] * 500.0f);
+    benchSink(acc);
+  });
+  const double loop = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) acc += wrap180Loop(ys[i] * 500.0f);
+    benchSink(acc);
+  });
+  benchReport("wrap180", fast, "call");
+  benchReport("wrap180 (pętle)", loop, "call");
+  TEST_ASSERT_GREATER_THAN(0.0, fast);
+}
+
+static void bench_accel_angles(void) {
+  const double fast = benchNsPerOp(N, [&]() {
+    float acc = 0, r = 0, p = 0;
+    for (size_t i = 0; i < N; i++) {
+      accelAnglesDeg(xs[i], ys[i], 0.5f, r, p);
+      acc += r + p;
+    }
+    benchSink(acc);
+  });
+  const double libm = benchNsPerOp(N, [&]() {
+    float acc = 0;
+    for (size_t i = 0; i < N; i++) {
+      const float r = atan2DegLibm(ys[i], 0.5f);
+      const float p = atan2DegLibm(-xs[i], sqrtf(ys[i] * ys[i] + 0.25f));
+      acc += r + p;
+    }
+    benchSink(acc);
+  });
+  benchReport(KG_FAST_MATH ? "accelAnglesDeg (fast)" : "accelAnglesDeg (libm)", fast, "call");
+  benchReport("accel angles (libm)", libm, "call");
+  TEST_ASSERT_GREATER_THAN(0.0, fast);
+}
+
+int main(int, char**) {
+  xs.resize(N);
+  ys.resize(N);
+  uint32_t lcg = 777;
+  for (size_t i = 0; i < N; i++) {
+    lcg = lcg * 1664525u + 1013904223u;
+    xs[i] = ((int32_t)(lcg >> 8) - (1 << 23)) / (float)(1 << 23);
+    lcg = lcg * 1664525u + 1013904223u;
+    ys[i] = ((int32_t)(lcg >> 8) - (1 << 23)) / (float)(1 << 23);
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(bench_atan2);
+  RUN_TEST(bench_inv_sqrt);
+  RUN_TEST(bench_wrap180);
+  RUN_TEST(bench_accel_angles);
+  return UNITY_END();
+}
@@ -0,0 +1,76 @@
+#include <unity.h>
+
+#include "bench.h"
+#include "fusion.h"
+
+/*
+  Benchmark silników fuzji: ns/aktualizację (1 IMU) oraz błąd kąta kolana
+  (RMSE względem prawdziwego zgięcia) dla montażu zgodnego z osią zgięcia
+  i montażu przekrzywionego o 30° (ruch poza osią X czujnika).
+  Uruchomienie: pio test -e native_bench
+*/
+
+static const size_t N = 20000;
+static const float FS_HZ = 500.0f;
+static const size_t SETTLE = 500; // pomijane próbki startowe w RMSE
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void runEngine(FusionEngine e, const std::vector<BenchRawPair>& motion, const char* label) {
+  std::vector<MpuSample> s1(N), s2(N);
+  for (size_t i = 0; i < N; i++) {
+    mpuScale(motion[i].thigh, s1[i]);
+    mpuScale(motion[i].shank, s2[i]);
+  }
+
+  const float dt = 1.0f / FS_HZ;
+  ImuState imu;
+  setFusionEngine(imu, e);
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) fuseImuSample(imu, s1[i], dt);
+    benchSink(imu.q.w + imu.k_roll.angle_deg);
+  });
+
+  ImuState a, b;
+  setFusionEngine(a, e);
+  setFusionEngine(b, e);
+  KneeSample k;
+  double se = 0;
+  for (size_t i = 0; i < N; i++) {
+    fuseImuSample(a, s1[i], dt);
+    fuseImuSample(b, s2[i], dt);
+    computeKneeSample((uint32_t)i, a, true, b, true, k);
+    if (i < SETTLE) continue;
+    const double err = k.knee_angle - motion[i].knee_deg;
+    se += err * err;
+  }
+  const double rmse = sqrt(se / (double)(N - SETTLE));
+
+  char name[64];
+  snprintf(name, sizeof(name), "%s (%s)", fusionEngineName(e), label);
+  printf("[BENCH] %-28s %10.1f ns/update  knee RMSE %.2f deg\n", name, ns, rmse);
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+  TEST_ASSERT_TRUE(rmse < 90.0);
+}
+
+static void bench_engines_aligned(void) {
+  const std::vector<BenchRawPair> motion = benchMakeKneeMotion(N, FS_HZ);
+  runEngine(FUSION_KALMAN, motion, "aligned");
+  runEngine(FUSION_MADGWICK, motion, "aligned");
+  runEngine(FUSION_MAHONY, motion, "aligned");
+}
+
+static void bench_engines_tilted(void) {
+  const std::vector<BenchRawPair> motion = benchMakeKneeMotion(N, FS_HZ, 30.0f);
+  runEngine(FUSION_KALMAN, motion, "tilt 30");
+  runEngine(FUSION_MADGWICK, motion, "tilt 30");
+  runEngine(FUSION_MAHONY, motion, "tilt 30");
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(bench_engines_aligned);
+  RUN_TEST(bench_engines_tilted);
+  return UNITY_END();
+}
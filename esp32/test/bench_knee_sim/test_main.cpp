@@ -0,0 +1,207 @@
+#include <unity.h>
+
+#include "bench.h"
+#include "calib_store.h"
+#include "fusion.h"
+#include "knee_sim.h"
+
+/*
+  Benchmark dokładności i obciążenia na syntetycznej kinematyce (knee_sim.h):
+  dla każdego scenariusza (przysiady, chód, przeprost, odchyłka montażu, dryf
+  biasu z nagrzewaniem, różne Fs) i konfiguracji fuzji (silnik, śledzenie
+  biasu) pełny potok jak w firmware: kalibracja żyroskopu z pierwszych
+  CAL_SAMPLES próbek bezruchu, "calib" w staniu, potem fuseKneeStep.
+  Wynik: RMSE i maksymalny błąd kąta kolana względem prawdy, opóźnienie
+  (przesunięcie minimalizujące błąd) i ns/próbkę (oba IMU + kolano).
+  Strojenie Kalmana: przebudowa z -DKG_KALMAN_Q=... -DKG_KALMAN_R=...
+  Uruchomienie: pio test -e native_bench -f bench_knee_sim
+*/
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const int LAG_MAX_MS = 150;
+
+// Bezruch na początku: kalibracja CAL_SAMPLES (przy 100 Hz to 5 s) + "calib" w staniu
+static float stillLeadS(const SimConfig& sc) {
+  return fmaxf(3.0f, (float)CAL_SAMPLES / sc.fs_hz + 1.5f);
+}
+
+struct SimScore {
+  double rmse = 0, max_err = 0, lag_ms = 0, ns = 0;
+};
+
+struct FusionSetup {
+  const char*  name;
+  FusionEngine engine;
+  bool         bias_track;
+};
+
+static const FusionSetup SETUPS[] = {
+  {"kalman",       FUSION_KALMAN,   true},
+  {"kalman-nobt",  FUSION_KALMAN,   false},
+  {"madgwick",     FUSION_MADGWICK, true},
+  {"mahony",       FUSION_MAHONY,   true},
+};
+
+static double meanSqErr(const std::vector<float>& est, const std::vector<float>& truth, size_t shift) {
+  double se = 0;
+  const size_t n = truth.size() - shift;
+  for (size_t i = 0; i < n; i++) {
+    const double e = est[i + shift] - truth[i];
+    se += e * e;
+  }
+  return se / (double)n;
+}
+
+static SimScore score(const std::vector<SimSample>& sim, const SimConfig& sc, const FusionSetup& fs) {
+  const MpuScaleFactors sf = mpuScaleFactors(sc.cfg);
+  std::vector<MpuSample> s1(sim.size()), s2(sim.size());
+  for (size_t i = 0; i < sim.size(); i++) {
+    mpuScale(sim[i].thigh, sf, s1[i]);
+    mpuScale(sim[i].shank, sf, s2[i]);
+  }
+  const float dt = 1.0f / sc.fs_hz;
+  const float motion_at_s = stillLeadS(sc);
+  const float calib_at_s  = motion_at_s - 0.5f;
+
+  ImuState imu1, imu2;
+  setFusionEngine(imu1, fs.engine);
+  setFusionEngine(imu2, fs.engine);
+  imu1.bias.enabled = imu2.bias.enabled = fs.bias_track;
+  GyroCalib cal1, cal2;
+  bool calibrated = false;
+
+  std::vector<float> est, truth;
+  KneeSample k;
+  for (size_t i = 0; i < sim.size(); i++) {
+    const float t = (float)sim[i].t_us * 1e-6f;
+    if (!calibrated) {
+      gyroCalibPush(cal1, s1[i]);
+      gyroCalibPush(cal2, s2[i]);
+      if (cal1.n >= CAL_SAMPLES) {
+        imuCalibApplyBias(imu1, cal1);
+        imuCalibApplyBias(imu2, cal2);
+        calibrated = true;
+      }
+      continue;
+    }
+    fuseKneeStep(sim[i].t_us, dt, imu1, true, s1[i], imu2, true, s2[i], k);
+    if (t >= calib_at_s && t < calib_at_s + dt) {
+      captureMountOffsets(imu1);
+      captureMountOffsets(imu2);
+    }
+    if (t < motion_at_s) continue;
+    est.push_back(k.knee_angle);
+    truth.push_back(fabsf(sim[i].knee_deg)); // potok: kąt bez znaku
+  }
+
+  SimScore r;
+  r.rmse = sqrt(meanSqErr(est, truth, 0));
+  for (size_t i = 0; i < est.size(); i++) r.max_err = fmax(r.max_err, fabs(est[i] - truth[i]));
+  double best = r.rmse * r.rmse;
+  const size_t max_shift = (size_t)(LAG_MAX_MS * 1e-3f * sc.fs_hz);
+  for (size_t sh = 1; sh <= max_shift; sh++) {
+    const double mse = meanSqErr(est, truth, sh);
+    if (mse < best) {
+      best = mse;
+      r.lag_ms = sh * 1e3 / sc.fs_hz;
+    }
+  }
+
+  r.ns = benchNsPerOp(sim.size(), [&]() {
+    ImuState a, b;
+    setFusionEngine(a, fs.engine);
+    setFusionEngine(b, fs.engine);
+    a.bias.enabled = b.bias.enabled = fs.bias_track;
+    KneeSample out;
+    for (size_t i = 0; i < sim.size(); i++) fuseKneeStep(sim[i].t_us, dt, a, true, s1[i], b, true, s2[i], out);
+    benchSink(out.knee_angle);
+  }, 3);
+  return r;
+}
+
+// Górne granice RMSE [°] per silnik: zmierzone wartości z zapasem, żeby regres
+// dokładności wywalał bench, a nie tylko rozbieżność filtra
+struct RmseLimit {
+  double kalman, madgwick, mahony;
+};
+
+static double rmseLimitFor(const RmseLimit& lim, FusionEngine e) {
+  switch (e) {
+    case FUSION_MADGWICK: return lim.madgwick;
+    case FUSION_MAHONY:   return lim.mahony;
+    default:              return lim.kalman;
+  }
+}
+
+static void runScenario(const char* label, SimMotion m, float duration_s, const SimConfig& sc,
+                        const RmseLimit& lim) {
+  const std::vector<SimSample> sim = simRun(simMakeScenario(m, duration_s, stillLeadS(sc)), sc);
+  for (size_t i = 0; i < sizeof(SETUPS) / sizeof(SETUPS[0]); i++) {
+    const SimScore r = score(sim, sc, SETUPS[i]);
+    printf("[BENCH] %-18s %-12s knee RMSE %6.2f max %6.2f deg  lag %5.1f ms  %7.1f ns/sample (%.1f M/s)\n",
+           label, SETUPS[i].name, r.rmse, r.max_err, r.lag_ms, r.ns, 1e3 / r.ns);
+    TEST_ASSERT_TRUE_MESSAGE(r.rmse < rmseLimitFor(lim, SETUPS[i].engine), label);
+  }
+}
+
+static SimConfig baseConfig() {
+  SimConfig sc;
+  const float b1[3] = {0.8f, -0.5f, 1.2f}, b2[3] = {-1.1f, 0.3f, 0.6f};
+  for (int a = 0; a < 3; a++) {
+    sc.imu[0].bias_dps[a] = b1[a];
+    sc.imu[1].bias_dps[a] = b2[a];
+  }
+  return sc;
+}
+
+// chód (też przekrzywiony montaż i inne Fs): Kalman zmierzony ~11°, Madgwick ~4°, Mahony ~6°
+static const RmseLimit GAIT_RMSE = {15.0, 6.0, 8.0};
+
+static void bench_squats_and_hyperextension(void) {
+  const SimConfig sc = baseConfig();
+  runScenario("squat", SIM_SQUAT, 30.0f, sc, {2.0, 2.0, 2.0});
+  runScenario("hyperext", SIM_HYPEREXT, 20.0f, sc, {2.5, 1.0, 1.0});
+}
+
+static void bench_gait(void) {
+  SimConfig sc = baseConfig();
+  runScenario("gait", SIM_GAIT, 30.0f, sc, GAIT_RMSE);
+
+  // czujniki przekrzywione na nodze (pasek obrócony, udo nie jest walcem)
+  sc.imu[0].mount_roll_deg = 5.0f;  sc.imu[0].mount_pitch_deg = 10.0f; sc.imu[0].mount_yaw_deg = 15.0f;
+  sc.imu[1].mount_roll_deg = -8.0f; sc.imu[1].mount_pitch_deg = 5.0f;  sc.imu[1].mount_yaw_deg = 20.0f;
+  runScenario("gait misaligned", SIM_GAIT, 30.0f, sc, GAIT_RMSE);
+}
+
+static void bench_sample_rate(void) {
+  SimConfig sc = baseConfig();
+  sc.fs_hz = 100.0f;
+  runScenario("gait 100 Hz", SIM_GAIT, 30.0f, sc, GAIT_RMSE);
+  sc.fs_hz = 1000.0f;
+  runScenario("gait 1000 Hz", SIM_GAIT, 30.0f, sc, GAIT_RMSE);
+}
+
+static void bench_bias_drift(void) {
+  // 5 min przysiadów z nagrzewaniem +8 °C: bias idzie za temperaturą i dryfuje
+  SimConfig sc = baseConfig();
+  sc.temp_rise_c = 8.0f;
+  sc.temp_tau_s = 120.0f;
+  sc.gyro_rw_dps = 0.005f;
+  for (int k = 0; k < 2; k++) {
+    sc.imu[k].temp_k_dps_c[0] = 0.15f;
+    sc.imu[k].temp_k_dps_c[2] = -0.1f;
+    sc.imu[k].drift_dps_min[0] = 0.05f;
+  }
+  runScenario("squat drift 5min", SIM_SQUAT, 300.0f, sc, {2.0, 6.0, 7.0});
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(bench_squats_and_hyperextension);
+  RUN_TEST(bench_gait);
+  RUN_TEST(bench_sample_rate);
+  RUN_TEST(bench_bias_drift);
+  return UNITY_END();
+}
@@ -0,0 +1,182 @@
+#include <unity.h>
+
+#include "bench.h"
+#include "binary_frame.h"
+#include "decimator.h"
+#include "fusion.h"
+#include "telemetry.h"
+
+/*
+  Benchmark potoku: ns/próbkę dla fuzji, kąta kolana i formatowania telemetrii.
+  Uruchomienie: pio test -e native_bench
+*/
+
+static const size_t N = 200000;
+static const float FS_HZ = 500.0f;
+
+static std::vector<BenchRawPair> motion;
+static std::vector<uint8_t> bursts;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void bench_decode_burst(void) {
+  MpuRaw raw;
+  MpuSample s;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) {
+      mpuDecodeBurst(&bursts[i * MPU_BURST_LEN], raw);
+      mpuScale(raw, s);
+      benchSink(s.gx);
+    }
+  });
+  benchReport("decode+scale (1 IMU)", ns);
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+}
+
+static void bench_fusion(void) {
+  std::vector<MpuSample> samples(N);
+  for (size_t i = 0; i < N; i++) mpuScale(motion[i].thigh, samples[i]);
+
+  ImuState imu;
+  const float dt = 1.0f / FS_HZ;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) fuseImuSample(imu, samples[i], dt);
+    benchSink(imu.k_roll.angle_deg);
+  });
+  benchReport("fuseImuSample (1 IMU)", ns);
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+}
+
+static void bench_knee_angle(void) {
+  ImuState a, b;
+  KneeSample k;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) {
+      a.k_roll.angle_deg = (float)(i % 360) - 180.0f;
+      computeKneeSample((uint32_t)i, a, true, b, true, k);
+      benchSink(k.knee_angle);
+    }
+  });
+  benchReport("computeKneeSample", ns);
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+}
+
+static void bench_csv_format(void) {
+  ImuState a, b;
+  std::vector<KneeSample> ks(1024);
+  for (size_t i = 0; i < ks.size(); i++) {
+    a.k_roll.angle_deg = 0.37f * i;
+    b.k_roll.angle_deg = -0.11f * i;
+    computeKneeSample((uint32_t)(i * 20000), a, true, b, true, ks[i]);
+  }
+
+  char out[TELEMETRY_CSV_MAX];
+  size_t bytes = 0;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) bytes += formatTelemetryCsv(out, sizeof(out), ks[i & 1023], (uint32_t)i);
+  });
+  benchReport("formatTelemetryCsv", ns, "frame");
+  TEST_ASSERT_GREATER_THAN(0, (int)bytes);
+}
+
+static void bench_labeled_format(void) {
+  ImuState a, b;
+  std::vector<KneeSample> ks(1024);
+  for (size_t i = 0; i < ks.size(); i++) {
+    a.k_roll.angle_deg = 0.37f * i;
+    b.k_roll.angle_deg = -0.11f * i;
+    computeKneeSample((uint32_t)(i * 20000), a, true, b, true, ks[i]);
+  }
+
+  char out[TELEMETRY_LABELED_MAX];
+  size_t bytes = 0;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) bytes += formatTelemetryLabeled(out, sizeof(out), ks[i & 1023], (uint32_t)i);
+  });
+  benchReport("formatTelemetryLabeled", ns, "frame");
+  TEST_ASSERT_GREATER_THAN(0, (int)bytes);
+}
+
+static void bench_binary_frame(void) {
+  ImuState a, b;
+  std::vector<KneeSample> ks(1024);
+  for (size_t i = 0; i < ks.size(); i++) {
+    a.k_roll.angle_deg = 0.37f * i;
+    b.k_roll.angle_deg = -0.11f * i;
+    computeKneeSample((uint32_t)(i * 20000), a, true, b, true, ks[i]);
+  }
+
+  uint8_t out[BIN_FRAME_LEN];
+  size_t bytes = 0;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) bytes += encodeBinaryFrame(out, (uint16_t)i, ks[i & 1023]);
+  });
+  benchReport("encodeBinaryFrame", ns, "frame");
+  TEST_ASSERT_GREATER_THAN(0, (int)bytes);
+}
+
+static void bench_decimator(void) {
+  ImuState a, b;
+  std::vector<KneeSample> ks(1024);
+  for (size_t i = 0; i < ks.size(); i++) {
+    a.k_roll.angle_deg = 0.37f * i;
+    b.k_roll.angle_deg = -0.11f * i;
+    computeKneeSample((uint32_t)(i * 2000), a, true, b, true, ks[i]);
+  }
+
+  static KneeDecimator d;
+  const uint16_t ratios[2] = {10, 100};
+  for (int r = 0; r < 2; r++) {
+    decimatorInit(d, ratios[r]);
+    KneeSample out;
+    const double ns = benchNsPerOp(N, [&]() {
+      for (size_t i = 0; i < N; i++) {
+        if (decimatorPush(d, ks[i & 1023], out)) benchSink(out.knee_angle);
+      }
+    });
+    char name[40];
+    snprintf(name, sizeof(name), "decimatorPush (1/%u)", (unsigned)ratios[r]);
+    benchReport(name, ns, "input");
+    TEST_ASSERT_GREATER_THAN(0.0, ns);
+  }
+}
+
+static void bench_full_pipeline(void) {
+  ImuState a, b;
+  KneeSample k;
+  char out[TELEMETRY_CSV_MAX];
+  const float dt = 1.0f / FS_HZ;
+  const double ns = benchNsPerOp(N, [&]() {
+    for (size_t i = 0; i < N; i++) {
+      MpuRaw raw;
+      MpuSample s;
+      mpuDecodeBurst(&bursts[i * MPU_BURST_LEN], raw);
+      mpuScale(raw, s);
+      fuseImuSample(a, s, dt);
+      mpuScale(motion[i].shank, s);
+      fuseImuSample(b, s, dt);
+      computeKneeSample((uint32_t)i, a, true, b, true, k);
+      benchSink((float)formatTelemetryCsv(out, sizeof(out), k, 0));
+    }
+  });
+  benchReport("full pipeline (2 IMU + CSV)", ns);
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+}
+
+int main(int, char**) {
+  motion = benchMakeKneeMotion(N, FS_HZ);
+  bursts.resize(N * MPU_BURST_LEN);
+  for (size_t i = 0; i < N; i++) benchEncodeBurst(motion[i].thigh, &bursts[i * MPU_BURST_LEN]);
+
+  UNITY_BEGIN();
+  RUN_TEST(bench_decode_burst);
+  RUN_TEST(bench_fusion);
+  RUN_TEST(bench_knee_angle);
+  RUN_TEST(bench_csv_format);
+  RUN_TEST(bench_labeled_format);
+  RUN_TEST(bench_binary_frame);
+  RUN_TEST(bench_decimator);
+  RUN_TEST(bench_full_pipeline);
+  return UNITY_END();
+}
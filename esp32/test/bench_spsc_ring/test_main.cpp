@@ -0,0 +1,75 @@
+#include <unity.h>
+
+#include <thread>
+
+#include "bench.h"
+#include "fusion.h"
+#include "spsc_ring.h"
+
+/*
+  Benchmark SpscRing: koszt push+pop w jednym wątku oraz przepustowość
+  (próbki/s) przy producencie i konsumencie w osobnych wątkach.
+*/
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static SpscRing<KneeSample, 128> knee_ring;
+static SpscRing<MpuRawPair, 128> raw_ring;
+
+template <typename T, size_t N>
+static double throughputPerSec(SpscRing<T, N>& ring, uint32_t count) {
+  const auto t0 = std::chrono::steady_clock::now();
+  std::thread producer([&]() {
+    T v;
+    for (uint32_t i = 0; i < count; i++) {
+      v.t_us = i;
+      while (!ring.push(v)) std::this_thread::yield();
+    }
+  });
+  T v;
+  uint32_t got = 0;
+  while (got < count) {
+    if (ring.pop(v)) got++;
+    else std::this_thread::yield();
+  }
+  producer.join();
+  const auto t1 = std::chrono::steady_clock::now();
+  benchSink((float)v.t_us);
+  return count / std::chrono::duration<double>(t1 - t0).count();
+}
+
+static void bench_push_pop_single_thread(void) {
+  const size_t n = 4000000;
+  KneeSample k;
+  const double ns = benchNsPerOp(n, [&]() {
+    for (size_t i = 0; i < n; i++) {
+      k.t_us = (uint32_t)i;
+      knee_ring.push(k);
+      knee_ring.pop(k);
+    }
+    benchSink((float)k.t_us);
+  });
+  benchReport("push+pop KneeSample", ns, "op");
+  TEST_ASSERT_GREATER_THAN(0.0, ns);
+}
+
+static void bench_cross_thread_knee(void) {
+  const double sps = throughputPerSec(knee_ring, 1000000);
+  printf("[BENCH] %-28s %10.2f Msamples/s\n", "SPSC KneeSample 2 threads", sps / 1e6);
+  TEST_ASSERT_GREATER_THAN(0.0, sps);
+}
+
+static void bench_cross_thread_raw(void) {
+  const double sps = throughputPerSec(raw_ring, 1000000);
+  printf("[BENCH] %-28s %10.2f Msamples/s\n", "SPSC MpuRawPair 2 threads", sps / 1e6);
+  TEST_ASSERT_GREATER_THAN(0.0, sps);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(bench_push_pop_single_thread);
+  RUN_TEST(bench_cross_thread_knee);
+  RUN_TEST(bench_cross_thread_raw);
+  return UNITY_END();
+}
@@ -0,0 +1,193 @@
+#include <unity.h>
+#include <string.h>
+
+#include "batch_frame.h"
+#include "telemetry.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static KneeSample makeSample(uint32_t i) {
+  KneeSample s;
+  s.t_us = 0xFFFFF000ull + i * 2000u; // czas 64-bit ciągły za granicą 2^32 us
+  s.roll1 = 0.5f * i;
+  s.pitch1 = -3.25f;
+  s.yaw1 = 120.0f;
+  s.roll2 = -60.0f + i;
+  s.pitch2 = 1.0f;
+  s.yaw2 = -179.99f;
+  s.knee_angle = 60.0f + 0.5f * i;
+  s.inv1 = (i & 1) != 0;
+  s.q2 = (i == 3) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  return s;
+}
+
+static void test_full_batch_roundtrip(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 20000);
+  uint8_t out[BATCH_FRAME_MAX];
+  size_t n = 0;
+  for (uint32_t i = 0; i < 10; i++) {
+    n = batcherPush(b, makeSample(i), 1000 + i, out);
+    if (i < 9) TEST_ASSERT_EQUAL_size_t(0, n);
+  }
+  TEST_ASSERT_EQUAL_size_t(batchFrameLen(10), n);
+
+  KneeSample got[10];
+  uint16_t seq = 0xFFFF;
+  TEST_ASSERT_EQUAL_size_t(10, decodeBatchFrame(out, n, seq, got, 10));
+  TEST_ASSERT_EQUAL_UINT16(0, seq);
+  for (uint32_t i = 0; i < 10; i++) {
+    const KneeSample e = makeSample(i);
+    TEST_ASSERT_EQUAL_UINT64(e.t_us, got[i].t_us);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.roll1, got[i].roll1);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.yaw2, got[i].yaw2);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.knee_angle, got[i].knee_angle);
+    TEST_ASSERT_EQUAL(e.inv1, got[i].inv1);
+    TEST_ASSERT_EQUAL_UINT8(e.q2, got[i].q2);
+  }
+}
+
+static void test_latency_ceiling_flushes_partial_batch(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 20000);
+  uint8_t out[BATCH_FRAME_MAX];
+  TEST_ASSERT_EQUAL_size_t(0, batcherPoll(b, 0, out)); // pusta
+  for (uint32_t i = 0; i < 3; i++) batcherPush(b, makeSample(i), 5000 + i * 2000, out);
+  TEST_ASSERT_EQUAL_size_t(0, batcherPoll(b, 5000 + 19999, out));
+  const size_t n = batcherPoll(b, 5000 + 20000, out);
+  TEST_ASSERT_EQUAL_size_t(batchFrameLen(3), n);
+  TEST_ASSERT_EQUAL_UINT32(1, b.latency_flushes);
+
+  KneeSample got[BATCH_K_MAX];
+  uint16_t seq = 0;
+  TEST_ASSERT_EQUAL_size_t(3, decodeBatchFrame(out, n, seq, got, BATCH_K_MAX));
+  TEST_ASSERT_EQUAL_size_t(0, batcherFlush(b, out));
+}
+
+static void test_time_gap_closes_batch(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 1000000);
+  uint8_t out[BATCH_FRAME_MAX];
+  KneeSample a = makeSample(0), c = makeSample(1);
+  c.t_us = a.t_us + 100000; // > uint16
+  TEST_ASSERT_EQUAL_size_t(0, batcherPush(b, a, 0, out));
+  const size_t n = batcherPush(b, c, 1, out);
+  TEST_ASSERT_EQUAL_size_t(batchFrameLen(1), n);
+
+  KneeSample got[2];
+  uint16_t seq = 0;
+  TEST_ASSERT_EQUAL_size_t(1, decodeBatchFrame(out, n, seq, got, 2));
+  TEST_ASSERT_EQUAL_UINT64(a.t_us, got[0].t_us);
+
+  const size_t m = batcherFlush(b, out);
+  TEST_ASSERT_EQUAL_size_t(1, decodeBatchFrame(out, m, seq, got, 2));
+  TEST_ASSERT_EQUAL_UINT16(1, seq);
+  TEST_ASSERT_EQUAL_UINT64(c.t_us, got[0].t_us);
+}
+
+static void test_corrupted_or_truncated_rejected(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 4, 20000);
+  uint8_t out[BATCH_FRAME_MAX];
+  size_t n = 0;
+  for (uint32_t i = 0; i < 4; i++) n = batcherPush(b, makeSample(i), 0, out);
+  KneeSample got[4];
+  uint16_t seq = 0;
+  TEST_ASSERT_EQUAL_size_t(0, decodeBatchFrame(out, n - 1, seq, got, 4));
+  out[20] ^= 0x01;
+  TEST_ASSERT_EQUAL_size_t(0, decodeBatchFrame(out, n, seq, got, 4));
+}
+
+static void test_writes_per_second_at_500hz(void) {
+  // 500 Hz, K = 10, sufit 20 ms: 50 zapisów/s i ~18.4 B/próbkę (ramka pojedyncza: 29 B)
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 20000);
+  uint8_t out[BATCH_FRAME_MAX];
+  size_t writes = 0, bytes = 0;
+  for (uint32_t i = 0; i < 500; i++) {
+    KneeSample s = makeSample(i);
+    size_t n = batcherPush(b, s, i * 2000, out);
+    if (n == 0) n = batcherPoll(b, i * 2000, out);
+    if (n > 0) {
+      writes++;
+      bytes += n;
+    }
+  }
+  TEST_ASSERT_EQUAL_size_t(50, writes);
+  TEST_ASSERT_TRUE((float)bytes / 500 < 0.75f * BIN_FRAME_LEN);
+  TEST_ASSERT_EQUAL_UINT32(0, b.latency_flushes);
+}
+
+static void test_delta_batches_roundtrip_and_resync(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 20000, true);
+  static DeltaFrameDecoder d;
+  deltaFrameDecoderInit(d);
+  uint8_t out[BATCH_OUT_MAX];
+  KneeSample got[BATCH_K_MAX];
+  size_t bytes = 0, decoded = 0;
+  uint32_t frames = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    const size_t n = batcherPush(b, makeSample(i), i * 2000, out);
+    if (n == 0) continue;
+    TEST_ASSERT_EQUAL_UINT8(BATCH_DELTA_SYNC1, out[1]);
+    bytes += n;
+    if (++frames == 7) continue; // paczka 6 (próbki 60..69) utracona
+    uint16_t seq = 0;
+    const size_t m = decodeDeltaFrame(d, out, n, seq, got, BATCH_K_MAX);
+    for (size_t j = 0; j < m; j++) {
+      const KneeSample e = makeSample((got[j].t_us - makeSample(0).t_us) / 2000u);
+      TEST_ASSERT_EQUAL_UINT64(e.t_us, got[j].t_us);
+      TEST_ASSERT_FLOAT_WITHIN(0.005f, e.roll2, got[j].roll2);
+      TEST_ASSERT_FLOAT_WITHIN(0.005f, e.knee_angle, got[j].knee_angle);
+      TEST_ASSERT_EQUAL(e.inv1, got[j].inv1);
+    }
+    decoded += m;
+  }
+  // klatki co 50 próbek: po utracie 60..69 odbiorca czeka do próbki 100
+  TEST_ASSERT_EQUAL_UINT32(1, d.lost_frames);
+  TEST_ASSERT_EQUAL_UINT32(30, d.codec.skipped);
+  TEST_ASSERT_EQUAL_size_t(200 - 10 - 30, decoded);
+  TEST_ASSERT_TRUE((float)bytes / 200 < 0.75f * batchFrameLen(10) / 10);
+
+  batcherPush(b, makeSample(200), 0, out);
+  const size_t n = batcherFlush(b, out);
+  out[9] ^= 0x01;
+  uint16_t seq = 0;
+  TEST_ASSERT_EQUAL_size_t(0, decodeDeltaFrame(d, out, n, seq, got, BATCH_K_MAX));
+  out[9] ^= 0x01;
+  TEST_ASSERT_EQUAL_size_t(1, decodeDeltaFrame(d, out, n, seq, got, BATCH_K_MAX));
+}
+
+static void test_batches_vs_csv_size(void) {
+  // ramka pojedyncza to ~2.3x mniej niż CSV; ~4x dają dopiero paczki
+  static TelemetryBatcher b, d;
+  batcherInit(b, 10, 20000);
+  batcherInit(d, 10, 20000, true);
+  uint8_t out[BATCH_OUT_MAX];
+  char csv[TELEMETRY_CSV_MAX];
+  size_t batch_bytes = 0, delta_bytes = 0, csv_bytes = 0;
+  for (uint32_t i = 0; i < 500; i++) {
+    KneeSample s = makeSample(i % 100);
+    s.t_us = makeSample(0).t_us + i * 2000ull;
+    batch_bytes += batcherPush(b, s, i * 2000, out);
+    delta_bytes += batcherPush(d, s, i * 2000, out);
+    csv_bytes += formatTelemetryCsv(csv, sizeof(csv), s, i);
+  }
+  TEST_ASSERT_TRUE(csv_bytes > 2 * BIN_FRAME_LEN * 500);
+  TEST_ASSERT_TRUE(3 * batch_bytes < csv_bytes);
+  TEST_ASSERT_TRUE(4 * delta_bytes < csv_bytes);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_batch_roundtrip);
+  RUN_TEST(test_latency_ceiling_flushes_partial_batch);
+  RUN_TEST(test_time_gap_closes_batch);
+  RUN_TEST(test_corrupted_or_truncated_rejected);
+  RUN_TEST(test_writes_per_second_at_500hz);
+  RUN_TEST(test_delta_batches_roundtrip_and_resync);
+  RUN_TEST(test_batches_vs_csv_size);
+  return UNITY_END();
+}
@@ -0,0 +1,100 @@
+#include <unity.h>
+#include <math.h>
+
+#include "bias_tracker.h"
+#include "fusion.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const float FS_HZ = 500.0f;
+static const float DT = 1.0f / FS_HZ;
+
+// Szum jednostajny ±amp (deterministyczny LCG)
+static float noise(uint32_t& rng, float amp) {
+  rng = rng * 1664525u + 1013904223u;
+  return ((float)(rng >> 8) / 16777216.0f * 2.0f - 1.0f) * amp;
+}
+
+// Nieruchomy czujnik: surowy żyroskop = bias + szum, a = 1 g (pochylony)
+static MpuSample stillSample(uint32_t& rng, float bx, float by, float bz) {
+  MpuSample s;
+  s.ax = 0.2f + noise(rng, 0.005f);
+  s.ay = 0.0f;
+  s.az = sqrtf(1.0f - 0.04f) + noise(rng, 0.005f);
+  s.gx = bx + noise(rng, 0.2f);
+  s.gy = by + noise(rng, 0.2f);
+  s.gz = bz + noise(rng, 0.2f);
+  return s;
+}
+
+static void test_converges_while_still(void) {
+  ImuState imu;
+  biasTrackerReset(imu.bias, 1.0f);
+  uint32_t rng = 7;
+  const float std0 = biasTrackerStdDps(imu.bias);
+  for (int i = 0; i < (int)(5 * FS_HZ); i++) fuseImuSample(imu, stillSample(rng, 1.2f, -0.8f, 0.5f), DT);
+
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 1.2f, imu.bgx);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, -0.8f, imu.bgy);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.5f, imu.bgz);
+  TEST_ASSERT_TRUE(imu.bias.updates >= 15);
+  TEST_ASSERT_TRUE(imu.bias.still);
+  TEST_ASSERT_TRUE(biasTrackerStdDps(imu.bias) < 0.2f * std0);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, biasTrackerStillPct(imu.bias));
+}
+
+static void test_motion_does_not_update(void) {
+  ImuState imu;
+  imu.bgx = 0.3f;
+  biasTrackerReset(imu.bias, 0.1f);
+  for (int i = 0; i < (int)(4 * FS_HZ); i++) {
+    // zgięcia kolana ~1 Hz: duże prędkości i przyspieszenia
+    const float ph = 2.0f * 3.14159265f * (float)i * DT;
+    MpuSample s;
+    s.gx = 120.0f * sinf(ph);
+    s.ax = 0.3f * cosf(ph);
+    s.az = 1.0f + 0.2f * sinf(2.0f * ph);
+    fuseImuSample(imu, s, DT);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, imu.bias.updates);
+  TEST_ASSERT_EQUAL_FLOAT(0.3f, imu.bgx);
+  TEST_ASSERT_TRUE(imu.bias.windows >= 15);
+  TEST_ASSERT_TRUE(biasTrackerStdDps(imu.bias) > 0.1f); // niepewność rośnie bez pomiarów
+}
+
+static void test_slow_rotation_rejected_by_gate(void) {
+  BiasTracker t;
+  biasTrackerReset(t, 0.05f);
+  float corr[3];
+  int updates = 0;
+  for (int i = 0; i < (int)(3 * FS_HZ); i++) {
+    // jednostajny obrót 5 dps: mała wariancja, ale reszta daleko poza bramką
+    if (biasTrackerPush(t, 5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, DT, corr)) updates++;
+  }
+  TEST_ASSERT_EQUAL_INT(0, updates);
+  TEST_ASSERT_TRUE(t.rejected >= 10);
+  TEST_ASSERT_EQUAL_UINT32(t.rejected, t.still_windows);
+}
+
+static void test_reduces_yaw_drift(void) {
+  // bias z kalibracji startowej przesunął się o 0.6 dps (temperatura)
+  ImuState tracked, fixed;
+  fixed.bias.enabled = false;
+  uint32_t rng1 = 99, rng2 = 99;
+  for (int i = 0; i < (int)(60 * FS_HZ); i++) {
+    fuseImuSample(tracked, stillSample(rng1, 0.0f, 0.0f, 0.6f), DT);
+    fuseImuSample(fixed, stillSample(rng2, 0.0f, 0.0f, 0.6f), DT);
+  }
+  TEST_ASSERT_TRUE(fabsf(fixed.yaw) > 30.0f);   // 0.6 dps * 60 s
+  TEST_ASSERT_TRUE(fabsf(tracked.yaw) < 1.0f);  // poprawione po ~1 s
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_converges_while_still);
+  RUN_TEST(test_motion_does_not_update);
+  RUN_TEST(test_slow_rotation_rejected_by_gate);
+  RUN_TEST(test_reduces_yaw_drift);
+  return UNITY_END();
+}
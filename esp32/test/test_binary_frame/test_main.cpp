@@ -0,0 +1,134 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+
+#include "binary_frame.h"
+#include "telemetry.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static KneeSample makeSample() {
+  KneeSample k;
+  k.t_us = 0x12DEADBEEFull; // po zawinięciu 32-bitowego micros()
+  k.roll1 = 1.234f;
+  k.pitch1 = -2.5f;
+  k.yaw1 = 179.99f;
+  k.roll2 = -180.0f;
+  k.pitch2 = 0.004f;
+  k.yaw2 = -0.006f;
+  k.knee_angle = 43.77f;
+  k.inv1 = false;
+  k.inv2 = true;
+  k.q2 = QUALITY_GYRO_ONLY;
+  return k;
+}
+
+static void test_crc_reference_vector(void) {
+  const uint8_t msg[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16Ccitt(msg, sizeof(msg)));
+}
+
+static void test_roundtrip(void) {
+  uint8_t frame[BIN_FRAME_LEN];
+  TEST_ASSERT_EQUAL_size_t(BIN_FRAME_LEN, encodeBinaryFrame(frame, 0xBEEF, makeSample()));
+  TEST_ASSERT_EQUAL_HEX8(BIN_SYNC0, frame[0]);
+  TEST_ASSERT_EQUAL_HEX8(BIN_SYNC1, frame[1]);
+
+  uint16_t seq = 0;
+  KneeSample k;
+  TEST_ASSERT_TRUE(decodeBinaryFrame(frame, seq, k));
+  TEST_ASSERT_EQUAL_HEX16(0xBEEF, seq);
+  TEST_ASSERT_EQUAL_UINT64(0x12DEADBEEFull, k.t_us);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 1.234f, k.roll1);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -2.5f, k.pitch1);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 179.99f, k.yaw1);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -180.0f, k.roll2);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.0f, k.pitch2);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, -0.01f, k.yaw2);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 43.77f, k.knee_angle);
+  TEST_ASSERT_FALSE(k.inv1);
+  TEST_ASSERT_TRUE(k.inv2);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_MEASURED, k.q1);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_GYRO_ONLY, k.q2);
+  TEST_ASSERT_EQUAL_HEX8(BIN_FLAG_INV2 | BIN_FLAG_GAP2, frame[26] & 0x0F);
+}
+
+static void test_invalid_angle_and_saturation(void) {
+  TEST_ASSERT_EQUAL_INT16(BIN_ANGLE_INVALID, binEncodeAngle(ANGLE_INVALID));
+  TEST_ASSERT_EQUAL_FLOAT(ANGLE_INVALID, binDecodeAngle(BIN_ANGLE_INVALID));
+  TEST_ASSERT_EQUAL_INT16(32767, binEncodeAngle(400.0f));
+  TEST_ASSERT_EQUAL_INT16(-32767, binEncodeAngle(-400.0f));
+  TEST_ASSERT_EQUAL_INT16(32767, binEncodeAngle(327.669f));
+  TEST_ASSERT_EQUAL_INT16(-32767, binEncodeAngle(-327.675f));
+  TEST_ASSERT_EQUAL_INT16(BIN_ANGLE_INVALID, binEncodeAngle(NAN));
+  TEST_ASSERT_EQUAL_INT16(BIN_ANGLE_INVALID, binEncodeAngle(INFINITY));
+  TEST_ASSERT_EQUAL_INT16(BIN_ANGLE_INVALID, binEncodeAngle(-INFINITY));
+
+  KneeSample s = makeSample();
+  s.roll1 = s.pitch1 = s.yaw1 = s.knee_angle = ANGLE_INVALID;
+  s.q1 = QUALITY_INVALID;
+  uint8_t frame[BIN_FRAME_LEN];
+  encodeBinaryFrame(frame, 1, s);
+  uint16_t seq = 0;
+  KneeSample k;
+  TEST_ASSERT_TRUE(decodeBinaryFrame(frame, seq, k));
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_INVALID, k.q1);
+}
+
+static void test_corrupted_frame_rejected(void) {
+  uint8_t frame[BIN_FRAME_LEN];
+  encodeBinaryFrame(frame, 7, makeSample());
+  uint16_t seq;
+  KneeSample k;
+  for (size_t i = 0; i < BIN_FRAME_LEN; i++) {
+    uint8_t bad[BIN_FRAME_LEN];
+    memcpy(bad, frame, sizeof(bad));
+    bad[i] ^= 0x10;
+    TEST_ASSERT_FALSE(decodeBinaryFrame(bad, seq, k));
+  }
+}
+
+static void test_parser_resyncs_after_garbage(void) {
+  uint8_t stream[3 * BIN_FRAME_LEN + 16];
+  size_t n = 0;
+  const uint8_t junk[] = {0x00, 0xAA, 0x13, 0xAA, 0x55, 0x01, '\n'};
+  memcpy(stream + n, junk, sizeof(junk));
+  n += sizeof(junk);
+  n += encodeBinaryFrame(stream + n, 1, makeSample());
+  const size_t broken = n;
+  n += encodeBinaryFrame(stream + n, 2, makeSample());
+  stream[broken + 10] ^= 0xFF; // zepsuta ramka nr 2
+  n += encodeBinaryFrame(stream + n, 3, makeSample());
+
+  BinFrameParser p;
+  uint16_t seqs[4];
+  int got = 0;
+  for (size_t i = 0; i < n; i++) {
+    uint16_t seq;
+    KneeSample k;
+    if (binFrameParserFeed(p, stream[i], seq, k) && got < 4) seqs[got++] = seq;
+  }
+  TEST_ASSERT_EQUAL_INT(2, got);
+  TEST_ASSERT_EQUAL_UINT16(1, seqs[0]);
+  TEST_ASSERT_EQUAL_UINT16(3, seqs[1]);
+  TEST_ASSERT_EQUAL_UINT32(2, p.frames_ok);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, p.crc_errors);
+}
+
+static void test_smaller_than_csv(void) {
+  char csv[TELEMETRY_CSV_MAX];
+  const size_t csv_len = formatTelemetryCsv(csv, sizeof(csv), makeSample(), 7);
+  TEST_ASSERT_LESS_THAN(csv_len / 2, BIN_FRAME_LEN);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_reference_vector);
+  RUN_TEST(test_roundtrip);
+  RUN_TEST(test_invalid_angle_and_saturation);
+  RUN_TEST(test_corrupted_frame_rejected);
+  RUN_TEST(test_parser_resyncs_after_garbage);
+  RUN_TEST(test_smaller_than_csv);
+  return UNITY_END();
+}
@@ -0,0 +1,72 @@
+#include <unity.h>
+
+#include "bus_recovery.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_recovery_after_consecutive_failures(void) {
+  BusLink l;
+  TEST_ASSERT_FALSE(linkDown(l));
+  TEST_ASSERT_FALSE(linkOnFailure(l, 1000));
+  TEST_ASSERT_FALSE(linkOnFailure(l, 5000));
+  TEST_ASSERT_TRUE(linkDown(l));
+  TEST_ASSERT_TRUE(linkOnFailure(l, 9000)); // próg BUS_FAILS_BEFORE_RECOVERY
+  TEST_ASSERT_EQUAL_UINT16(1, l.attempts);
+
+  // pojedynczy błąd przerwany sukcesem nie uruchamia odzyskiwania
+  BusLink m;
+  TEST_ASSERT_FALSE(linkOnFailure(m, 0));
+  TEST_ASSERT_TRUE(linkOnSuccess(m, 4000));
+  TEST_ASSERT_FALSE(linkOnFailure(m, 8000));
+  TEST_ASSERT_FALSE(linkOnFailure(m, 12000));
+}
+
+static void test_backoff_doubles_and_saturates(void) {
+  BusLink l;
+  uint32_t t = 0;
+  for (int i = 0; i < BUS_FAILS_BEFORE_RECOVERY; i++) linkOnFailure(l, t);
+
+  // kolejne próby dokładnie po 20, 40, 80 ... ms, potem co BUS_BACKOFF_MAX_US
+  uint32_t expected = BUS_BACKOFF_MIN_US;
+  for (int attempt = 0; attempt < 12; attempt++) {
+    TEST_ASSERT_FALSE(linkOnFailure(l, t + expected - 1));
+    t += expected;
+    TEST_ASSERT_TRUE(linkOnFailure(l, t));
+    expected = expected * 2 > BUS_BACKOFF_MAX_US ? BUS_BACKOFF_MAX_US : expected * 2;
+  }
+  TEST_ASSERT_EQUAL_UINT32(BUS_BACKOFF_MAX_US, l.backoff_us);
+  TEST_ASSERT_EQUAL_UINT32(13, l.recover_attempts);
+}
+
+static void test_time_to_recover_and_wraparound(void) {
+  BusLink l;
+  const uint32_t t0 = 0xFFFFF000u; // awaria przez przepełnienie micros()
+  for (int i = 0; i < 3; i++) linkOnFailure(l, t0 + i * 1000);
+  TEST_ASSERT_FALSE(linkOnFailure(l, t0 + 10000)); // backoff liczony przez zawinięcie
+  TEST_ASSERT_TRUE(linkOnSuccess(l, t0 + 150000));
+  TEST_ASSERT_EQUAL_UINT32(150000, l.last_recover_us);
+  TEST_ASSERT_EQUAL_UINT32(150000, l.max_recover_us);
+  TEST_ASSERT_EQUAL_UINT32(1, l.outages);
+  TEST_ASSERT_FALSE(linkDown(l));
+  TEST_ASSERT_FALSE(linkOnSuccess(l, t0 + 160000));
+
+  // nowa awaria zaczyna od minimalnego backoff
+  for (int i = 0; i < 3; i++) linkOnFailure(l, 1000);
+  TEST_ASSERT_EQUAL_UINT32(2 * BUS_BACKOFF_MIN_US, l.backoff_us);
+  linkOnSuccess(l, 51000);
+  TEST_ASSERT_EQUAL_UINT32(50000, l.last_recover_us);
+  TEST_ASSERT_EQUAL_UINT32(150000, l.max_recover_us);
+
+  linkResetStats(l);
+  TEST_ASSERT_EQUAL_UINT32(0, l.outages);
+  TEST_ASSERT_EQUAL_UINT32(0, l.max_recover_us);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_recovery_after_consecutive_failures);
+  RUN_TEST(test_backoff_doubles_and_saturates);
+  RUN_TEST(test_time_to_recover_and_wraparound);
+  return UNITY_END();
+}
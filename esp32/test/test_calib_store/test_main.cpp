@@ -0,0 +1,162 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+
+#include "calib_store.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Próbka nieruchomego czujnika: bias + szum ±noise (deterministyczny LCG), a = 1 g.
+static MpuSample stillSample(uint32_t& rng, float bx, float by, float bz, float noise) {
+  float r[3];
+  for (int i = 0; i < 3; i++) {
+    rng = rng * 1664525u + 1013904223u;
+    r[i] = ((float)(rng >> 8) / 16777216.0f * 2.0f - 1.0f) * noise;
+  }
+  MpuSample s;
+  s.ax = 0.01f;
+  s.ay = -0.02f;
+  s.az = 1.0f + r[0] * 0.01f;
+  s.gx = bx + r[0];
+  s.gy = by + r[1];
+  s.gz = bz + r[2];
+  return s;
+}
+
+static void fillStill(GyroCalib& c, int n, float bx, float by, float bz) {
+  uint32_t rng = 12345;
+  for (int i = 0; i < n; i++) gyroCalibPush(c, stillSample(rng, bx, by, bz, 0.15f));
+}
+
+static void test_mean_and_stillness(void) {
+  GyroCalib c;
+  fillStill(c, CAL_SAMPLES, 1.5f, -0.7f, 0.3f);
+  TEST_ASSERT_EQUAL_UINT32(CAL_SAMPLES, c.n);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 1.5f, c.g_mean[0]);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, -0.7f, c.g_mean[1]);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.3f, c.g_mean[2]);
+  TEST_ASSERT_FLOAT_WITHIN(0.03f, 0.15f / sqrtf(3.0f), gyroCalibGyroStd(c, 0)); // rozkład jednostajny
+  TEST_ASSERT_TRUE(gyroCalibStill(c));
+
+  // ruch nogi: kilkadziesiąt dps w kilku próbkach
+  for (int i = 0; i < 20; i++) {
+    MpuSample s;
+    s.az = 1.3f;
+    s.gx = 40.0f;
+    gyroCalibPush(c, s);
+  }
+  TEST_ASSERT_FALSE(gyroCalibStill(c));
+
+  GyroCalib few;
+  fillStill(few, 10, 0, 0, 0);
+  TEST_ASSERT_FALSE(gyroCalibStill(few)); // za mało próbek
+}
+
+static void test_record_roundtrip_and_rejects(void) {
+  CalibRecord r;
+  r.flags = CAL_HAS_BIAS | CAL_HAS_MOUNT;
+  r.imu[0].bgx = 1.25f;
+  r.imu[0].off_roll = -12.5f;
+  r.imu[1].bgz = -3.0f;
+  r.imu[1].off_pitch = 45.0f;
+
+  uint8_t buf[CAL_RECORD_LEN];
+  TEST_ASSERT_EQUAL_size_t(CAL_RECORD_LEN, calibRecordEncode(r, buf));
+  CalibRecord d;
+  TEST_ASSERT_TRUE(calibRecordDecode(buf, sizeof(buf), d));
+  TEST_ASSERT_EQUAL_HEX8(CAL_HAS_BIAS | CAL_HAS_MOUNT, d.flags);
+  TEST_ASSERT_EQUAL_FLOAT(1.25f, d.imu[0].bgx);
+  TEST_ASSERT_EQUAL_FLOAT(-12.5f, d.imu[0].off_roll);
+  TEST_ASSERT_EQUAL_FLOAT(-3.0f, d.imu[1].bgz);
+  TEST_ASSERT_EQUAL_FLOAT(45.0f, d.imu[1].off_pitch);
+
+  TEST_ASSERT_FALSE(calibRecordDecode(buf, sizeof(buf) - 1, d));
+  for (size_t i = 0; i < CAL_RECORD_LEN; i++) {
+    uint8_t bad[CAL_RECORD_LEN];
+    memcpy(bad, buf, sizeof(bad));
+    bad[i] ^= 0x04;
+    TEST_ASSERT_FALSE(calibRecordDecode(bad, sizeof(bad), d));
+  }
+
+  // poprawne CRC, ale bias poza zakresem czujnika / NaN
+  r.imu[1].bgy = 200.0f;
+  calibRecordEncode(r, buf);
+  TEST_ASSERT_FALSE(calibRecordDecode(buf, sizeof(buf), d));
+  r.imu[1].bgy = NAN;
+  calibRecordEncode(r, buf);
+  TEST_ASSERT_FALSE(calibRecordDecode(buf, sizeof(buf), d));
+}
+
+static void test_boot_decision(void) {
+  ImuCalib stored;
+  stored.bgx = 1.5f;
+  stored.bgy = -0.7f;
+  stored.bgz = 0.3f;
+
+  // nieruchomo, bias bez zmian -> zapisany już po oknie sprawdzającym
+  GyroCalib c;
+  fillStill(c, CAL_CHECK_SAMPLES, 1.6f, -0.7f, 0.3f);
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_STORED, calibBootDecide(c, &stored, false));
+
+  // nieruchomo, bias przesunięty (temperatura) albo brak zapisu -> pełny przebieg
+  GyroCalib drift;
+  fillStill(drift, CAL_CHECK_SAMPLES, 3.0f, -0.7f, 0.3f);
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_CONTINUE, calibBootDecide(drift, &stored, false));
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_CONTINUE, calibBootDecide(c, nullptr, false));
+  fillStill(drift, CAL_SAMPLES - CAL_CHECK_SAMPLES, 3.0f, -0.7f, 0.3f);
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_FRESH, calibBootDecide(drift, &stored, true));
+
+  // ruch: zapisany bias wygrywa; bez zapisu – średnia z ruchu, oznaczona
+  GyroCalib moving;
+  for (int i = 0; i < CAL_CHECK_SAMPLES; i++) {
+    MpuSample s;
+    s.az = 1.0f;
+    s.gx = (i & 1) ? 30.0f : -30.0f;
+    gyroCalibPush(moving, s);
+  }
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_STORED, calibBootDecide(moving, &stored, false));
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_CONTINUE, calibBootDecide(moving, nullptr, false));
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_MOVING, calibBootDecide(moving, nullptr, true));
+
+  GyroCalib none;
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_STORED, calibBootDecide(none, &stored, true));
+  TEST_ASSERT_EQUAL_UINT8(CAL_BOOT_CONTINUE, calibBootDecide(none, nullptr, true));
+}
+
+static void test_apply_to_imu_state(void) {
+  ImuState imu;
+  imu.off_roll = 10.0f;
+  imu.off_pitch = -5.0f;
+  imu.bgx = 0.5f;
+  ImuCalib c;
+  imuCalibFromState(imu, c);
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, c.bgx);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, c.off_roll);
+
+  ImuState fresh;
+  fresh.off_yaw = 33.0f;
+  imuCalibApplyMount(fresh, c);
+  imuCalibApplyBias(fresh, c);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, fresh.off_roll);
+  TEST_ASSERT_EQUAL_FLOAT(-5.0f, fresh.off_pitch);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, fresh.off_yaw);
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, fresh.bgx);
+
+  // q_off zgodny z przełączeniem silnika na kwaternion (ta sama konwencja)
+  ImuState q = fresh;
+  setFusionEngine(q, FUSION_MADGWICK);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, q.q_off.w, fresh.q_off.w);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, q.q_off.x, fresh.q_off.x);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, q.q_off.y, fresh.q_off.y);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, q.q_off.z, fresh.q_off.z);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_mean_and_stillness);
+  RUN_TEST(test_record_roundtrip_and_rejects);
+  RUN_TEST(test_boot_decision);
+  RUN_TEST(test_apply_to_imu_state);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <unity.h>
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "command.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct Calls {
+  int  calib = 0;
+  long rate  = -1;
+  int  argc  = 0;
+  char last[CMD_LINE_MAX + 1];
+};
+
+static bool cmdCalib(int argc, const char* const*, void* ctx) {
+  Calls& c = *(Calls*)ctx;
+  c.calib++;
+  c.argc = argc;
+  return true;
+}
+
+static bool cmdRate(int argc, const char* const* argv, void* ctx) {
+  Calls& c = *(Calls*)ctx;
+  c.argc = argc;
+  long v = 0;
+  if (!cmdParseInt(argv[1], v) || v < 4 || v > 1000) return false;
+  c.rate = v;
+  return true;
+}
+
+static bool cmdEcho(int argc, const char* const* argv, void* ctx) {
+  Calls& c = *(Calls*)ctx;
+  c.argc = argc;
+  strcpy(c.last, argv[argc - 1]);
+  return true;
+}
+
+static const CmdEntry TABLE[] = {
+  {"calib", 0, 0, cmdCalib, ""},
+  {"rate",  1, 1, cmdRate,  "<4..1000>"},
+  {"echo",  1, 3, cmdEcho,  "<a> [b] [c]"},
+};
+static const size_t TABLE_LEN = sizeof(TABLE) / sizeof(TABLE[0]);
+
+// Podanie całego tekstu; zwraca wynik ostatniej kompletnej linii.
+static CmdResult feed(CmdLineBuffer& lb, const char* text, Calls& calls,
+                      const CmdEntry** entry = nullptr, const char** argv0 = nullptr) {
+  CmdResult r = CMD_EMPTY;
+  for (const char* p = text; *p; p++) {
+    if (cmdLineFeed(lb, *p)) r = cmdDispatch(TABLE, TABLE_LEN, lb, &calls, entry, argv0);
+  }
+  return r;
+}
+
+static void test_line_buffer_crlf_and_case(void) {
+  CmdLineBuffer lb;
+  Calls calls;
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "CALIB\r\n", calls));
+  TEST_ASSERT_EQUAL(1, calls.calib);
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "  calib  \n\n\r", calls));
+  TEST_ASSERT_EQUAL(2, calls.calib);
+
+  // linia rozłożona na kilka porcji z transportu
+  TEST_ASSERT_EQUAL(CMD_EMPTY, feed(lb, "ca", calls));
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "lib\n", calls));
+  TEST_ASSERT_EQUAL(3, calls.calib);
+}
+
+static void test_arguments_and_validation(void) {
+  CmdLineBuffer lb;
+  Calls calls;
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "rate 250\n", calls));
+  TEST_ASSERT_EQUAL(250, calls.rate);
+  TEST_ASSERT_EQUAL(2, calls.argc);
+
+  const CmdEntry* e = nullptr;
+  TEST_ASSERT_EQUAL(CMD_BAD_ARGS, feed(lb, "rate 5000\n", calls, &e));
+  TEST_ASSERT_EQUAL_STRING("<4..1000>", e->usage);
+  TEST_ASSERT_EQUAL(CMD_BAD_ARGS, feed(lb, "rate abc\n", calls));
+  TEST_ASSERT_EQUAL(CMD_BAD_ARGS, feed(lb, "rate\n", calls));
+  TEST_ASSERT_EQUAL(CMD_BAD_ARGS, feed(lb, "rate 1 2\n", calls));
+  TEST_ASSERT_EQUAL(CMD_BAD_ARGS, feed(lb, "calib now\n", calls));
+  TEST_ASSERT_EQUAL(250, calls.rate);
+
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "echo\tA  b c\n", calls));
+  TEST_ASSERT_EQUAL(4, calls.argc);
+  TEST_ASSERT_EQUAL_STRING("c", calls.last);
+}
+
+static void test_unknown_empty_and_too_long(void) {
+  CmdLineBuffer lb;
+  Calls calls;
+  const char* name = nullptr;
+  TEST_ASSERT_EQUAL(CMD_UNKNOWN, feed(lb, "Reboot now\n", calls, nullptr, &name));
+  TEST_ASSERT_EQUAL_STRING("reboot", name);
+  TEST_ASSERT_EQUAL(CMD_EMPTY, feed(lb, "   \n", calls));
+
+  char longline[CMD_LINE_MAX + 20];
+  memset(longline, 'x', sizeof(longline));
+  longline[sizeof(longline) - 2] = '\n';
+  longline[sizeof(longline) - 1] = '\0';
+  TEST_ASSERT_EQUAL(CMD_TOO_LONG, feed(lb, longline, calls));
+
+  // następna linia działa normalnie
+  TEST_ASSERT_EQUAL(CMD_OK, feed(lb, "calib\n", calls));
+  TEST_ASSERT_EQUAL(1, calls.calib);
+}
+
+static void test_tokenize_in_place(void) {
+  char line[] = "  a bb   ccc dddd eeeee  ";
+  const char* argv[3];
+  TEST_ASSERT_EQUAL(3, cmdTokenize(line, argv, 3));
+  TEST_ASSERT_EQUAL_STRING("a", argv[0]);
+  TEST_ASSERT_EQUAL_STRING("bb", argv[1]);
+  TEST_ASSERT_EQUAL_STRING("ccc dddd eeeee", argv[2]); // reszta w ostatnim tokenie
+  TEST_ASSERT_TRUE(argv[0] >= line && argv[2] < line + sizeof(line));
+}
+
+static void test_parse_int(void) {
+  long v = 0;
+  TEST_ASSERT_TRUE(cmdParseInt("-42", v));
+  TEST_ASSERT_EQUAL(-42, v);
+  TEST_ASSERT_FALSE(cmdParseInt("", v));
+  TEST_ASSERT_FALSE(cmdParseInt("12x", v));
+  TEST_ASSERT_FALSE(cmdParseInt(nullptr, v));
+  // poza zakresem long (także 64-bit): odrzucone, a nie nasycone
+  TEST_ASSERT_FALSE(cmdParseInt("99999999999999999999999", v));
+  TEST_ASSERT_FALSE(cmdParseInt("-99999999999999999999999", v));
+  TEST_ASSERT_EQUAL(-42, v);
+  char max[24];
+  snprintf(max, sizeof(max), "%ld", LONG_MAX);
+  TEST_ASSERT_TRUE(cmdParseInt(max, v));
+  TEST_ASSERT_TRUE(v == LONG_MAX);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_line_buffer_crlf_and_case);
+  RUN_TEST(test_arguments_and_validation);
+  RUN_TEST(test_unknown_empty_and_too_long);
+  RUN_TEST(test_tokenize_in_place);
+  RUN_TEST(test_parse_int);
+  return UNITY_END();
+}
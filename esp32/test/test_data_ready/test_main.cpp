@@ -0,0 +1,66 @@
+#include <unity.h>
+
+#include "data_ready.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_stamps_ring(void) {
+  DrdyStamps d;
+  uint64_t t = 0;
+  TEST_ASSERT_FALSE(drdyStampAt(d, 0, t)); // jeszcze bez przerwań
+  TEST_ASSERT_FALSE(drdyStampAt(d, (uint32_t)-3, t)); // indeks "przed startem" (INT niepodłączony)
+  for (uint32_t i = 0; i < 100; i++) drdyStamp(d, 1000 + 2000ull * i);
+  TEST_ASSERT_EQUAL_UINT32(100, d.count);
+  TEST_ASSERT_TRUE(drdyStampAt(d, 99, t));
+  TEST_ASSERT_EQUAL_UINT64(1000 + 2000ull * 99, t);
+  TEST_ASSERT_TRUE(drdyStampAt(d, 100 - DRDY_STAMPS / 2, t));
+  TEST_ASSERT_FALSE(drdyStampAt(d, 100 - DRDY_STAMPS / 2 - 1, t)); // może być nadpisany
+  TEST_ASSERT_FALSE(drdyStampAt(d, 100, t));
+}
+
+// Ramka k FIFO = przerwanie base + k; niezgodna liczba ramek koryguje base.
+static void test_fifo_index_and_resync(void) {
+  DrdyFifo f;
+  drdyFifoStart(f, 10);
+  TEST_ASSERT_TRUE(drdyFifoSync(f, 12, 12, 2));
+  TEST_ASSERT_EQUAL_UINT32(10, drdyFifoIndex(f, 0));
+  drdyFifoConsume(f, 2);
+  TEST_ASSERT_EQUAL_UINT32(12, drdyFifoIndex(f, 0));
+
+  // start FIFO tuż po próbce, której przerwanie policzono już po starcie: 1 ramka mniej
+  TEST_ASSERT_FALSE(drdyFifoSync(f, 15, 15, 2));
+  TEST_ASSERT_EQUAL_UINT32(1, f.resyncs);
+  TEST_ASSERT_EQUAL_UINT32(13, drdyFifoIndex(f, 0));
+  drdyFifoConsume(f, 2);
+  TEST_ASSERT_TRUE(drdyFifoSync(f, 17, 17, 2));
+
+  // przerwanie w trakcie odczytu: bez oceny
+  TEST_ASSERT_TRUE(drdyFifoSync(f, 17, 18, 5));
+  TEST_ASSERT_EQUAL_UINT32(1, f.resyncs);
+}
+
+static void test_jitter_against_mean_period(void) {
+  DrdyJitter j;
+  uint32_t dev = 0;
+  TEST_ASSERT_FALSE(drdyJitterUpdate(j, 0, 1000, dev));
+  TEST_ASSERT_FALSE(drdyJitterUpdate(j, 1, 3010, dev)); // pierwsza średnia
+  TEST_ASSERT_TRUE(drdyJitterUpdate(j, 2, 5020, dev));
+  TEST_ASSERT_EQUAL_UINT32(0, dev); // zegar czujnika 0.5% wolniej – bez rozrzutu
+  TEST_ASSERT_TRUE(drdyJitterUpdate(j, 3, 7050, dev));
+  TEST_ASSERT_EQUAL_UINT32(20, dev);
+  TEST_ASSERT_TRUE(drdyJitterUpdate(j, 4, 9040, dev));
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 2010.0f, j.period_us);
+
+  // przerwa w numeracji (wpisy nadpisane): nowy punkt startu bez oceny
+  TEST_ASSERT_FALSE(drdyJitterUpdate(j, 10, 21100, dev));
+  TEST_ASSERT_TRUE(drdyJitterUpdate(j, 11, 23110, dev));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_stamps_ring);
+  RUN_TEST(test_fifo_index_and_resync);
+  RUN_TEST(test_jitter_against_mean_period);
+  return UNITY_END();
+}
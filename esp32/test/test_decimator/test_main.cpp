@@ -0,0 +1,182 @@
+#include <unity.h>
+
+#include <math.h>
+
+#include "decimator.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const float FS_HZ = 500.0f;
+static const uint32_t PERIOD_US = 2000;
+
+static KneeSample makeSample(uint32_t i, float v) {
+  KneeSample s;
+  s.t_us = i * PERIOD_US;
+  s.roll1 = s.pitch1 = s.yaw1 = v;
+  s.roll2 = s.pitch2 = s.yaw2 = -v;
+  s.knee_angle = 45.0f + v;
+  return s;
+}
+
+static void test_ratio_one_is_passthrough(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 1);
+  KneeSample out;
+  const KneeSample in = makeSample(7, 12.5f);
+  TEST_ASSERT_TRUE(decimatorPush(d, in, out));
+  TEST_ASSERT_EQUAL_UINT64(in.t_us, out.t_us);
+  TEST_ASSERT_EQUAL_FLOAT(12.5f, out.roll1);
+}
+
+static void test_output_rate_and_dc_gain(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  TEST_ASSERT_EQUAL_UINT16(10, d.ratio);
+  int outputs = 0;
+  KneeSample out;
+  for (uint32_t i = 0; i < 1000; i++) {
+    if (!decimatorPush(d, makeSample(i, 30.0f), out)) continue;
+    outputs++;
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 30.0f, out.roll1);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, -30.0f, out.yaw2);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 75.0f, out.knee_angle);
+  }
+  TEST_ASSERT_EQUAL(100 - 6, outputs); // bez wyjść do wypełnienia okna (61 próbek)
+}
+
+// Pierwsze wyjście nie wcześniej niż pierwsze wejście, czasy ściśle rosnące.
+static void test_timestamps_start_after_first_input(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  KneeSample out;
+  uint64_t prev = 0;
+  for (uint32_t i = 0; i < 500; i++) {
+    KneeSample s = makeSample(i, 5.0f);
+    s.t_us += 1000000;
+    if (!decimatorPush(d, s, out)) continue;
+    TEST_ASSERT_TRUE(out.t_us >= 1000000);
+    TEST_ASSERT_TRUE(out.t_us > prev);
+    prev = out.t_us;
+  }
+  TEST_ASSERT_TRUE(prev > 0);
+}
+
+// Amplituda wyjścia dla sinusoidy f_hz (po ustaleniu się filtra).
+static float outputAmplitude(uint16_t ratio, float f_hz, float amp) {
+  static KneeDecimator d;
+  decimatorInit(d, ratio);
+  KneeSample out;
+  float peak = 0;
+  for (uint32_t i = 0; i < 20000; i++) {
+    const float v = amp * sinf(2.0f * 3.14159265f * f_hz * i / FS_HZ);
+    if (decimatorPush(d, makeSample(i, v), out) && i > 2000) {
+      if (fabsf(out.pitch1) > peak) peak = fabsf(out.pitch1);
+    }
+  }
+  return peak;
+}
+
+static void test_alias_band_is_attenuated(void) {
+  // 45 Hz przy 500 -> 50 Hz: zwykłe próbkowanie co 10. próbkę daje alias 5 Hz
+  TEST_ASSERT_TRUE(outputAmplitude(10, 45.0f, 20.0f) < 0.1f);
+  TEST_ASSERT_TRUE(outputAmplitude(10, 55.0f, 20.0f) < 0.1f);
+  // pasmo ruchu (2 Hz) przechodzi bez zmian amplitudy
+  TEST_ASSERT_FLOAT_WITHIN(0.2f, 20.0f, outputAmplitude(10, 2.0f, 20.0f));
+}
+
+static void test_timestamp_compensates_group_delay(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  KneeSample out;
+  float max_err = 0;
+  for (uint32_t i = 0; i < 5000; i++) {
+    const float v = 20.0f * sinf(2.0f * 3.14159265f * 1.0f * i / FS_HZ);
+    if (!decimatorPush(d, makeSample(i, v), out) || i < 500) continue;
+    const float truth = 20.0f * sinf(2.0f * 3.14159265f * 1.0f * (out.t_us * 1e-6f));
+    if (fabsf(out.roll1 - truth) > max_err) max_err = fabsf(out.roll1 - truth);
+  }
+  TEST_ASSERT_TRUE(max_err < 0.1f);
+}
+
+static void test_wraps_through_180(void) {
+  // roll rośnie 0.5°/próbkę przez kilka obrotów: wyjście ciągłe, zawinięte do ±180
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  KneeSample out;
+  for (uint32_t i = 0; i < 10000; i++) {
+    KneeSample s = makeSample(i, 0.0f);
+    s.roll1 = wrap180(170.0f + 0.5f * i);
+    if (!decimatorPush(d, s, out) || i < 100) continue;
+    const float truth = wrap180(170.0f + 0.5f * (out.t_us / PERIOD_US));
+    TEST_ASSERT_TRUE(out.roll1 >= -180.0f && out.roll1 <= 180.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, angleDiffDeg(out.roll1, truth));
+  }
+}
+
+static void test_invalid_samples_propagate_and_recover(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  KneeSample out;
+  int invalid_outputs = 0, valid_after = 0;
+  for (uint32_t i = 0; i < 2000; i++) {
+    KneeSample s = makeSample(i, 10.0f);
+    if (i >= 1000 && i < 1005) s.roll2 = ANGLE_INVALID;
+    if (!decimatorPush(d, s, out)) continue;
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 10.0f, out.roll1); // inne kanały bez zmian
+    if (out.roll2 == ANGLE_INVALID) invalid_outputs++;
+    else if (i > 1100) {
+      valid_after++;
+      TEST_ASSERT_FLOAT_WITHIN(1e-3f, -10.0f, out.roll2);
+    }
+  }
+  TEST_ASSERT_TRUE(invalid_outputs > 0 && invalid_outputs <= 8);
+  TEST_ASSERT_TRUE(valid_after > 0);
+}
+
+static void test_gyro_only_quality_spans_filter_window(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 10);
+  KneeSample out;
+  int gap_outputs = 0;
+  for (uint32_t i = 0; i < 2000; i++) {
+    KneeSample s = makeSample(i, 10.0f);
+    if (i >= 1000 && i < 1003) s.q1 = QUALITY_GYRO_ONLY;
+    if (!decimatorPush(d, s, out)) continue;
+    TEST_ASSERT_EQUAL_UINT8(QUALITY_MEASURED, out.q2);
+    if (out.q1 == QUALITY_GYRO_ONLY) gap_outputs++;
+  }
+  // każde wyjście, którego okno FIR (61 próbek) obejmuje przerwę
+  TEST_ASSERT_TRUE(gap_outputs >= 6 && gap_outputs <= 8);
+}
+
+static void test_large_ratio_uses_cic_stage(void) {
+  static KneeDecimator d;
+  decimatorInit(d, 100);
+  TEST_ASSERT_TRUE(d.pre > 1);
+  TEST_ASSERT_TRUE(d.fir <= DECIM_FIR_RATIO_MAX);
+  TEST_ASSERT_EQUAL_UINT16(100, d.ratio);
+  KneeSample out;
+  int outputs = 0;
+  for (uint32_t i = 0; i < 20000; i++) {
+    const float v = 5.0f + 20.0f * sinf(2.0f * 3.14159265f * 47.0f * i / FS_HZ);
+    if (!decimatorPush(d, makeSample(i, v), out)) continue;
+    outputs++;
+    if (i > 5000) TEST_ASSERT_FLOAT_WITHIN(0.1f, 5.0f, out.pitch1);
+  }
+  TEST_ASSERT_EQUAL(200 - 6, outputs); // CIC 10 x FIR 10: okno 61 wyjść CIC
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ratio_one_is_passthrough);
+  RUN_TEST(test_output_rate_and_dc_gain);
+  RUN_TEST(test_timestamps_start_after_first_input);
+  RUN_TEST(test_alias_band_is_attenuated);
+  RUN_TEST(test_timestamp_compensates_group_delay);
+  RUN_TEST(test_wraps_through_180);
+  RUN_TEST(test_invalid_samples_propagate_and_recover);
+  RUN_TEST(test_gyro_only_quality_spans_filter_window);
+  RUN_TEST(test_large_ratio_uses_cic_stage);
+  return UNITY_END();
+}
@@ -0,0 +1,146 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+
+#include "binary_frame.h"
+#include "delta_codec.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Ruch kolana ~1 Hz + szum 0.02°, przejście yaw przez ±180°, przerwy i nieważne kąty.
+static KneeSample makeSample(uint32_t i) {
+  KneeSample s;
+  s.t_us = 0xFFF00000ull + i * 2000u + (i > 300 ? 500000u : 0u); // granica 2^32 us i przerwa
+  const float ph = 2.0f * 3.14159265f * i / 500.0f;
+  const float noise = 0.02f * (float)((int)((i * 2654435761u) >> 29) - 4);
+  s.roll1 = 5.0f * sinf(ph) + noise;
+  s.pitch1 = -20.0f + 30.0f * sinf(ph);
+  s.yaw1 = 178.0f + 0.02f * i;
+  if (s.yaw1 > 180.0f) s.yaw1 -= 360.0f;
+  s.roll2 = 2.0f * cosf(ph);
+  s.pitch2 = 10.0f + 50.0f * sinf(ph + 0.3f) + noise;
+  s.yaw2 = -90.0f;
+  s.knee_angle = 60.0f + 55.0f * sinf(ph + 0.3f);
+  if (i % 97 == 13) {
+    s.roll2 = s.pitch2 = s.yaw2 = s.knee_angle = ANGLE_INVALID;
+    s.inv2 = true;
+    s.q2 = QUALITY_INVALID;
+  }
+  s.q1 = (i % 40 == 3) ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  return s;
+}
+
+// Bezstratność względem rekordu 17 B (te same jednostki 0.01° i flagi).
+static void assertSameAsRecord(const KneeSample& e, const KneeSample& got) {
+  uint8_t a[BIN_RECORD_LEN], b[BIN_RECORD_LEN];
+  binEncodeRecord(a, 0, e);
+  binEncodeRecord(b, 0, got);
+  TEST_ASSERT_EQUAL_UINT64(e.t_us, got.t_us);
+  TEST_ASSERT_EQUAL_MEMORY(a, b, BIN_RECORD_LEN);
+}
+
+static void test_lossless_roundtrip(void) {
+  DeltaCodec enc, dec;
+  deltaCodecInit(enc, 50);
+  deltaCodecInit(dec, 0);
+  uint8_t buf[DELTA_SAMPLE_MAX];
+  for (uint32_t i = 0; i < 1000; i++) {
+    const KneeSample e = makeSample(i);
+    const size_t n = deltaEncode(enc, e, buf);
+    TEST_ASSERT_TRUE(n >= DELTA_SAMPLE_MIN && n <= DELTA_SAMPLE_MAX);
+    KneeSample got;
+    bool have = false;
+    TEST_ASSERT_EQUAL_size_t(n, deltaDecode(dec, buf, n, got, have));
+    TEST_ASSERT_TRUE(have);
+    assertSameAsRecord(e, got);
+  }
+  TEST_ASSERT_EQUAL_UINT32(20, enc.keyframes);
+  TEST_ASSERT_EQUAL_UINT32(20, dec.keyframes);
+}
+
+static void test_resync_on_next_keyframe(void) {
+  DeltaCodec enc, dec;
+  deltaCodecInit(enc, 10);
+  deltaCodecInit(dec, 0);
+  static uint8_t stream[100 * DELTA_SAMPLE_MAX];
+  size_t len = 0, start = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    if (i == 24) start = len; // odbiornik dołącza w środku strumienia
+    len += deltaEncode(enc, makeSample(i), stream + len);
+  }
+
+  uint32_t i = 24, decoded = 0;
+  for (size_t p = start; p < len; i++) {
+    KneeSample got;
+    bool have = false;
+    const size_t m = deltaDecode(dec, stream + p, len - p, got, have);
+    TEST_ASSERT_TRUE(m > 0);
+    p += m;
+    TEST_ASSERT_EQUAL(i >= 30, have); // klatki kluczowe: 0, 10, 20, 30...
+    if (have) {
+      assertSameAsRecord(makeSample(i), got);
+      decoded++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(70, decoded);
+  TEST_ASSERT_EQUAL_UINT32(6, dec.skipped);
+
+  // utrata danych w środku -> resync do klatki
+  deltaCodecResync(dec);
+  KneeSample got;
+  bool have = true;
+  uint8_t rec[DELTA_SAMPLE_MAX];
+  deltaEncode(enc, makeSample(100), rec); // klatka 100 utracona
+  TEST_ASSERT_TRUE(deltaDecode(dec, rec, deltaEncode(enc, makeSample(101), rec), got, have) > 0);
+  TEST_ASSERT_FALSE(have);
+}
+
+static void test_long_gap_forces_keyframe(void) {
+  // przerwa > DELTA_DT_MAX_US nie mieści się w przyroście int32 -> klatka kluczowa
+  DeltaCodec enc, dec;
+  deltaCodecInit(enc, 0);
+  deltaCodecInit(dec, 0);
+  uint8_t buf[DELTA_SAMPLE_MAX];
+  KneeSample a = makeSample(0), b = makeSample(1), got;
+  b.t_us = a.t_us + 3ull * 3600 * 1000000; // 3 h
+  bool have = false;
+  deltaDecode(dec, buf, deltaEncode(enc, a, buf), got, have);
+  const size_t n = deltaEncode(enc, b, buf);
+  TEST_ASSERT_TRUE((buf[0] & DELTA_FLAG_KEY) != 0);
+  TEST_ASSERT_EQUAL_size_t(n, deltaDecode(dec, buf, n, got, have));
+  TEST_ASSERT_EQUAL_UINT64(b.t_us, got.t_us);
+}
+
+static void test_truncated_record_rejected(void) {
+  DeltaCodec enc, dec;
+  deltaCodecInit(enc, 0);
+  deltaCodecInit(dec, 0);
+  uint8_t buf[DELTA_SAMPLE_MAX];
+  const size_t n = deltaEncode(enc, makeSample(0), buf);
+  KneeSample got;
+  bool have = true;
+  TEST_ASSERT_EQUAL_size_t(0, deltaDecode(dec, buf, n - 1, got, have));
+  TEST_ASSERT_FALSE(have);
+  TEST_ASSERT_EQUAL_size_t(0, deltaDecode(dec, buf, 0, got, have));
+}
+
+static void test_compression_ratio_on_smooth_motion(void) {
+  // 500 Hz, klatka co 50 próbek: średnio poniżej 12 B/próbkę (rekord stały: 17 B)
+  DeltaCodec enc;
+  deltaCodecInit(enc, 50);
+  uint8_t buf[DELTA_SAMPLE_MAX];
+  size_t bytes = 0;
+  for (uint32_t i = 0; i < 300; i++) bytes += deltaEncode(enc, makeSample(i), buf);
+  TEST_ASSERT_TRUE((float)bytes / 300 < 12.0f);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_lossless_roundtrip);
+  RUN_TEST(test_resync_on_next_keyframe);
+  RUN_TEST(test_long_gap_forces_keyframe);
+  RUN_TEST(test_truncated_record_rejected);
+  RUN_TEST(test_compression_ratio_on_smooth_motion);
+  return UNITY_END();
+}
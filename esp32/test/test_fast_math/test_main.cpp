@@ -0,0 +1,165 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "bench.h"
+#include "fast_math.h"
+#include "fusion.h"
+#include "kg_math.h"
+
+/*
+  Granice błędów fast_math.h sprawdzane na całej dziedzinie wejść oraz
+  zgodność kątów z fuzji z wersją libm (<= 0.05°).
+*/
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const double DEG_PER_RAD_D = 57.29577951308232;
+
+static void test_atan2_error_bound_full_circle(void) {
+  // pełny okrąg, promienie od szumu czujnika do pełnej skali surowych próbek
+  const int STEPS = 200000;
+  const double radii[4] = {1e-4, 1.0, 4096.0, 32768.0};
+  double max_err = 0;
+  for (int r = 0; r < 4; r++) {
+    for (int i = 0; i <= STEPS; i++) {
+      const double th = -3.141592653589793 + 6.283185307179586 * i / STEPS;
+      const float x = (float)(radii[r] * cos(th));
+      const float y = (float)(radii[r] * sin(th));
+      double err = fabs(atan2DegFast(y, x) - atan2((double)y, (double)x) * DEG_PER_RAD_D);
+      if (err > 180.0) err = fabs(err - 360.0); // -180 vs 180
+      if (err > max_err) max_err = err;
+    }
+  }
+  TEST_ASSERT_TRUE(max_err <= FAST_ATAN2_MAX_ERR_DEG);
+}
+
+static void test_atan2_axes_and_origin(void) {
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, atan2DegFast(0.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, 0.0f, atan2DegFast(0.0f, 1.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, 90.0f, atan2DegFast(1.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, -90.0f, atan2DegFast(-1.0f, 0.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, 180.0f, atan2DegFast(0.0f, -1.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, 45.0f, atan2DegFast(3.0f, 3.0f));
+  TEST_ASSERT_FLOAT_WITHIN(FAST_ATAN2_MAX_ERR_DEG, -135.0f, atan2DegFast(-3.0f, -3.0f));
+}
+
+static void test_inv_sqrt_relative_error(void) {
+  double max_rel = 0;
+  for (double v = 1e-30; v < 1e30; v *= 1.0003) {
+    const float f = (float)v;
+    const double rel = fabs(invSqrtFast(f) * sqrt((double)f) - 1.0);
+    if (rel > max_rel) max_rel = rel;
+  }
+  TEST_ASSERT_TRUE(max_rel <= FAST_INV_SQRT_MAX_REL_ERR);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, kgSqrt(0.0f));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, kgSqrt(-1.0f));
+}
+
+static void test_wrap180_matches_fmod(void) {
+  for (int i = -2000000; i <= 2000000; i += 7) {
+    const float deg = i * 0.01f;
+    double ref = fmod((double)deg + 180.0, 360.0);
+    if (ref < 0) ref += 360.0;
+    ref -= 180.0;
+    const float w = wrap180(deg);
+    TEST_ASSERT_TRUE(w >= -180.0f && w <= 180.0f);
+    double err = fabs(w - ref);
+    if (err > 180.0) err = fabs(err - 360.0); // ±180 to ten sam kąt
+    TEST_ASSERT_TRUE(err < 1e-3);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(180.0f, wrap180(180.0f));
+  TEST_ASSERT_EQUAL_FLOAT(-180.0f, wrap180(-180.0f));
+  // duże i nieskończone wartości: bez UB konwersji do int, wynik w przedziale albo NaN
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, wrap180(360.0f * 4194304.0f));
+  TEST_ASSERT_EQUAL_FLOAT(144.0f, wrap180(1.0e12f)); // float 1e12 = 999999995904 = k * 360 + 144
+  TEST_ASSERT_TRUE(fabsf(wrap180(-3.0e38f)) <= 180.0f);
+  TEST_ASSERT_TRUE(isnan(wrap180(NAN)));
+  TEST_ASSERT_TRUE(isnan(wrap180(INFINITY)));
+  TEST_ASSERT_TRUE(isnan(wrap180(-INFINITY)));
+}
+
+static void test_accel_angles_match_libm(void) {
+  double max_err = 0;
+  for (int i = 0; i < 100000; i++) {
+    const float a = (float)i * 0.000628f, b = (float)i * 0.000377f;
+    const float ax = sinf(b), ay = cosf(b) * sinf(a), az = cosf(b) * cosf(a);
+    float r = 0, p = 0;
+    accelAnglesDeg(ax, ay, az, r, p);
+    const double rr = atan2((double)ay, (double)az) * DEG_PER_RAD_D;
+    const double pr = atan2(-(double)ax, sqrt((double)ay * ay + (double)az * az)) * DEG_PER_RAD_D;
+    const double er = fabs(fabs(r - rr) > 180.0 ? fabs(r - rr) - 360.0 : r - rr);
+    const double ep = fabs(p - pr);
+    if (er > max_err) max_err = er;
+    if (ep > max_err) max_err = ep;
+  }
+  TEST_ASSERT_TRUE(max_err <= 2.0 * FAST_ATAN2_MAX_ERR_DEG);
+}
+
+// Referencja: ten sam Kalman, kąty z akcelerometru liczone przez libm.
+static void test_fused_angles_within_005_deg(void) {
+  const size_t N = 20000;
+  const float dt = 1.0f / 500.0f;
+  const std::vector<BenchRawPair> motion = benchMakeKneeMotion(N, 500.0f, 20.0f);
+
+  ImuState a, b;
+  Kalman1D ra_roll, ra_pitch, rb_roll, rb_pitch;
+  float max_err = 0;
+  for (size_t i = 0; i < N; i++) {
+    MpuSample s1, s2;
+    mpuScale(motion[i].thigh, s1);
+    mpuScale(motion[i].shank, s2);
+    fuseImuSample(a, s1, dt);
+    fuseImuSample(b, s2, dt);
+
+    const MpuSample* s[2] = {&s1, &s2};
+    Kalman1D* kr[2] = {&ra_roll, &rb_roll};
+    Kalman1D* kp[2] = {&ra_pitch, &rb_pitch};
+    for (int k = 0; k < 2; k++) {
+      const float r = atan2DegLibm(s[k]->ay, s[k]->az);
+      const float p = atan2DegLibm(-s[k]->ax, sqrtf(s[k]->ay * s[k]->ay + s[k]->az * s[k]->az));
+      kalmanUpdate(*kr[k], s[k]->gx, r, dt);
+      kalmanUpdate(*kp[k], s[k]->gy, p, dt);
+    }
+
+    const float e[5] = {
+      fabsf(a.k_roll.angle_deg - ra_roll.angle_deg),
+      fabsf(a.k_pitch.angle_deg - ra_pitch.angle_deg),
+      fabsf(b.k_roll.angle_deg - rb_roll.angle_deg),
+      fabsf(b.k_pitch.angle_deg - rb_pitch.angle_deg),
+      fabsf(fabsf(angleDiffDeg(b.k_roll.angle_deg, a.k_roll.angle_deg)) -
+            fabsf(angleDiffDeg(rb_roll.angle_deg, ra_roll.angle_deg))),
+    };
+    for (int k = 0; k < 5; k++) if (e[k] > max_err) max_err = e[k];
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, max_err);
+}
+
+static void test_quat_euler_and_angle_match_libm(void) {
+  double max_err = 0;
+  for (int i = 0; i < 20000; i++) {
+    const float roll = -179.0f + 0.0179f * i, pitch = -89.0f + 0.0089f * i;
+    const Quat q = quatMul(quatFromAxisAngleDeg(0.0f, 0.0f, 1.0f, 0.013f * i), quatFromRollPitchDeg(roll, pitch));
+    float r = 0, p = 0, y = 0;
+    quatToEulerDeg(q, r, p, y);
+    const double rr = atan2(2.0 * (q.w * q.x + q.y * q.z), 1.0 - 2.0 * (q.x * q.x + q.y * q.y)) * DEG_PER_RAD_D;
+    const double pr = asin(2.0 * (q.w * q.y - q.z * q.x)) * DEG_PER_RAD_D;
+    const double ar = 2.0 * acos(fabs((double)q.w)) * DEG_PER_RAD_D;
+    const double e[3] = {fabs(r - rr), fabs(p - pr), fabs(quatAngleDeg(q) - ar)};
+    for (int k = 0; k < 3; k++) if (e[k] > max_err) max_err = e[k];
+  }
+  TEST_ASSERT_TRUE(max_err <= 0.05);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_atan2_error_bound_full_circle);
+  RUN_TEST(test_atan2_axes_and_origin);
+  RUN_TEST(test_inv_sqrt_relative_error);
+  RUN_TEST(test_wrap180_matches_fmod);
+  RUN_TEST(test_accel_angles_match_libm);
+  RUN_TEST(test_fused_angles_within_005_deg);
+  RUN_TEST(test_quat_euler_and_angle_match_libm);
+  return UNITY_END();
+}
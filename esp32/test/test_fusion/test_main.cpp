@@ -0,0 +1,255 @@
+#include <unity.h>
+
+#include "fusion.h"
+#include "kg_math.h"
+#include "quaternion.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_wrap180(void) {
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, wrap180(360.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, -170.0f, wrap180(190.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 170.0f, wrap180(-190.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 45.0f, wrap180(45.0f + 720.0f));
+}
+
+static void test_angle_diff_crosses_180(void) {
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 20.0f, angleDiffDeg(-170.0f, 170.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -20.0f, angleDiffDeg(170.0f, -170.0f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 90.0f, angleDiffDeg(45.0f, -45.0f));
+}
+
+static void test_accel_angles_quadrants(void) {
+  float r = 0, p = 0;
+  accelAnglesDeg(0.0f, 0.0f, 1.0f, r, p);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, r);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, p);
+
+  accelAnglesDeg(0.0f, 1.0f, 0.0f, r, p);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 90.0f, r);
+
+  accelAnglesDeg(0.0f, 0.0f, -1.0f, r, p);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 180.0f, fabsf(r));
+
+  accelAnglesDeg(-1.0f, 0.0f, 0.0f, r, p);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 90.0f, p);
+}
+
+static void test_kalman_converges_to_static_tilt(void) {
+  ImuState imu;
+  MpuSample s;
+  s.ay = sinf(30.0f * KG_RAD_PER_DEG);
+  s.az = cosf(30.0f * KG_RAD_PER_DEG);
+  for (int i = 0; i < 500; i++) fuseImuSample(imu, s, 0.004f);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, imu.k_roll.angle_deg);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, imu.k_pitch.angle_deg);
+}
+
+static void test_gyro_bias_is_removed(void) {
+  ImuState imu;
+  imu.bgz = 1.5f;
+  MpuSample s;
+  s.az = 1.0f;
+  s.gz = 1.5f;
+  for (int i = 0; i < 100; i++) fuseImuSample(imu, s, 0.01f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, imu.yaw);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, imu.gz);
+}
+
+static void test_knee_sample_offsets_and_invalid(void) {
+  ImuState a, b;
+  a.k_roll.angle_deg = 10.0f;
+  b.k_roll.angle_deg = 100.0f;
+  b.az = -0.5f;
+
+  KneeSample k;
+  computeKneeSample(1234, a, true, b, true, k);
+  TEST_ASSERT_EQUAL_UINT32(1234, k.t_us);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 90.0f, k.knee_angle);
+  TEST_ASSERT_FALSE(k.inv1);
+  TEST_ASSERT_TRUE(k.inv2);
+
+  captureMountOffsets(a);
+  captureMountOffsets(b);
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, k.roll1);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, k.knee_angle);
+
+  computeKneeSample(0, a, true, b, false, k);
+  TEST_ASSERT_EQUAL_FLOAT(ANGLE_INVALID, k.roll2);
+  TEST_ASSERT_EQUAL_FLOAT(ANGLE_INVALID, k.knee_angle);
+  TEST_ASSERT_FALSE(k.inv2);
+}
+
+static MpuSample gravitySample(const Quat& q, float rate_x_dps = 0.0f) {
+  float gx = 0.0f, gy = 0.0f, gz = 1.0f;
+  quatRotate(quatConj(q), gx, gy, gz);
+  MpuSample s;
+  s.ax = gx;
+  s.ay = gy;
+  s.az = gz;
+  s.gx = rate_x_dps;
+  return s;
+}
+
+static void test_quat_euler_matches_accel_angles(void) {
+  const Quat q = quatFromRollPitchDeg(25.0f, -40.0f);
+  const MpuSample s = gravitySample(q);
+  float ra = 0, pa = 0, r = 0, p = 0, y = 0;
+  accelAnglesDeg(s.ax, s.ay, s.az, ra, pa);
+  quatToEulerDeg(q, r, p, y);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.0f, ra);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -40.0f, pa);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.0f, r);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -40.0f, p);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, y);
+}
+
+static void test_quaternion_engines_static_tilt(void) {
+  const FusionEngine engines[2] = {FUSION_MADGWICK, FUSION_MAHONY};
+  for (int e = 0; e < 2; e++) {
+    ImuState imu;
+    setFusionEngine(imu, engines[e]);
+    const MpuSample s = gravitySample(quatFromRollPitchDeg(30.0f, 10.0f));
+    for (int i = 0; i < 2000; i++) fuseImuSample(imu, s, 0.002f);
+    float r = 0, p = 0, y = 0;
+    imuEulerDeg(imu, r, p, y);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 30.0f, r);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 10.0f, p);
+  }
+}
+
+static void test_quaternion_tracks_gyro_rotation(void) {
+  // 90°/s wokół X przez 0.5 s, akcelerometr zgodny z ruchem -> roll 45°
+  ImuState imu;
+  setFusionEngine(imu, FUSION_MADGWICK);
+  const float dt = 0.002f;
+  for (int i = 0; i <= 250; i++) {
+    const float roll = 90.0f * i * dt;
+    fuseImuSample(imu, gravitySample(quatFromRollPitchDeg(roll, 0.0f), 90.0f), dt);
+  }
+  float r = 0, p = 0, y = 0;
+  imuEulerDeg(imu, r, p, y);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 45.0f, r);
+}
+
+static void test_quaternion_knee_angle_out_of_plane(void) {
+  // udo poziomo, podudzie: zgięcie 60° + odchylenie boczne 40° (pitch);
+  // rzeczywisty kąt względny to kąt obrotu q2, nie różnica roll
+  const Quat q1 = quatFromRollPitchDeg(0.0f, 0.0f);
+  const Quat q2 = quatFromRollPitchDeg(60.0f, 40.0f);
+  const float truth = quatAngleDeg(q2);
+
+  ImuState a, b;
+  setFusionEngine(a, FUSION_MADGWICK);
+  setFusionEngine(b, FUSION_MADGWICK);
+  for (int i = 0; i < 3000; i++) {
+    fuseImuSample(a, gravitySample(q1), 0.002f);
+    fuseImuSample(b, gravitySample(q2), 0.002f);
+  }
+  KneeSample k;
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, truth, k.knee_angle);
+
+  // ścieżka Kalmana (różnica roll) myli się poza płaszczyzną strzałkową
+  ImuState ka, kb;
+  for (int i = 0; i < 3000; i++) {
+    fuseImuSample(ka, gravitySample(q1), 0.002f);
+    fuseImuSample(kb, gravitySample(q2), 0.002f);
+  }
+  KneeSample kk;
+  computeKneeSample(0, ka, true, kb, true, kk);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 60.0f, kk.knee_angle);
+  TEST_ASSERT_GREATER_THAN_FLOAT(5.0f, fabsf(kk.knee_angle - truth));
+}
+
+static void test_quaternion_knee_relative_to_calib(void) {
+  const Quat q1 = quatFromAxisAngleDeg(1.0f, 0.0f, 0.0f, 5.0f);
+  const Quat q2 = quatFromAxisAngleDeg(1.0f, 0.0f, 0.0f, 15.0f);
+  ImuState a, b;
+  setFusionEngine(a, FUSION_MAHONY);
+  setFusionEngine(b, FUSION_MAHONY);
+  for (int i = 0; i < 3000; i++) {
+    fuseImuSample(a, gravitySample(q1), 0.002f);
+    fuseImuSample(b, gravitySample(q2), 0.002f);
+  }
+  KneeSample k;
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 10.0f, k.knee_angle);
+
+  captureMountOffsets(a);
+  captureMountOffsets(b);
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, k.knee_angle);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.0f, k.roll2);
+}
+
+static void test_gap_fill_kalman_follows_gyro(void) {
+  ImuState a, b;
+  MpuSample s;
+  s.az = 1.0f;
+  s.gx = 20.0f;
+  for (int i = 0; i < 10; i++) fuseImuSample(a, s, 0.004f);
+  b = a;
+  const float roll0 = a.k_roll.angle_deg;
+
+  // 50 ms bez odczytu: roll dalej rośnie z ostatnią prędkością 20°/s
+  for (int i = 0; i < 25; i++) TEST_ASSERT_TRUE(propagateGyroOnly(a, 0.002f));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, roll0 + 1.0f, a.k_roll.angle_deg);
+  TEST_ASSERT_TRUE(a.k_roll.uncert > b.k_roll.uncert);
+
+  KneeSample k;
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_GYRO_ONLY, k.q1);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_MEASURED, k.q2);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1.0f, k.knee_angle);
+
+  // nowa próbka kończy przerwę
+  fuseImuSample(a, s, 0.004f);
+  computeKneeSample(0, a, true, b, false, k);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_MEASURED, k.q1);
+  TEST_ASSERT_EQUAL_UINT8(QUALITY_INVALID, k.q2);
+}
+
+static void test_gap_fill_quaternion_and_limit(void) {
+  ImuState imu;
+  setFusionEngine(imu, FUSION_MAHONY);
+  TEST_ASSERT_FALSE(propagateGyroOnly(imu, 0.002f)); // brak orientacji startowej
+
+  imu = ImuState();
+  setFusionEngine(imu, FUSION_MAHONY);
+  MpuSample s = gravitySample(quatFromRollPitchDeg(0.0f, 0.0f), 90.0f);
+  fuseImuSample(imu, s, 0.002f);
+  float r0 = 0, p0 = 0, y0 = 0;
+  imuEulerDeg(imu, r0, p0, y0);
+
+  // 0.1 s przy 90°/s -> +9° roll, bez korekcji grawitacją
+  for (int i = 0; i < 50; i++) TEST_ASSERT_TRUE(propagateGyroOnly(imu, 0.002f));
+  float r = 0, p = 0, y = 0;
+  imuEulerDeg(imu, r, p, y);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, r0 + 9.0f, r);
+
+  // po GAP_FILL_MAX_S kąty przestają być ważne
+  int steps = 50;
+  while (propagateGyroOnly(imu, 0.002f)) steps++;
+  TEST_ASSERT_INT_WITHIN(1, (int)(GAP_FILL_MAX_S / 0.002f), steps);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_wrap180);
+  RUN_TEST(test_angle_diff_crosses_180);
+  RUN_TEST(test_accel_angles_quadrants);
+  RUN_TEST(test_kalman_converges_to_static_tilt);
+  RUN_TEST(test_gyro_bias_is_removed);
+  RUN_TEST(test_knee_sample_offsets_and_invalid);
+  RUN_TEST(test_quat_euler_matches_accel_angles);
+  RUN_TEST(test_quaternion_engines_static_tilt);
+  RUN_TEST(test_quaternion_tracks_gyro_rotation);
+  RUN_TEST(test_quaternion_knee_angle_out_of_plane);
+  RUN_TEST(test_quaternion_knee_relative_to_calib);
+  RUN_TEST(test_gap_fill_kalman_follows_gyro);
+  RUN_TEST(test_gap_fill_quaternion_and_limit);
+  return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <unity.h>
+
+#include "mpu6050.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_decode_burst_big_endian(void) {
+  const uint8_t buf[MPU_BURST_LEN] = {0x10, 0x00, 0xF0, 0x00, 0x00, 0x01,
+                                      0x12, 0x34,
+                                      0x00, 0x83, 0xFF, 0x7D, 0x80, 0x00};
+  MpuRaw raw;
+  mpuDecodeBurst(buf, raw);
+  TEST_ASSERT_EQUAL_INT16(4096, raw.ax);
+  TEST_ASSERT_EQUAL_INT16(-4096, raw.ay);
+  TEST_ASSERT_EQUAL_INT16(1, raw.az);
+  TEST_ASSERT_EQUAL_INT16(0x1234, raw.temp);
+  TEST_ASSERT_EQUAL_INT16(131, raw.gx);
+  TEST_ASSERT_EQUAL_INT16(-131, raw.gy);
+  TEST_ASSERT_EQUAL_INT16(-32768, raw.gz);
+
+  MpuSample s;
+  mpuScale(raw, s);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, s.ax);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -1.0f, s.ay);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 2.0f, s.gx);
+}
+
+static void test_decode_fifo_frame(void) {
+  const uint8_t buf[MPU_FIFO_FRAME_LEN] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                           0x00, 0x83, 0x00, 0x00, 0xFF, 0x7D};
+  MpuRaw raw;
+  raw.temp = 55;
+  mpuDecodeFifoFrame(buf, raw);
+  TEST_ASSERT_EQUAL_INT16(0, raw.ax);
+  TEST_ASSERT_EQUAL_INT16(4096, raw.az);
+  TEST_ASSERT_EQUAL_INT16(0, raw.temp);
+  TEST_ASSERT_EQUAL_INT16(131, raw.gx);
+  TEST_ASSERT_EQUAL_INT16(0, raw.gy);
+  TEST_ASSERT_EQUAL_INT16(-131, raw.gz);
+}
+
+static void test_sample_rate(void) {
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 500.0f, mpuSampleRateHz(0x05, 1));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1000.0f, mpuSampleRateHz(0x03, 0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 8000.0f, mpuSampleRateHz(0x00, 0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1000.0f, mpuSampleRateHz(0x07, 7));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.0f, mpuSampleRateHz(0x06, 39));
+}
+
+static void test_fifo_frames(void) {
+  TEST_ASSERT_EQUAL_INT(0, mpuFifoFrames(0));
+  TEST_ASSERT_EQUAL_INT(0, mpuFifoFrames(11));
+  TEST_ASSERT_EQUAL_INT(1, mpuFifoFrames(12));
+  TEST_ASSERT_EQUAL_INT(3, mpuFifoFrames(40));
+  TEST_ASSERT_EQUAL_INT(85, mpuFifoFrames(1020));
+  TEST_ASSERT_EQUAL_INT(-1, mpuFifoFrames(1024));
+}
+
+static void test_range_scale_factors(void) {
+  TEST_ASSERT_EQUAL_FLOAT(16384.0f, mpuAccelLsbPerG(MPU_ACCEL_2G));
+  TEST_ASSERT_EQUAL_FLOAT(ACC_LSB_PER_G, mpuAccelLsbPerG(MPU_ACCEL_8G));
+  TEST_ASSERT_EQUAL_FLOAT(2048.0f, mpuAccelLsbPerG(MPU_ACCEL_16G));
+  TEST_ASSERT_EQUAL_FLOAT(131.0f, mpuGyroLsbPerDps(MPU_GYRO_250DPS));
+  TEST_ASSERT_EQUAL_FLOAT(GYRO_LSB_PER_DPS, mpuGyroLsbPerDps(MPU_GYRO_500DPS));
+  TEST_ASSERT_EQUAL_FLOAT(16.4f, mpuGyroLsbPerDps(MPU_GYRO_2000DPS));
+  TEST_ASSERT_EQUAL_HEX8(0x10, mpuRangeReg(MPU_ACCEL_8G));
+  TEST_ASSERT_EQUAL_HEX8(0x08, mpuRangeReg(MPU_GYRO_500DPS));
+
+  MpuAccelRange ar;
+  MpuGyroRange gr;
+  TEST_ASSERT_TRUE(mpuAccelRangeFromG(16, ar));
+  TEST_ASSERT_EQUAL(MPU_ACCEL_16G, ar);
+  TEST_ASSERT_FALSE(mpuAccelRangeFromG(3, ar));
+  TEST_ASSERT_TRUE(mpuGyroRangeFromDps(1000, gr));
+  TEST_ASSERT_EQUAL(MPU_GYRO_1000DPS, gr);
+  TEST_ASSERT_FALSE(mpuGyroRangeFromDps(300, gr));
+}
+
+static void test_scale_consistent_across_ranges(void) {
+  // ta sama wielkość fizyczna (1 g, 100 dps) w każdym zakresie -> ta sama próbka
+  for (uint8_t i = 0; i < 4; i++) {
+    MpuConfig cfg;
+    cfg.accel_range = (MpuAccelRange)i;
+    cfg.gyro_range  = (MpuGyroRange)i;
+    MpuRaw raw;
+    raw.az = (int16_t)mpuAccelLsbPerG(cfg.accel_range);
+    raw.gx = (int16_t)(100.0f * mpuGyroLsbPerDps(cfg.gyro_range));
+    MpuSample s;
+    mpuScale(raw, mpuScaleFactors(cfg), s);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, s.az);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 100.0f, s.gx);
+  }
+
+  // domyślna konfiguracja == stałe ACC_LSB_PER_G / GYRO_LSB_PER_DPS
+  MpuRaw raw;
+  raw.ax = -1234;
+  raw.gz = 4321;
+  MpuSample a, b;
+  mpuScale(raw, a);
+  mpuScale(raw, mpuScaleFactors(MpuConfig()), b);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, a.ax, b.ax);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, a.gz, b.gz);
+}
+
+static void test_divider_for_rate(void) {
+  TEST_ASSERT_EQUAL_UINT8(1, mpuDividerForRate(0x05, 500.0f));
+  TEST_ASSERT_EQUAL_UINT8(39, mpuDividerForRate(0x05, 25.0f));
+  TEST_ASSERT_EQUAL_UINT8(2, mpuDividerForRate(0x05, 300.0f));   // 333 Hz bliżej niż 250 Hz
+  TEST_ASSERT_EQUAL_UINT8(3, mpuDividerForRate(0x05, 290.0f));   // 250 Hz bliżej niż 333 Hz (div 2.45)
+  TEST_ASSERT_EQUAL_UINT8(0, mpuDividerForRate(0x05, 1000.0f));
+  TEST_ASSERT_EQUAL_UINT8(7, mpuDividerForRate(0x00, 1000.0f));  // 8 kHz / 8
+  TEST_ASSERT_EQUAL_UINT8(7, mpuDividerForRate(0x00, 4000.0f));  // limit MPU_RATE_MAX_HZ
+  TEST_ASSERT_EQUAL_UINT8(255, mpuDividerForRate(0x05, 1.0f));   // najwolniej: ~3.9 Hz
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 30.0f, mpuSampleRateHz(0x05, mpuDividerForRate(0x05, 30.0f)));
+
+  MpuConfig cfg;
+  TEST_ASSERT_TRUE(mpuConfigValid(cfg));
+  cfg.dlpf_cfg = 7;
+  TEST_ASSERT_FALSE(mpuConfigValid(cfg));
+  cfg.dlpf_cfg = 0;
+  cfg.smplrt_div = 0; // 8 kHz
+  TEST_ASSERT_FALSE(mpuConfigValid(cfg));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_burst_big_endian);
+  RUN_TEST(test_decode_fifo_frame);
+  RUN_TEST(test_sample_rate);
+  RUN_TEST(test_fifo_frames);
+  RUN_TEST(test_range_scale_factors);
+  RUN_TEST(test_scale_consistent_across_ranges);
+  RUN_TEST(test_divider_for_rate);
+  return UNITY_END();
+}
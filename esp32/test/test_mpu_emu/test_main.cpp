@@ -0,0 +1,300 @@
+#include <unity.h>
+
+#include "i2c_emu.h"
+#include "mpu6050_emu.h"
+#include "tca9548a_emu.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Źródło: stała orientacja, żyroskop = czas [s] na osi X (kolejne próbki różne)
+static void rampSource(void*, uint64_t t_us, MpuEmuReading& r) {
+  r.acc_g[0] = 0.0f;
+  r.acc_g[1] = 0.5f;
+  r.acc_g[2] = 0.866f;
+  r.gyro_dps[0] = (float)t_us * 1e-6f;
+  r.gyro_dps[1] = -100.0f;
+  r.temp_c = 30.0f;
+}
+
+struct Rig {
+  I2cEmuBus bus;
+  MpuEmu    mpu1, mpu2;
+  uint64_t  t = 0;
+
+  Rig() {
+    mpuEmuInit(mpu1, rampSource, nullptr);
+    mpuEmuInit(mpu2, rampSource, nullptr);
+    i2cEmuAttach(bus, mpuEmuDevice(mpu1, 0x68));
+    i2cEmuAttach(bus, mpuEmuDevice(mpu2, 0x69));
+    bus.clock_hz = 400000;
+  }
+
+  // Jak writeReg / readBurst w firmware; czas płynie o czas transakcji
+  uint8_t write(uint8_t addr, uint8_t reg, uint8_t val) {
+    const uint8_t b[2] = {reg, val};
+    uint32_t dur;
+    const uint8_t r = i2cEmuWrite(bus, addr, b, 2, t, dur);
+    t += dur;
+    return r;
+  }
+
+  uint8_t read(uint8_t addr, uint8_t reg, uint8_t* out, size_t n) {
+    uint32_t dur;
+    uint8_t r = i2cEmuWrite(bus, addr, &reg, 1, t, dur);
+    t += dur;
+    if (r != I2C_EMU_OK) return r;
+    r = i2cEmuRead(bus, addr, out, n, t, dur);
+    t += dur;
+    return r;
+  }
+
+  // mpuInit z firmware (reset, 100 ms, wybudzenie + konfiguracja)
+  bool init(uint8_t addr, const MpuConfig& cfg) {
+    if (write(addr, MPU_REG_PWR_MGMT_1, 0x80) != I2C_EMU_OK) return false;
+    t += 100000;
+    return write(addr, MPU_REG_PWR_MGMT_1, 0x01) == I2C_EMU_OK &&
+           write(addr, MPU_REG_CONFIG, cfg.dlpf_cfg) == I2C_EMU_OK &&
+           write(addr, MPU_REG_SMPLRT_DIV, cfg.smplrt_div) == I2C_EMU_OK &&
+           write(addr, MPU_REG_ACCEL_CONFIG, mpuRangeReg(cfg.accel_range)) == I2C_EMU_OK &&
+           write(addr, MPU_REG_GYRO_CONFIG, mpuRangeReg(cfg.gyro_range)) == I2C_EMU_OK;
+  }
+
+  int fifoCount(uint8_t addr) {
+    uint8_t b[2];
+    if (read(addr, MPU_REG_FIFO_COUNT_H, b, 2) != I2C_EMU_OK) return -1;
+    return (b[0] << 8) | b[1];
+  }
+};
+
+static void test_power_on_reset_and_data_registers(void) {
+  Rig r;
+  uint8_t who = 0;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x69, MPU_REG_WHO_AM_I, &who, 1));
+  TEST_ASSERT_EQUAL_HEX8(0x68, who); // także przy AD0 = 1
+  uint8_t buf[MPU_BURST_LEN];
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_NACK_ADDR, r.read(0x6A, MPU_REG_WHO_AM_I, &who, 1));
+
+  // uśpiony po zasileniu: brak próbek
+  r.t += 50000;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT32(0, r.mpu1.samples);
+
+  // reset: NACK do końca resetu, potem rejestry domyślne
+  MpuConfig cfg;
+  cfg.accel_range = MPU_ACCEL_4G;
+  cfg.gyro_range = MPU_GYRO_1000DPS;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_PWR_MGMT_1, 0x80));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_NACK_ADDR, r.write(0x68, MPU_REG_PWR_MGMT_1, 0x01));
+  r.t += MPU_EMU_RESET_US;
+  TEST_ASSERT_TRUE(r.init(0x68, cfg));
+  TEST_ASSERT_EQUAL_FLOAT(500.0f, mpuEmuSampleRateHz(r.mpu1));
+
+  mpuEmuAdvance(r.mpu1, r.t);
+  const uint32_t n0 = r.mpu1.samples;
+  r.t += 10000; // 5 próbek przy 500 Hz
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT32(n0 + 5, r.mpu1.samples);
+  MpuRaw raw;
+  mpuDecodeBurst(buf, raw);
+  TEST_ASSERT_EQUAL_INT16(4096, raw.ay);              // 0.5 g przy ±4 g
+  TEST_ASSERT_EQUAL_INT16(-3280, raw.gy);             // -100 dps przy ±1000 dps
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, mpuTempC(raw.temp));
+
+  // ten sam blok przy ponownym odczycie bez nowej próbki; rejestr po rejestrze = burst
+  uint8_t again[MPU_BURST_LEN];
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H, again, 8));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H + 8, again + 8, 6));
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, sizeof(buf));
+}
+
+static void test_fifo_frames_order_and_overflow(void) {
+  Rig r;
+  MpuConfig cfg; // 500 Hz, ±8 g, ±500 dps
+  TEST_ASSERT_TRUE(r.init(0x68, cfg));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_FIFO_EN, MPU_FIFO_EN_ACCEL_GYRO));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_RESET));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_EN));
+  TEST_ASSERT_EQUAL_INT(0, r.fifoCount(0x68));
+
+  r.t += 20000;
+  const int count = r.fifoCount(0x68);
+  TEST_ASSERT_EQUAL_INT(10 * (int)MPU_FIFO_FRAME_LEN, count);
+
+  // ramki w kolejności, bez przesunięcia bajtów: gx rośnie z czasem
+  uint8_t buf[10 * MPU_FIFO_FRAME_LEN];
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_FIFO_R_W, buf, sizeof(buf)));
+  MpuRaw prev;
+  for (int i = 0; i < 10; i++) {
+    MpuRaw f;
+    mpuDecodeFifoFrame(buf + i * MPU_FIFO_FRAME_LEN, f);
+    TEST_ASSERT_EQUAL_INT16(2048, f.ay);
+    TEST_ASSERT_EQUAL_INT16(-6550, f.gy);
+    if (i > 0) TEST_ASSERT_TRUE(f.gx >= prev.gx);
+    prev = f;
+  }
+  TEST_ASSERT_TRUE(r.fifoCount(0x68) <= 2 * (int)MPU_FIFO_FRAME_LEN); // próbki w trakcie odczytu
+
+  // 1 s bez odczytu: pełne FIFO (firmware: mpuFifoFrames < 0) i flaga w INT_STATUS
+  r.t += 1000000;
+  TEST_ASSERT_EQUAL_INT(MPU_FIFO_SIZE, r.fifoCount(0x68));
+  TEST_ASSERT_TRUE(mpuFifoFrames(MPU_FIFO_SIZE) < 0);
+  TEST_ASSERT_TRUE(r.mpu1.fifo_overflows > 0);
+  uint8_t st = 0;
+  r.read(0x68, 0x3A, &st, 1);
+  TEST_ASSERT_TRUE(st & 0x10);
+  r.read(0x68, 0x3A, &st, 1);
+  TEST_ASSERT_FALSE(st & 0x10); // odczyt kasuje
+
+  // restart jak mpuFifoStart
+  r.write(0x68, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_RESET);
+  r.write(0x68, MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_EN);
+  TEST_ASSERT_TRUE(r.fifoCount(0x68) < (int)MPU_FIFO_FRAME_LEN);
+}
+
+// Impulsy data-ready na siatce próbek; kolejne impulsy = kolejne ramki FIFO.
+static void test_data_ready_interrupt(void) {
+  Rig r;
+  MpuConfig cfg; // 500 Hz
+  TEST_ASSERT_TRUE(r.init(0x68, cfg));
+  TEST_ASSERT_EQUAL_UINT64(0, mpuEmuNextDataReady(r.mpu1, r.t)); // INT wyłączone
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_INT_PIN_CFG, MPU_INT_PIN_CFG_PULSE));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_INT_ENABLE, MPU_INT_DATA_RDY));
+
+  const uint64_t t0 = mpuEmuNextDataReady(r.mpu1, r.t);
+  TEST_ASSERT_TRUE(t0 > r.t && t0 <= r.t + 2000);
+  TEST_ASSERT_EQUAL_UINT64(t0 + 2000, mpuEmuNextDataReady(r.mpu1, t0));
+  TEST_ASSERT_EQUAL_UINT64(t0 + 10000, mpuEmuNextDataReady(r.mpu1, t0 + 9999));
+
+  // odczyt po 5 impulsach: 5 nowych próbek, a siatka bez zmian (także wstecz od stanu emulatora)
+  const uint32_t n0 = r.mpu1.samples;
+  r.t = t0 + 4 * 2000;
+  uint8_t buf[MPU_BURST_LEN];
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT32(n0 + 5, r.mpu1.samples);
+  TEST_ASSERT_EQUAL_UINT64(t0 + 2000, mpuEmuNextDataReady(r.mpu1, t0));
+}
+
+static void test_transaction_timing_and_latency(void) {
+  Rig r;
+  uint8_t buf[MPU_BURST_LEN];
+  uint32_t dur = 0;
+  // 14 B przy 400 kHz: (2 + 9 * 15) bitów = 343 us
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, i2cEmuRead(r.bus, 0x68, buf, sizeof(buf), 0, dur));
+  TEST_ASSERT_EQUAL_UINT32(343, dur);
+  r.bus.latency_us = 100;
+  r.bus.latency_jitter_us = 50;
+  for (int i = 0; i < 100; i++) {
+    i2cEmuRead(r.bus, 0x68, buf, sizeof(buf), 0, dur);
+    TEST_ASSERT_TRUE(dur >= 443 && dur <= 493);
+  }
+  // NACK trwa tylko fazę adresu
+  i2cEmuRead(r.bus, 0x50, buf, sizeof(buf), 0, dur);
+  TEST_ASSERT_TRUE(dur < 200);
+}
+
+static void test_nack_detach_and_stuck_bus(void) {
+  Rig r;
+  MpuConfig cfg;
+  TEST_ASSERT_TRUE(r.init(0x68, cfg));
+  TEST_ASSERT_TRUE(r.init(0x69, cfg));
+
+  I2cEmuFault nack;
+  nack.type = I2C_FAULT_NACK;
+  nack.addr = 0x69;
+  nack.t0_us = r.t;
+  nack.t1_us = r.t + 100000;
+  nack.prob = 0.5f;
+  i2cEmuAddFault(r.bus, nack);
+  int reads = 0, nacks = 0;
+  uint8_t buf[MPU_BURST_LEN];
+  while (r.t < nack.t1_us) {
+    reads++;
+    if (r.read(0x69, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)) == I2C_EMU_NACK_ADDR) nacks++;
+    TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  }
+  // odczyt to 2 transakcje: NACK z prawdopodobieństwem 1 - 0.5^2
+  TEST_ASSERT_TRUE(reads > 50);
+  TEST_ASSERT_TRUE(nacks > reads * 6 / 10 && nacks < reads * 9 / 10);
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x69, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+
+  // odłączenie: NACK, po powrocie czujnik uśpiony i wymaga konfiguracji
+  I2cEmuFault det;
+  det.type = I2C_FAULT_DETACH;
+  det.addr = 0x68;
+  det.t0_us = r.t;
+  det.t1_us = r.t + 50000;
+  i2cEmuAddFault(r.bus, det);
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_NACK_ADDR, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  r.t += 60000;
+  uint8_t pwr = 0;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_PWR_MGMT_1, &pwr, 1));
+  TEST_ASSERT_EQUAL_HEX8(0x40, pwr);
+  TEST_ASSERT_TRUE(r.init(0x68, cfg));
+
+  // zablokowana magistrala: timeout dla wszystkich adresów aż do impulsów SCL
+  I2cEmuFault stuck;
+  stuck.type = I2C_FAULT_STUCK;
+  stuck.t0_us = r.t;
+  stuck.t1_us = r.t + 1;
+  i2cEmuAddFault(r.bus, stuck);
+  r.bus.timeout_us = 5000;
+  const uint64_t t0 = r.t;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_TIMEOUT, r.read(0x68, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT64(t0 + 5000, r.t);
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_TIMEOUT, r.read(0x69, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_TRUE(i2cEmuSdaLow(r.bus));
+  int pulses = 0;
+  while (i2cEmuSdaLow(r.bus) && pulses < 9) {
+    i2cEmuSclPulse(r.bus);
+    pulses++;
+  }
+  TEST_ASSERT_FALSE(i2cEmuSdaLow(r.bus));
+  TEST_ASSERT_EQUAL_UINT32(1, r.bus.unstuck);
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x69, MPU_REG_ACCEL_XOUT_H, buf, sizeof(buf)));
+  TEST_ASSERT_EQUAL_UINT32(1, r.bus.stuck_events);
+}
+
+// Dwa czujniki 0x68 za różnymi kanałami: widoczny tylko ten z wybranego kanału.
+static void test_tca9548a_channels(void) {
+  Rig r;
+  r.bus = I2cEmuBus();
+  r.bus.clock_hz = 400000;
+  Tca9548aEmu mux;
+  TEST_ASSERT_TRUE(tca9548aEmuAttach(mux, 0, mpuEmuDevice(r.mpu1, 0x68)));
+  TEST_ASSERT_TRUE(tca9548aEmuAttach(mux, 3, mpuEmuDevice(r.mpu2, 0x68)));
+  TEST_ASSERT_TRUE(tca9548aEmuConnect(mux, r.bus, 0x70));
+  TEST_ASSERT_EQUAL_UINT32(2, r.bus.n_dev); // multiplekser + jeden pośrednik 0x68
+
+  uint8_t who = 0;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_NACK_ADDR, r.read(0x68, MPU_REG_WHO_AM_I, &who, 1)); // kanały odłączone
+
+  uint32_t dur;
+  const uint8_t ch3 = 1u << 3;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, i2cEmuWrite(r.bus, 0x70, &ch3, 1, r.t, dur));
+  uint8_t ctrl = 0;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, i2cEmuRead(r.bus, 0x70, &ctrl, 1, r.t, dur));
+  TEST_ASSERT_EQUAL_HEX8(ch3, ctrl);
+
+  // reset trafia tylko do czujnika kanału 3
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.write(0x68, MPU_REG_PWR_MGMT_1, 0x80));
+  TEST_ASSERT_EQUAL_UINT32(1, r.mpu2.resets);
+  TEST_ASSERT_EQUAL_UINT32(0, r.mpu1.resets);
+
+  const uint8_t ch0 = 1u << 0;
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, i2cEmuWrite(r.bus, 0x70, &ch0, 1, r.t, dur));
+  TEST_ASSERT_EQUAL_UINT8(I2C_EMU_OK, r.read(0x68, MPU_REG_WHO_AM_I, &who, 1));
+  TEST_ASSERT_EQUAL_HEX8(0x68, who);
+  TEST_ASSERT_EQUAL_UINT32(2, mux.selects);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_power_on_reset_and_data_registers);
+  RUN_TEST(test_fifo_frames_order_and_overflow);
+  RUN_TEST(test_data_ready_interrupt);
+  RUN_TEST(test_transaction_timing_and_latency);
+  RUN_TEST(test_nack_detach_and_stuck_bus);
+  RUN_TEST(test_tca9548a_channels);
+  return UNITY_END();
+}
@@ -0,0 +1,71 @@
+#include <unity.h>
+
+#include <string.h>
+
+#include "perf_stats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_bucket_edges(void) {
+  TEST_ASSERT_EQUAL_UINT8(0, latencyBucket(0));
+  TEST_ASSERT_EQUAL_UINT8(0, latencyBucket(1));
+  TEST_ASSERT_EQUAL_UINT8(1, latencyBucket(2));
+  TEST_ASSERT_EQUAL_UINT8(1, latencyBucket(3));
+  TEST_ASSERT_EQUAL_UINT8(2, latencyBucket(4));
+  TEST_ASSERT_EQUAL_UINT8(9, latencyBucket(1023));
+  TEST_ASSERT_EQUAL_UINT8(10, latencyBucket(1024));
+  TEST_ASSERT_EQUAL_UINT8(LATENCY_BUCKETS - 1, latencyBucket(UINT32_MAX));
+}
+
+static void test_record_min_max_avg_and_reset(void) {
+  LatencyHist h;
+  latencyRecord(h, 100);
+  latencyRecord(h, 300);
+  latencyRecord(h, 5);
+  TEST_ASSERT_EQUAL_UINT32(3, h.count);
+  TEST_ASSERT_EQUAL_UINT32(5, h.min_us);
+  TEST_ASSERT_EQUAL_UINT32(300, h.max_us);
+  TEST_ASSERT_EQUAL_UINT32(405, (uint32_t)h.sum_us);
+  TEST_ASSERT_EQUAL_UINT32(1, h.buckets[latencyBucket(100)]);
+
+  latencyReset(h);
+  TEST_ASSERT_EQUAL_UINT32(0, h.count);
+  TEST_ASSERT_EQUAL_UINT32(0, h.max_us);
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) TEST_ASSERT_EQUAL_UINT32(0, h.buckets[i]);
+}
+
+static void test_percentiles(void) {
+  LatencyHist h;
+  TEST_ASSERT_EQUAL_UINT32(0, latencyPercentileUs(h, 0.5f));
+  // 98 próbek ~ 4000 us (takt akwizycji) + 2 przestoje ~ 20 ms
+  for (int i = 0; i < 98; i++) latencyRecord(h, 4000 + (i % 3));
+  latencyRecord(h, 20000);
+  latencyRecord(h, 21000);
+  TEST_ASSERT_EQUAL_UINT32(4095, latencyPercentileUs(h, 0.50f));  // kubełek [2048, 4096)
+  TEST_ASSERT_EQUAL_UINT32(21000, latencyPercentileUs(h, 0.99f)); // ograniczone do max
+}
+
+static void test_format_lists_nonempty_buckets(void) {
+  LatencyHist h;
+  latencyRecord(h, 1);
+  latencyRecord(h, 12);
+  latencyRecord(h, 13);
+  char out[256];
+  const size_t n = formatLatencyHist(out, sizeof(out), "i2c1", h);
+  TEST_ASSERT_EQUAL(strlen(out), n);
+  TEST_ASSERT_NOT_NULL(strstr(out, "i2c1 n=3 min=1 avg=8 max=13"));
+  TEST_ASSERT_NOT_NULL(strstr(out, "| 0:1 8:2"));
+
+  char small[16];
+  TEST_ASSERT_EQUAL(0, formatLatencyHist(small, sizeof(small), "i2c1", h));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_edges);
+  RUN_TEST(test_record_min_max_avg_and_reset);
+  RUN_TEST(test_percentiles);
+  RUN_TEST(test_format_lists_nonempty_buckets);
+  return UNITY_END();
+}
@@ -0,0 +1,197 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#include "fusion.h"
+#include "raw_trace.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static bool sameBits(float a, float b) { return memcmp(&a, &b, sizeof(a)) == 0; }
+
+static bool sameSample(const KneeSample& a, const KneeSample& b) {
+  return a.t_us == b.t_us && sameBits(a.roll1, b.roll1) && sameBits(a.pitch1, b.pitch1) &&
+         sameBits(a.yaw1, b.yaw1) && sameBits(a.roll2, b.roll2) && sameBits(a.pitch2, b.pitch2) &&
+         sameBits(a.yaw2, b.yaw2) && sameBits(a.knee_angle, b.knee_angle) && a.inv1 == b.inv1 &&
+         a.inv2 == b.inv2 && a.q1 == b.q1 && a.q2 == b.q2;
+}
+
+// Udo i podudzie w ruchu zgięcia ~1 Hz, rejestry jak z czujnika (±8 g, ±500 dps)
+static MpuRaw rawAt(int i, int imu, uint32_t& rng) {
+  rng = rng * 1664525u + 1013904223u;
+  const int16_t jitter = (int16_t)((rng >> 24) & 0x0F) - 8;
+  const float ph = 2.0f * 3.14159265f * (float)i / 500.0f;
+  const float tilt = (imu == 0 ? 10.0f : 40.0f) * sinf(ph) * 3.14159265f / 180.0f;
+  MpuRaw r;
+  r.ay = (int16_t)(4096.0f * sinf(tilt)) + jitter;
+  r.az = (int16_t)(4096.0f * cosf(tilt)) - jitter;
+  r.ax = jitter;
+  r.temp = (int16_t)(-3740 + i / 100);
+  r.gx = (int16_t)(65.5f * (imu == 0 ? 63.0f : 251.0f) * cosf(ph)) + jitter;
+  r.gy = (int16_t)(30 + jitter);
+  r.gz = (int16_t)(-20 - jitter);
+  return r;
+}
+
+static void test_state_roundtrip(void) {
+  ImuState a;
+  a.bgx = 0.3f;
+  a.bgz = -1.25f;
+  a.bias.var = 0.02f;
+  a.bias.n = 17;
+  a.bias.updates = 5;
+  a.bias.enabled = false;
+  a.tk[2] = 0.12f;
+  imuSetTemperature(a, 31.5f);
+  a.yaw = 12.5f;
+  a.q = quatMake(0.9f, 0.1f, -0.2f, 0.3f);
+  a.q_init = true;
+  a.off_roll = 4.0f;
+  a.gap_s = 0.004f;
+  setFusionEngine(a, FUSION_MAHONY);
+
+  uint8_t buf[TRACE_IMU_STATE_LEN], again[TRACE_IMU_STATE_LEN];
+  imuStateEncode(a, buf);
+  ImuState b;
+  imuStateDecode(buf, b);
+  imuStateEncode(b, again);
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, sizeof(buf));
+  TEST_ASSERT_EQUAL_INT(FUSION_MAHONY, b.engine);
+  TEST_ASSERT_FALSE(b.bias.enabled);
+  TEST_ASSERT_TRUE(b.has_temp);
+  TEST_ASSERT_EQUAL_UINT16(17, b.bias.n);
+  TEST_ASSERT_EQUAL_FLOAT(31.5f, b.temp_c);
+
+  // ta sama próbka na kopii i oryginale -> identyczny stan
+  MpuSample s;
+  s.az = 1.0f;
+  s.gx = 3.0f;
+  fuseImuSample(a, s, 0.002f);
+  fuseImuSample(b, s, 0.002f);
+  imuStateEncode(a, buf);
+  imuStateEncode(b, again);
+  TEST_ASSERT_EQUAL_MEMORY(buf, again, sizeof(buf));
+}
+
+static void test_parser_skips_text_and_bad_crc(void) {
+  std::vector<uint8_t> stream;
+  uint8_t rec[TRACE_RECORD_MAX];
+  const char* text = "[TRACE] on records=0\n";
+  stream.insert(stream.end(), text, text + strlen(text));
+  MpuConfig cfg;
+  stream.insert(stream.end(), rec, rec + traceEncodeConfig(rec, cfg, true));
+  TraceSample s;
+  s.seq = 7;
+  s.t_us = 0x123456789ULL;
+  s.dt = 0.002f;
+  s.ok1 = true;
+  s.raw1.gz = -1234;
+  s.raw2.ax = 32767;
+  size_t n = traceEncodeSample(rec, s);
+  rec[10] ^= 0x40; // uszkodzony rekord
+  stream.insert(stream.end(), rec, rec + n);
+  rec[10] ^= 0x40;
+  stream.insert(stream.end(), rec, rec + n);
+
+  static TraceParser p;
+  int got = 0;
+  TraceSample d;
+  for (size_t i = 0; i < stream.size(); i++) {
+    uint8_t type;
+    const uint8_t* payload;
+    size_t len;
+    if (!traceParserFeed(p, stream[i], type, payload, len)) continue;
+    got++;
+    if (type == TRACE_REC_SAMPLE) TEST_ASSERT_TRUE(traceDecodeSample(payload, len, d));
+  }
+  TEST_ASSERT_EQUAL_INT(2, got);
+  TEST_ASSERT_EQUAL_UINT32(1, p.crc_errors);
+  TEST_ASSERT_EQUAL_UINT32(7, d.seq);
+  TEST_ASSERT_TRUE(d.t_us == s.t_us);
+  TEST_ASSERT_TRUE(d.ok1 && !d.ok2);
+  TEST_ASSERT_EQUAL_INT16(-1234, d.raw1.gz);
+  TEST_ASSERT_EQUAL_INT16(32767, d.raw2.ax);
+}
+
+// Potok "na żywo" (jak akwizycja w firmware: zmiany stanu poza fuzją, błędy
+// odczytu, zmiana zakresu, zgubione rekordy) i odtworzenie jego śladu.
+static void test_replay_is_bit_identical(void) {
+  std::vector<uint8_t> trace;
+  std::vector<KneeSample> live;
+  uint8_t rec[TRACE_RECORD_MAX];
+  ImuState imu1, imu2;
+  MpuConfig cfg;
+  MpuScaleFactors scale = mpuScaleFactors(cfg);
+  bool state_dirty = true, config_dirty = true;
+  uint32_t seq = 0, rng = 11;
+  const float dt = 0.002f;
+
+  for (int i = 0; i < 6000; i++) {
+    if (i == 700)  { captureMountOffsets(imu1); captureMountOffsets(imu2); state_dirty = true; }
+    if (i == 1700) { setFusionEngine(imu1, FUSION_MADGWICK); setFusionEngine(imu2, FUSION_MADGWICK); state_dirty = true; }
+    if (i % 500 == 0) { imuSetTemperature(imu1, 25.0f + i * 0.001f); state_dirty = true; }
+    if (i == 3300) {
+      const float k[3] = {0.01f, 0.02f, 0.1f};
+      imuSetTempSlopes(imu2, k);
+      state_dirty = true;
+    }
+    if (i == 4100) { cfg.gyro_range = MPU_GYRO_1000DPS; scale = mpuScaleFactors(cfg); config_dirty = true; }
+
+    TraceSample ts;
+    ts.seq = seq++;
+    ts.t_us = 1000000ULL + (uint64_t)i * 2000;
+    ts.dt = dt;
+    ts.ok1 = (i % 97) != 0;  // sporadyczne błędy odczytu
+    ts.ok2 = (i / 50) % 40 != 7; // przerwa 50 próbek (dłuższa niż GAP_FILL_MAX_S)
+    ts.raw1 = rawAt(i, 0, rng);
+    ts.raw2 = rawAt(i, 1, rng);
+
+    const bool drop = (i >= 2000 && i < 2010); // pełny bufor: rekordy tracone
+    if (!drop) {
+      if (config_dirty) { trace.insert(trace.end(), rec, rec + traceEncodeConfig(rec, cfg, true)); config_dirty = false; }
+      if (state_dirty)  { trace.insert(trace.end(), rec, rec + traceEncodeState(rec, imu1, imu2)); state_dirty = false; }
+      trace.insert(trace.end(), rec, rec + traceEncodeSample(rec, ts));
+    } else {
+      state_dirty = true;
+    }
+
+    MpuSample s1, s2;
+    mpuScale(ts.raw1, scale, s1);
+    mpuScale(ts.raw2, scale, s2);
+    KneeSample k;
+    fuseKneeStep(ts.t_us, dt, imu1, ts.ok1, s1, imu2, ts.ok2, s2, k);
+    if (!drop) live.push_back(k);
+  }
+
+  static TraceParser p;
+  static TraceReplay r;
+  size_t next = 0;
+  int mismatches = 0;
+  for (size_t i = 0; i < trace.size(); i++) {
+    uint8_t type;
+    const uint8_t* payload;
+    size_t len;
+    KneeSample k;
+    if (!traceParserFeed(p, trace[i], type, payload, len)) continue;
+    if (!traceReplayRecord(r, type, payload, len, k)) continue;
+    if (next >= live.size() || !sameSample(k, live[next])) mismatches++;
+    next++;
+  }
+  TEST_ASSERT_EQUAL_INT(0, mismatches);
+  TEST_ASSERT_EQUAL_size_t(live.size(), next);
+  TEST_ASSERT_TRUE(r.lost == 10);
+  TEST_ASSERT_TRUE(r.waiting == 0); // STATE zaraz po stracie
+  TEST_ASSERT_EQUAL_UINT32(0, p.crc_errors);
+  TEST_ASSERT_TRUE(r.configs == 2);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_state_roundtrip);
+  RUN_TEST(test_parser_skips_text_and_bad_crc);
+  RUN_TEST(test_replay_is_bit_identical);
+  return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include "fusion.h"
+#include "sensor_array.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_address_conflicts(void) {
+  const SensorDesc ok[] = {
+    {"a", 0, 0x68, MUX_NONE}, {"b", 0, 0x69, MUX_NONE}, // bez multipleksera
+    {"c", 1, 0x68, MUX_NONE},                           // ten sam adres na drugim porcie
+  };
+  TEST_ASSERT_EQUAL_INT(-1, sensorArrayCheck(ok, 3));
+
+  // za różnymi kanałami ten sam adres jest dozwolony, za tym samym – nie
+  const SensorDesc mux[] = {
+    {"a", 0, 0x68, 0}, {"b", 0, 0x69, 0}, {"c", 0, 0x68, 1}, {"d", 0, 0x68, 1},
+  };
+  TEST_ASSERT_EQUAL_INT(-1, sensorArrayCheck(mux, 3));
+  TEST_ASSERT_EQUAL_INT(3, sensorArrayCheck(mux, 4));
+
+  // czujnik bez multipleksera jest widoczny przy każdym kanale
+  const SensorDesc shadow[] = {{"a", 0, 0x68, 2}, {"b", 0, 0x68, MUX_NONE}};
+  TEST_ASSERT_EQUAL_INT(1, sensorArrayCheck(shadow, 2));
+
+  const SensorDesc bad_port[]  = {{"a", 0, 0x68, MUX_NONE}, {"b", 2, 0x68, MUX_NONE}};
+  const SensorDesc bad_ch[]    = {{"a", 0, 0x68, 8}};
+  const SensorDesc bad_addr[]  = {{"a", 0, MUX_ADDR, MUX_NONE}};
+  TEST_ASSERT_EQUAL_INT(1, sensorArrayCheck(bad_port, 2));
+  TEST_ASSERT_EQUAL_INT(0, sensorArrayCheck(bad_ch, 1));
+  TEST_ASSERT_EQUAL_INT(0, sensorArrayCheck(bad_addr, 1));
+}
+
+static void test_joint_check(void) {
+  const JointDesc j[] = {{"knee", 0, 1}, {"hip", 2, 0}, {"bad", 1, 1}, {"out", 0, 3}};
+  TEST_ASSERT_EQUAL_INT(-1, jointArrayCheck(j, 2, 3));
+  TEST_ASSERT_EQUAL_INT(2, jointArrayCheck(j, 3, 3));
+  TEST_ASSERT_EQUAL_INT(1, jointArrayCheck(j + 1, 3, 3));
+}
+
+static void test_port_order_groups_mux_channels(void) {
+  const SensorDesc s[] = {
+    {"a", 0, 0x68, 1}, {"b", 1, 0x68, MUX_NONE}, {"c", 0, 0x69, MUX_NONE},
+    {"d", 0, 0x69, 0}, {"e", 0, 0x69, 1},        {"f", 1, 0x69, MUX_NONE},
+  };
+  uint8_t order[SENSORS_MAX];
+  TEST_ASSERT_EQUAL_UINT32(4, sensorPortOrder(s, 6, 0, order));
+  const uint8_t expect0[4] = {2, 3, 0, 4}; // bez mux, kanał 0, kanał 1 (a przed e)
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expect0, order, 4);
+  TEST_ASSERT_EQUAL_UINT32(2, sensorPortOrder(s, 6, 1, order));
+  TEST_ASSERT_EQUAL_UINT8(1, order[0]);
+  TEST_ASSERT_EQUAL_UINT8(5, order[1]);
+  TEST_ASSERT_EQUAL_UINT32(4, sensorPortMaxLoad(s, 6));
+
+  MuxPort m;
+  TEST_ASSERT_FALSE(muxNeedsSelect(m, MUX_NONE));
+  TEST_ASSERT_TRUE(muxNeedsSelect(m, 0));
+  m.ch = 0;
+  TEST_ASSERT_FALSE(muxNeedsSelect(m, 0));
+  TEST_ASSERT_TRUE(muxNeedsSelect(m, 1));
+}
+
+// Kąt stawu z dowolnej pary = knee_angle z computeKneeSample (te same operacje).
+static void test_joint_angle_matches_knee(void) {
+  ImuState a, b;
+  a.k_roll.angle_deg = 170.0f;
+  b.k_roll.angle_deg = -150.0f;
+  b.off_roll = 5.0f;
+  KneeSample k;
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_EQUAL_FLOAT(k.knee_angle, jointAngleDeg(a, true, b, true));
+  TEST_ASSERT_EQUAL_FLOAT(ANGLE_INVALID, jointAngleDeg(a, true, b, false));
+
+  setFusionEngine(a, FUSION_MADGWICK);
+  setFusionEngine(b, FUSION_MADGWICK);
+  a.q = quatFromRollPitchDeg(10.0f, 0.0f);
+  b.q = quatFromRollPitchDeg(-30.0f, 0.0f);
+  computeKneeSample(0, a, true, b, true, k);
+  TEST_ASSERT_EQUAL_FLOAT(k.knee_angle, jointAngleDeg(a, true, b, true));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_address_conflicts);
+  RUN_TEST(test_joint_check);
+  RUN_TEST(test_port_order_groups_mux_channels);
+  RUN_TEST(test_joint_angle_matches_knee);
+  return UNITY_END();
+}
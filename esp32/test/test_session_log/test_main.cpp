@@ -0,0 +1,194 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "session_log.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static KneeSample makeSample(uint32_t i) {
+  KneeSample s;
+  s.t_us = 0xFFF00000ull + i * 2000u; // przez granicę 2^32 us
+  s.roll1 = 0.01f * (int)(i % 1000);
+  s.pitch1 = -12.34f;
+  s.yaw1 = 179.99f;
+  s.roll2 = (i % 50 == 7) ? ANGLE_INVALID : -45.5f;
+  s.pitch2 = 0.0f;
+  s.yaw2 = -180.0f;
+  s.knee_angle = (i % 50 == 7) ? ANGLE_INVALID : 90.25f;
+  s.inv2 = (i % 3) == 0;
+  s.q1 = (i % 5) == 0 ? QUALITY_GYRO_ONLY : QUALITY_MEASURED;
+  s.q2 = (i % 50 == 7) ? QUALITY_INVALID : QUALITY_MEASURED;
+  return s;
+}
+
+// Odczyt całego zakresu [oldest, next) do tablicy próbek (uszkodzone bloki pomijane).
+static size_t readAll(SessionLog& lg, KneeSample* out, size_t max) {
+  uint8_t blk[LOG_BLOCK_SIZE];
+  size_t n = 0;
+  for (uint32_t seq = lg.oldest_seq; seq != lg.next_seq; seq++) {
+    if (logReadBlock(lg, seq, blk)) n += logDecodeBlock(blk, out + n, max - n);
+  }
+  return n;
+}
+
+static void test_roundtrip_through_host_file(void) {
+  FILE* f = tmpfile();
+  TEST_ASSERT_NOT_NULL(f);
+  static SessionLog lg;
+  TEST_ASSERT_TRUE(logOpen(lg, logFileStorage(f, 64)));
+  TEST_ASSERT_EQUAL_UINT32(0, logBlockCount(lg));
+
+  const uint32_t N = 200;
+  for (uint32_t i = 0; i < N; i++) TEST_ASSERT_TRUE(logAppend(lg, makeSample(i)));
+  TEST_ASSERT_TRUE(logFlush(lg)); // niepełny ostatni blok
+  TEST_ASSERT_EQUAL_UINT32((N + LOG_SAMPLES_PER_BLOCK - 1) / LOG_SAMPLES_PER_BLOCK, logBlockCount(lg));
+
+  // po "restarcie" zakres i próbki odtworzone z pliku
+  static SessionLog rd;
+  TEST_ASSERT_TRUE(logOpen(rd, logFileStorage(f, 64)));
+  TEST_ASSERT_EQUAL_UINT32(lg.oldest_seq, rd.oldest_seq);
+  TEST_ASSERT_EQUAL_UINT32(lg.next_seq, rd.next_seq);
+  TEST_ASSERT_EQUAL_UINT16(1, rd.session);
+
+  static KneeSample got[256];
+  TEST_ASSERT_EQUAL_size_t(N, readAll(rd, got, 256));
+  for (uint32_t i = 0; i < N; i++) {
+    const KneeSample e = makeSample(i);
+    TEST_ASSERT_EQUAL_UINT64(e.t_us, got[i].t_us);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.roll1, got[i].roll1);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.pitch1, got[i].pitch1);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.yaw2, got[i].yaw2);
+    TEST_ASSERT_EQUAL_FLOAT(e.roll2, got[i].roll2);
+    TEST_ASSERT_EQUAL_FLOAT(e.knee_angle, got[i].knee_angle);
+    TEST_ASSERT_EQUAL(e.inv2, got[i].inv2);
+    TEST_ASSERT_EQUAL_UINT8(e.q1, got[i].q1);
+    TEST_ASSERT_EQUAL_UINT8(e.q2, got[i].q2);
+  }
+  fclose(f);
+}
+
+static void test_circular_overwrite_and_reopen(void) {
+  FILE* f = tmpfile();
+  static SessionLog lg;
+  logOpen(lg, logFileStorage(f, 4));
+  const uint32_t blocks = 10;
+  for (uint32_t i = 0; i < blocks * LOG_SAMPLES_PER_BLOCK; i++) logAppend(lg, makeSample(i));
+  TEST_ASSERT_EQUAL_UINT32(blocks, lg.next_seq);
+  TEST_ASSERT_EQUAL_UINT32(blocks - 4, lg.oldest_seq);
+
+  uint8_t blk[LOG_BLOCK_SIZE];
+  TEST_ASSERT_FALSE(logReadBlock(lg, blocks - 5, blk)); // nadpisany
+  TEST_ASSERT_FALSE(logReadBlock(lg, blocks, blk));     // jeszcze nie istnieje
+  TEST_ASSERT_TRUE(logReadBlock(lg, blocks - 4, blk));
+  LogBlockInfo info;
+  TEST_ASSERT_TRUE(logBlockValid(blk, &info));
+  TEST_ASSERT_EQUAL_UINT64(makeSample((blocks - 4) * LOG_SAMPLES_PER_BLOCK).t_us, info.t0_us);
+
+  logNewSession(lg);
+  for (uint32_t i = 0; i < LOG_SAMPLES_PER_BLOCK; i++) logAppend(lg, makeSample(i));
+  static SessionLog rd;
+  logOpen(rd, logFileStorage(f, 4));
+  TEST_ASSERT_EQUAL_UINT32(blocks + 1, rd.next_seq);
+  TEST_ASSERT_EQUAL_UINT32(blocks - 3, rd.oldest_seq);
+  TEST_ASSERT_EQUAL_UINT16(2, rd.session);
+  fclose(f);
+}
+
+static void test_time_gap_starts_new_block(void) {
+  FILE* f = tmpfile();
+  static SessionLog lg;
+  logOpen(lg, logFileStorage(f, 8));
+  KneeSample a = makeSample(0), b = makeSample(1);
+  b.t_us = a.t_us + 70000; // > uint16 przyrostu
+  logAppend(lg, a);
+  logAppend(lg, b);
+  logFlush(lg);
+  TEST_ASSERT_EQUAL_UINT32(2, logBlockCount(lg));
+
+  KneeSample got[4];
+  TEST_ASSERT_EQUAL_size_t(2, readAll(lg, got, 4));
+  TEST_ASSERT_EQUAL_UINT64(a.t_us, got[0].t_us);
+  TEST_ASSERT_EQUAL_UINT64(b.t_us, got[1].t_us);
+  fclose(f);
+}
+
+static void test_torn_block_is_rejected(void) {
+  FILE* f = tmpfile();
+  static SessionLog lg;
+  logOpen(lg, logFileStorage(f, 8));
+  for (uint32_t i = 0; i < 3 * LOG_SAMPLES_PER_BLOCK; i++) logAppend(lg, makeSample(i));
+
+  // przerwany zapis ostatniego bloku: druga połowa slotu zostaje stara
+  fseek(f, 2 * (long)LOG_BLOCK_SIZE + 300, SEEK_SET);
+  const uint8_t junk[16] = {0xFF};
+  fwrite(junk, 1, sizeof(junk), f);
+  fflush(f);
+
+  uint8_t blk[LOG_BLOCK_SIZE];
+  TEST_ASSERT_FALSE(logReadBlock(lg, 2, blk));
+  static SessionLog rd;
+  logOpen(rd, logFileStorage(f, 8));
+  TEST_ASSERT_EQUAL_UINT32(0, rd.oldest_seq);
+  TEST_ASSERT_EQUAL_UINT32(2, rd.next_seq); // nowe bloki nadpiszą uszkodzony slot
+  fclose(f);
+}
+
+static void test_block_layout_is_compact(void) {
+  TEST_ASSERT_EQUAL_size_t(28, LOG_SAMPLES_PER_BLOCK);
+  // ~18.3 B/próbkę wobec 29 B ramki binarnej i ~60 B CSV
+  TEST_ASSERT_TRUE((float)LOG_BLOCK_SIZE / LOG_SAMPLES_PER_BLOCK < 18.5f);
+  static SessionLog lg;
+  TEST_ASSERT_FALSE(logOpen(lg, logFileStorage(nullptr, 16)));
+}
+
+static void test_delta_blocks_roundtrip_and_mix(void) {
+  FILE* f = tmpfile();
+  static SessionLog lg;
+  logOpen(lg, logFileStorage(f, 64));
+  const uint32_t N = 400;
+  for (uint32_t i = 0; i < 100; i++) logAppend(lg, makeSample(i));
+  TEST_ASSERT_TRUE(logSetKind(lg, LOG_KIND_KNEE_DELTA)); // niepełny blok 17 B zamknięty
+  TEST_ASSERT_FALSE(logSetKind(lg, 0x7F));
+  const uint32_t plain_blocks = logBlockCount(lg);
+  for (uint32_t i = 100; i < N; i++) logAppend(lg, makeSample(i));
+  logFlush(lg);
+
+  // te same próbki w ~1.7x mniejszej liczbie bloków
+  const uint32_t delta_blocks = logBlockCount(lg) - plain_blocks;
+  TEST_ASSERT_TRUE(delta_blocks * LOG_SAMPLES_PER_BLOCK * 3 < (N - 100) * 2);
+
+  static SessionLog rd;
+  logOpen(rd, logFileStorage(f, 64));
+  uint8_t blk[LOG_BLOCK_SIZE];
+  LogBlockInfo info;
+  TEST_ASSERT_TRUE(logReadBlock(rd, rd.next_seq - 1, blk));
+  TEST_ASSERT_TRUE(logBlockValid(blk, &info));
+  TEST_ASSERT_EQUAL_UINT8(LOG_KIND_KNEE_DELTA, info.kind);
+
+  static KneeSample got[512];
+  TEST_ASSERT_EQUAL_size_t(N, readAll(rd, got, 512));
+  for (uint32_t i = 0; i < N; i++) {
+    const KneeSample e = makeSample(i);
+    TEST_ASSERT_EQUAL_UINT64(e.t_us, got[i].t_us);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.roll1, got[i].roll1);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, e.yaw1, got[i].yaw1);
+    TEST_ASSERT_EQUAL_FLOAT(e.knee_angle, got[i].knee_angle);
+    TEST_ASSERT_EQUAL(e.inv2, got[i].inv2);
+    TEST_ASSERT_EQUAL_UINT8(e.q1, got[i].q1);
+    TEST_ASSERT_EQUAL_UINT8(e.q2, got[i].q2);
+  }
+  fclose(f);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_roundtrip_through_host_file);
+  RUN_TEST(test_circular_overwrite_and_reopen);
+  RUN_TEST(test_time_gap_starts_new_block);
+  RUN_TEST(test_torn_block_is_rejected);
+  RUN_TEST(test_block_layout_is_compact);
+  RUN_TEST(test_delta_blocks_roundtrip_and_mix);
+  return UNITY_END();
+}
@@ -0,0 +1,165 @@
+#include <unity.h>
+
+#include <thread>
+
+#include "fusion.h"
+#include "mpu6050.h"
+#include "spsc_ring.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_fifo_order_and_full(void) {
+  static SpscRing<int, 4> r;
+  TEST_ASSERT_TRUE(r.empty());
+  TEST_ASSERT_EQUAL_size_t(4, r.capacity());
+  for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(r.push(i));
+  TEST_ASSERT_FALSE(r.push(99));
+  TEST_ASSERT_EQUAL_UINT32(1, r.dropped());
+  TEST_ASSERT_EQUAL_size_t(4, r.size());
+
+  int v = -1;
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(r.pop(v));
+    TEST_ASSERT_EQUAL_INT(i, v);
+  }
+  TEST_ASSERT_FALSE(r.pop(v));
+}
+
+static void test_index_wraparound(void) {
+  static SpscRing<uint32_t, 8> r;
+  uint32_t next_out = 0;
+  for (uint32_t i = 0; i < 1000; i++) {
+    TEST_ASSERT_TRUE(r.push(i));
+    if (i % 3 == 0) continue;
+    uint32_t v;
+    while (r.size() > 2 && r.pop(v)) TEST_ASSERT_EQUAL_UINT32(next_out++, v);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, r.dropped());
+}
+
+// Bloki zmiennej długości (ślad surowy): wszystko albo nic, także przez
+// zawinięcie indeksu
+static void test_block_push_pop(void) {
+  static SpscRing<uint8_t, 16> r;
+  uint8_t in[12], out[12];
+  uint8_t next_in = 0, next_out = 0;
+  for (int round = 0; round < 50; round++) {
+    const size_t n = 3 + (size_t)(round % 7);
+    for (size_t i = 0; i < n; i++) in[i] = next_in++;
+    TEST_ASSERT_TRUE(r.pushN(in, n));
+    TEST_ASSERT_FALSE(r.popN(out, n + 1)); // mniej w buforze -> nic nie zdjęte
+    TEST_ASSERT_TRUE(r.popN(out, n));
+    for (size_t i = 0; i < n; i++) TEST_ASSERT_EQUAL_UINT8(next_out++, out[i]);
+  }
+  TEST_ASSERT_TRUE(r.pushN(in, 12));
+  TEST_ASSERT_FALSE(r.pushN(in, 5)); // zostały 4 miejsca
+  TEST_ASSERT_EQUAL_size_t(12, r.size());
+  TEST_ASSERT_EQUAL_UINT32(1, r.dropped());
+  TEST_ASSERT_TRUE(r.pushN(in, 4));
+  TEST_ASSERT_FALSE(r.pushN(in, 20));
+}
+
+// Rekord, którego wszystkie pola wynikają z numeru – rozerwany zapis/odczyt
+// (mieszanka dwóch próbek) daje niespójne pola.
+static KneeSample makeRecord(uint32_t n) {
+  KneeSample k;
+  k.t_us = n;
+  k.roll1 = (float)(n & 0xFFFF);
+  k.pitch1 = k.roll1 + 1.0f;
+  k.yaw1 = k.roll1 + 2.0f;
+  k.roll2 = k.roll1 + 3.0f;
+  k.pitch2 = k.roll1 + 4.0f;
+  k.yaw2 = k.roll1 + 5.0f;
+  k.knee_angle = k.roll1 + 6.0f;
+  k.inv1 = (n & 1) != 0;
+  k.inv2 = (n & 2) != 0;
+  return k;
+}
+
+static bool recordConsistent(const KneeSample& k) {
+  const KneeSample e = makeRecord(k.t_us);
+  return k.roll1 == e.roll1 && k.pitch1 == e.pitch1 && k.yaw1 == e.yaw1 &&
+         k.roll2 == e.roll2 && k.pitch2 == e.pitch2 && k.yaw2 == e.yaw2 &&
+         k.knee_angle == e.knee_angle && k.inv1 == e.inv1 && k.inv2 == e.inv2;
+}
+
+static SpscRing<KneeSample, 64> knee_ring;
+
+static void test_two_threads_knee_samples_no_tearing(void) {
+  const uint32_t COUNT = 200000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < COUNT; i++) {
+      const KneeSample k = makeRecord(i);
+      while (!knee_ring.push(k)) std::this_thread::yield();
+    }
+  });
+
+  uint32_t expected = 0, torn = 0, out_of_order = 0;
+  KneeSample k;
+  while (expected < COUNT) {
+    if (!knee_ring.pop(k)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (!recordConsistent(k)) torn++;
+    if (k.t_us != expected) out_of_order++;
+    expected = k.t_us + 1;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+  TEST_ASSERT_TRUE(knee_ring.empty());
+}
+
+static SpscRing<MpuRawPair, 32> raw_ring;
+
+static void test_two_threads_raw_frames_with_drops(void) {
+  // Producent nie czeka (jak akwizycja): pełny bufor -> odrzucenie + licznik
+  const uint32_t COUNT = 200000;
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < COUNT; i++) {
+      MpuRawPair p;
+      p.t_us = i;
+      p.imu1.ax = (int16_t)i;
+      p.imu1.gz = (int16_t)~i;
+      p.imu2.ay = (int16_t)(i >> 3);
+      p.imu2.gx = (int16_t)(i * 7);
+      raw_ring.push(p);
+    }
+  });
+
+  uint32_t received = 0, torn = 0, last = 0;
+  bool first = true, ordered = true, done = false;
+  MpuRawPair p;
+  while (!done) {
+    if (!raw_ring.pop(p)) {
+      done = (received + raw_ring.dropped() == COUNT) && raw_ring.empty();
+      std::this_thread::yield();
+      continue;
+    }
+    const uint32_t i = p.t_us;
+    if (p.imu1.ax != (int16_t)i || p.imu1.gz != (int16_t)~i ||
+        p.imu2.ay != (int16_t)(i >> 3) || p.imu2.gx != (int16_t)(i * 7)) torn++;
+    if (!first && i <= last) ordered = false;
+    first = false;
+    last = i;
+    received++;
+  }
+  producer.join();
+
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL_UINT32(COUNT, received + raw_ring.dropped());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order_and_full);
+  RUN_TEST(test_index_wraparound);
+  RUN_TEST(test_block_push_pop);
+  RUN_TEST(test_two_threads_knee_samples_no_tearing);
+  RUN_TEST(test_two_threads_raw_frames_with_drops);
+  return UNITY_END();
+}
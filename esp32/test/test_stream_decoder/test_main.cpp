@@ -0,0 +1,192 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stream_decoder.h"
+#include "telemetry.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const uint64_t T0 = 0xFFFF0000ull; // przez granicę 2^32 us
+static const uint32_t PERIOD_US = 2000;
+
+static KneeSample makeSample(uint32_t i) {
+  KneeSample s;
+  s.t_us = T0 + (uint64_t)i * PERIOD_US;
+  s.roll1 = 0.25f * (i % 100);
+  s.pitch1 = -10.0f;
+  s.yaw1 = 90.0f;
+  s.roll2 = 5.0f;
+  s.pitch2 = -0.5f;
+  s.yaw2 = 179.0f;
+  s.knee_angle = 30.0f + 0.1f * (i % 200);
+  return s;
+}
+
+struct Capture {
+  uint32_t  samples = 0;
+  uint64_t  last_t  = 0;
+  uint32_t  gaps    = 0;
+  StreamGap gap[8];
+};
+
+static void onSample(void* ctx, const KneeSample& s, StreamFrameKind, uint64_t) {
+  Capture& c = *(Capture*)ctx;
+  c.samples++;
+  c.last_t = s.t_us;
+}
+
+static void onGap(void* ctx, const StreamGap& g) {
+  Capture& c = *(Capture*)ctx;
+  if (c.gaps < 8) c.gap[c.gaps] = g;
+  c.gaps++;
+}
+
+static void initDecoder(StreamDecoder& d, Capture& c) {
+  d.on_sample = onSample;
+  d.on_gap = onGap;
+  d.ctx = &c;
+  streamDecoderInit(d);
+}
+
+static void feedText(StreamDecoder& d, const char* s) {
+  streamDecoderFeed(d, (const uint8_t*)s, strlen(s));
+}
+
+static void test_seq_tracker_gaps_reorder_wrap(void) {
+  SeqTracker t;
+  uint64_t missing = 0;
+  TEST_ASSERT_EQUAL(SEQ_IN_ORDER, seqTrackerPush(t, 65533, 16, missing));
+  TEST_ASSERT_EQUAL(SEQ_IN_ORDER, seqTrackerPush(t, 65534, 16, missing));
+  TEST_ASSERT_EQUAL(SEQ_GAP, seqTrackerPush(t, 1, 16, missing)); // 65535 i 0 brak, zawinięcie
+  TEST_ASSERT_EQUAL_UINT64(2, missing);
+  TEST_ASSERT_EQUAL(SEQ_LATE, seqTrackerPush(t, 65535, 16, missing));
+  TEST_ASSERT_EQUAL(SEQ_DUPLICATE, seqTrackerPush(t, 65535, 16, missing));
+  TEST_ASSERT_EQUAL(SEQ_IN_ORDER, seqTrackerPush(t, 2, 16, missing));
+  TEST_ASSERT_EQUAL_UINT64(65533 + 6, t.next);
+  TEST_ASSERT_EQUAL_UINT64(5, t.received);
+  TEST_ASSERT_EQUAL_UINT64(1, t.lost);
+  TEST_ASSERT_EQUAL_UINT64(1, t.late);
+  TEST_ASSERT_EQUAL_UINT64(1, t.duplicates);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f / 6.0f, seqLossPct(t));
+
+  TEST_ASSERT_EQUAL(SEQ_RESTART, seqTrackerPush(t, 40000, 16, missing));
+  TEST_ASSERT_EQUAL_UINT64(1, t.restarts);
+}
+
+static void test_binary_frames_with_loss_text_and_noise(void) {
+  static StreamDecoder d;
+  Capture c;
+  initDecoder(d, c);
+  feedText(d, "[FORMAT] bin\n");
+  uint8_t frame[BIN_FRAME_LEN];
+  for (uint32_t i = 0; i < 100; i++) {
+    if (i >= 40 && i < 45) continue; // 5 ramek utraconych (pełny bufor SPP)
+    encodeBinaryFrame(frame, (uint16_t)i, makeSample(i));
+    if (i == 70) frame[10] ^= 0x40;   // uszkodzona – też luka
+    streamDecoderFeed(d, frame, sizeof(frame));
+    if (i == 20) feedText(d, "[I2C] IMU2 read error\n");
+  }
+  streamDecoderFinish(d);
+
+  TEST_ASSERT_EQUAL_UINT32(94, c.samples);
+  TEST_ASSERT_EQUAL_UINT32(2, c.gaps);
+  TEST_ASSERT_EQUAL_UINT64(40, c.gap[0].first_seq);
+  TEST_ASSERT_EQUAL_UINT64(5, c.gap[0].frames);
+  TEST_ASSERT_EQUAL_UINT64(5, c.gap[0].samples_est);
+  TEST_ASSERT_EQUAL_UINT64(makeSample(39).t_us, c.gap[0].t_before_us);
+  TEST_ASSERT_EQUAL_UINT64(makeSample(45).t_us, c.gap[0].t_after_us);
+  TEST_ASSERT_EQUAL_UINT64(1, c.gap[1].frames);
+  TEST_ASSERT_EQUAL_UINT64(2, d.stats.text_lines);
+  TEST_ASSERT_TRUE(d.stats.crc_errors >= 1);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 6.0f, seqLossPct(d.seq));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 6.0f, streamSampleLossPct(d));
+  TEST_ASSERT_EQUAL_UINT64(makeSample(99).t_us, c.last_t);
+}
+
+static void test_csv_and_labeled_lines(void) {
+  static StreamDecoder d;
+  Capture c;
+  initDecoder(d, c);
+  char line[TELEMETRY_LABELED_MAX];
+  for (uint32_t i = 0; i < 50; i++) {
+    if (i == 10 || i == 11) continue;
+    formatTelemetryCsv(line, sizeof(line), makeSample(i), i);
+    feedText(d, line);
+  }
+  TEST_ASSERT_EQUAL_UINT32(48, c.samples);
+  TEST_ASSERT_EQUAL_UINT32(1, c.gaps);
+  TEST_ASSERT_EQUAL_UINT64(2, c.gap[0].samples_est);
+  TEST_ASSERT_EQUAL_UINT64(makeSample(49).t_us, c.last_t); // > 2^32 bez zawinięcia
+
+  // przełączenie na format USB: nowy licznik, bez fałszywej luki
+  for (uint32_t i = 50; i < 60; i++) {
+    formatTelemetryLabeled(line, sizeof(line), makeSample(i), i - 50);
+    feedText(d, line);
+  }
+  TEST_ASSERT_EQUAL_UINT32(58, c.samples);
+  TEST_ASSERT_EQUAL_UINT32(1, c.gaps);
+  TEST_ASSERT_EQUAL_UINT8(STREAM_LABELED, d.kind);
+}
+
+static void test_delta_batches_gap_includes_resync(void) {
+  static TelemetryBatcher b;
+  batcherInit(b, 10, 20000, true);
+  static StreamDecoder d;
+  Capture c;
+  initDecoder(d, c);
+  uint8_t out[BATCH_OUT_MAX];
+  uint32_t frames = 0;
+  for (uint32_t i = 0; i < 200; i++) {
+    const size_t n = batcherPush(b, makeSample(i), 0, out);
+    if (n == 0) continue;
+    if (++frames == 7) continue; // paczka z próbkami 60..69 utracona
+    streamDecoderFeed(d, out, n);
+  }
+  // klatki co 50 próbek: 70..99 nie do odtworzenia -> jedna luka 60..99
+  TEST_ASSERT_EQUAL_UINT32(160, c.samples);
+  TEST_ASSERT_EQUAL_UINT32(1, c.gaps);
+  TEST_ASSERT_EQUAL_UINT64(1, c.gap[0].frames);
+  TEST_ASSERT_EQUAL_UINT64(40, c.gap[0].samples_est);
+  TEST_ASSERT_EQUAL_UINT64(makeSample(59).t_us, c.gap[0].t_before_us);
+  TEST_ASSERT_EQUAL_UINT64(makeSample(100).t_us, c.gap[0].t_after_us);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, streamSampleLossPct(d));
+}
+
+static void test_log_download_stream(void) {
+  FILE* f = tmpfile();
+  static SessionLog lg;
+  logOpen(lg, logFileStorage(f, 32));
+  logSetKind(lg, LOG_KIND_KNEE_DELTA);
+  for (uint32_t i = 0; i < 500; i++) logAppend(lg, makeSample(i));
+  logFlush(lg);
+
+  static StreamDecoder d;
+  Capture c;
+  initDecoder(d, c);
+  feedText(d, "[LOG] begin from=0 to=10 block=512\n");
+  uint8_t blk[LOG_BLOCK_SIZE];
+  for (uint32_t seq = lg.oldest_seq; seq != lg.next_seq; seq++) {
+    if (seq == 3) continue; // blok nieodczytany po stronie urządzenia
+    TEST_ASSERT_TRUE(logReadBlock(lg, seq, blk));
+    streamDecoderFeed(d, blk, sizeof(blk));
+  }
+  feedText(d, "[LOG] end next=10 sent=9 bad=1\n");
+
+  TEST_ASSERT_EQUAL_UINT32(1, c.gaps);
+  TEST_ASSERT_EQUAL_UINT64(3, c.gap[0].first_seq);
+  TEST_ASSERT_EQUAL_UINT32(500, c.samples + c.gap[0].samples_est);
+  TEST_ASSERT_EQUAL_UINT64(2, d.stats.text_lines);
+  fclose(f);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_seq_tracker_gaps_reorder_wrap);
+  RUN_TEST(test_binary_frames_with_loss_text_and_noise);
+  RUN_TEST(test_csv_and_labeled_lines);
+  RUN_TEST(test_delta_batches_gap_includes_resync);
+  RUN_TEST(test_log_download_stream);
+  return UNITY_END();
+}
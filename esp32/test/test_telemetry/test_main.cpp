@@ -0,0 +1,75 @@
+#include <unity.h>
+#include <string.h>
+
+#include "telemetry.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static KneeSample makeSample() {
+  KneeSample k;
+  k.t_us = 5000000123456ull; // ~58 dni: poza zakresem uint32
+  k.roll1 = 1.234f;
+  k.pitch1 = -2.5f;
+  k.yaw1 = 179.999f;
+  k.roll2 = 45.0f;
+  k.pitch2 = 0.0f;
+  k.yaw2 = -0.004f;
+  k.knee_angle = 43.77f;
+  k.inv1 = false;
+  k.inv2 = true;
+  k.q2 = QUALITY_GYRO_ONLY;
+  return k;
+}
+
+static void test_csv_format(void) {
+  char out[TELEMETRY_CSV_MAX];
+  const size_t n = formatTelemetryCsv(out, sizeof(out), makeSample(), 42);
+  TEST_ASSERT_EQUAL_STRING("5000000123456,1.23,-2.50,180.00,45.00,0.00,-0.00,43.77,0,1,0,1,42\n", out);
+  TEST_ASSERT_EQUAL_size_t(strlen(out), n);
+}
+
+static void test_csv_invalid_sentinel(void) {
+  KneeSample k = makeSample();
+  k.roll2 = k.pitch2 = k.yaw2 = k.knee_angle = ANGLE_INVALID;
+  char out[TELEMETRY_CSV_MAX];
+  TEST_ASSERT_GREATER_THAN(0, (int)formatTelemetryCsv(out, sizeof(out), k, 0));
+  TEST_ASSERT_NOT_NULL(strstr(out, ",-999.00,-999.00,-999.00,-999.00,"));
+}
+
+static void test_csv_too_small_buffer(void) {
+  char out[16];
+  TEST_ASSERT_EQUAL_size_t(0, formatTelemetryCsv(out, sizeof(out), makeSample(), 0));
+}
+
+static void test_labeled_format(void) {
+  char out[TELEMETRY_LABELED_MAX];
+  const size_t n = formatTelemetryLabeled(out, sizeof(out), makeSample(), 7);
+  TEST_ASSERT_EQUAL_STRING("time:5000000123456 roll1:1.23 pitch1:-2.50 yaw1:180.00"
+                           " roll2:45.00 pitch2:0.00 yaw2:-0.00"
+                           " knee_angle:43.77 inv1:0 inv2:1 q1:0 q2:1 seq:7\r\n", out);
+  TEST_ASSERT_EQUAL_size_t(strlen(out), n);
+}
+
+static void test_labeled_worst_case_fits(void) {
+  KneeSample k = makeSample();
+  k.t_us = UINT64_MAX;
+  k.roll1 = k.pitch1 = k.yaw1 = k.roll2 = k.pitch2 = k.yaw2 = k.knee_angle = ANGLE_INVALID;
+  k.inv1 = k.inv2 = true;
+  k.q1 = k.q2 = QUALITY_INVALID;
+  char out[TELEMETRY_LABELED_MAX];
+  TEST_ASSERT_GREATER_THAN(0, (int)formatTelemetryLabeled(out, sizeof(out), k, UINT32_MAX));
+  TEST_ASSERT_EQUAL_size_t(0, formatTelemetryLabeled(out, 32, k, UINT32_MAX));
+  char csv[TELEMETRY_CSV_MAX];
+  TEST_ASSERT_GREATER_THAN(0, (int)formatTelemetryCsv(csv, sizeof(csv), k, UINT32_MAX));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_csv_format);
+  RUN_TEST(test_csv_invalid_sentinel);
+  RUN_TEST(test_csv_too_small_buffer);
+  RUN_TEST(test_labeled_format);
+  RUN_TEST(test_labeled_worst_case_fits);
+  return UNITY_END();
+}
@@ -0,0 +1,139 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+
+#include "temp_comp.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const float FS_HZ = 500.0f;
+static const float DT = 1.0f / FS_HZ;
+
+// Bias „czujnika” zależny od temperatury: 0.8 + 0.15 * (T - 25) dps na osi z
+static const float TRUE_B0 = 0.8f;
+static const float TRUE_K  = 0.15f;
+
+static float noise(uint32_t& rng, float amp) {
+  rng = rng * 1664525u + 1013904223u;
+  return ((float)(rng >> 8) / 16777216.0f * 2.0f - 1.0f) * amp;
+}
+
+static MpuSample stillSample(uint32_t& rng, float temp_c) {
+  MpuSample s;
+  s.az = 1.0f + noise(rng, 0.003f);
+  s.gx = noise(rng, 0.2f);
+  s.gy = noise(rng, 0.2f);
+  s.gz = TRUE_B0 + TRUE_K * (temp_c - TEMP_REF_C) + noise(rng, 0.2f);
+  return s;
+}
+
+static void test_decode_temperature(void) {
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 36.53f, mpuTempC(0));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.53f, mpuTempC(-3740));
+  MpuRaw r;
+  const uint8_t burst[MPU_BURST_LEN] = {0, 0, 0, 0, 0, 0, 0xF1, 0x64, 0, 0, 0, 0, 0, 0};
+  mpuDecodeBurst(burst, r);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 25.53f, mpuTempC(r.temp));
+}
+
+static void test_fit_slopes_and_spread(void) {
+  TempBiasFit f;
+  float k[3];
+  for (int i = 0; i < 20; i++) {
+    const float t = 25.0f + 0.2f * (float)i;
+    const float b[3] = {0.1f, -0.05f * (t - TEMP_REF_C), TRUE_B0 + TRUE_K * (t - TEMP_REF_C)};
+    tempFitAddPoint(f, t, b);
+    if (i == 6) TEST_ASSERT_FALSE(tempFitSlopes(f, k)); // 7 punktów, odch. 0.4 °C < TEMP_FIT_MIN_STD_C
+  }
+  TEST_ASSERT_TRUE(tempFitSlopes(f, k));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.0f, k[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, -0.05f, k[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, TRUE_K, k[2]);
+
+  // nachylenie fizycznie niemożliwe -> brak modelu
+  TempBiasFit bad;
+  for (int i = 0; i < 20; i++) {
+    const float t = 20.0f + (float)i;
+    const float b[3] = {0, 0, 2.0f * (t - TEMP_REF_C)};
+    tempFitAddPoint(bad, t, b);
+  }
+  TEST_ASSERT_FALSE(tempFitSlopes(bad, k));
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, k[2]);
+}
+
+static void test_slopes_keep_bias_continuous(void) {
+  ImuState imu;
+  imu.bgz = 1.0f;
+  imuSetTemperature(imu, 31.0f);
+  const float before = imuBiasNow(imu, 2);
+  const float k[3] = {0.0f, 0.0f, 0.2f};
+  imuSetTempSlopes(imu, k);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, before, imuBiasNow(imu, 2));
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, 1.2f, imu.tc[2]);
+  imuSetTemperature(imu, 33.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-5f, before + 0.4f, imuBiasNow(imu, 2));
+}
+
+// Sesja z nagrzewaniem 25 -> 33 °C: model z okien bezruchu, potem ruch bez
+// przerw – bias idzie za temperaturą tylko z modelem.
+static void test_warming_session(void) {
+  ImuState imu;
+  imu.bgz = TRUE_B0; // kalibracja startowa w 25 °C
+  biasTrackerReset(imu.bias, 0.05f);
+  imuSetTemperature(imu, 25.0f);
+  TempBiasFit f;
+  uint32_t rng = 3;
+
+  const int n = (int)(20 * 60 * FS_HZ); // 20 min
+  for (int i = 0; i < n; i++) {
+    const float temp = 25.0f + 8.0f * (float)i / (float)n;
+    if (i % 500 == 0) imuSetTemperature(imu, temp); // odczyt TEMP_OUT co 1 s
+    fuseImuSample(imu, stillSample(rng, temp), DT);
+    if (i % 2 == 0 && tempFitObserve(f, imu, 2 * DT)) {
+      float k[3];
+      if (tempFitSlopes(f, k)) imuSetTempSlopes(imu, k);
+    }
+  }
+  float k[3];
+  TEST_ASSERT_TRUE(tempFitSlopes(f, k));
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, TRUE_K, k[2]);
+  TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.0f, k[0]);
+  TEST_ASSERT_TRUE(f.points >= TEMP_FIT_MIN_POINTS);
+
+  // dalsze nagrzewanie bez okien bezruchu (śledzenie wyłączone): model przewiduje bias
+  imu.bias.enabled = false;
+  imuSetTemperature(imu, 36.0f);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, TRUE_B0 + TRUE_K * 11.0f, imuBiasNow(imu, 2));
+}
+
+static void test_model_record_roundtrip(void) {
+  TempBiasFit fits[2];
+  const float b[3] = {0.5f, -0.25f, 1.0f};
+  tempFitAddPoint(fits[0], 27.0f, b);
+  tempFitAddPoint(fits[1], 30.0f, b);
+  fits[1].points = 77; // stan sesji nie jest zapisywany
+
+  uint8_t buf[TEMP_MODEL_LEN];
+  TEST_ASSERT_EQUAL_size_t(TEMP_MODEL_LEN, tempModelEncode(fits, buf));
+  TempBiasFit d[2];
+  TEST_ASSERT_TRUE(tempModelDecode(buf, sizeof(buf), d));
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, d[0].n);
+  TEST_ASSERT_EQUAL_FLOAT(2.0f, d[0].st);
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, d[1].st2);
+  TEST_ASSERT_EQUAL_FLOAT(-1.25f, d[1].stb[1]);
+  TEST_ASSERT_EQUAL_UINT32(0, d[1].points);
+
+  buf[10] ^= 0x01;
+  TEST_ASSERT_FALSE(tempModelDecode(buf, sizeof(buf), d));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_temperature);
+  RUN_TEST(test_fit_slopes_and_spread);
+  RUN_TEST(test_slopes_keep_bias_continuous);
+  RUN_TEST(test_warming_session);
+  RUN_TEST(test_model_record_roundtrip);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+// fwsim – podzbiór API Arduino-ESP32 używany przez src/main.cpp (host, Linux).
+// Implementacja: tools/fwsim/hal.cpp; opis całości: tools/fwsim/fwsim.cpp.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+// wartości jak w esp32-hal-gpio.h
+#define INPUT             0x01
+#define OUTPUT            0x03
+#define INPUT_PULLUP      0x05
+#define OUTPUT_OPEN_DRAIN 0x13
+
+#define RISING            0x01
+
+#define IRAM_ATTR
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n) {
+    size_t i = 0;
+    while (i < n && write(buf[i])) i++;
+    return i;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char* buf, size_t n) { return write((const uint8_t*)buf, n); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));  // jak w arduino-esp32
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { return print(v) + println(); }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+  void setTimeout(unsigned long ms) { timeout_ms_ = ms; }
+
+ protected:
+  unsigned long timeout_ms_ = 1000;
+};
+
+// UART0 (USB): zapis blokuje, gdy bufor TX jest pełny; bufor opróżnia się
+// z prędkością baud / 10 B/s. Wyjście -> stdout, wejście <- fwsimSerialInject.
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud);
+  void setTxBufferSize(size_t n);
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  int availableForWrite() override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+ public:
+  const char* getChipModel() { return "fwsim"; }
+  void restart();
+};
+
+extern EspClass ESP;
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// GPIO: linie SDA/SCL portów Wire trafiają do emulatora magistrali (odblokowanie)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+// Przerwanie GPIO: impulsy z emulatora czujnika (fwsimSetIntSource), ISR w osobnym wątku
+#define digitalPinToInterrupt(p) (p)
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
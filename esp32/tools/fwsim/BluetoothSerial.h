@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Arduino.h"
+
+typedef enum {
+  ESP_SPP_INIT_EVT = 0,
+  ESP_SPP_SRV_OPEN_EVT = 34,
+  ESP_SPP_CLOSE_EVT = 27,
+} esp_spp_cb_event_t;
+
+typedef union {
+  int unused;
+} esp_spp_cb_param_t;
+
+typedef void (*esp_spp_cb_t)(esp_spp_cb_event_t event, esp_spp_cb_param_t* param);
+
+// Radio bez klienta: begin() działa, hasClient() == false, zapis jest odrzucany.
+class BluetoothSerial : public Stream {
+ public:
+  bool begin(const char*) { return true; }
+  bool hasClient() { return false; }
+  void register_callback(esp_spp_cb_t cb) { cb_ = cb; }
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t n) override { return n; }
+  using Print::write;
+  int availableForWrite() override { return 0; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+
+ private:
+  esp_spp_cb_t cb_ = nullptr;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Brak partycji danych w fwsim: begin() zawodzi, firmware działa bez dziennika sesji
+// (ścieżka błędu jak przy uszkodzonym flashu).
+class LittleFSFS {
+ public:
+  bool begin(bool = false, const char* = "/littlefs", uint8_t = 10, const char* = "spiffs") {
+    return false;
+  }
+  void end() {}
+};
+
+extern LittleFSFS LittleFS;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Arduino.h"
+
+// NVS w pamięci (klucz "przestrzeń/klucz"); fwsim -n PLIK wczytuje i zapisuje całość.
+class Preferences {
+ public:
+  bool begin(const char* name, bool read_only = false, const char* partition_label = nullptr);
+  void end() {}
+  size_t putBytes(const char* key, const void* value, size_t len);
+  size_t getBytes(const char* key, void* buf, size_t max_len);
+  size_t getBytesLength(const char* key);
+  bool remove(const char* key);
+  bool isKey(const char* key) { return getBytesLength(key) > 0; }
+
+ private:
+  char ns_[16]    = {0};
+  bool read_only_ = false;
+};
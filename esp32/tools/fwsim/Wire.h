@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Arduino.h"
+
+struct I2cEmuBus;
+
+// Port I2C na emulatorze magistrali (lib/kgsim/src/i2c_emu.h). Transakcja trwa
+// tyle, ile wynika z zegara magistrali i opóźnień emulatora – wywołanie czeka.
+class TwoWire : public Stream {
+ public:
+  static const size_t BUFFER_LEN = 128; // I2C_BUFFER_LENGTH w Arduino-ESP32
+
+  explicit TwoWire(uint8_t bus_num) : num_(bus_num) {}
+
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool end();
+  bool setClock(uint32_t frequency);
+  void setTimeOut(uint16_t timeout_ms);
+
+  void beginTransmission(uint16_t address);
+  void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+  void beginTransmission(uint8_t address) { beginTransmission((uint16_t)address); }
+  uint8_t endTransmission(bool send_stop = true);
+  size_t requestFrom(uint16_t address, size_t size, bool send_stop = true);
+  size_t requestFrom(int address, int size, int send_stop) {
+    return requestFrom((uint16_t)address, (size_t)size, send_stop != 0);
+  }
+
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t* buf, size_t n) override;
+  using Print::write;
+  int available() override { return (int)(rx_len_ - rx_pos_); }
+  int read() override { return rx_pos_ < rx_len_ ? rx_[rx_pos_++] : -1; }
+  int peek() override { return rx_pos_ < rx_len_ ? rx_[rx_pos_] : -1; }
+
+  uint8_t num() const { return num_; }
+
+ private:
+  uint8_t  num_;
+  bool     begun_    = false;
+  uint16_t tx_addr_  = 0;
+  uint8_t  tx_[BUFFER_LEN];
+  size_t   tx_len_   = 0;
+  bool     tx_over_  = false;
+  uint8_t  rx_[BUFFER_LEN];
+  size_t   rx_len_ = 0, rx_pos_ = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// fwsim: typy i makra FreeRTOS (1 tick = 1 ms jak w Arduino-ESP32)
+
+typedef int          BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t     TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+
+#define portMAX_DELAY        ((TickType_t)0xFFFFFFFFu)
+#define portTICK_PERIOD_MS   1
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(ms))
+#define configMAX_PRIORITIES 25
+#define portYIELD_FROM_ISR(...) ((void)0) // powiadomienie z ISR budzi wątek od razu
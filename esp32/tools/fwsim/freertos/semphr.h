@@ -0,0 +1,12 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Semafor binarny FreeRTOS jako flaga + zmienna warunkowa (jak powiadomienia zadań).
+
+struct FwsimSemaphore;
+typedef FwsimSemaphore* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Zadania FreeRTOS jako wątki hosta: priorytet i rdzeń są pomijane (planista
+// Linuksa), powiadomienia zadań to licznik + zmienna warunkowa.
+
+struct FwsimTask;
+typedef FwsimTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core_id);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
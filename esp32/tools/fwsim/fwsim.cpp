@@ -0,0 +1,289 @@
+// fwsim – firmware KneeGuard (src/main.cpp: setup()/loop(), zadania, komendy)
+// na Linuksie z emulowanymi magistralami I2C i MPU6050 na poziomie rejestrów
+//
+// Czujniki (lib/kgsim/src/mpu6050_emu.h) są rozmieszczone jak w src/sensor_layout.h
+// (te same -DKG_SENSOR_LAYOUT=...): port Wire / Wire1, adres, kanał TCA9548A
+// (tca9548a_emu.h). Ruch z generatora knee_sim.h (szum, bias): czujniki "thigh*"
+// dostają udo, "shank*" podudzie, pozostałe leżą nieruchomo. INT czujnika
+// DRDY_SENSOR wywołuje ISR firmware pod DRDY_PIN (attachInterrupt). Magistrala
+// (i2c_emu.h) liczy czas transakcji z zegara ustawionego przez firmware plus
+// zadane opóźnienie, a usterki (NACK, odłączenie czujnika, zablokowana SDA)
+// sprawdzają ścieżki błędów i odzyskiwania bez sprzętu. Warstwa Arduino,
+// FreeRTOS i esp_timer (tools/fwsim/*.h, hal.cpp) działa na wątkach hosta
+// w czasie rzeczywistym – pomiary "stats" (takt, I2C, fuzja) mają sens jako
+// porównanie wersji kodu, nie jako czasy ESP32. Bez BT-klienta i bez LittleFS.
+//
+// Wyjście Serial -> stdout (tekst i ewentualny ślad surowy "trace on"),
+// podsumowanie magistrali i czujników -> stderr. Na 0.5 s przed końcem
+// fwsim wysyła komendę "stats".
+//
+// Budowanie (z katalogu esp32/):
+//   g++ -std=gnu++11 -O2 -pthread -Wall -Wextra -Itools/fwsim -Isrc -Ilib/kneeguard/src
+//       -Ilib/kgsim/src -Ilib/kgbench/src src/main.cpp tools/fwsim/*.cpp lib/kneeguard/src/*.cpp lib/kgsim/src/*.cpp
+//       -o fwsim
+// Użycie:
+//   fwsim [-t S] [-m still|squat|gait|hyperext] [-s SEED] [-l US] [-j US]
+//         [-f USTERKA]... [-c T:KOMENDA]... [-n PLIK_NVS]
+//   -t   czas działania [s] (10); ruch zaczyna się po 4 s bezruchu (kalibracja)
+//   -l/-j stałe opóźnienie / losowy rozrzut transakcji I2C [us]
+//   -f   [1/]nack:ADDR:T0:T1:P | detach:ADDR:T0:T1 | stuck:T0   (czasy [s], ADDR hex, 0 = każdy;
+//        "1/" = usterka na Wire1, bez prefiksu – Wire)
+//   -c   komenda na Serial w chwili T [s], np. -c 5:calib -c 6:stats
+//   -n   NVS (kalibracja) wczytany na starcie i zapisany na końcu
+// Przykład: odłączenie podudzia na 1 s i zablokowana magistrala
+//   fwsim -t 12 -m gait -f detach:69:6:7 -f stuck:9 -c 5:calib
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "fwsim.h"
+#include "i2c_emu.h"
+#include "knee_sim.h"
+#include "mpu6050_emu.h"
+#include "sensor_layout.h"
+#include "tca9548a_emu.h"
+
+void setup();
+void loop();
+
+static const float SIM_FS_HZ     = 1000.0f; // siatka generatora (maksymalne Fs czujnika)
+static const float SIM_STILL_S   = 4.0f;    // start + kalibracja żyroskopu
+static const float STATS_BEFORE_END_S = 0.5f;
+
+struct ImuFeed {
+  const std::vector<SimSample>* sim;
+  int k; // 0 = udo, 1 = podudzie
+};
+
+// Segment generatora dla czujnika z układu (po nazwie); -1 = nieruchomy.
+static int simSegment(const char* name) {
+  if (strncmp(name, "thigh", 5) == 0) return 0;
+  if (strncmp(name, "shank", 5) == 0) return 1;
+  return -1;
+}
+
+// Próbka generatora najbliższa chwili t_us (po końcu scenariusza: ostatnia).
+static void simSource(void* ctx, uint64_t t_us, MpuEmuReading& r) {
+  const ImuFeed& f = *(const ImuFeed*)ctx;
+  size_t i = (size_t)((double)t_us * 1e-6 * SIM_FS_HZ + 0.5);
+  if (i >= f.sim->size()) i = f.sim->size() - 1;
+  const SimSample& s = (*f.sim)[i];
+  for (int a = 0; a < 3; a++) {
+    r.acc_g[a] = s.phys[f.k].acc_g[a];
+    r.gyro_dps[a] = s.phys[f.k].gyro_dps[a];
+  }
+  r.temp_c = s.temp_c;
+}
+
+// Pin INT czujnika odniesienia (DRDY_PIN): impulsy data-ready z emulatora.
+static uint64_t drdyNext(void* ctx, uint64_t after_us) {
+  return mpuEmuNextDataReady(*(const MpuEmu*)ctx, after_us);
+}
+
+struct TimedCommand {
+  uint64_t t_us;
+  std::string line;
+  bool sent;
+};
+
+static bool parseMotion(const char* s, SimMotion& m) {
+  const SimMotion all[] = {SIM_STILL, SIM_SQUAT, SIM_GAIT, SIM_HYPEREXT};
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+    if (strcmp(s, simMotionName(all[i])) == 0) {
+      m = all[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t secToUs(const char* s) { return (uint64_t)(atof(s) * 1e6); }
+
+// nack:ADDR:T0:T1:P | detach:ADDR:T0:T1 | stuck:T0
+static bool parseFault(const char* spec, I2cEmuFault& f) {
+  char buf[96];
+  strncpy(buf, spec, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = 0;
+  const char* tok[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
+  int n = 0;
+  for (char* p = strtok(buf, ":"); p && n < 5; p = strtok(nullptr, ":")) tok[n++] = p;
+  if (n == 0) return false;
+  if (strcmp(tok[0], "stuck") == 0 && n == 2) {
+    f.type = I2C_FAULT_STUCK;
+    f.t0_us = secToUs(tok[1]);
+    f.t1_us = UINT64_MAX;
+    return true;
+  }
+  if (n < 4) return false;
+  f.addr = (uint8_t)strtol(tok[1], nullptr, 16);
+  f.t0_us = secToUs(tok[2]);
+  f.t1_us = secToUs(tok[3]);
+  if (strcmp(tok[0], "detach") == 0 && n == 4) {
+    f.type = I2C_FAULT_DETACH;
+    return true;
+  }
+  if (strcmp(tok[0], "nack") == 0 && n == 5) {
+    f.type = I2C_FAULT_NACK;
+    f.prob = (float)atof(tok[4]);
+    return true;
+  }
+  return false;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fwsim [-t S] [-m still|squat|gait|hyperext] [-s SEED] [-l US] [-j US]\n"
+          "             [-f [1/]nack:ADDR:T0:T1:P|detach:ADDR:T0:T1|stuck:T0]... [-c T:CMD]... [-n NVS]\n");
+}
+
+int main(int argc, char** argv) {
+  float run_s = 10.0f;
+  SimMotion motion = SIM_SQUAT;
+  uint32_t seed = 1;
+  const char* nvs_path = nullptr;
+  static I2cEmuBus buses[SENSOR_PORTS];
+  std::vector<TimedCommand> cmds;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!v) {
+      usage();
+      return 1;
+    }
+    i++;
+    if (strcmp(a, "-t") == 0) {
+      run_s = (float)atof(v);
+    } else if (strcmp(a, "-m") == 0) {
+      if (!parseMotion(v, motion)) { usage(); return 1; }
+    } else if (strcmp(a, "-s") == 0) {
+      seed = (uint32_t)strtoul(v, nullptr, 10);
+    } else if (strcmp(a, "-l") == 0) {
+      for (uint8_t p = 0; p < SENSOR_PORTS; p++) buses[p].latency_us = (uint32_t)strtoul(v, nullptr, 10);
+    } else if (strcmp(a, "-j") == 0) {
+      for (uint8_t p = 0; p < SENSOR_PORTS; p++) buses[p].latency_jitter_us = (uint32_t)strtoul(v, nullptr, 10);
+    } else if (strcmp(a, "-f") == 0) {
+      I2cEmuFault f;
+      const int port = strncmp(v, "1/", 2) == 0 ? 1 : 0;
+      if (!parseFault(v + 2 * port, f) || !i2cEmuAddFault(buses[port], f)) {
+        fprintf(stderr, "fwsim: bad fault '%s'\n", v);
+        return 1;
+      }
+    } else if (strcmp(a, "-c") == 0) {
+      const char* colon = strchr(v, ':');
+      if (!colon) { usage(); return 1; }
+      TimedCommand c = {secToUs(v), std::string(colon + 1) + "\n", false};
+      cmds.push_back(c);
+    } else if (strcmp(a, "-n") == 0) {
+      nvs_path = v;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (run_s < 1.0f) run_s = 1.0f;
+  const uint64_t end_us = (uint64_t)(run_s * 1e6f);
+  TimedCommand stats = {end_us - (uint64_t)(STATS_BEFORE_END_S * 1e6f), "stats\n", false};
+  cmds.push_back(stats);
+
+  // Ruch: bezruch na start, potem scenariusz do końca przebiegu
+  SimConfig sc;
+  sc.fs_hz = SIM_FS_HZ;
+  sc.seed = seed;
+  const float b1[3] = {0.8f, -0.5f, 1.2f}, b2[3] = {-1.1f, 0.3f, 0.6f};
+  for (int a = 0; a < 3; a++) {
+    sc.imu[0].bias_dps[a] = b1[a];
+    sc.imu[1].bias_dps[a] = b2[a];
+  }
+  const float motion_s = run_s - SIM_STILL_S - 1.0f;
+  const std::vector<SimSample> sim =
+      simRun(simMakeScenario(motion, motion_s > 1.0f ? motion_s : 1.0f, SIM_STILL_S), sc);
+
+  // Czujniki z układu: bezpośrednio na magistrali portu albo za multiplekserem
+  static MpuEmu imus[SENSOR_COUNT];
+  static ImuFeed feeds[SENSOR_COUNT];
+  static Tca9548aEmu muxes[SENSOR_PORTS];
+  bool has_mux[SENSOR_PORTS] = {false, false};
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorDesc& d = SENSORS[i];
+    feeds[i].sim = &sim;
+    feeds[i].k = simSegment(d.name);
+    mpuEmuInit(imus[i], feeds[i].k >= 0 ? simSource : nullptr, &feeds[i]);
+    if (d.mux_ch == MUX_NONE) {
+      i2cEmuAttach(buses[d.port], mpuEmuDevice(imus[i], d.addr));
+    } else {
+      tca9548aEmuAttach(muxes[d.port], (uint8_t)d.mux_ch, mpuEmuDevice(imus[i], d.addr));
+      has_mux[d.port] = true;
+    }
+  }
+  for (uint8_t p = 0; p < SENSOR_PORTS; p++) {
+    if (has_mux[p]) tca9548aEmuConnect(muxes[p], buses[p], MUX_ADDR);
+    buses[p].rng = seed + p;
+    fwsimSetBus(p, &buses[p]);
+  }
+  fwsimSetIntSource(DRDY_PIN, drdyNext, &imus[DRDY_SENSOR]);
+  if (nvs_path && !fwsimNvsLoad(nvs_path)) fprintf(stderr, "[FWSIM] nvs %s: new\n", nvs_path);
+
+  const uint64_t t_setup = fwsimNowUs();
+  setup();
+  const uint64_t setup_us = fwsimNowUs() - t_setup;
+
+  uint64_t loops = 0, last_flush = 0;
+  for (;;) {
+    const uint64_t now = fwsimNowUs();
+    if (now >= end_us) break;
+    for (size_t i = 0; i < cmds.size(); i++) {
+      if (!cmds[i].sent && now >= cmds[i].t_us) {
+        fwsimSerialInject(cmds[i].line.data(), cmds[i].line.size());
+        cmds[i].sent = true;
+      }
+    }
+    if (now - last_flush > 100000) {
+      fwsimSerialFlush();
+      last_flush = now;
+    }
+    if (!fwsimLoopDeleted()) {
+      loop();
+      loops++;
+    } else {
+      delay(1);
+    }
+  }
+  fwsimSerialFlush();
+
+  const FwsimSerialStats ss = fwsimSerialStats();
+  fwsimBusLock();
+  fprintf(stderr, "[FWSIM] run=%.1fs motion=%s setup=%llums loop_calls=%llu\n", run_s, simMotionName(motion),
+          (unsigned long long)(setup_us / 1000), (unsigned long long)loops);
+  for (uint8_t p = 0; p < SENSOR_PORTS; p++) {
+    const I2cEmuBus& bus = buses[p];
+    if (bus.n_dev == 0) continue;
+    fprintf(stderr,
+            "[FWSIM] i2c%u clock=%luHz trans=%lu bytes=%lu nack=%lu timeout=%lu stuck=%lu unstuck=%lu"
+            " busy=%.1f%% mux_select=%lu\n",
+            (unsigned)p, (unsigned long)bus.clock_hz, (unsigned long)bus.transactions, (unsigned long)bus.bytes,
+            (unsigned long)bus.nacks, (unsigned long)bus.timeouts, (unsigned long)bus.stuck_events,
+            (unsigned long)bus.unstuck, 100.0 * (double)bus.busy_us / (double)end_us,
+            (unsigned long)muxes[p].selects);
+  }
+  for (size_t i = 0; i < SENSOR_COUNT; i++) {
+    fprintf(stderr, "[FWSIM] imu%u %s@%u/0x%02X samples=%lu fifo_overflow=%lu resets=%lu fs=%.0fHz\n",
+            (unsigned)(i + 1), SENSORS[i].name, (unsigned)SENSORS[i].port, SENSORS[i].addr,
+            (unsigned long)imus[i].samples, (unsigned long)imus[i].fifo_overflows, (unsigned long)imus[i].resets,
+            mpuEmuSampleRateHz(imus[i]));
+  }
+  fwsimBusUnlock();
+  fprintf(stderr, "[FWSIM] serial tx=%llu B blocked=%llums\n", (unsigned long long)ss.tx_bytes,
+          (unsigned long long)(ss.blocked_us / 1000));
+  if (nvs_path && !fwsimNvsSave(nvs_path)) fprintf(stderr, "[FWSIM] nvs %s: save failed\n", nvs_path);
+
+  // zadania firmware działają w nieskończonych pętlach – bez destruktorów globalnych
+  fflush(stderr);
+  _exit(0);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i2c_emu.h"
+
+// fwsim – interfejs między symulatorem (fwsim.cpp) a warstwą Arduino (hal.cpp)
+
+// Czas od startu [us] (esp_timer_get_time, micros) i czekanie do chwili t_us.
+uint64_t fwsimNowUs();
+void fwsimWaitUntilUs(uint64_t t_us);
+
+// Magistrala emulatora pod portem Wire (0) / Wire1 (1); dostęp przez fwsimBusLock.
+void fwsimSetBus(int port, I2cEmuBus* bus);
+void fwsimBusLock();
+void fwsimBusUnlock();
+
+// Pin INT czujnika: next(ctx, after_us) – chwila pierwszego impulsu po after_us
+// (0 = brak impulsów), wywoływane pod fwsimBusLock. Po attachInterrupt na tym
+// pinie wątek fwsim wywołuje ISR w chwilach impulsów.
+typedef uint64_t (*FwsimIntSource)(void* ctx, uint64_t after_us);
+void fwsimSetIntSource(uint8_t pin, FwsimIntSource next, void* ctx);
+
+// Bajty "odebrane" przez Serial (komendy).
+void fwsimSerialInject(const char* data, size_t n);
+
+struct FwsimSerialStats {
+  uint64_t tx_bytes   = 0;
+  uint64_t blocked_us = 0; // czas zapisów czekających na miejsce w buforze TX
+};
+FwsimSerialStats fwsimSerialStats();
+void fwsimSerialFlush();
+
+// loop() wywołało vTaskDelete(nullptr) – pracę przejęły zadania.
+bool fwsimLoopDeleted();
+
+// NVS (Preferences) z/do pliku.
+bool fwsimNvsLoad(const char* path);
+bool fwsimNvsSave(const char* path);
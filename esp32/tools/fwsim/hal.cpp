@@ -0,0 +1,554 @@
+// fwsim – warstwa Arduino-ESP32 / FreeRTOS / esp_timer na wątkach hosta
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include <Wire.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fwsim.h"
+
+// ============================================================================
+// Czas
+// ============================================================================
+
+typedef std::chrono::steady_clock Clock;
+static const Clock::time_point t_start = Clock::now();
+
+static const uint64_t SPIN_BELOW_US = 200; // krótsze oczekiwania aktywnie (sleep ma ~60 us rozrzutu)
+
+uint64_t fwsimNowUs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t_start).count();
+}
+
+void fwsimWaitUntilUs(uint64_t t_us) {
+  for (;;) {
+    const uint64_t now = fwsimNowUs();
+    if (now >= t_us) return;
+    if (t_us - now > SPIN_BELOW_US) std::this_thread::sleep_for(std::chrono::microseconds(t_us - now - SPIN_BELOW_US / 2));
+    else std::this_thread::yield();
+  }
+}
+
+uint32_t micros() { return (uint32_t)fwsimNowUs(); }
+uint32_t millis() { return (uint32_t)(fwsimNowUs() / 1000); }
+int64_t esp_timer_get_time() { return (int64_t)fwsimNowUs(); }
+
+void delay(uint32_t ms) {
+  if (ms == 0) std::this_thread::yield();
+  else std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) { fwsimWaitUntilUs(fwsimNowUs() + us); }
+void yield() { std::this_thread::yield(); }
+
+void EspClass::restart() {
+  fwsimSerialFlush();
+  fprintf(stderr, "[FWSIM] ESP.restart()\n");
+  _exit(3);
+}
+
+EspClass ESP;
+
+// ============================================================================
+// Print / Serial
+// ============================================================================
+
+size_t Print::printf(const char* fmt, ...) {
+  char small[256];
+  va_list ap;
+  va_start(ap, fmt);
+  const int n = vsnprintf(small, sizeof(small), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(small)) return write((const uint8_t*)small, (size_t)n);
+  std::vector<char> big((size_t)n + 1);
+  va_start(ap, fmt);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  va_end(ap);
+  return write((const uint8_t*)&big[0], (size_t)n);
+}
+
+static std::mutex serial_tx_mutex, serial_rx_mutex;
+static uint32_t serial_baud   = 115200;
+static size_t   serial_tx_cap = 128; // FIFO UART bez bufora programowego
+static double   serial_level  = 0;   // bajty czekające na wysłanie
+static uint64_t serial_t      = 0;
+static FwsimSerialStats serial_stats;
+static std::deque<uint8_t> serial_rx;
+
+static void serialDrain(uint64_t now) {
+  serial_level -= (double)(now - serial_t) * serial_baud / 10e6;
+  if (serial_level < 0) serial_level = 0;
+  serial_t = now;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  serial_baud = (uint32_t)baud;
+  serial_t = fwsimNowUs();
+}
+
+void HardwareSerial::setTxBufferSize(size_t n) {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  serial_tx_cap = n > 128 ? n : 128;
+}
+
+int HardwareSerial::availableForWrite() {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  serialDrain(fwsimNowUs());
+  return (int)(serial_tx_cap - (size_t)ceil(serial_level));
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  size_t done = 0;
+  while (done < n) {
+    const size_t chunk = min(n - done, serial_tx_cap);
+    uint64_t now = fwsimNowUs();
+    serialDrain(now);
+    const double over = serial_level + chunk - serial_tx_cap;
+    if (over > 0) { // pełny bufor: czekanie jak w uartWrite
+      const uint64_t until = now + (uint64_t)(over * 10e6 / serial_baud) + 1;
+      fwsimWaitUntilUs(until);
+      serial_stats.blocked_us += fwsimNowUs() - now;
+      serialDrain(fwsimNowUs());
+    }
+    fwrite(buf + done, 1, chunk, stdout);
+    serial_level += chunk;
+    serial_stats.tx_bytes += chunk;
+    done += chunk;
+  }
+  return n;
+}
+
+int HardwareSerial::available() {
+  std::lock_guard<std::mutex> lock(serial_rx_mutex);
+  return (int)serial_rx.size();
+}
+
+int HardwareSerial::read() {
+  std::lock_guard<std::mutex> lock(serial_rx_mutex);
+  if (serial_rx.empty()) return -1;
+  const int c = serial_rx.front();
+  serial_rx.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  std::lock_guard<std::mutex> lock(serial_rx_mutex);
+  return serial_rx.empty() ? -1 : serial_rx.front();
+}
+
+HardwareSerial Serial;
+
+void fwsimSerialInject(const char* data, size_t n) {
+  std::lock_guard<std::mutex> lock(serial_rx_mutex);
+  serial_rx.insert(serial_rx.end(), data, data + n);
+}
+
+FwsimSerialStats fwsimSerialStats() {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  return serial_stats;
+}
+
+void fwsimSerialFlush() {
+  std::lock_guard<std::mutex> lock(serial_tx_mutex);
+  fflush(stdout);
+}
+
+// ============================================================================
+// Wire + GPIO (linie magistrali)
+// ============================================================================
+
+static std::mutex bus_mutex;
+static I2cEmuBus* buses[2] = {nullptr, nullptr};
+static int bus_sda[2] = {-1, -1}, bus_scl[2] = {-1, -1};
+static uint8_t pin_level[40];
+
+void fwsimSetBus(int port, I2cEmuBus* bus) { buses[port & 1] = bus; }
+void fwsimBusLock() { bus_mutex.lock(); }
+void fwsimBusUnlock() { bus_mutex.unlock(); }
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  static const int DEFAULT_SDA[2] = {21, 4}, DEFAULT_SCL[2] = {22, 5};
+  bus_sda[num_] = sda >= 0 ? sda : DEFAULT_SDA[num_];
+  bus_scl[num_] = scl >= 0 ? scl : DEFAULT_SCL[num_];
+  begun_ = buses[num_] != nullptr;
+  if (begun_ && frequency) setClock(frequency);
+  return begun_;
+}
+
+bool TwoWire::end() {
+  begun_ = false;
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+  if (!buses[num_]) return false;
+  std::lock_guard<std::mutex> lock(bus_mutex);
+  buses[num_]->clock_hz = frequency;
+  return true;
+}
+
+void TwoWire::setTimeOut(uint16_t timeout_ms) {
+  if (!buses[num_]) return;
+  std::lock_guard<std::mutex> lock(bus_mutex);
+  buses[num_]->timeout_us = (uint32_t)timeout_ms * 1000;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+  tx_addr_ = address;
+  tx_len_ = 0;
+  tx_over_ = false;
+}
+
+size_t TwoWire::write(uint8_t b) {
+  if (tx_len_ >= BUFFER_LEN) {
+    tx_over_ = true;
+    return 0;
+  }
+  tx_[tx_len_++] = b;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* buf, size_t n) {
+  size_t i = 0;
+  while (i < n && write(buf[i])) i++;
+  return i;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+  if (!begun_) return 4;
+  if (tx_over_) return 1;
+  const uint64_t t0 = fwsimNowUs();
+  uint32_t dur = 0;
+  uint8_t r;
+  {
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    r = i2cEmuWrite(*buses[num_], (uint8_t)tx_addr_, tx_, tx_len_, t0, dur);
+  }
+  fwsimWaitUntilUs(t0 + dur);
+  return r;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool) {
+  rx_len_ = rx_pos_ = 0;
+  if (!begun_ || size > BUFFER_LEN) return 0;
+  const uint64_t t0 = fwsimNowUs();
+  uint32_t dur = 0;
+  uint8_t r;
+  {
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    r = i2cEmuRead(*buses[num_], (uint8_t)address, rx_, size, t0, dur);
+  }
+  fwsimWaitUntilUs(t0 + dur);
+  if (r != I2C_EMU_OK) return 0;
+  rx_len_ = size;
+  return size;
+}
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < sizeof(pin_level) && (mode == INPUT_PULLUP || mode == INPUT)) pin_level[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= sizeof(pin_level)) return;
+  const uint8_t prev = pin_level[pin];
+  pin_level[pin] = val ? HIGH : LOW;
+  for (int p = 0; p < 2; p++) {
+    if (buses[p] && pin == bus_scl[p] && prev == LOW && val) { // zbocze narastające SCL
+      std::lock_guard<std::mutex> lock(bus_mutex);
+      i2cEmuSclPulse(*buses[p]);
+    }
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  for (int p = 0; p < 2; p++) {
+    if (buses[p] && pin == bus_sda[p]) {
+      std::lock_guard<std::mutex> lock(bus_mutex);
+      if (i2cEmuSdaLow(*buses[p])) return LOW;
+    }
+  }
+  return pin < sizeof(pin_level) ? pin_level[pin] : LOW;
+}
+
+struct IntPin {
+  FwsimIntSource next = nullptr;
+  void*          ctx  = nullptr;
+  void (*isr)()       = nullptr;
+};
+static IntPin int_pins[sizeof(pin_level)];
+
+void fwsimSetIntSource(uint8_t pin, FwsimIntSource next, void* ctx) {
+  if (pin >= sizeof(int_pins) / sizeof(int_pins[0])) return;
+  int_pins[pin].next = next;
+  int_pins[pin].ctx = ctx;
+}
+
+// Jeden wątek na pin: czekanie do impulsu, ISR; impulsy przegapione przez
+// opóźniony wątek przepadają (jak przerwanie zablokowane na ESP32).
+void attachInterrupt(uint8_t pin, void (*isr)(), int) {
+  if (pin >= sizeof(int_pins) / sizeof(int_pins[0]) || int_pins[pin].isr || !int_pins[pin].next) return;
+  IntPin* ip = &int_pins[pin];
+  ip->isr = isr;
+  std::thread([ip]() {
+    uint64_t last = 0;
+    for (;;) {
+      const uint64_t now = fwsimNowUs();
+      uint64_t t;
+      {
+        std::lock_guard<std::mutex> lock(bus_mutex);
+        t = ip->next(ip->ctx, now > last ? now : last);
+      }
+      if (t == 0) { // przerwanie wyłączone / czujnik nie próbkuje
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      fwsimWaitUntilUs(t);
+      last = t;
+      ip->isr();
+    }
+  }).detach();
+}
+
+// ============================================================================
+// Zadania FreeRTOS i esp_timer
+// ============================================================================
+
+struct FwsimTask {
+  std::mutex              m;
+  std::condition_variable cv;
+  uint32_t                notify = 0;
+  TaskFunction_t          fn     = nullptr;
+  void*                   arg    = nullptr;
+};
+
+static FwsimTask loop_task; // wątek główny: setup() / loop()
+static thread_local FwsimTask* current_task = nullptr;
+static std::atomic<bool> loop_deleted(false);
+
+static FwsimTask* selfTask() {
+  if (!current_task) current_task = &loop_task;
+  return current_task;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg, UBaseType_t,
+                                   TaskHandle_t* created, BaseType_t) {
+  FwsimTask* t = new FwsimTask;
+  t->fn = fn;
+  t->arg = arg;
+  if (created) *created = t;
+  std::thread([t]() {
+    current_task = t;
+    t->fn(t->arg);
+  }).detach();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> lock(task->m);
+    task->notify++;
+  }
+  task->cv.notify_one();
+  return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_woken) {
+  xTaskNotifyGive(task);
+  if (higher_priority_woken) *higher_priority_woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+  FwsimTask* t = selfTask();
+  std::unique_lock<std::mutex> lock(t->m);
+  if (ticks_to_wait == portMAX_DELAY) {
+    t->cv.wait(lock, [t]() { return t->notify > 0; });
+  } else if (ticks_to_wait > 0) {
+    t->cv.wait_for(lock, std::chrono::milliseconds(ticks_to_wait * portTICK_PERIOD_MS),
+                   [t]() { return t->notify > 0; });
+  }
+  const uint32_t v = t->notify;
+  if (v > 0) t->notify = clear_on_exit ? 0 : v - 1;
+  return v;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (!task) task = selfTask();
+  if (task == &loop_task) { // loop() wraca, fwsim przestaje je wywoływać
+    loop_deleted = true;
+    return;
+  }
+  for (;;) std::this_thread::sleep_for(std::chrono::hours(1)); // zadanie usunięte: wątek stoi
+}
+
+bool fwsimLoopDeleted() { return loop_deleted; }
+
+struct FwsimSemaphore {
+  std::mutex              m;
+  std::condition_variable cv;
+  bool                    given = false;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return new FwsimSemaphore; }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  {
+    std::lock_guard<std::mutex> lock(sem->m);
+    if (sem->given) return pdFAIL;
+    sem->given = true;
+  }
+  sem->cv.notify_one();
+  return pdPASS;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait) {
+  std::unique_lock<std::mutex> lock(sem->m);
+  if (ticks_to_wait == portMAX_DELAY) {
+    sem->cv.wait(lock, [sem]() { return sem->given; });
+  } else if (ticks_to_wait > 0) {
+    sem->cv.wait_for(lock, std::chrono::milliseconds(ticks_to_wait * portTICK_PERIOD_MS),
+                     [sem]() { return sem->given; });
+  }
+  if (!sem->given) return pdFAIL;
+  sem->given = false;
+  return pdPASS;
+}
+
+struct esp_timer {
+  esp_timer_cb_t    cb  = nullptr;
+  void*             arg = nullptr;
+  std::atomic<bool> running;
+  esp_timer() : running(false) {}
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+  if (!args || !args->callback || !out_handle) return ESP_FAIL;
+  esp_timer* t = new esp_timer;
+  t->cb = args->callback;
+  t->arg = args->arg;
+  *out_handle = t;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  if (!timer || timer->running || period_us == 0) return ESP_FAIL;
+  timer->running = true;
+  std::thread([timer, period_us]() {
+    uint64_t next = fwsimNowUs() + period_us;
+    while (timer->running) {
+      std::this_thread::sleep_until(t_start + std::chrono::microseconds(next));
+      if (!timer->running) break;
+      timer->cb(timer->arg);
+      next += period_us;
+    }
+  }).detach();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (!timer || !timer->running) return ESP_FAIL;
+  timer->running = false;
+  return ESP_OK;
+}
+
+// ============================================================================
+// NVS (Preferences) i LittleFS
+// ============================================================================
+
+static std::mutex nvs_mutex;
+static std::map<std::string, std::vector<uint8_t> > nvs;
+
+static std::string nvsKey(const char* ns, const char* key) { return std::string(ns) + "/" + key; }
+
+bool Preferences::begin(const char* name, bool read_only, const char*) {
+  strncpy(ns_, name, sizeof(ns_) - 1);
+  read_only_ = read_only;
+  return true;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (read_only_) return 0;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  const uint8_t* p = (const uint8_t*)value;
+  nvs[nvsKey(ns_, key)].assign(p, p + len);
+  return len;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t max_len) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.find(nvsKey(ns_, key));
+  if (it == nvs.end() || it->second.size() > max_len) return 0; // jak nvs_get_blob: za mały bufor = błąd
+  if (!it->second.empty()) memcpy(buf, &it->second[0], it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.find(nvsKey(ns_, key));
+  return it == nvs.end() ? 0 : it->second.size();
+}
+
+bool Preferences::remove(const char* key) {
+  if (read_only_) return false;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  return nvs.erase(nvsKey(ns_, key)) > 0;
+}
+
+// Plik NVS: [u8 długość klucza][klucz][u16 LE długość][bajty] ...
+bool fwsimNvsLoad(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  for (;;) {
+    uint8_t kl, ll[2];
+    char key[256];
+    if (fread(&kl, 1, 1, f) != 1) break;
+    if (fread(key, 1, kl, f) != kl || fread(ll, 1, 2, f) != 2) break;
+    std::vector<uint8_t> v((size_t)(ll[0] | (ll[1] << 8)));
+    if (!v.empty() && fread(&v[0], 1, v.size(), f) != v.size()) break;
+    nvs[std::string(key, kl)] = v;
+  }
+  fclose(f);
+  return true;
+}
+
+bool fwsimNvsSave(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  std::lock_guard<std::mutex> lock(nvs_mutex);
+  for (std::map<std::string, std::vector<uint8_t> >::const_iterator it = nvs.begin(); it != nvs.end(); ++it) {
+    const uint8_t kl = (uint8_t)it->first.size();
+    const uint8_t ll[2] = {(uint8_t)it->second.size(), (uint8_t)(it->second.size() >> 8)};
+    fwrite(&kl, 1, 1, f);
+    fwrite(it->first.data(), 1, kl, f);
+    fwrite(ll, 1, 2, f);
+    if (!it->second.empty()) fwrite(&it->second[0], 1, it->second.size(), f);
+  }
+  return fclose(f) == 0;
+}
+
+LittleFSFS LittleFS;
@@ -0,0 +1,69 @@
+// kgdecode – referencyjny dekoder zapisu strumienia KneeGuard (host, Linux/macOS)
+//
+// Czyta surowe bajty z USB/BT (plik albo stdin), rozpoznaje CSV, linie USB,
+// ramki/paczki binarne i bloki dziennika (lib/kneeguard/src/stream_decoder.h),
+// wypisuje próbki jako CSV z czasem 64-bit, luki jako linie "# gap ..." oraz
+// podsumowanie strat na stderr.
+//
+// Budowanie (z katalogu esp32/):
+//   g++ -std=gnu++11 -O2 -Ilib/kneeguard/src tools/kgdecode.cpp lib/kneeguard/src/*.cpp -o kgdecode
+// Użycie:
+//   kgdecode [-q] [plik]      (-q: tylko podsumowanie)
+
+#include <stdio.h>
+#include <string.h>
+
+#include "stream_decoder.h"
+
+static bool quiet = false;
+
+static void onSample(void*, const KneeSample& s, StreamFrameKind kind, uint64_t seq) {
+  if (quiet) return;
+  printf("%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%d,%d,%s,%llu\n", (unsigned long long)s.t_us,
+         s.roll1, s.pitch1, s.yaw1, s.roll2, s.pitch2, s.yaw2, s.knee_angle, s.inv1 ? 1 : 0,
+         s.inv2 ? 1 : 0, (int)s.q1, (int)s.q2, streamFrameKindName(kind), (unsigned long long)seq);
+}
+
+static void onGap(void*, const StreamGap& g) {
+  if (quiet) return;
+  printf("# gap %s seq=%llu frames=%llu t=%llu..%llu samples~%llu\n", streamFrameKindName(g.kind),
+         (unsigned long long)g.first_seq, (unsigned long long)g.frames,
+         (unsigned long long)g.t_before_us, (unsigned long long)g.t_after_us,
+         (unsigned long long)g.samples_est);
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-q") == 0) quiet = true;
+    else path = argv[i];
+  }
+  FILE* in = path ? fopen(path, "rb") : stdin;
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+
+  static StreamDecoder d;
+  d.on_sample = onSample;
+  d.on_gap = onGap;
+  streamDecoderInit(d);
+  if (!quiet) printf("time,roll1,pitch1,yaw1,roll2,pitch2,yaw2,knee_angle,inv1,inv2,q1,q2,kind,seq\n");
+
+  uint8_t buf[4096];
+  size_t n = 0;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) streamDecoderFeed(d, buf, n);
+  streamDecoderFinish(d);
+  if (in != stdin) fclose(in);
+
+  const StreamStats& st = d.stats;
+  fprintf(stderr,
+          "samples=%llu lost~%llu (%.3f%%) gaps=%llu | frames=%llu lost=%llu (%.3f%%) late=%llu dup=%llu"
+          " restarts=%llu | crc_err=%llu text=%llu skipped_bytes=%llu\n",
+          (unsigned long long)st.samples, (unsigned long long)st.samples_lost, streamSampleLossPct(d),
+          (unsigned long long)st.gaps, (unsigned long long)d.seq.received, (unsigned long long)d.seq.lost,
+          seqLossPct(d.seq), (unsigned long long)d.seq.late, (unsigned long long)d.seq.duplicates,
+          (unsigned long long)d.seq.restarts, (unsigned long long)st.crc_errors,
+          (unsigned long long)st.text_lines, (unsigned long long)st.bytes_skipped);
+  return 0;
+}
@@ -0,0 +1,121 @@
+// kgreplay – odtwarzanie śladu surowego KneeGuard (host, Linux/macOS)
+//
+// Czyta zapis USB po "trace on" (plik albo stdin; linie tekstowe są pomijane),
+// przepuszcza rejestry obu IMU przez ten sam potok co firmware (mpuScale +
+// fuseKneeStep, lib/kneeguard/src/raw_trace.h) i wypisuje próbki wyjściowe jako
+// CSV z pełną precyzją float (%.9g – zapis odwracalny bit w bit). Podsumowanie
+// na stderr: rekordy, straty, czas odtwarzania, krotność czasu rzeczywistego
+// i skrót FNV-1a wyniku (porównanie dwóch przebiegów / wersji kodu fuzji).
+//
+// Budowanie (z katalogu esp32/):
+//   g++ -std=gnu++11 -O2 -Ilib/kneeguard/src tools/kgreplay.cpp lib/kneeguard/src/*.cpp -o kgreplay
+// Użycie:
+//   kgreplay [-q] [-r N] [plik]   (-q: tylko podsumowanie, -r: N przebiegów – pomiar szybkości)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <vector>
+
+#include "raw_trace.h"
+
+static uint64_t fnv1a(uint64_t h, const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < n; i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+// Skrót pól próbki (bity float, bez wypełnienia struktury)
+static uint64_t hashSample(uint64_t h, const KneeSample& s) {
+  const float v[7] = {s.roll1, s.pitch1, s.yaw1, s.roll2, s.pitch2, s.yaw2, s.knee_angle};
+  const uint8_t f[4] = {(uint8_t)s.inv1, (uint8_t)s.inv2, (uint8_t)s.q1, (uint8_t)s.q2};
+  h = fnv1a(h, &s.t_us, sizeof(s.t_us));
+  h = fnv1a(h, v, sizeof(v));
+  return fnv1a(h, f, sizeof(f));
+}
+
+static double nowSec() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  bool quiet = false;
+  long runs = 1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-q") == 0) quiet = true;
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) runs = strtol(argv[++i], nullptr, 10);
+    else path = argv[i];
+  }
+  if (runs < 1) runs = 1;
+  FILE* in = path ? fopen(path, "rb") : stdin;
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+
+  // Rekordy raz do pamięci – pomiar obejmuje tylko odtwarzanie, nie I/O
+  std::vector<uint8_t> rec_type;
+  std::vector<std::vector<uint8_t> > rec_payload;
+  static TraceParser parser;
+  uint8_t buf[4096];
+  size_t n = 0;
+  while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      uint8_t type = 0;
+      const uint8_t* payload = nullptr;
+      size_t len = 0;
+      if (!traceParserFeed(parser, buf[i], type, payload, len)) continue;
+      rec_type.push_back(type);
+      rec_payload.push_back(std::vector<uint8_t>(payload, payload + len));
+    }
+  }
+  if (in != stdin) fclose(in);
+
+  if (!quiet) printf("time,roll1,pitch1,yaw1,roll2,pitch2,yaw2,knee_angle,inv1,inv2,q1,q2\n");
+  static TraceReplay r;
+  uint64_t hash = 0;
+  double t_replay = 0;
+  for (long run = 0; run < runs; run++) {
+    r = TraceReplay();
+    uint64_t h = 14695981039346656037ULL;
+    const bool print = !quiet && run == 0;
+    const double t0 = nowSec();
+    for (size_t i = 0; i < rec_type.size(); i++) {
+      KneeSample k;
+      const std::vector<uint8_t>& p = rec_payload[i];
+      if (!traceReplayRecord(r, rec_type[i], p.empty() ? nullptr : &p[0], p.size(), k)) continue;
+      h = hashSample(h, k);
+      if (print) {
+        printf("%llu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%d,%d,%d\n", (unsigned long long)k.t_us,
+               k.roll1, k.pitch1, k.yaw1, k.roll2, k.pitch2, k.yaw2, k.knee_angle, k.inv1 ? 1 : 0,
+               k.inv2 ? 1 : 0, (int)k.q1, (int)k.q2);
+      }
+    }
+    const double dt = nowSec() - t0;
+    if (run == 0 || dt < t_replay) t_replay = dt; // najlepszy przebieg
+    if (run > 0 && h != hash) {
+      fprintf(stderr, "kgreplay: run %ld hash differs (non-deterministic replay)\n", run);
+      return 2;
+    }
+    hash = h;
+  }
+
+  const double span_s = r.samples > 1 ? (double)(r.last_t_us - r.first_t_us) / 1e6 : 0.0;
+  fprintf(stderr,
+          "records=%lu crc_err=%lu | config=%llu state=%llu samples=%llu lost=%llu waiting=%llu bad=%llu"
+          " | span=%.1fs replay=%.3fms (%.0f samples/s, x%.0f real time) runs=%ld | hash=%016llx\n",
+          (unsigned long)parser.records, (unsigned long)parser.crc_errors,
+          (unsigned long long)r.configs, (unsigned long long)r.states, (unsigned long long)r.samples,
+          (unsigned long long)r.lost, (unsigned long long)r.waiting, (unsigned long long)r.bad_records,
+          span_s, t_replay * 1e3, t_replay > 0 ? (double)r.samples / t_replay : 0.0,
+          t_replay > 0 ? span_s / t_replay : 0.0, runs, (unsigned long long)hash);
+  return 0;
+}